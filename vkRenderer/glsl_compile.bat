@@ -23,4 +23,8 @@ C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\resolve.frag -o sh
 C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\resolve.frag -o shaders_bin\resolvePS_msaa.spv -g --define-macro USE_MSAA
 C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\gaussian.frag -o shaders_bin\gaussianPS.spv -g
 C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\equirectangularSky.frag -o shaders_bin\equirectangularSkyPS.spv -g
-C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\preCalculatedDiffuseIbl.frag -o shaders_bin\preCalculatedDiffuseIblPS.spv -g
\ No newline at end of file
+C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\preCalculatedDiffuseIbl.frag -o shaders_bin\preCalculatedDiffuseIblPS.spv -g
+C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\cullDraws.comp -o shaders_bin\cullDrawsCS.spv -g
+C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\lightCull.comp -o shaders_bin\lightCullCS.spv -g
+C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\hiZBuild.comp -o shaders_bin\hiZBuildCS.spv -g
+C:\VulkanSDK\1.3.261.0\Bin\glslangValidator.exe -l -V shaders\hiZBuild.comp -o shaders_bin\hiZBuildCS_msaa.spv -g --define-macro USE_MSAA
\ No newline at end of file
@@ -6,8 +6,13 @@
 #include <raytracer/scene.h>
 #include <raytracer/raytrace.h>
 
+#include "src/globals/sceneBvh.h"
+
+extern SceneBvh g_sceneBvh;
+
 static RtView rtview;
 static RtScene rtScene;
+static std::vector<uint32_t> rtModelEntities;	// Entity of each model in rtScene
 
 static void BuildRayTraceScene( const Scene* scene )
 {
@@ -19,12 +24,25 @@ static void BuildRayTraceScene( const Scene* scene )
 	rtScene.models.clear();
 	rtScene.models.reserve( entCount );
 	rtScene.aabb = AABB();
+	rtModelEntities.clear();
+
+	// Models are listed in hierarchy leaf order so neighbours in the list are neighbours in space
+	std::vector<uint32_t> entityOrder;
+	if ( g_sceneBvh.EntityCount() == entCount ) {
+		g_sceneBvh.LeafOrder( entityOrder );
+	} else {
+		entityOrder.resize( entCount );
+		for ( uint32_t i = 0; i < entCount; ++i ) {
+			entityOrder[ i ] = i;
+		}
+	}
 
-	for ( uint32_t i = 0; i < entCount; ++i )
+	for ( const uint32_t entIx : entityOrder )
 	{
 		RtModel rtModel;
-		CreateRayTraceModel( g_assets, scene->entities[ i ], &rtModel );
+		CreateRayTraceModel( g_assets, scene->entities[ entIx ], &rtModel );
 		rtScene.models.push_back( rtModel );
+		rtModelEntities.push_back( entIx );
 
 		AABB& aabb = rtModel.octree.GetAABB();
 		rtScene.aabb.Expand( aabb.GetMin() );
@@ -38,6 +56,51 @@ static void BuildRayTraceScene( const Scene* scene )
 }
 
 
+// The tracer tests every model it is given, so the hierarchy picks them. Models are kept when the BVH
+// finds them in the camera frustum pushed out by ShadowCasterReach, so off-screen casters still shadow.
+static void CullRayTraceScene( const RtScene& scene, const Camera& camera, RtScene& culledScene )
+{
+	culledScene.scene = scene.scene;
+	culledScene.assets = scene.assets;
+	culledScene.lights = scene.lights;
+	culledScene.models.clear();
+	culledScene.aabb = AABB();
+
+	const uint32_t entCount = static_cast<uint32_t>( scene.scene->entities.size() );
+	if ( ( g_sceneBvh.EntityCount() != entCount ) || ( rtModelEntities.size() != scene.models.size() ) )
+	{
+		culledScene.models = scene.models;
+		culledScene.aabb = scene.aabb;
+		return;
+	}
+
+	frustum_t frustum;
+	ExtractFrustumPlanes( camera.GetPerspectiveMatrix() * camera.GetViewMatrix(), frustum );
+	for ( uint32_t i = 0; i < 6; ++i )
+	{
+		const float normalLength = sqrtf( frustum.nx[ i ] * frustum.nx[ i ] + frustum.ny[ i ] * frustum.ny[ i ] + frustum.nz[ i ] * frustum.nz[ i ] );
+		frustum.d[ i ] += ShadowCasterReach * normalLength;
+	}
+
+	std::vector<uint8_t> reached( entCount );
+	g_sceneBvh.CullFrustum( frustum, reached.data() );
+
+	const uint32_t modelCount = static_cast<uint32_t>( scene.models.size() );
+	for ( uint32_t modelIx = 0; modelIx < modelCount; ++modelIx )
+	{
+		if ( reached[ rtModelEntities[ modelIx ] ] == 0 ) {
+			continue;
+		}
+
+		culledScene.models.push_back( scene.models[ modelIx ] );
+
+		AABB& aabb = culledScene.models.back().octree.GetAABB();
+		culledScene.aabb.Expand( aabb.GetMin() );
+		culledScene.aabb.Expand( aabb.GetMax() );
+	}
+}
+
+
 static void TraceScene( const bool rasterize = false )
 {
 #if defined( USE_IMGUI )
@@ -55,11 +118,14 @@ static void TraceScene( const bool rasterize = false )
 		rtview.projView = rtview.projTransform * rtview.viewTransform;
 	}
 
+	RtScene culledScene;
+	CullRayTraceScene( rtScene, rtview.camera, culledScene );
+
 	if ( rasterize ) {
-		RasterScene( rtimage, rtview, rtScene, true );
+		RasterScene( rtimage, rtview, culledScene, true );
 	}
 	else {
-		TraceScene( rtview, rtScene, rtimage );
+		TraceScene( rtview, culledScene, rtimage );
 	}
 
 	{
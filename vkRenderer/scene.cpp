@@ -5,6 +5,7 @@
 #include <gfxcore/scene/entity.h>
 #include <gfxcore/scene/scene.h>
 #include "src/globals/render_util.h"
+#include "src/globals/sceneBvh.h"
 
 #if defined( USE_IMGUI )
 #include "external/imgui/imgui.h"
@@ -14,6 +15,7 @@
 
 extern AssetManager g_assets;
 extern Scene* g_scene;
+extern SceneBvh g_sceneBvh;
 
 #if defined( USE_IMGUI )
 extern imguiControls_t			g_imguiControls;
@@ -26,6 +28,7 @@ void DrawManipDebugMenu();
 void DrawEntityDebugMenu();
 void DrawOutlinerDebugMenu();
 void DeviceDebugMenu();
+void ViewDebugMenu();
 
 void CreateCodeAssets()
 {
@@ -254,24 +257,31 @@ void InitScene( Scene* scene )
 	}
 
 	{
-		scene->lights.resize( 3 );
-		scene->lights[ 0 ].pos = vec4f( 0.0f, 0.0f, 6.0f, 0.0f );
+		scene->lights.resize( 4 );
+		scene->lights[ 0 ].pos = vec4f( 0.0f, 0.0f, 6.0f, 1.0f );
 		scene->lights[ 0 ].intensity = 1.0f;
 		scene->lights[ 0 ].dir = vec4f( 0.0f, 0.0f, -1.0f, 0.0f );
 		scene->lights[ 0 ].color = Color::White;
 		scene->lights[ 0 ].flags = LIGHT_FLAGS_SHADOW;
 
-		scene->lights[ 1 ].pos = vec4f( 0.0f, 10.0f, 5.0f, 0.0f );
+		scene->lights[ 1 ].pos = vec4f( 0.0f, 10.0f, 5.0f, 1.0f );
 		scene->lights[ 1 ].intensity = 1.0f;
 		scene->lights[ 1 ].dir = vec4f( 0.0f, 0.0f, -1.0f, 0.0f );
 		scene->lights[ 1 ].color = Color::Red;
 		scene->lights[ 1 ].flags = LIGHT_FLAGS_SHADOW;
 
-		scene->lights[ 2 ].pos = vec4f( 0.0f, -10.0f, 5.0f, 0.0f );
+		scene->lights[ 2 ].pos = vec4f( 0.0f, -10.0f, 5.0f, 1.0f );
 		scene->lights[ 2 ].intensity = 1.0f;
 		scene->lights[ 2 ].dir = vec4f( 0.0f, 0.0f, -1.0f, 0.0f );
 		scene->lights[ 2 ].color = Color::Blue;
 		scene->lights[ 2 ].flags = LIGHT_FLAGS_SHADOW;
+
+		// Sun, a zero w makes it directional
+		scene->lights[ 3 ].pos = vec4f( 0.0f, 0.0f, 0.0f, 0.0f );
+		scene->lights[ 3 ].intensity = 1.0f;
+		scene->lights[ 3 ].dir = vec4f( 0.3f, 0.2f, -1.0f, 0.0f );
+		scene->lights[ 3 ].color = Color::White;
+		scene->lights[ 3 ].flags = LIGHT_FLAGS_SHADOW;
 	}
 }
 
@@ -363,7 +373,7 @@ void UpdateScene( Scene* scene )
 	else if ( mouse.leftDown )
 	{
 		Ray ray = scene->mainCamera->GetViewRay( vec2f( 0.5f * mouse.x + 0.5f, 0.5f * mouse.y + 0.5f ) );
-		scene->selectedEntity = scene->GetTracedEntity( ray );
+		scene->selectedEntity = TraceEntity( scene, g_sceneBvh, ray );
 	}
 
 	// Skybox
@@ -431,6 +441,7 @@ void UpdateScene( Scene* scene )
 		DrawEntityDebugMenu();
 		DrawOutlinerDebugMenu();
 		DeviceDebugMenu();
+		ViewDebugMenu();
 
 		ImGui::EndTabBar();
 	}
@@ -457,6 +468,24 @@ void UpdateScene( Scene* scene )
 	ImGui::Text( "Frame Number: %d", g_renderDebugData.frameNumber );
 	ImGui::SameLine();
 	ImGui::Text( "FPS: %f", 1000.0f / g_renderDebugData.frameTimeMs );
+	ImGui::Text( "GPU: %4.3fms, resolution scale %3.0f%%", g_renderDebugData.gpuFrameTimeMs, 100.0f * g_renderDebugData.resolutionScale );
+	ImGui::Text( "Commit: %4.3fms", g_renderDebugData.commitTimeMs );
+	ImGui::Text( "Scene BVH: %u nodes, %u reinserted%s", g_renderDebugData.bvhNodeCount, g_renderDebugData.bvhReinsertCount, g_renderDebugData.bvhRebuilt ? ", rebuilt" : "" );
+	ImGui::Text( "Record: %4.3fms", g_renderDebugData.recordTimeMs );
+	ImGui::Text( "Render graph: %u barriers, %u tasks culled", g_renderDebugData.graphBarrierCount, g_renderDebugData.graphCulledTaskCount );
+	ImGui::Text( "Pipelines: %u built in %4.3fms, cache %s", g_renderDebugData.pipelineBuildCount, g_renderDebugData.pipelineBuildMs, ( g_renderDebugData.pipelineCacheBytes > 0 ) ? "warm" : "cold" );
+	ImGui::Text( "Pipelines compiling: %u, prewarmed: %u", g_renderDebugData.pipelineCompilesPending, g_renderDebugData.pipelinePrewarmCount );
+	ImGui::Text( "Descriptor writes: %u (%u descriptors)", g_renderDebugData.descriptorWriteCount, g_renderDebugData.descriptorCount );
+	if ( g_renderDebugData.shaderReloadCount > 0 ) {
+		ImGui::Text( "Shader reloads: %u, last %s", g_renderDebugData.shaderReloadCount, g_renderDebugData.lastShaderReload );
+	}
+	for ( uint32_t i = 0; i < MaxRecordThreads; ++i )
+	{
+		if ( g_renderDebugData.recordThreadTasks[ i ] == 0 ) {
+			continue;
+		}
+		ImGui::Text( "  Thread %u: %4.3fms (%u tasks)", i, g_renderDebugData.recordThreadMs[ i ], g_renderDebugData.recordThreadTasks[ i ] );
+	}
 
 	ImGui::End();
 #endif
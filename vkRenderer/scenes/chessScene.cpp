@@ -22,11 +22,13 @@
 */
 
 #include "chessScene.h"
+#include "../src/globals/sceneBvh.h"
 
 #if defined( USE_IMGUI )
 extern imguiControls_t	g_imguiControls;
 #endif
 extern Window			g_window;
+extern SceneBvh			g_sceneBvh;
 
 struct pieceMappingInfo_t {
 	const char* name;
@@ -168,13 +170,13 @@ void ChessScene::Update()
 	const float time = TotalTimeSeconds();
 	const float periodsPerSecond = 2.0f;
 
-	lights[ 0 ].pos = vec4f( 5.0f * cos( periodsPerSecond * time ), 5.0f * sin( periodsPerSecond * time ), 8.0f, 0.0f );
+	lights[ 0 ].pos = vec4f( 5.0f * cos( periodsPerSecond * time ), 5.0f * sin( periodsPerSecond * time ), 8.0f, 1.0f );
 
 	const mouse_t& mouse = g_window.input.GetMouse();
 	if ( ( mouse.centered == false ) && mouse.leftDown )
 	{
 		Ray ray = mainCamera->GetViewRay( vec2f( 0.5f * mouse.x + 0.5f, 0.5f * mouse.y + 0.5f ) );
-		selectedEntity = GetTracedEntity( ray );
+		selectedEntity = TraceEntity( this, g_sceneBvh, ray );
 	}
 
 	if ( selectedEntity != nullptr )
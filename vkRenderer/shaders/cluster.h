@@ -0,0 +1,46 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Clusters tile the viewport and split its depth range into exponential slices,
+// so every slice spans the same ratio of depths
+
+float ClusterSliceDepth( const view_t view, const uint slice )
+{
+    return view.nearClip * pow( view.farClip / view.nearClip, float( slice ) / float( ClusterSlices ) );
+}
+
+uint ClusterSlice( const view_t view, const float viewDepth )
+{
+    const float slice = log( max( viewDepth, view.nearClip ) / view.nearClip ) / log( view.farClip / view.nearClip );
+    return min( uint( slice * ClusterSlices ), ClusterSlices - 1 );
+}
+
+uint ClusterIndex( const view_t view, const vec2 fragCoord, const float viewDepth )
+{
+    const vec2 viewportMin = view.viewportRect.xy * view.dimensions.xy;
+    const vec2 viewportSize = view.viewportRect.zw * view.dimensions.xy;
+    const vec2 tileCoord = ( ( fragCoord - viewportMin ) / viewportSize ) * vec2( ClusterTilesX, ClusterTilesY );
+    const uvec2 tile = min( uvec2( max( tileCoord, vec2( 0.0f ) ) ), uvec2( ClusterTilesX - 1, ClusterTilesY - 1 ) );
+    const uint slice = ClusterSlice( view, viewDepth );
+    return ( slice * ClusterTilesY + tile.y ) * ClusterTilesX + tile.x;
+}
@@ -29,10 +29,24 @@
 #include "globals.h"
 
 PS_LAYOUT_STANDARD( sampler2D )
+MATERIAL_FEATURES_LAYOUT
+
+const float AlphaTestThreshold = 0.5f;
 
 void main()
 {
     const uint materialId = pushConstants.materialId;
 
+    // Must cut the same holes as the color pass that tests against this depth
+    if ( ( materialFeatures & MATERIAL_FEATURE_ALPHA_TEST ) != 0 )
+    {
+        const material_t material = materialUbo.materials[ materialId ];
+        const bool isTextured = ( material.textured != 0 ) && ( globals.isTextured != 0 );
+        const uint albedoTexId = isTextured ? material.textureId0 : globals.defaultAlbedoId;
+        if ( texture( texSampler[ albedoTexId ], fragTexCoord.xy ).a < AlphaTestThreshold ) {
+            discard;
+        }
+    }
+
 	outColor = vec4( 1.0, 0.0, 0.0, 1.0 );
 }
\ No newline at end of file
@@ -47,22 +47,28 @@ void main()
     const bool horizontal = ( imageProcess.generic0.x != 0.0f ) ? true : false;
 
     vec2 offset = dimensions.zw;
-    outColor = vec4( texture( codeSamplers[ 0 ], fragTexCoord.xy ).rgb * weights[ 0 ], 1.0f );
+
+    // Under dynamic resolution only the top-left of the source was rendered. Taps are clamped half a
+    // texel of the source inside it, the source is a single mip so its own size gives the texel.
+    const vec2 sourceTexel = 1.0f / vec2( textureSize( codeSamplers[ 0 ], 0 ) );
+    const vec2 maxTexCoord = globals.resolutionScale.xy - 0.5f * sourceTexel;
+
+    outColor = vec4( texture( codeSamplers[ 0 ], min( fragTexCoord.xy, maxTexCoord ) ).rgb * weights[ 0 ], 1.0f );
 
     if ( horizontal )
     {
         for ( uint i = 1; i < weightCount; ++i )
         {
-            outColor.rgb += texture( codeSamplers[ 0 ], fragTexCoord.xy + vec2( offset.x * i, 0.0 ) ).rgb * weights[ i ];
-            outColor.rgb += texture( codeSamplers[ 0 ], fragTexCoord.xy - vec2( offset.x * i, 0.0 ) ).rgb * weights[ i ];
+            outColor.rgb += texture( codeSamplers[ 0 ], min( fragTexCoord.xy + vec2( offset.x * i, 0.0 ), maxTexCoord ) ).rgb * weights[ i ];
+            outColor.rgb += texture( codeSamplers[ 0 ], min( fragTexCoord.xy - vec2( offset.x * i, 0.0 ), maxTexCoord ) ).rgb * weights[ i ];
         }
     }
     else
     {
         for ( uint i = 1; i < weightCount; ++i )
         {
-            outColor.rgb += texture( codeSamplers[ 0 ], fragTexCoord.xy + vec2( 0.0, offset.y * i ) ).rgb * weights[ i ];
-            outColor.rgb += texture( codeSamplers[ 0 ], fragTexCoord.xy - vec2( 0.0, offset.y * i ) ).rgb * weights[ i ];
+            outColor.rgb += texture( codeSamplers[ 0 ], min( fragTexCoord.xy + vec2( 0.0, offset.y * i ), maxTexCoord ) ).rgb * weights[ i ];
+            outColor.rgb += texture( codeSamplers[ 0 ], min( fragTexCoord.xy - vec2( 0.0, offset.y * i ), maxTexCoord ) ).rgb * weights[ i ];
         }
     }
 }
\ No newline at end of file
@@ -23,8 +23,26 @@
 
 #define MaxLights		128
 #define MaxMaterials	256
-#define MaxViews		6
-#define MaxSurfaces		1000
+#define MaxViews		17
+#define MaxHiZLevels	16
+
+#define ClusterTilesX		16
+#define ClusterTilesY		9
+#define ClusterSlices		24
+#define ClusterCount		( ClusterTilesX * ClusterTilesY * ClusterSlices )
+#define MaxClusterLights	31
+#define LightUnitDistance	6.0f
+#define ClusterStride		( MaxClusterLights + 1 )
+
+#define SURF_CULL_NO_OCCLUSION	( 1 << 0 )
+
+#define MATERIAL_FEATURE_NORMAL_MAP		( 1u << 0 )
+#define MATERIAL_FEATURE_SPECULAR_MAPS	( 1u << 1 )
+#define MATERIAL_FEATURE_ALPHA_TEST		( 1u << 2 )
+#define MATERIAL_FEATURE_SHADOWED		( 1u << 3 )
+#define MATERIAL_FEATURE_IBL			( 1u << 4 )
+#define MATERIAL_FEATURE_ALL			0x1Fu
+#define MATERIAL_FEATURES_SPEC_ID		0
 
 #define PI				3.14159265359f
 
@@ -33,10 +51,11 @@ struct light_t
 	vec4	lightPos;
 	vec4	intensity;
 	vec4	lightDir;
+	vec4	cascadeSplits;
 	uint	shadowViewId;
+	uint	cascadeCount;
+	float	radius;
 	uint	pad0;
-	uint	pad1;
-	uint	pad2;
 };
 
 struct material_t
@@ -70,18 +89,52 @@ struct view_t
 	mat4	viewMat;
 	mat4	projMat;
 	vec4	dimensions;
+	vec4	viewportRect;
 	uint	numLights;
-	uint	pad0;
-	uint	pad1;
-	uint	pad2;
+	float	nearClip;
+	float	farClip;
+	uint	numDirectionalLights;
 };
 
 struct surface_t
 {
 	mat4	model;
+	vec4	boundsCenter;
+	vec4	boundsExtent;
 	uint	diffuseIblCubeId;
 	uint	envCubeId;
-	uint	pad[14];
+	uint	drawId;
+	uint	cullFlags;
+	uint	pad[4];
+};
+
+struct drawCommand_t
+{
+	uint	indexCount;
+	uint	instanceCount;
+	uint	firstIndex;
+	int		vertexOffset;
+	uint	firstInstance;
+};
+
+struct hiZ_t
+{
+	mat4	viewMat;
+	mat4	projMat;
+	vec4	dimensions;
+	uint	levelCount;
+	uint	valid;
+	int		debugLevel;
+	uint	pad;
+	uvec4	levelOffsets[ MaxHiZLevels / 4 ];
+};
+
+struct cullStats_t
+{
+	uint	visible;
+	uint	frustumCulled;
+	uint	occlusionCulled;
+	uint	pad;
 };
 
 
@@ -102,9 +155,24 @@ struct surface_t
 
 #define MODEL_LAYOUT( S, N )				layout( set = S, binding = N ) buffer UniformBufferObject				\
 											{																		\
-												surface_t	surface[MaxSurfaces];										\
+												surface_t	surface[];												\
 											} ubo;
 
+#define DRAW_REMAP_LAYOUT( S, N )			layout( set = S, binding = N ) readonly buffer DrawRemapBuffer			\
+											{																		\
+												uint		objectIds[];											\
+											} drawRemap;
+
+#define HIZ_LAYOUT( S, N )					layout( set = S, binding = N ) readonly buffer HiZPyramidBuffer			\
+											{																		\
+												float		depth[];												\
+											} hiZPyramid;
+
+#define HIZ_PARMS_LAYOUT( S, N )			layout( set = S, binding = N ) uniform HiZParms							\
+											{																		\
+												hiZ_t		hiZ;													\
+											};
+
 #define GLOBALS_LAYOUT( S, N )				layout( set = S, binding = N ) uniform GlobalConstants					\
 											{																		\
 												vec4        time;													\
@@ -112,6 +180,7 @@ struct surface_t
 												vec4        shadowParms;											\
 												vec4        toneMap;												\
 												vec4        dof;													\
+												vec4        resolutionScale;										\
 												uint		numSamples;												\
 												uint		whiteId;												\
 												uint		blackId;												\
@@ -141,6 +210,14 @@ struct surface_t
 												TYPE	NAME[];														\
 											};
 
+#define CLUSTER_LIGHTS_LAYOUT( S, N )			layout( set = S, binding = N ) readonly buffer ClusterLightsBuffer		\
+											{																		\
+												uint		lightIds[];												\
+											} clusterLights;
+
+// Specialized per material when the pipeline is built, unspecialized modules keep every feature
+#define MATERIAL_FEATURES_LAYOUT			layout( constant_id = MATERIAL_FEATURES_SPEC_ID ) const uint materialFeatures = MATERIAL_FEATURE_ALL;
+
 #define SAMPLER_2D_LAYOUT( S, N )			layout( set = S, binding = N ) uniform sampler2D texSampler[];
 
 #define SAMPLER_CUBE_LAYOUT( S, N )			layout( set = S, binding = N ) uniform samplerCube cubeSamplers[];
@@ -149,7 +226,8 @@ struct surface_t
 
 #define CODE_IMAGE_CUBE_LAYOUT( S, N )		layout( set = S, binding = N ) uniform samplerCube codeCubeSamplers[];
 
-#define STENCIL_LAYOUT( S, N, SAMPLER )		layout( set = S, binding = N ) uniform SAMPLER stencilImage;
+// The stencil aspect only reads through an unsigned integer sampler
+#define STENCIL_LAYOUT( S, N )				layout( set = S, binding = N ) uniform usampler2D stencilImage;
 
 #define MATERIAL_LAYOUT( S, N )				layout( set = S, binding = N ) buffer MaterialBuffer					\
 											{																		\
@@ -193,9 +271,10 @@ struct surface_t
 											SAMPLER_CUBE_LAYOUT( 0, 3 )												\
 											MATERIAL_LAYOUT( 0, 4 )													\
 											MODEL_LAYOUT( 1, 0 )													\
+											DRAW_REMAP_LAYOUT( 1, 1 )												\
 											LIGHT_LAYOUT( 2, 0 )													\
 											CODE_IMAGE_LAYOUT( 2, 1, SAMPLER )										\
-											STENCIL_LAYOUT( 2, 2, SAMPLER )											\
+											STENCIL_LAYOUT( 2, 2 )													\
 											MATERIAL_PUSH_CONSTANTS													\
 											VS_IN																	\
 											VS_OUT
@@ -221,9 +300,10 @@ struct surface_t
 											SAMPLER_CUBE_LAYOUT( 0, 3 )												\
 											MATERIAL_LAYOUT( 0, 4 )													\
 											MODEL_LAYOUT( 1, 0 )													\
+											CLUSTER_LIGHTS_LAYOUT( 1, 4 )											\
 											LIGHT_LAYOUT( 2, 0 )													\
 											CODE_IMAGE_LAYOUT( 2, 1, SAMPLER )										\
-											STENCIL_LAYOUT( 2, 2, SAMPLER )											\
+											STENCIL_LAYOUT( 2, 2 )													\
 											MATERIAL_PUSH_CONSTANTS													\
 											PS_IN																	\
 											PS_OUT
@@ -236,5 +316,5 @@ struct surface_t
 											MATERIAL_LAYOUT( 0, 4 )													\
 											CODE_IMAGE_LAYOUT( 1, 0, SAMPLER )										\
 											CODE_IMAGE_CUBE_LAYOUT( 1, 1 )											\
-											STENCIL_LAYOUT( 1, 2, SAMPLER )											\
+											STENCIL_LAYOUT( 1, 2 )													\
 											IMAGE_CONSTANT_LAYOUT( 1, 3, TYPE, imageProcess )
\ No newline at end of file
@@ -103,3 +103,13 @@ vec3 ImportanceSampleGGX( vec2 Xi, vec3 N, float roughness )
     vec3 sampleVec = tangent * H.x + bitangent * H.y + N * H.z;
     return normalize( sampleVec );
 }
+
+// Inverse square falloff, windowed to reach zero at the light's radius so clusters can leave the light out past it.
+// Scaled to be 1 at LightUnitDistance so scene intensities keep meaning the same brightness.
+float LightAttenuation( const float distance, const float radius )
+{
+    const float ratio = distance / radius;
+    const float ratio2 = ratio * ratio;
+    const float window = clamp( 1.0f - ratio2 * ratio2, 0.0f, 1.0f );
+    return ( LightUnitDistance * LightUnitDistance ) * ( window * window ) / max( distance * distance, 0.01f );
+}
@@ -32,6 +32,14 @@
 
 PS_LAYOUT_STANDARD( sampler2D )
 PS_LAYOUT_MRT_1_OUT
+MATERIAL_FEATURES_LAYOUT
+
+#define HAS_FEATURE( F ) ( ( materialFeatures & F ) != 0 )
+
+const float AlphaTestThreshold = 0.5f;
+
+#include "shadow.h"
+#include "cluster.h"
 
 void main()
 {
@@ -43,9 +51,6 @@ void main()
 
 	const bool isTextured = ( material.textured != 0 ) && ( globals.isTextured != 0 );
     const uint albedoTexId = isTextured ? material.textureId0 : globals.defaultAlbedoId;
-    const uint normalTexId = isTextured ? material.textureId1 : globals.defaultNormalId;
-    const uint roughnessTexId = isTextured ? material.textureId2 : globals.defaultRoughnessId;
-    const uint metalnessTexId = isTextured ? material.textureId3 : globals.defaultMetalId;
 	
 	const vec3 diffuseColor = material.Kd.rgb;
     const vec3 specularColor = material.Ks.rgb;
@@ -58,14 +63,26 @@ void main()
     const vec3 modelOrigin = vec3( modelMat[ 3 ][ 0 ], modelMat[ 3 ][ 1 ], modelMat[ 3 ][ 2 ] );
 
     const vec4 albedoTex = SrgbToLinear( texture( texSampler[ albedoTexId ], fragTexCoord.xy ) );
-    const vec3 normalTex = 2.0f * texture( texSampler[ normalTexId ], fragTexCoord.xy ).rgb - vec3( 1.0f, 1.0f, 1.0f );
-    const vec4 roughnessTex = texture( texSampler[ roughnessTexId ], fragTexCoord.xy );
-    const vec4 metalnessTex = texture( texSampler[ metalnessTexId ], fragTexCoord.xy );
 
-    const float perceptualRoughness = globals.generic.y * roughnessTex.r;
+    if ( HAS_FEATURE( MATERIAL_FEATURE_ALPHA_TEST ) && ( albedoTex.a < AlphaTestThreshold ) ) {
+        discard;
+    }
+
+    // Untextured materials would sample the white default, skip the fetch
+    float roughnessScale = 1.0f;
+    if ( HAS_FEATURE( MATERIAL_FEATURE_SPECULAR_MAPS ) && isTextured ) {
+        roughnessScale = texture( texSampler[ material.textureId2 ], fragTexCoord.xy ).r;
+    }
+    const float perceptualRoughness = globals.generic.y * roughnessScale;
 
     const float blendFactor = 0.0f;
-    const vec3 normal = fragTangentBasis * mix( vec3( 0.0f, 0.0f, 1.0f ), normalTex, blendFactor );
+    vec3 tangentNormal = vec3( 0.0f, 0.0f, 1.0f );
+    if ( HAS_FEATURE( MATERIAL_FEATURE_NORMAL_MAP ) && isTextured )
+    {
+        const vec3 normalTex = 2.0f * texture( texSampler[ material.textureId1 ], fragTexCoord.xy ).rgb - vec3( 1.0f, 1.0f, 1.0f );
+        tangentNormal = mix( tangentNormal, normalTex, blendFactor );
+    }
+    const vec3 normal = fragTangentBasis * tangentNormal;
 
     const vec3 v = normalize( cameraOrigin.xyz - worldPosition.xyz );
     const vec3 n = normalize( normal ); // normalize( worldPosition.xyz - modelOrigin );
@@ -92,12 +109,20 @@ void main()
     vec3 F0 = vec3( 0.04f ); 
     F0 = mix( F0, albedoColor.rgb, metallic );
 	
+    const float viewDepth = abs( ( viewMat * vec4( worldPosition.xyz, 1.0f ) ).z );
+    const uint clusterBase = ClusterIndex( view, gl_FragCoord.xy, viewDepth ) * ClusterStride;
+    const uint clusterLightCount = clusterLights.lightIds[ clusterBase ];
+
     vec3 Lo = vec3( 0.0f, 0.0f, 0.0f );
-    for( int i = 0; i < view.numLights; ++i )
+    // Directional lights come first in the view's list, then the cluster's point lights
+    for( uint i = 0; i < ( view.numDirectionalLights + clusterLightCount ); ++i )
     {
-        const light_t light = lightUbo.lights[ i ];
+        const uint lightIx = ( i < view.numDirectionalLights ) ? i : clusterLights.lightIds[ clusterBase + 1 + i - view.numDirectionalLights ];
+        const light_t light = lightUbo.lights[ lightIx ];
 
-	    const vec3 l = normalize( light.lightPos.xyz - worldPosition.xyz );
+        // Directional lights have a zero w
+        const bool isDirectional = ( light.lightPos.w == 0.0f );
+	    const vec3 l = isDirectional ? normalize( -light.lightDir.xyz ) : normalize( light.lightPos.xyz - worldPosition.xyz );
         const vec3 h = normalize( v + l );
 
         const float NoL = max( dot( n, l ), 0.0f );
@@ -119,36 +144,12 @@ void main()
         const float spotAngle = dot( l, light.lightDir.xyz );
         const float spotFov = 0.5f;
                
-        const float distance    = length( l );
-        const float attenuation = 1.0f / ( distance * distance );
+        const float distance    = length( light.lightPos.xyz - worldPosition.xyz );
+        const float attenuation = isDirectional ? 1.0f : LightAttenuation( distance, light.radius );
         const float spotFalloff = 1.0f; // * smoothstep( 0.5f, 0.8f, spotAngle );
         const vec3 radiance     = attenuation * spotFalloff * light.intensity.rgb;
 
-        float shadowing = 1.0f;
-        const uint shadowViewId = light.shadowViewId;
-        if ( shadowViewId != 0xFF )
-        {
-            const view_t shadowView = viewUbo.views[ shadowViewId ];
-
-            const uint shadowMapTexId = shadowViewId;
-            vec4 lsPosition = shadowView.projMat * shadowView.viewMat * vec4( worldPosition.xyz, 1.0f );
-            lsPosition.xyz /= lsPosition.w;
-
-            const vec2 ndc = 0.5f * ( ( lsPosition.xy ) + 1.0f );
-            const float bias = 0.001f;
-            const float depth = ( lsPosition.z );
-
-            if ( length( ndc.xy - vec2( 0.5f ) ) < 0.5f )
-            {
-                const ivec2 shadowPixelLocation = ivec2( globals.shadowParms.yz * ndc.xy );
-                const float shadowValue = texture( codeSamplers[ shadowMapTexId ], ndc.xy ).r;
-                if ( shadowValue < ( depth - bias ) ) {
-                    shadowing = 1.0f - min( 1.0f, globals.shadowParms.w );
-                }
-            } else {
-                shadowing = 1.0f - min( 1.0f, globals.shadowParms.w );
-            }
-        }
+        const float shadowing = HAS_FEATURE( MATERIAL_FEATURE_SHADOWED ) ? ShadowVisibility( light, view, worldPosition.xyz, 0.001f ) : 1.0f;
 
         vec3 diffuse = ( ( kD * albedoColor.rgb ) / PI + Fr ) * radiance * NoL;
 
@@ -164,7 +165,11 @@ void main()
                             0.0f, 1.0f, 0.0f, 0.0f,
                             0.0f, 0.0f, 0.0f, 0.0f );
 
-    const vec3 irradiance = texture( cubeSamplers[ diffuseIBL ], (glslSpace * vec4( n, 0.0f )).xyz ).rgb * material.Ka.rgb;
+    // Ka scales the irradiance, materials without ambient skip the cube fetch
+    vec3 irradiance = vec3( 0.0f );
+    if ( HAS_FEATURE( MATERIAL_FEATURE_IBL ) ) {
+        irradiance = texture( cubeSamplers[ diffuseIBL ], (glslSpace * vec4( n, 0.0f )).xyz ).rgb * material.Ka.rgb;
+    }
     const vec3 diffuse = irradiance * albedoColor;
     const vec3 ambient = ( kD * diffuse ) * ao;
 
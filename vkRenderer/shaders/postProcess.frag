@@ -30,6 +30,8 @@
 #include "color.h"
 
 PS_LAYOUT_STANDARD( sampler2D )
+HIZ_LAYOUT( 1, 2 )
+HIZ_PARMS_LAYOUT( 1, 3 )
 
 void main()
 {
@@ -50,18 +52,22 @@ void main()
 	const vec3 right = normalize( vec3( viewMat[ 0 ][ 1 ], viewMat[ 1 ][ 1 ], viewMat[ 2 ][ 1 ] ) );
 	const vec3 viewVector = normalize( forward + fragTexCoord.x * up + fragTexCoord.y * right );
 
-	const ivec2 pixelLocation = ivec2( view.dimensions.xy * fragTexCoord.xy );
+	// The main view renders into the top-left of its targets under dynamic resolution, this pass upscales it.
+	// Clamped half a texel in so filtering never reaches the part that wasn't rendered.
+	const vec2 sceneTexCoord = min( fragTexCoord.xy * globals.resolutionScale.xy, globals.resolutionScale.xy - 0.5f * view.dimensions.zw );
+	const ivec2 pixelLocation = ivec2( view.dimensions.xy * sceneTexCoord );
 
+	// Stencil is resolved from sample zero with the main pass, outlined surfaces write 0x01
 	float stencilCoverage = 0;
-	stencilCoverage += texelFetch( codeSamplers[ textureId1 ], pixelLocation + ivec2( -1, -1 ), 0 ).g;
-	stencilCoverage += texelFetch( codeSamplers[ textureId1 ], pixelLocation + ivec2( 1, -1 ), 0 ).g;
-	stencilCoverage += texelFetch( codeSamplers[ textureId1 ], pixelLocation + ivec2( -1, 1 ), 0 ).g;
-	stencilCoverage += texelFetch( codeSamplers[ textureId1 ], pixelLocation + ivec2( 1, 1 ), 0 ).g;
+	stencilCoverage += ( texelFetch( stencilImage, pixelLocation + ivec2( -1, -1 ), 0 ).r == 1u ) ? 1.0f : 0.0f;
+	stencilCoverage += ( texelFetch( stencilImage, pixelLocation + ivec2( 1, -1 ), 0 ).r == 1u ) ? 1.0f : 0.0f;
+	stencilCoverage += ( texelFetch( stencilImage, pixelLocation + ivec2( -1, 1 ), 0 ).r == 1u ) ? 1.0f : 0.0f;
+	stencilCoverage += ( texelFetch( stencilImage, pixelLocation + ivec2( 1, 1 ), 0 ).r == 1u ) ? 1.0f : 0.0f;
 
 	stencilCoverage /= 4.0f;
 
 	vec4 sceneColor = vec4( 0.0f, 0.0f, 0.0f, 1.0f );
-	sceneColor.rgb = LinearToSrgb( texture( codeSamplers[ textureId0 ], fragTexCoord.xy, 0 ).rgb );
+	sceneColor.rgb = LinearToSrgb( texture( codeSamplers[ textureId0 ], sceneTexCoord, 0 ).rgb );
 
 	const vec4 uvColor = vec4( fragTexCoord.xy, 0.0f, 1.0f );
 	const float sceneDepth = texelFetch( codeSamplers[ textureId1 ], pixelLocation, 0 ).r;
@@ -75,8 +81,13 @@ void main()
 	float coc = ( sceneDepth - focalDepth ) / focalRange;
 	const int MAX_MIP_LEVELS = 3;
 	coc = clamp( coc, -1.0, 1.0f );
-	if ( enabled && ( coc < 0.0f ) ) {
-		sceneColor.rgb = LinearToSrgb( textureLod( codeSamplers[ textureId2 ], fragTexCoord.xy, int( -coc * MAX_MIP_LEVELS ) ).rgb );
+	if ( enabled && ( coc < 0.0f ) )
+	{
+		// Texels grow with each mip, so the half texel clamp is redone at the mip that's read
+		const int blurLod = int( -coc * MAX_MIP_LEVELS );
+		const vec2 blurTexel = 1.0f / vec2( textureSize( codeSamplers[ textureId2 ], blurLod ) );
+		const vec2 blurTexCoord = min( fragTexCoord.xy * globals.resolutionScale.xy, globals.resolutionScale.xy - 0.5f * blurTexel );
+		sceneColor.rgb = LinearToSrgb( textureLod( codeSamplers[ textureId2 ], blurTexCoord, blurLod ).rgb );
 	}
 
 	outColor.a = 1.0f;
@@ -85,4 +96,16 @@ void main()
 	} else {
 		outColor.rgb = globals.toneMap.rgb * sceneColor.rgb;
 	}
+
+	if ( hiZ.debugLevel >= 0 )
+	{
+		const uint level = min( uint( hiZ.debugLevel ), hiZ.levelCount - 1 );
+		const uvec2 levelSize = max( uvec2( hiZ.dimensions.xy ) >> level, uvec2( 1 ) );
+		const uvec2 texel = min( uvec2( fragTexCoord.xy * vec2( levelSize ) ), levelSize - 1 );
+		const uint offset = hiZ.levelOffsets[ level / 4 ][ level % 4 ];
+		const float hiZDepth = hiZPyramid.depth[ offset + texel.y * levelSize.x + texel.x ];
+
+		// Reverse-Z values bunch up near zero, stretch them so distant occluders are visible
+		outColor.rgb = vec3( sqrt( hiZDepth ) );
+	}
 }
\ No newline at end of file
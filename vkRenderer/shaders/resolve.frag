@@ -62,7 +62,7 @@ void main()
 	for ( int i = 0; i < int( globals.numSamples ); ++i )
 	{
 		outColor1.r += ( texelFetch( codeSamplers[ 1 ], pixelLocation, i ).r );
-		outColor1.g += floatBitsToUint( texelFetch( stencilImage, pixelLocation + ivec2( -1, -1 ), 0 ).r ) == 0x01 ? 1.0f : 0.0f;
+		outColor1.g += texelFetch( stencilImage, pixelLocation + ivec2( -1, -1 ), 0 ).r == 1u ? 1.0f : 0.0f;
 	}
 	outColor1.rgb /= globals.numSamples;
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Requires PS_LAYOUT_STANDARD, the shadow atlas is code image 0
+
+const uint ShadowAtlasTexId = 0;
+
+float ShadowVisibility( const light_t light, const view_t view, const vec3 worldPosition, const float bias )
+{
+    const uint shadowViewId = light.shadowViewId;
+    if ( shadowViewId == 0xFF ) {
+        return 1.0f;
+    }
+
+    const float shadowed = 1.0f - min( 1.0f, globals.shadowParms.w );
+    const bool isCascaded = ( light.cascadeCount > 0 );
+
+    // Cascades are picked by view depth, past the last split there is no shadow
+    uint cascadeIx = 0;
+    if ( isCascaded )
+    {
+        const float viewDepth = abs( ( view.viewMat * vec4( worldPosition, 1.0f ) ).z );
+        while ( ( cascadeIx < light.cascadeCount ) && ( viewDepth > light.cascadeSplits[ cascadeIx ] ) ) {
+            ++cascadeIx;
+        }
+        if ( cascadeIx >= light.cascadeCount ) {
+            return 1.0f;
+        }
+    }
+
+    const view_t shadowView = viewUbo.views[ shadowViewId + cascadeIx ];
+
+    vec4 lsPosition = shadowView.projMat * shadowView.viewMat * vec4( worldPosition, 1.0f );
+    lsPosition.xyz /= lsPosition.w;
+
+    const vec2 ndc = 0.5f * ( lsPosition.xy + 1.0f );
+    const float depth = lsPosition.z;
+
+    // Cascades cover a square, spot lights the circle of their cone
+    const bool inside = isCascaded ? all( lessThan( abs( ndc - vec2( 0.5f ) ), vec2( 0.5f ) ) ) : ( length( ndc - vec2( 0.5f ) ) < 0.5f );
+    if ( inside == false ) {
+        return isCascaded ? 1.0f : shadowed;
+    }
+
+    // Keep the filter footprint inside the view's tile
+    const vec4 tileRect = shadowView.viewportRect;
+    const vec2 halfTexel = 0.5f / globals.shadowParms.yz;
+    const vec2 tileMin = tileRect.xy + halfTexel;
+    const vec2 tileMax = tileRect.xy + tileRect.zw - halfTexel;
+    const vec2 atlasUv = clamp( tileRect.xy + ndc * tileRect.zw, tileMin, tileMax );
+
+    const float shadowValue = texture( codeSamplers[ ShadowAtlasTexId ], atlasUv ).r;
+    return ( shadowValue < ( depth - bias ) ) ? shadowed : 1.0f;
+}
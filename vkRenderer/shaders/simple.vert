@@ -32,7 +32,7 @@ VS_LAYOUT_STANDARD( sampler2D )
 
 void main()
 {
-	objectId = pushConstants.objectId + gl_InstanceIndex;
+	objectId = drawRemap.objectIds[ gl_InstanceIndex ];
 	const uint materialId = pushConstants.materialId;
 	const uint viewlId = pushConstants.viewId;
 
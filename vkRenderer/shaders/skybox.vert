@@ -32,7 +32,7 @@ VS_LAYOUT_STANDARD( sampler2D )
 
 void main()
 {
-	objectId = pushConstants.objectId;
+	objectId = drawRemap.objectIds[ gl_InstanceIndex ];
 	const uint viewlId = pushConstants.viewId;
 
 	const view_t view = viewUbo.views[ viewlId ];
@@ -28,9 +28,13 @@
 
 #include "globals.h"
 #include "color.h"
+#include "light.h"
 
 PS_LAYOUT_STANDARD( sampler2D )
 
+#include "shadow.h"
+#include "cluster.h"
+
 void main()
 {
     const uint materialId = pushConstants.materialId;
@@ -50,32 +54,25 @@ void main()
     const vec4 texColor = mix( texColor1, texColor0, smoothstep( 0.0f, 0.4f, blendValue ) );
     outColor = AMBIENT * texColor;
 
-    for( int i = 0; i < view.numLights; ++i )
+    const float viewDepth = abs( ( view.viewMat * vec4( worldPosition.xyz, 1.0f ) ).z );
+    const uint clusterBase = ClusterIndex( view, gl_FragCoord.xy, viewDepth ) * ClusterStride;
+    const uint clusterLightCount = clusterLights.lightIds[ clusterBase ];
+
+    // Directional lights come first in the view's list, then the cluster's point lights
+    for( uint i = 0; i < ( view.numDirectionalLights + clusterLightCount ); ++i )
     {
-	    const vec3 lightDist = -normalize( lightUbo.lights[ i ].lightPos.xyz - worldPosition.xyz );
-        const float spotAngle = dot( lightDist, lightUbo.lights[ i ].lightDir.xyz );
+        const uint lightIx = ( i < view.numDirectionalLights ) ? i : clusterLights.lightIds[ clusterBase + 1 + i - view.numDirectionalLights ];
+        const light_t light = lightUbo.lights[ lightIx ];
+        const bool isDirectional = ( light.lightPos.w == 0.0f );
+	    const vec3 lightDist = -normalize( light.lightPos.xyz - worldPosition.xyz );
+        const float spotAngle = isDirectional ? 1.0f : dot( lightDist, light.lightDir.xyz );
         const float spotFov = 0.5f;
+        const float attenuation = isDirectional ? 1.0f : LightAttenuation( length( light.lightPos.xyz - worldPosition.xyz ), light.radius );
         vec4 color = texColor;
         // color.rgb *= lights[ i ].intensity * max( 0.0f, dot( lightDist, normalize( fragNormal ) ) );
-	    color.rgb *= lightUbo.lights[ i ].intensity.rgb * smoothstep( 0.5f, 0.8f, spotAngle );
+	    color.rgb *= attenuation * light.intensity.rgb * smoothstep( 0.5f, 0.8f, spotAngle );
+        color.rgb *= ShadowVisibility( light, view, worldPosition.xyz, 0.0001f );
         outColor += color;
     }
    // outColor.rgb = fragNormal;
-
-    float visibility = 1.0f;
-    const uint shadowMapTexId = 0;
-    const uint shadowId = int( globals.shadowParms.x );
-    vec4 lsPosition = view.projMat * view.viewMat * vec4( worldPosition.xyz, 1.0f );
-    lsPosition.xyz /= lsPosition.w;
-    vec2 ndc = 0.5f * ( ( lsPosition.xy ) + 1.0f );
-    float bias = 0.0001f;
-    float depth = ( lsPosition.z );
-
-    const ivec2 pixelLocation = ivec2( globals.shadowParms.yz * ndc.xy );
-    const float shadowValue = texelFetch( codeSamplers[ shadowMapTexId ], pixelLocation, 0 ).r;
-    if( shadowValue < ( depth - bias ) ) // shadowed
-    {
-        visibility = globals.shadowParms.w;
-    }
-    outColor.rgb *= visibility; 
 }
\ No newline at end of file
@@ -57,7 +57,7 @@ mat3 GetTerrainTangent( vec2 uv )
 
 void main()
 {
-	objectId = pushConstants.objectId + gl_InstanceIndex;
+	objectId = drawRemap.objectIds[ gl_InstanceIndex ];
 	const uint materialId = pushConstants.materialId;
 	const uint viewlId = pushConstants.viewId;
 
@@ -0,0 +1,216 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "fileWatcher.h"
+#include <iostream>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if defined( _WIN32 )
+
+bool FileWatcher::Init( const std::string& directory )
+{
+	Shutdown();
+
+	HANDLE dirHandle = CreateFileA( directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr );
+	if ( dirHandle == INVALID_HANDLE_VALUE )
+	{
+		std::cout << "Couldn't watch \"" << directory << "\"." << std::endl;
+		return false;
+	}
+
+	OVERLAPPED* overlapped = new OVERLAPPED{};
+	overlapped->hEvent = CreateEventA( nullptr, TRUE, FALSE, nullptr );
+
+	m_directory = directory;
+	m_dirHandle = dirHandle;
+	m_overlapped = overlapped;
+
+	return IssueRead();
+}
+
+
+void FileWatcher::Shutdown()
+{
+	if ( m_dirHandle != nullptr )
+	{
+		CancelIo( m_dirHandle );
+		CloseHandle( m_dirHandle );
+		m_dirHandle = nullptr;
+	}
+
+	if ( m_overlapped != nullptr )
+	{
+		OVERLAPPED* overlapped = reinterpret_cast<OVERLAPPED*>( m_overlapped );
+		CloseHandle( overlapped->hEvent );
+		delete overlapped;
+		m_overlapped = nullptr;
+	}
+	m_pending.clear();
+}
+
+
+bool FileWatcher::IssueRead()
+{
+	OVERLAPPED* overlapped = reinterpret_cast<OVERLAPPED*>( m_overlapped );
+	ResetEvent( overlapped->hEvent );
+
+	const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+	if ( ReadDirectoryChangesW( m_dirHandle, m_events, EventBufferSize, FALSE, filter, nullptr, overlapped, nullptr ) == FALSE )
+	{
+		Shutdown();
+		return false;
+	}
+	return true;
+}
+
+
+void FileWatcher::ReadEvents()
+{
+	OVERLAPPED* overlapped = reinterpret_cast<OVERLAPPED*>( m_overlapped );
+
+	DWORD bytes = 0;
+	if ( GetOverlappedResult( m_dirHandle, overlapped, &bytes, FALSE ) == FALSE ) {
+		return;
+	}
+
+	const watchClock_t::time_point now = watchClock_t::now();
+
+	// Zero bytes means the buffer overflowed, the changes are lost until the next write
+	uint32_t offset = 0;
+	while ( bytes > 0 )
+	{
+		const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>( m_events + offset );
+
+		const int nameLength = static_cast<int>( info->FileNameLength / sizeof( WCHAR ) );
+		const int size = WideCharToMultiByte( CP_UTF8, 0, info->FileName, nameLength, nullptr, 0, nullptr, nullptr );
+
+		std::string name( size, '\0' );
+		WideCharToMultiByte( CP_UTF8, 0, info->FileName, nameLength, &name[ 0 ], size, nullptr, nullptr );
+		m_pending[ name ] = now;
+
+		if ( info->NextEntryOffset == 0 ) {
+			break;
+		}
+		offset += info->NextEntryOffset;
+	}
+
+	IssueRead();
+}
+
+#else
+
+bool FileWatcher::Init( const std::string& directory )
+{
+	Shutdown();
+
+	m_fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if ( m_fd < 0 ) {
+		return false;
+	}
+
+	// Compilers either write in place or rename a temp file over the target
+	m_watch = inotify_add_watch( m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO );
+	if ( m_watch < 0 )
+	{
+		std::cout << "Couldn't watch \"" << directory << "\"." << std::endl;
+		Shutdown();
+		return false;
+	}
+
+	m_directory = directory;
+	return true;
+}
+
+
+void FileWatcher::Shutdown()
+{
+	if ( m_fd >= 0 )
+	{
+		if ( m_watch >= 0 ) {
+			inotify_rm_watch( m_fd, m_watch );
+		}
+		close( m_fd );
+	}
+	m_fd = -1;
+	m_watch = -1;
+	m_pending.clear();
+}
+
+
+void FileWatcher::ReadEvents()
+{
+	alignas( inotify_event ) char buffer[ EventBufferSize ];
+
+	const watchClock_t::time_point now = watchClock_t::now();
+
+	while ( true )
+	{
+		const ssize_t bytes = read( m_fd, buffer, sizeof( buffer ) );
+		if ( bytes <= 0 ) {
+			break;
+		}
+
+		for ( ssize_t offset = 0; offset < bytes; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>( buffer + offset );
+			if ( ( event->len > 0 ) && ( ( event->mask & IN_ISDIR ) == 0 ) ) {
+				m_pending[ event->name ] = now;
+			}
+			offset += sizeof( inotify_event ) + event->len;
+		}
+	}
+}
+
+#endif
+
+
+void FileWatcher::Poll( std::vector<std::string>& changedFiles )
+{
+	if ( IsValid() == false ) {
+		return;
+	}
+
+	ReadEvents();
+
+	const watchClock_t::time_point now = watchClock_t::now();
+	const std::chrono::milliseconds settleTime( SettleTimeMs );
+
+	auto it = m_pending.begin();
+	while ( it != m_pending.end() )
+	{
+		if ( ( now - it->second ) < settleTime )
+		{
+			++it;
+			continue;
+		}
+		changedFiles.push_back( it->first );
+		it = m_pending.erase( it );
+	}
+}
@@ -0,0 +1,78 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+// Reports files written in a single directory. A change is held until the file has been quiet
+// for a moment so a compiler that's still writing it isn't read half way.
+class FileWatcher
+{
+private:
+	using watchClock_t = std::chrono::steady_clock;
+
+	static const uint32_t	SettleTimeMs = 100;
+	static const uint32_t	EventBufferSize = 4096;
+
+	std::string				m_directory;
+	std::unordered_map<std::string, watchClock_t::time_point> m_pending;
+
+#if defined( _WIN32 )
+	void*					m_dirHandle = nullptr;
+	void*					m_overlapped = nullptr;
+	alignas( 8 ) uint8_t	m_events[ EventBufferSize ];
+
+	bool					IssueRead();
+#else
+	int						m_fd = -1;
+	int						m_watch = -1;
+#endif
+
+	void					ReadEvents();
+
+public:
+	~FileWatcher()
+	{
+		Shutdown();
+	}
+
+	bool					Init( const std::string& directory );
+	void					Shutdown();
+
+	// Appends the names, relative to the directory, of files that settled since the last call
+	void					Poll( std::vector<std::string>& changedFiles );
+
+	inline bool IsValid() const
+	{
+#if defined( _WIN32 )
+		return ( m_dirHandle != nullptr );
+#else
+		return ( m_fd >= 0 );
+#endif
+	}
+};
@@ -0,0 +1,154 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "jobSystem.h"
+
+static thread_local uint32_t t_threadIndex = 0;
+
+void JobSystem::Init( const uint32_t workerCount )
+{
+	assert( m_running == false );
+	m_running = true;
+
+	m_workers.reserve( workerCount );
+	for ( uint32_t i = 0; i < workerCount; ++i ) {
+		m_workers.push_back( std::thread( &JobSystem::WorkerLoop, this, i + 1 ) );
+	}
+}
+
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_queueLock );
+		if ( m_running == false ) {
+			return;
+		}
+		m_running = false;
+	}
+	m_queueSignal.notify_all();
+
+	for ( size_t i = 0; i < m_workers.size(); ++i ) {
+		m_workers[ i ].join();
+	}
+	m_workers.clear();
+
+	// Drain anything left so waiters aren't stranded
+	while ( TryRunOne() ) {}
+}
+
+
+void JobSystem::Submit( const job_t& job, JobCounter* counter )
+{
+	assert( counter != nullptr );
+	counter->m_pending.fetch_add( 1, std::memory_order_relaxed );
+
+	// Without workers the caller is the only thread, run inline
+	if ( m_workers.empty() )
+	{
+		job();
+		counter->m_pending.fetch_sub( 1, std::memory_order_release );
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( m_queueLock );
+		m_queue.push_back( jobEntry_t{ job, counter } );
+	}
+	m_queueSignal.notify_one();
+}
+
+
+void JobSystem::Wait( JobCounter* counter )
+{
+	// The waiting thread steals work instead of sleeping
+	while ( counter->IsDone() == false )
+	{
+		if ( TryRunOne() == false ) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+bool JobSystem::TryRunOne()
+{
+	jobEntry_t entry;
+	{
+		std::lock_guard<std::mutex> lock( m_queueLock );
+		if ( m_queue.empty() ) {
+			return false;
+		}
+		entry = std::move( m_queue.front() );
+		m_queue.pop_front();
+	}
+
+	entry.func();
+	entry.counter->m_pending.fetch_sub( 1, std::memory_order_release );
+
+	return true;
+}
+
+
+void JobSystem::WorkerLoop( const uint32_t threadIndex )
+{
+	t_threadIndex = threadIndex;
+
+	while ( true )
+	{
+		jobEntry_t entry;
+		{
+			std::unique_lock<std::mutex> lock( m_queueLock );
+			m_queueSignal.wait( lock, [this] { return ( m_running == false ) || ( m_queue.empty() == false ); } );
+
+			if ( m_queue.empty() ) {
+				return;
+			}
+			entry = std::move( m_queue.front() );
+			m_queue.pop_front();
+		}
+
+		entry.func();
+		entry.counter->m_pending.fetch_sub( 1, std::memory_order_release );
+	}
+}
+
+
+uint32_t JobSystem::WorkerCount() const
+{
+	return static_cast<uint32_t>( m_workers.size() );
+}
+
+
+uint32_t JobSystem::DefaultWorkerCount()
+{
+	// Leave the calling thread free, it helps drain the queue in Wait()
+	const uint32_t hwThreads = std::thread::hardware_concurrency();
+	return ( hwThreads > 1 ) ? ( hwThreads - 1 ) : 0;
+}
+
+
+uint32_t JobSystem::ThreadIndex()
+{
+	return t_threadIndex;
+}
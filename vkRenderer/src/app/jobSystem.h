@@ -0,0 +1,92 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <assert.h>
+
+// Tracks completion of a batch of jobs. Must outlive every job submitted against it.
+class JobCounter
+{
+private:
+	std::atomic<uint32_t>	m_pending;
+
+	friend class JobSystem;
+
+public:
+	JobCounter() : m_pending( 0 )
+	{}
+
+	inline bool IsDone() const
+	{
+		return ( m_pending.load( std::memory_order_acquire ) == 0 );
+	}
+};
+
+
+class JobSystem
+{
+public:
+	using job_t = std::function<void()>;
+
+private:
+	struct jobEntry_t
+	{
+		job_t			func;
+		JobCounter*		counter;
+	};
+
+	std::vector<std::thread>	m_workers;
+	std::deque<jobEntry_t>		m_queue;
+	std::mutex					m_queueLock;
+	std::condition_variable		m_queueSignal;
+	bool						m_running = false;
+
+	bool						TryRunOne();
+	void						WorkerLoop( const uint32_t threadIndex );
+
+public:
+	~JobSystem()
+	{
+		Shutdown();
+	}
+
+	void						Init( const uint32_t workerCount );
+	void						Shutdown();
+
+	void						Submit( const job_t& job, JobCounter* counter );
+	void						Wait( JobCounter* counter );
+
+	uint32_t					WorkerCount() const;
+	static uint32_t				DefaultWorkerCount();
+
+	// 0 for threads outside the pool, 1 to WorkerCount() for workers
+	static uint32_t				ThreadIndex();
+};
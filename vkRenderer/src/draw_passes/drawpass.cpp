@@ -28,33 +28,6 @@
 
 extern renderConstants_t rc;
 
-void DrawPass::InsertResourceBarriers( CommandContext& cmdContext )
-{
-	const uint32_t codeImageCount = codeImages.Count();
-	for ( uint32_t i = 0; i < codeImageCount; ++i ) {
-		// HACK: depth-stencil transitions are creating validation issues
-		if ( ( codeImages[ i ]->info.aspect & IMAGE_ASPECT_DEPTH_FLAG ) != 0 ) {
-			continue;
-		}
-		if ( ( codeImages[ i ]->info.aspect & IMAGE_ASPECT_STENCIL_FLAG ) != 0 ) {
-			continue;
-		}
-		Transition( &cmdContext, *codeImages[ i ], GPU_IMAGE_READ, GPU_IMAGE_READ );
-	}
-
-	const uint32_t codeCubeImageCount = codeCubeImages.Count();
-	for ( uint32_t i = 0; i < codeCubeImageCount; ++i ) {
-		// HACK: depth-stencil transitions are creating validation issues
-		if ( ( codeCubeImages[ i ]->info.aspect & IMAGE_ASPECT_DEPTH_FLAG ) != 0 ) {
-			continue;
-		}
-		if ( ( codeCubeImages[ i ]->info.aspect & IMAGE_ASPECT_STENCIL_FLAG ) != 0 ) {
-			continue;
-		}
-		Transition( &cmdContext, *codeCubeImages[ i ], GPU_IMAGE_READ, GPU_IMAGE_READ );
-	}
-}
-
 void ShadowPass::Init( FrameBuffer* frameBuffer )
 {
 	m_name = "Shadow Pass";
@@ -124,7 +97,7 @@ void OpaquePass::Init( FrameBuffer* frameBuffer )
 	m_stateBits |= GFX_STATE_DEPTH_WRITE;
 	m_stateBits |= GFX_STATE_CULL_MODE_BACK;
 
-	codeImages.Resize( 3 );
+	codeImages.Resize( 1 );
 
 	SetFrameBuffer( frameBuffer );
 }
@@ -132,9 +105,7 @@ void OpaquePass::Init( FrameBuffer* frameBuffer )
 
 void OpaquePass::FrameBegin( const ResourceContext* resources )
 {
-	codeImages[ 0 ] = &resources->shadowMapImage[ 0 ];
-	codeImages[ 1 ] = &resources->shadowMapImage[ 1 ];
-	codeImages[ 2 ] = &resources->shadowMapImage[ 2 ];
+	codeImages[ 0 ] = &resources->shadowAtlasImage;
 
 	parms->Bind( bind_lightBuffer, &resources->lightParms );
 	parms->Bind( bind_imageCodeArray, &codeImages );
@@ -158,16 +129,14 @@ void TransPass::Init( FrameBuffer* frameBuffer )
 	m_stateBits |= GFX_STATE_CULL_MODE_BACK;
 	m_stateBits |= GFX_STATE_BLEND_ENABLE;
 
-	codeImages.Resize( 3 );
+	codeImages.Resize( 1 );
 
 	SetFrameBuffer( frameBuffer );
 }
 
 void TransPass::FrameBegin( const ResourceContext* resources )
 {
-	codeImages[ 0 ] = &resources->shadowMapImage[ 0 ];
-	codeImages[ 1 ] = &resources->shadowMapImage[ 1 ];
-	codeImages[ 2 ] = &resources->shadowMapImage[ 2 ];
+	codeImages[ 0 ] = &resources->shadowAtlasImage;
 
 	parms->Bind( bind_lightBuffer, &resources->lightParms );
 	parms->Bind( bind_imageCodeArray, &codeImages );
@@ -191,7 +160,7 @@ void EmissivePass::Init( FrameBuffer* frameBuffer )
 	m_stateBits |= GFX_STATE_CULL_MODE_BACK;
 	m_stateBits |= GFX_STATE_BLEND_ENABLE;
 
-	codeImages.Resize( 3 );
+	codeImages.Resize( 1 );
 
 	SetFrameBuffer( frameBuffer );
 }
@@ -199,9 +168,7 @@ void EmissivePass::Init( FrameBuffer* frameBuffer )
 
 void EmissivePass::FrameBegin( const ResourceContext* resources )
 {
-	codeImages[ 0 ] = &resources->shadowMapImage[ 0 ];
-	codeImages[ 1 ] = &resources->shadowMapImage[ 1 ];
-	codeImages[ 2 ] = &resources->shadowMapImage[ 2 ];
+	codeImages[ 0 ] = &resources->shadowAtlasImage;
 
 	parms->Bind( bind_lightBuffer, &resources->lightParms );
 	parms->Bind( bind_imageCodeArray, &codeImages );
@@ -232,8 +199,9 @@ void PostPass::Init( FrameBuffer* frameBuffer )
 void PostPass::FrameBegin( const ResourceContext* resources )
 {
 	codeImages[ 0 ] = &resources->mainColorResolvedImage;
-	codeImages[ 1 ] = &resources->depthStencilResolvedImage;
+	codeImages[ 1 ] = &resources->depthResolvedImageView;
 	codeImages[ 2 ] = &resources->blurredImage;
+	stencilImage = &resources->stencilResolvedImageView;
 
 	parms->Bind( bind_lightBuffer, &resources->lightParms );
 	parms->Bind( bind_imageCodeArray, &codeImages );
@@ -257,7 +225,7 @@ void TerrainPass::Init( FrameBuffer* frameBuffer )
 	m_stateBits |= GFX_STATE_DEPTH_WRITE;
 	m_stateBits |= GFX_STATE_CULL_MODE_BACK;
 
-	codeImages.Resize( 3 );
+	codeImages.Resize( 1 );
 
 	SetFrameBuffer( frameBuffer );
 }
@@ -265,9 +233,7 @@ void TerrainPass::Init( FrameBuffer* frameBuffer )
 
 void TerrainPass::FrameBegin( const ResourceContext* resources )
 {
-	codeImages[ 0 ] = &resources->shadowMapImage[ 0 ];
-	codeImages[ 1 ] = &resources->shadowMapImage[ 1 ];
-	codeImages[ 2 ] = &resources->shadowMapImage[ 2 ];
+	codeImages[ 0 ] = &resources->shadowAtlasImage;
 
 	parms->Bind( bind_lightBuffer, &resources->lightParms );
 	parms->Bind( bind_imageCodeArray, &codeImages );
@@ -352,7 +318,7 @@ void Debug2dPass::Init( FrameBuffer* frameBuffer )
 void Debug2dPass::FrameBegin( const ResourceContext* resources )
 {
 	codeImages[ 0 ] = &resources->mainColorResolvedImage;
-	codeImages[ 1 ] = &resources->depthStencilResolvedImage;
+	codeImages[ 1 ] = &resources->depthResolvedImageView;
 
 	parms->Bind( bind_lightBuffer, &resources->lightParms );
 	parms->Bind( bind_imageCodeArray, &codeImages );
@@ -102,10 +102,9 @@ public:
 		return m_fb;
 	}
 
-	void InsertResourceBarriers( CommandContext& cmdContext );
-
 	Array<const Image*, 100>	codeImages;
 	Array<const Image*, 100>	codeCubeImages;
+	const Image*				stencilImage = nullptr;	// Stencil the pass samples, placeholders bound to fill the slot aren't listed
 	ShaderBindParms*			parms;
 };
 
@@ -78,10 +78,21 @@ const uint32_t	DescriptorPoolMaxImages			= 1000;
 const uint32_t	DescriptorPoolMaxComboImages	= 1000;
 const uint32_t	DescriptorPoolMaxSets			= ( DescriptorPoolMaxUniformBuffers + DescriptorPoolMaxStorageBuffers + DescriptorPoolMaxImages + DescriptorPoolMaxComboImages );
 const uint32_t	MaxImageDescriptors				= 100;
+const uint32_t	MaxBindlessImages				= 4096;		// Texture table ceiling, lowered to the device's descriptor limits
+const uint32_t	BindlessReservedImages			= 64;		// Per-stage sampled images left for bindings outside the texture tables
+const uint32_t	BindlessTableCount				= 2;		// 2D and cube
 const uint32_t	MaxLights						= 128;
+const float		LightFalloffCutoff				= 0.05f;	// Intensity where a light's falloff is windowed to zero, sets its radius
+const float		LightUnitDistance				= 6.0f;		// Distance where a point light's falloff equals its intensity
+const uint32_t	ClusterTilesX					= 16;
+const uint32_t	ClusterTilesY					= 9;
+const uint32_t	ClusterSlices					= 24;
+const uint32_t	ClusterCount					= ( ClusterTilesX * ClusterTilesY * ClusterSlices );
+const uint32_t	MaxClusterLights				= 31;		// A cluster's count and light ids fill 32 words
 const uint32_t	MaxParticles					= 1024;
-const uint32_t	MaxShadowMaps					= 6;
+const uint32_t	MaxShadowMaps					= 8;
 const uint32_t	MaxShadowViews					= MaxShadowMaps;
+const uint32_t	MaxShadowCascades				= 4;
 const uint32_t	Max2DViews						= 2;
 const uint32_t	Max3DViews						= 7;
 const uint32_t	MaxViews						= ( MaxShadowViews + Max3DViews + Max2DViews );
@@ -89,6 +100,15 @@ const uint32_t	MaxModels						= 1000;
 const uint32_t	MaxVertices						= 0x000FFFFF;
 const uint32_t	MaxIndices						= 0x000FFFFF;
 const uint32_t	MaxSurfaces						= MaxModels;
+const uint32_t	MaxMeshLods						= 4;
+const float		LodPixelError					= 1.0f;
+const float		LodHysteresis					= 0.15f;	// Relative change of projected size before an instance may switch LOD
+const float		AlphaTestThreshold				= 0.5f;		// Mirrors the shaders, texels below it are discarded
+const uint32_t	LodRescanFrames					= 4;		// Minimum frames between LOD rescans caused by the eye moving
+const float		OpaqueResortDistance			= 0.01f;	// Eye travel, relative to the clip range, before opaque draws are re-sorted front-to-back
+const float		ShadowCascadeDistance			= 100.0f;
+const float		ShadowCascadeSplitBlend			= 0.75f;	// Weight of the logarithmic split scheme over the uniform one
+const float		ShadowCasterReach				= 100.0f;	// Distance toward the sun that casters are kept in front of a cascade
 const uint32_t	MaxSurfacesDescriptors			= 1;
 const uint32_t	MaxMaterials					= 256;
 const uint32_t	MaxCodeImages					= 3;
@@ -99,6 +119,10 @@ const uint64_t	MaxFrameBufferMemory			= GB( 2 );
 const uint32_t	MaxFrameStates					= 3;
 const uint64_t	MaxTimeStampQueries				= 12;
 const uint64_t	MaxOcclusionQueries				= 12;
+const uint32_t	HiZWidth						= 512;
+const uint32_t	HiZHeight						= 256;
+const uint32_t	MaxHiZLevels					= 16;
+const float		MinResolutionScale				= 0.5f;		// Per-axis floor of the main view under dynamic resolution
 const uint32_t	DefaultDisplayWidth				= 1280;
 const uint32_t	DefaultDisplayHeight			= 720;
 const bool		ForceDisableMSAA				= false;
@@ -109,9 +133,12 @@ const std::string CodeAssetPath = ".\\code_assets\\";
 const std::string ScreenshotPath = "..\\screenshots\\";
 const std::string MaterialPath = ".\\materials\\";
 const std::string BakePath = ".\\baked\\";
+const std::string ShaderBinPath = "shaders_bin/";	// Where GpuProgramLoader reads SPIR-V from
 const std::string BakedModelExtension = ".mdl.bin";
 const std::string BakedTextureExtension = ".img.bin";
 const std::string BakedMaterialExtension = ".mtl.bin";
+const std::string BakedLodExtension = ".lod.bin";
+const std::string PipelineCachePath = BakePath + "pipelines.cache.bin";
 
 uint32_t Hash( const uint8_t* bytes, const uint32_t sizeBytes );
 
@@ -153,6 +180,7 @@ struct imguiControls_t
 	float		dofFocalRange;
 	bool		dofEnable;
 	int			dbgImageId;
+	int			hiZDebugLevel;
 	int			selectedEntityId;
 	bool		rebuildShaders;
 	hdl_t		shaderHdl;
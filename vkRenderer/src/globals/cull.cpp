@@ -0,0 +1,182 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "cull.h"
+
+// Large enough to pass every plane test, small enough that |n| * extent stays finite
+static const float UnboundedExtent = 1.0e30f;
+
+
+void ExtractFrustumPlanes( const mat4x4f& viewProj, frustum_t& frustum )
+{
+	// Columns are taken through the matrix product so this holds regardless of storage order
+	const vec4f c0 = viewProj * vec4f( 1.0f, 0.0f, 0.0f, 0.0f );
+	const vec4f c1 = viewProj * vec4f( 0.0f, 1.0f, 0.0f, 0.0f );
+	const vec4f c2 = viewProj * vec4f( 0.0f, 0.0f, 1.0f, 0.0f );
+	const vec4f c3 = viewProj * vec4f( 0.0f, 0.0f, 0.0f, 1.0f );
+
+	// Gribb-Hartmann: clip-space row r, plane = row3 +/- row r.
+	// Depth uses -w <= z <= w, which is conservative for both [0,1] and reversed depth ranges.
+	const float sign[ 6 ] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+	const uint32_t row[ 6 ] = { 0, 0, 1, 1, 2, 2 };
+
+	for ( uint32_t i = 0; i < 6; ++i )
+	{
+		const uint32_t r = row[ i ];
+		frustum.nx[ i ] = c0[ 3 ] + sign[ i ] * c0[ r ];
+		frustum.ny[ i ] = c1[ 3 ] + sign[ i ] * c1[ r ];
+		frustum.nz[ i ] = c2[ 3 ] + sign[ i ] * c2[ r ];
+		frustum.d[ i ] = c3[ 3 ] + sign[ i ] * c3[ r ];
+	}
+}
+
+
+// Point shared by three planes, false if two of them are parallel
+static bool IntersectPlanes( const frustum_t& frustum, const uint32_t p0, const uint32_t p1, const uint32_t p2, vec3f& point )
+{
+	const vec3f n0 = vec3f( frustum.nx[ p0 ], frustum.ny[ p0 ], frustum.nz[ p0 ] );
+	const vec3f n1 = vec3f( frustum.nx[ p1 ], frustum.ny[ p1 ], frustum.nz[ p1 ] );
+	const vec3f n2 = vec3f( frustum.nx[ p2 ], frustum.ny[ p2 ], frustum.nz[ p2 ] );
+
+	const vec3f c12 = Cross( n1, n2 );
+	const float det = Dot( n0, c12 );
+	if ( fabsf( det ) < 1e-12f ) {
+		return false;
+	}
+
+	const vec3f c20 = Cross( n2, n0 );
+	const vec3f c01 = Cross( n0, n1 );
+	for ( uint32_t i = 0; i < 3; ++i ) {
+		point[ i ] = -( frustum.d[ p0 ] * c12[ i ] + frustum.d[ p1 ] * c20[ i ] + frustum.d[ p2 ] * c01[ i ] ) / det;
+	}
+	return true;
+}
+
+
+// Conservative: only reports no overlap when every corner of the volume is outside one plane of the frustum
+bool FrustumOverlaps( const frustum_t& volume, const frustum_t& frustum )
+{
+	vec3f corners[ 8 ];
+	for ( uint32_t i = 0; i < 8; ++i )
+	{
+		const uint32_t px = 0 + ( ( i >> 0 ) & 1 );
+		const uint32_t py = 2 + ( ( i >> 1 ) & 1 );
+		const uint32_t pz = 4 + ( ( i >> 2 ) & 1 );
+		if ( IntersectPlanes( volume, px, py, pz, corners[ i ] ) == false ) {
+			return true;
+		}
+	}
+
+	for ( uint32_t p = 0; p < 6; ++p )
+	{
+		uint32_t outsideCount = 0;
+		for ( uint32_t i = 0; i < 8; ++i )
+		{
+			const float dist = corners[ i ][ 0 ] * frustum.nx[ p ] + corners[ i ][ 1 ] * frustum.ny[ p ] + corners[ i ][ 2 ] * frustum.nz[ p ] + frustum.d[ p ];
+			outsideCount += ( dist < 0.0f ) ? 1 : 0;
+		}
+		if ( outsideCount == 8 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void CullBounds::Reset()
+{
+	m_centerX.clear();
+	m_centerY.clear();
+	m_centerZ.clear();
+	m_extentX.clear();
+	m_extentY.clear();
+	m_extentZ.clear();
+	m_count = 0;
+}
+
+
+void CullBounds::Append( const AABB& localBounds, const mat4x4f& transform )
+{
+	const vec3f& boundsMin = localBounds.GetMin();
+	const vec3f& boundsMax = localBounds.GetMax();
+	if ( ( boundsMin[ 0 ] > boundsMax[ 0 ] ) || ( boundsMin[ 1 ] > boundsMax[ 1 ] ) || ( boundsMin[ 2 ] > boundsMax[ 2 ] ) )
+	{
+		AppendUnbounded();
+		return;
+	}
+
+	const vec3f localExtent = 0.5f * ( boundsMax - boundsMin );
+
+	// Arvo: world extent is |M| applied to the local extent
+	const vec4f center = transform * vec4f( localBounds.GetCenter(), 1.0f );
+	const vec4f axisX = transform * vec4f( 1.0f, 0.0f, 0.0f, 0.0f );
+	const vec4f axisY = transform * vec4f( 0.0f, 1.0f, 0.0f, 0.0f );
+	const vec4f axisZ = transform * vec4f( 0.0f, 0.0f, 1.0f, 0.0f );
+
+	m_centerX.push_back( center[ 0 ] );
+	m_centerY.push_back( center[ 1 ] );
+	m_centerZ.push_back( center[ 2 ] );
+	m_extentX.push_back( fabsf( axisX[ 0 ] ) * localExtent[ 0 ] + fabsf( axisY[ 0 ] ) * localExtent[ 1 ] + fabsf( axisZ[ 0 ] ) * localExtent[ 2 ] );
+	m_extentY.push_back( fabsf( axisX[ 1 ] ) * localExtent[ 0 ] + fabsf( axisY[ 1 ] ) * localExtent[ 1 ] + fabsf( axisZ[ 1 ] ) * localExtent[ 2 ] );
+	m_extentZ.push_back( fabsf( axisX[ 2 ] ) * localExtent[ 0 ] + fabsf( axisY[ 2 ] ) * localExtent[ 1 ] + fabsf( axisZ[ 2 ] ) * localExtent[ 2 ] );
+	++m_count;
+}
+
+
+void CullBounds::AppendUnbounded()
+{
+	m_centerX.push_back( 0.0f );
+	m_centerY.push_back( 0.0f );
+	m_centerZ.push_back( 0.0f );
+	m_extentX.push_back( UnboundedExtent );
+	m_extentY.push_back( UnboundedExtent );
+	m_extentZ.push_back( UnboundedExtent );
+	++m_count;
+}
+
+
+uint32_t CullBounds::Count() const
+{
+	return m_count;
+}
+
+
+vec3f CullBounds::Center( const uint32_t ix ) const
+{
+	assert( ix < m_count );
+	return vec3f( m_centerX[ ix ], m_centerY[ ix ], m_centerZ[ ix ] );
+}
+
+
+vec3f CullBounds::Extent( const uint32_t ix ) const
+{
+	assert( ix < m_count );
+	return vec3f( m_extentX[ ix ], m_extentY[ ix ], m_extentZ[ ix ] );
+}
+
+
+bool CullBounds::IsUnbounded( const uint32_t ix ) const
+{
+	assert( ix < m_count );
+	return ( m_extentX[ ix ] >= UnboundedExtent );
+}
@@ -0,0 +1,65 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+#include "common.h"
+
+struct frustum_t
+{
+	// Plane i is ( nx[ i ], ny[ i ], nz[ i ], d[ i ] ), normal pointing inward
+	float	nx[ 6 ];
+	float	ny[ 6 ];
+	float	nz[ 6 ];
+	float	d[ 6 ];
+};
+
+
+// World-space entity bounds stored as center/extent streams
+class CullBounds
+{
+private:
+	std::vector<float>	m_centerX;
+	std::vector<float>	m_centerY;
+	std::vector<float>	m_centerZ;
+	std::vector<float>	m_extentX;
+	std::vector<float>	m_extentY;
+	std::vector<float>	m_extentZ;
+	uint32_t			m_count;
+
+public:
+	CullBounds()
+	{
+		m_count = 0;
+	}
+
+	void				Reset();
+	void				Append( const AABB& localBounds, const mat4x4f& transform );
+	void				AppendUnbounded();
+	uint32_t			Count() const;
+	vec3f				Center( const uint32_t ix ) const;
+	vec3f				Extent( const uint32_t ix ) const;
+	bool				IsUnbounded( const uint32_t ix ) const;
+};
+
+void		ExtractFrustumPlanes( const mat4x4f& viewProj, frustum_t& frustum );
+bool		FrustumOverlaps( const frustum_t& volume, const frustum_t& frustum );
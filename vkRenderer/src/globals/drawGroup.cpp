@@ -1,75 +1,261 @@
-#include <numeric>
 #include "DrawGroup.h"
 #include "../render_core/renderer.h"
 
-void DrawGroup::Sort()
+// LSD radix sort of ( key, index ) pairs, 8 bits per pass. Passes where every key has the same digit are skipped.
+// Sorted pairs are left in keys[ 0 ]/indices[ 0 ].
+static void RadixSort( sortKey_t* keys[ 2 ], uint32_t* indices[ 2 ], const uint32_t count )
 {
-	class Comparator
+	const uint32_t RadixBits = 8;
+	const uint32_t RadixSize = ( 1 << RadixBits );
+	const uint32_t PassCount = ( 64 / RadixBits );
+
+	uint32_t histogram[ PassCount ][ RadixSize ];
+	memset( histogram, 0, sizeof( histogram ) );
+
+	for ( uint32_t i = 0; i < count; ++i )
 	{
-	private:
-		DrawGroup* drawgroup;
-	public:
-		Comparator( DrawGroup* drawgroup ) : drawgroup( drawgroup ) {}
-		bool operator()( const uint32_t ix0, const uint32_t ix1 )
+		const sortKey_t key = keys[ 0 ][ i ];
+		for ( uint32_t pass = 0; pass < PassCount; ++pass ) {
+			++histogram[ pass ][ ( key >> ( pass * RadixBits ) ) & ( RadixSize - 1 ) ];
+		}
+	}
+
+	uint32_t src = 0;
+	for ( uint32_t pass = 0; pass < PassCount; ++pass )
+	{
+		uint32_t* digitCounts = histogram[ pass ];
+		const uint32_t shift = pass * RadixBits;
+
+		if ( digitCounts[ ( keys[ src ][ 0 ] >> shift ) & ( RadixSize - 1 ) ] == count ) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for ( uint32_t digit = 0; digit < RadixSize; ++digit )
+		{
+			const uint32_t digitCount = digitCounts[ digit ];
+			digitCounts[ digit ] = offset;
+			offset += digitCount;
+		}
+
+		const uint32_t dst = ( src ^ 1 );
+		for ( uint32_t i = 0; i < count; ++i )
 		{
-			const auto lhs = drawgroup->surfaces[ ix0 ].sortKey.key;
-			const auto rhs = drawgroup->surfaces[ ix1 ].sortKey.key;
-			return ( lhs < rhs );
+			const sortKey_t key = keys[ src ][ i ];
+			const uint32_t dstIx = digitCounts[ ( key >> shift ) & ( RadixSize - 1 ) ]++;
+			keys[ dst ][ dstIx ] = key;
+			indices[ dst ][ dstIx ] = indices[ src ][ i ];
 		}
-	};
+		src = dst;
+	}
 
-	std::vector<uint32_t> sortIndices( committedModelCount );
-	std::iota( sortIndices.begin(), sortIndices.end(), 0 );
+	if ( src != 0 )
+	{
+		memcpy( keys[ 0 ], keys[ 1 ], count * sizeof( sortKey_t ) );
+		memcpy( indices[ 0 ], indices[ 1 ], count * sizeof( uint32_t ) );
+	}
+}
 
-	std::sort( sortIndices.begin(), sortIndices.end(), Comparator( this ) );
 
-	for ( uint32_t srcIndex = 0; srcIndex < committedModelCount; ++srcIndex )
+void DrawGroup::Grow()
+{
+	assert( allocator != nullptr );
+
+	// Outgrown streams stay in the arena until the next reset
+	const uint32_t newCapacity = ( capacity == 0 ) ? 64 : ( 2 * capacity );
+
+	sortKey_t* newSortKeys = allocator->Alloc<sortKey_t>( newCapacity );
+	drawSurf_t* newSurfaces = allocator->Alloc<drawSurf_t>( newCapacity );
+	mat4x4f* newTransforms = allocator->Alloc<mat4x4f>( newCapacity );
+	uint32_t* newEntityIds = allocator->Alloc<uint32_t>( newCapacity );
+	const char** newDbgNames = allocator->Alloc<const char*>( newCapacity );
+
+	if ( committedModelCount > 0 )
 	{
-		const uint32_t dstIndex = sortIndices[ srcIndex ];
-		sortedSurfaces[ dstIndex ] = surfaces[ srcIndex ];
-		sortedInstances[ dstIndex ] = instances[ srcIndex ];
+		memcpy( newSortKeys, sortKeys, committedModelCount * sizeof( sortKey_t ) );
+		memcpy( newSurfaces, surfaces, committedModelCount * sizeof( drawSurf_t ) );
+		memcpy( newTransforms, transforms, committedModelCount * sizeof( mat4x4f ) );
+		memcpy( newEntityIds, entityIds, committedModelCount * sizeof( uint32_t ) );
+		memcpy( newDbgNames, dbgNames, committedModelCount * sizeof( const char* ) );
+	}
+
+	sortKeys = newSortKeys;
+	surfaces = newSurfaces;
+	transforms = newTransforms;
+	entityIds = newEntityIds;
+	dbgNames = newDbgNames;
+	capacity = newCapacity;
+}
+
+
+void DrawGroup::Sort()
+{
+	if ( committedModelCount == 0 ) {
+		return;
 	}
+
+	sortOrder = allocator->Alloc<uint32_t>( committedModelCount );
+	for ( uint32_t i = 0; i < committedModelCount; ++i ) {
+		sortOrder[ i ] = i;
+	}
+
+	// Sorts the committed key stream in place, nothing reads it in Add() order afterwards
+	sortKey_t* keys[ 2 ] = { sortKeys, allocator->Alloc<sortKey_t>( committedModelCount ) };
+	uint32_t* indices[ 2 ] = { sortOrder, allocator->Alloc<uint32_t>( committedModelCount ) };
+	RadixSort( keys, indices, committedModelCount );
 }
 
 
-void DrawGroup::Merge()
+// Single pass over the sorted surfaces. Each one is looked up by draw state in an open addressing
+// table from the arena. Probes compare the full state, so hash collisions never merge different surfaces.
+// Merged surfaces keep the order of their first sorted instance. State ordered groups are then regrouped
+// so that each pipeline and material is one contiguous bucket, whatever the depth of its instances.
+void DrawGroup::Merge( const bool depthOrdered )
 {
 	mergedModelCount = 0;
-	std::unordered_map< uint32_t, uint32_t > uniqueSurfs;
-	uniqueSurfs.reserve( committedModelCount );
+	if ( committedModelCount == 0 ) {
+		return;
+	}
 
-	uint32_t surfaceHashes[ MaxSurfaces ];
-	for ( uint32_t i = 0; i < committedModelCount; ++i ) {
-		surfaceHashes[ i ] = Hash( sortedSurfaces[ i ] );
+	uint32_t tableSize = 16;
+	while ( tableSize < ( 2 * committedModelCount ) ) {
+		tableSize *= 2;
 	}
+	const uint32_t tableMask = ( tableSize - 1 );
+	const uint32_t emptySlot = ~0u;
 
-	for ( uint32_t i = 0; i < committedModelCount; ++i ) {
-		drawSurfInstance_t& instance = sortedInstances[ i ];
-		auto it = uniqueSurfs.find( surfaceHashes[ i ] );
-		if ( it == uniqueSurfs.end() ) {
+	uint32_t* table = allocator->Alloc<uint32_t>( tableSize );
+	memset( table, 0xFF, tableSize * sizeof( uint32_t ) );
+
+	merged = allocator->Alloc<drawSurf_t>( committedModelCount );
+	mergedFirst = allocator->Alloc<uint32_t>( committedModelCount );
+	instanceCounts = allocator->Alloc<uint32_t>( committedModelCount );
+	objectIds = allocator->Alloc<uint32_t>( committedModelCount );
+
+	// objectIds first holds the merged draw of each instance, then its final offset
+	uint32_t* localIds = allocator->Alloc<uint32_t>( committedModelCount );
+
+	for ( uint32_t i = 0; i < committedModelCount; ++i )
+	{
+		const uint32_t srcIx = sortOrder[ i ];
+		const drawSurf_t& surf = surfaces[ srcIx ];
+
+		uint32_t slot = Hash( surf ) & tableMask;
+		while ( ( table[ slot ] != emptySlot ) && ( SameDrawState( merged[ table[ slot ] ], surf ) == false ) ) {
+			slot = ( slot + 1 ) & tableMask;
+		}
+
+		if ( table[ slot ] == emptySlot )
+		{
 			const uint32_t surfId = mergedModelCount;
-			uniqueSurfs[ surfaceHashes[ i ] ] = surfId;
+			table[ slot ] = surfId;
 
+			merged[ surfId ] = surf;
+			mergedFirst[ surfId ] = srcIx;
 			instanceCounts[ surfId ] = 1;
-			merged[ surfId ] = sortedSurfaces[ i ];
 
-			instance.id = 0;
-			instance.surfId = surfId;
+			objectIds[ i ] = surfId;
+			localIds[ i ] = 0;
 
 			++mergedModelCount;
 		}
-		else {
-			instance.id = instanceCounts[ it->second ];
-			instance.surfId = it->second;
-			instanceCounts[ it->second ]++;
+		else
+		{
+			const uint32_t surfId = table[ slot ];
+			objectIds[ i ] = surfId;
+			localIds[ i ] = instanceCounts[ surfId ]++;
 		}
 	}
+
+	if ( depthOrdered == false ) {
+		GroupBuckets();
+	}
+
 	uint32_t totalCount = 0;
 	for ( uint32_t i = 0; i < mergedModelCount; ++i )
 	{
 		merged[ i ].objectOffset += totalCount;
 		totalCount += instanceCounts[ i ];
 	}
+
+	for ( uint32_t i = 0; i < committedModelCount; ++i ) {
+		objectIds[ i ] = merged[ objectIds[ i ] ].objectOffset + localIds[ i ];
+	}
+}
+
+
+// Counting scatter by bucket, stable so draws of a bucket stay front-to-back. Buckets are placed in
+// order of first appearance. Sort keys only hold a few bits of the pipeline handle, hashing the full
+// state keeps colliding pipelines out of each other's bucket.
+void DrawGroup::GroupBuckets()
+{
+	uint32_t tableSize = 16;
+	while ( tableSize < ( 2 * mergedModelCount ) ) {
+		tableSize *= 2;
+	}
+	const uint32_t tableMask = ( tableSize - 1 );
+	const uint32_t emptySlot = ~0u;
+
+	uint32_t* table = allocator->Alloc<uint32_t>( tableSize );
+	memset( table, 0xFF, tableSize * sizeof( uint32_t ) );
+
+	uint32_t* bucketIds = allocator->Alloc<uint32_t>( mergedModelCount );
+	uint32_t* bucketFirst = allocator->Alloc<uint32_t>( mergedModelCount );
+	uint32_t* bucketOffsets = allocator->Alloc<uint32_t>( mergedModelCount );
+	uint32_t bucketCount = 0;
+
+	for ( uint32_t i = 0; i < mergedModelCount; ++i )
+	{
+		uint32_t slot = BucketHash( merged[ i ] ) & tableMask;
+		while ( ( table[ slot ] != emptySlot ) && ( SameBucket( merged[ bucketFirst[ table[ slot ] ] ], merged[ i ] ) == false ) ) {
+			slot = ( slot + 1 ) & tableMask;
+		}
+
+		if ( table[ slot ] == emptySlot )
+		{
+			table[ slot ] = bucketCount;
+			bucketFirst[ bucketCount ] = i;
+			bucketOffsets[ bucketCount ] = 0;
+			++bucketCount;
+		}
+
+		bucketIds[ i ] = table[ slot ];
+		++bucketOffsets[ bucketIds[ i ] ];
+	}
+
+	uint32_t offset = 0;
+	for ( uint32_t i = 0; i < bucketCount; ++i )
+	{
+		const uint32_t count = bucketOffsets[ i ];
+		bucketOffsets[ i ] = offset;
+		offset += count;
+	}
+
+	uint32_t* order = allocator->Alloc<uint32_t>( mergedModelCount );
+	for ( uint32_t i = 0; i < mergedModelCount; ++i ) {
+		order[ bucketOffsets[ bucketIds[ i ] ]++ ] = i;
+	}
+
+	drawSurf_t* sortedMerged = allocator->Alloc<drawSurf_t>( committedModelCount );
+	uint32_t* sortedFirst = allocator->Alloc<uint32_t>( committedModelCount );
+	uint32_t* sortedCounts = allocator->Alloc<uint32_t>( committedModelCount );
+	uint32_t* remap = allocator->Alloc<uint32_t>( mergedModelCount );
+
+	for ( uint32_t i = 0; i < mergedModelCount; ++i )
+	{
+		sortedMerged[ i ] = merged[ order[ i ] ];
+		sortedFirst[ i ] = mergedFirst[ order[ i ] ];
+		sortedCounts[ i ] = instanceCounts[ order[ i ] ];
+		remap[ order[ i ] ] = i;
+	}
+
+	for ( uint32_t i = 0; i < committedModelCount; ++i ) {
+		objectIds[ i ] = remap[ objectIds[ i ] ];
+	}
+
+	merged = sortedMerged;
+	mergedFirst = sortedFirst;
+	instanceCounts = sortedCounts;
 }
 
 
@@ -78,7 +264,17 @@ void DrawGroup::AssignGeometryResources( const GeometryContext* context )
 	geo = context;
 
 	// Cache upload records
-	for ( uint32_t i = 0; i < mergedModelCount; ++i ) {
+	uploads = ( mergedModelCount > 0 ) ? allocator->Alloc<surfaceUpload_t>( mergedModelCount ) : nullptr;
+	for ( uint32_t i = 0; i < mergedModelCount; ++i )
+	{
 		uploads[ i ] = geo->surfUploads[ merged[ i ].uploadId ];
+
+		// Draws read the index range of the selected level
+		const uint32_t lod = merged[ i ].lod;
+		if ( lod < uploads[ i ].lodCount )
+		{
+			uploads[ i ].firstIndex = uploads[ i ].lods[ lod ].firstIndex;
+			uploads[ i ].indexCount = uploads[ i ].lods[ lod ].indexCount;
+		}
 	}
 }
\ No newline at end of file
@@ -3,67 +3,109 @@
 #include <cstdint>
 #include <gfxcore/scene/scene.h>
 #include "common.h"
+#include "linearAllocator.h"
 
 class GpuBuffer;
 class ShaderBindParms;
 class GeometryContext;
 
-const static uint32_t KeyMaterialBits = 32;
+const static uint32_t KeyPipelineBits = 16;
+const static uint32_t KeyMaterialBits = 16;
 const static uint32_t KeyStencilBits = 8;
-const static uint32_t KeyVisBits = 1;
+const static uint32_t KeyDepthBits = 24;
+static_assert( ( KeyPipelineBits + KeyMaterialBits + KeyStencilBits + KeyDepthBits ) == 64, "Sort key must fill 64 bits" );
+
+// Index range of one simplified level. Error is relative to the surface bounding radius.
+struct surfaceLod_t
+{
+	uint32_t					firstIndex;
+	uint32_t					indexCount;
+	float						error;
+};
+
 
 struct surfaceUpload_t
 {
-	surfaceUpload_t() : vertexCount( 0 ), indexCount( 0 ), vertexOffset( 0 ), firstIndex( 0 ) {}
+	surfaceUpload_t() : vertexCount( 0 ), indexCount( 0 ), vertexOffset( 0 ), firstIndex( 0 ), lodCount( 0 )
+	{
+		memset( lods, 0, sizeof( lods ) );
+	}
 
 	uint32_t					vertexCount;
 	uint32_t					indexCount;
 	uint32_t					vertexOffset;
 	uint32_t					firstIndex;
+	uint32_t					lodCount;
+	surfaceLod_t				lods[ MaxMeshLods ];	// All levels share the vertex range
 };
 
 
-union sortKey_t
+using sortKey_t = uint64_t;
+
+
+// State-major for opaque passes so pipeline and material binds are grouped, then front-to-back within a state.
+// Blended passes put inverted depth in the high bits to draw back-to-front.
+// Depth is normalized view distance in [0, 1].
+inline sortKey_t MakeSortKey( const hdl_t pipelineObject, const uint32_t materialId, const uint32_t stencilBit, const float depth, const bool backToFront )
 {
-	struct
+	const uint64_t maxDepth = ( 1ull << KeyDepthBits ) - 1;
+
+	assert( materialId < ( 1ull << KeyMaterialBits ) );
+	assert( stencilBit < ( 1ull << KeyStencilBits ) );
+
+	// The pipeline handle is a hash, any of its bits group identical pipelines
+	const uint64_t pipelineBits = pipelineObject.Get() & ( ( 1ull << KeyPipelineBits ) - 1 );
+	const uint64_t stateBits = ( pipelineBits << ( KeyMaterialBits + KeyStencilBits ) ) | ( uint64_t( materialId ) << KeyStencilBits ) | uint64_t( stencilBit );
+
+	const float clampedDepth = ( depth < 0.0f ) ? 0.0f : ( ( depth > 1.0f ) ? 1.0f : depth );
+	uint64_t depthBits = static_cast<uint64_t>( clampedDepth * maxDepth );
+
+	if ( backToFront )
 	{
-		uint64_t	materialId	: KeyMaterialBits;
-		uint64_t	stencilBit	: KeyStencilBits;
-		uint64_t	visible		: KeyVisBits;
-	};
-	uint64_t	key;
-};
+		depthBits = maxDepth - depthBits;
+		return ( depthBits << ( 64 - KeyDepthBits ) ) | stateBits;
+	}
+	return ( stateBits << KeyDepthBits ) | depthBits;
+}
 
 
+// Hot draw state. Debug names are kept in a separate stream by DrawGroup.
 struct drawSurf_t
 {
 	sortKey_t			sortKey;
+	hdl_t				pipelineObject;
 	uint32_t			uploadId;
 	uint32_t			objectOffset;
 	renderFlags_t		flags;
+	uint32_t			materialId;
 	uint8_t				stencilBit;
-
-	const char*			dbgName;
-
-	hdl_t				pipelineObject;
+	uint8_t				lod;
 };
 static_assert( sizeof( drawSurf_t ) == 40, "Informative" );
 
 
+// Hashes the draw state only. The sort key is left out so that instances at different depths still merge.
 inline uint32_t Hash( const drawSurf_t& surf ) {
-	uint64_t shaderIds;
-	shaderIds = surf.pipelineObject.Get();
-	uint32_t shaderHash = Hash( reinterpret_cast<const uint8_t*>( &shaderIds ), sizeof( shaderIds ) );
-	uint32_t stateHash = Hash( reinterpret_cast<const uint8_t*>( &surf ), offsetof( drawSurf_t, dbgName ) );
-	return ( shaderHash ^ stateHash );
+	// Hashed as raw bytes, so the struct must have no padding. Stencil bit and LOD share a word.
+	struct drawState_t
+	{
+		uint64_t	pipelineObject;
+		uint32_t	uploadId;
+		uint32_t	flags;
+		uint32_t	materialId;
+		uint32_t	stencilAndLod;
+	};
+	static_assert( sizeof( drawState_t ) == ( sizeof( uint64_t ) + 4 * sizeof( uint32_t ) ), "Padding would be hashed" );
+
+	const drawState_t state = { surf.pipelineObject.Get(), surf.uploadId, uint32_t( surf.flags ), surf.materialId, uint32_t( surf.stencilBit ) | ( uint32_t( surf.lod ) << 8 ) };
+	return Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
 }
 
 
 struct drawSurfInstance_t
 {
 	mat4x4f		modelMatrix;
-	uint16_t	surfId;
-	uint16_t	id;
+	uint32_t	entityId;
 };
 static_assert( sizeof( drawSurfInstance_t ) == 68, "Informative" );
 
@@ -81,13 +123,49 @@ inline bool operator==( const drawSurf_t& lhs, const drawSurf_t& rhs )
 }
 
 
+// Surfaces with the same draw state can be drawn as instances of one draw call
+inline bool SameDrawState( const drawSurf_t& lhs, const drawSurf_t& rhs )
+{
+	return	( lhs.pipelineObject == rhs.pipelineObject ) &&
+			( lhs.uploadId == rhs.uploadId ) &&
+			( lhs.materialId == rhs.materialId ) &&
+			( lhs.flags == rhs.flags ) &&
+			( lhs.stencilBit == rhs.stencilBit ) &&
+			( lhs.lod == rhs.lod );
+}
+
+
+// A bucket is the state bound once per indirect draw. Depth is not part of it.
+inline bool SameBucket( const drawSurf_t& lhs, const drawSurf_t& rhs )
+{
+	return	( lhs.pipelineObject == rhs.pipelineObject ) &&
+			( lhs.materialId == rhs.materialId ) &&
+			( lhs.stencilBit == rhs.stencilBit );
+}
+
+
+inline uint32_t BucketHash( const drawSurf_t& surf )
+{
+	struct bucketState_t
+	{
+		uint64_t	pipelineObject;
+		uint32_t	materialId;
+		uint32_t	stencilBit;
+	};
+	static_assert( sizeof( bucketState_t ) == ( sizeof( uint64_t ) + 2 * sizeof( uint32_t ) ), "Padding would be hashed" );
+
+	const bucketState_t state = { surf.pipelineObject.Get(), surf.materialId, uint32_t( surf.stencilBit ) };
+	return Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
+}
+
+
 inline bool operator<( const drawSurf_t& surf0, const drawSurf_t& surf1 )
 {
-	if ( surf0.sortKey.materialId == surf1.sortKey.materialId ) {
+	if ( surf0.sortKey == surf1.sortKey ) {
 		return ( surf0.objectOffset < surf1.objectOffset );
 	}
 	else {
-		return ( surf0.sortKey.materialId < surf1.sortKey.materialId );
+		return ( surf0.sortKey < surf1.sortKey );
 	}
 }
 
@@ -99,45 +177,72 @@ template<> struct std::hash<drawSurf_t> {
 };
 
 
+// Draw surfaces of one pass of a view, stored as separate streams allocated from the view's arena.
+// Streams are valid until the next Reset(), so retained groups survive frames where the view is not rebuilt.
 class DrawGroup
 {
 private:
 	const GeometryContext*	geo;
+	LinearAllocator*		allocator;
 
+	// Committed surfaces in Add() order
 	uint32_t				committedModelCount;
+	uint32_t				capacity;
+	sortKey_t*				sortKeys;
+	drawSurf_t*				surfaces;
+	mat4x4f*				transforms;
+	uint32_t*				entityIds;
+	const char**			dbgNames;
+
+	// Sorted instances
+	uint32_t*				sortOrder;		// Committed index of each sorted instance
+	uint32_t*				objectIds;		// Offset of each sorted instance in the surface buffer
+
+	// Merged draws
 	uint32_t				mergedModelCount;
-	uint32_t				instanceCounts[ MaxSurfaces ];
-	drawSurf_t				surfaces[ MaxSurfaces ];
-	drawSurf_t				sortedSurfaces[ MaxSurfaces ];
-	drawSurf_t				merged[ MaxSurfaces ];
-	surfaceUpload_t			uploads[ MaxSurfaces ];
-	drawSurfInstance_t		instances[ MaxSurfaces ];
-	drawSurfInstance_t		sortedInstances[ MaxSurfaces ];
+	drawSurf_t*				merged;
+	uint32_t*				mergedFirst;	// Committed index of the first instance of each draw
+	uint32_t*				instanceCounts;
+	surfaceUpload_t*		uploads;
+
+	void					Grow();
+	void					GroupBuckets();
 
 public:
 
 	DrawGroup()
 	{
+		geo = nullptr;
+		allocator = nullptr;
+
 		committedModelCount = 0;
-		mergedModelCount = 0;
+		capacity = 0;
+		sortKeys = nullptr;
+		surfaces = nullptr;
+		transforms = nullptr;
+		entityIds = nullptr;
+		dbgNames = nullptr;
 
-		geo = nullptr;
+		sortOrder = nullptr;
+		objectIds = nullptr;
 
-		memset( surfaces,			0, MaxSurfaces );
-		memset( sortedSurfaces,		0, MaxSurfaces );
-		memset( merged,				0, MaxSurfaces );
-		memset( uploads,			0, MaxSurfaces );
-		memset( sortedInstances,	0, MaxSurfaces );
-		memset( instances,			0, MaxSurfaces );
-		memset( instanceCounts,		0, MaxSurfaces );
+		mergedModelCount = 0;
+		merged = nullptr;
+		mergedFirst = nullptr;
+		instanceCounts = nullptr;
+		uploads = nullptr;
 	}
 
 	void			Sort();
-	void			Merge();
+	// Blended groups keep their back-to-front order, the others are grouped by bucket
+	void			Merge( const bool depthOrdered );
 
-	inline void	Reset()
+	// The allocator must have been reset by the caller, previous streams are abandoned
+	inline void	Reset( LinearAllocator* arena )
 	{
+		allocator = arena;
 		committedModelCount = 0;
+		capacity = 0;
 		mergedModelCount = 0;
 	}
 
@@ -151,12 +256,6 @@ public:
 		return mergedModelCount;
 	}
 
-	inline const drawSurfInstance_t* Instances() const
-	{
-		assert( committedModelCount > 0 );
-		return &sortedInstances[ 0 ];
-	}
-
 	inline const GeometryContext* Geometry() const
 	{
 		assert( geo != nullptr );
@@ -165,9 +264,27 @@ public:
 
 	inline uint32_t InstanceId( const uint32_t instanceIx ) const
 	{
-		const drawSurf_t& surf = merged[ sortedInstances[ instanceIx ].surfId ];
-		const uint32_t objectId = ( sortedInstances[ instanceIx ].id + surf.objectOffset );
-		return objectId;
+		return objectIds[ instanceIx ];
+	}
+
+	inline const mat4x4f& InstanceTransform( const uint32_t instanceIx ) const
+	{
+		return transforms[ sortOrder[ instanceIx ] ];
+	}
+
+	inline uint32_t EntityId( const uint32_t instanceIx ) const
+	{
+		return entityIds[ sortOrder[ instanceIx ] ];
+	}
+
+	inline const drawSurf_t& InstanceDrawSurf( const uint32_t instanceIx ) const
+	{
+		return surfaces[ sortOrder[ instanceIx ] ];
+	}
+
+	inline void SetInstanceTransform( const uint32_t instanceIx, const mat4x4f& modelMatrix )
+	{
+		transforms[ sortOrder[ instanceIx ] ] = modelMatrix;
 	}
 
 	inline const drawSurf_t& DrawSurf( const uint32_t surfIx ) const
@@ -175,6 +292,11 @@ public:
 		return merged[ surfIx ];
 	}
 
+	inline const char* DebugName( const uint32_t surfIx ) const
+	{
+		return dbgNames[ mergedFirst[ surfIx ] ];
+	}
+
 	inline const surfaceUpload_t& SurfUpload( const uint32_t surfIx ) const
 	{
 		return uploads[ surfIx ];
@@ -185,12 +307,17 @@ public:
 		return instanceCounts[ surfIx ];
 	}
 
-	inline void Add( const drawSurf_t& surf, const drawSurfInstance_t& instance )
+	inline void Add( const drawSurf_t& surf, const drawSurfInstance_t& instance, const char* dbgName )
 	{
-		assert( committedModelCount < MaxSurfaces );
+		if ( committedModelCount >= capacity ) {
+			Grow();
+		}
 
+		sortKeys[ committedModelCount ] = surf.sortKey;
 		surfaces[ committedModelCount ] = surf;
-		instances[ committedModelCount ] = instance;
+		transforms[ committedModelCount ] = instance.modelMatrix;
+		entityIds[ committedModelCount ] = instance.entityId;
+		dbgNames[ committedModelCount ] = dbgName;
 
 		++committedModelCount;
 	}
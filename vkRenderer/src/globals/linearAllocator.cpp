@@ -0,0 +1,113 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "linearAllocator.h"
+#include <cstring>
+
+
+void LinearAllocator::AddBlock( const size_t minSize )
+{
+	size_t size = DefaultBlockSize;
+	while ( size < minSize ) {
+		size *= 2;
+	}
+
+	block_t block;
+	block.data = new uint8_t[ size ];
+	block.size = size;
+	m_blocks.push_back( block );
+
+	m_offset = 0;
+}
+
+
+void LinearAllocator::FreeBlocks()
+{
+	for ( size_t i = 0; i < m_blocks.size(); ++i ) {
+		delete[] m_blocks[ i ].data;
+	}
+	m_blocks.clear();
+	m_offset = 0;
+}
+
+
+void* LinearAllocator::Alloc( const size_t bytes, const size_t alignment )
+{
+	assert( ( alignment & ( alignment - 1 ) ) == 0 );
+
+	if ( bytes == 0 ) {
+		return nullptr;
+	}
+
+	for ( uint32_t attempt = 0; attempt < 2; ++attempt )
+	{
+		if ( m_blocks.empty() == false )
+		{
+			block_t& block = m_blocks.back();
+			const uintptr_t base = reinterpret_cast<uintptr_t>( block.data );
+			const uintptr_t aligned = ( base + m_offset + alignment - 1 ) & ~uintptr_t( alignment - 1 );
+			const size_t end = ( aligned - base ) + bytes;
+
+			if ( end <= block.size )
+			{
+				m_used += ( end - m_offset );
+				m_offset = end;
+				return reinterpret_cast<void*>( aligned );
+			}
+		}
+		AddBlock( bytes + alignment );
+	}
+
+	assert( false );
+	return nullptr;
+}
+
+
+void LinearAllocator::Reset()
+{
+	m_highWater = ( m_used > m_highWater ) ? m_used : m_highWater;
+	m_used = 0;
+	m_offset = 0;
+
+	if ( m_blocks.size() > 1 )
+	{
+		FreeBlocks();
+		AddBlock( m_highWater );
+	}
+}
+
+
+size_t LinearAllocator::Used() const
+{
+	return m_used;
+}
+
+
+size_t LinearAllocator::Capacity() const
+{
+	size_t capacity = 0;
+	for ( size_t i = 0; i < m_blocks.size(); ++i ) {
+		capacity += m_blocks[ i ].size;
+	}
+	return capacity;
+}
@@ -0,0 +1,75 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <assert.h>
+
+// Bump allocator for transient CPU data. Nothing is freed individually, Reset() releases everything at once.
+// Blocks are chained when an allocation does not fit. Reset() folds them into one block sized to the
+// previous high-water mark, so a steady workload stops touching the heap after its first reset.
+class LinearAllocator
+{
+private:
+	struct block_t
+	{
+		uint8_t*	data;
+		size_t		size;
+	};
+
+	std::vector<block_t>	m_blocks;
+	size_t					m_offset;		// Offset into the last block
+	size_t					m_used;			// Bytes handed out since Reset(), including alignment
+	size_t					m_highWater;
+
+	void					AddBlock( const size_t minSize );
+	void					FreeBlocks();
+
+public:
+	static const size_t		DefaultBlockSize = 64 * 1024;
+
+	LinearAllocator() : m_offset( 0 ), m_used( 0 ), m_highWater( 0 )
+	{}
+
+	~LinearAllocator()
+	{
+		FreeBlocks();
+	}
+
+	LinearAllocator( const LinearAllocator& ) = delete;
+	LinearAllocator& operator=( const LinearAllocator& ) = delete;
+
+	void*					Alloc( const size_t bytes, const size_t alignment );
+	void					Reset();
+	size_t					Used() const;
+	size_t					Capacity() const;
+
+	template<typename T>
+	inline T* Alloc( const uint32_t count )
+	{
+		return reinterpret_cast<T*>( Alloc( count * sizeof( T ), alignof( T ) ) );
+	}
+};
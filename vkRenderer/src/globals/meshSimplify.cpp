@@ -0,0 +1,539 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "meshSimplify.h"
+
+#include <algorithm>
+#include <numeric>
+#include <fstream>
+
+struct quadric_t
+{
+	double	a2, ab, ac, ad;
+	double	b2, bc, bd;
+	double	c2, cd;
+	double	d2;
+};
+
+
+struct collapse_t
+{
+	double		cost;
+	uint32_t	v0;	// Removed
+	uint32_t	v1;	// Kept
+};
+
+
+static void QuadricAddPlane( quadric_t& q, const double a, const double b, const double c, const double d )
+{
+	q.a2 += a * a;	q.ab += a * b;	q.ac += a * c;	q.ad += a * d;
+	q.b2 += b * b;	q.bc += b * c;	q.bd += b * d;
+	q.c2 += c * c;	q.cd += c * d;
+	q.d2 += d * d;
+}
+
+
+static void QuadricAdd( quadric_t& q, const quadric_t& r )
+{
+	q.a2 += r.a2;	q.ab += r.ab;	q.ac += r.ac;	q.ad += r.ad;
+	q.b2 += r.b2;	q.bc += r.bc;	q.bd += r.bd;
+	q.c2 += r.c2;	q.cd += r.cd;
+	q.d2 += r.d2;
+}
+
+
+// Sum of squared distances from p to the accumulated planes
+static double QuadricError( const quadric_t& q, const vec3f& p )
+{
+	const double x = p[ 0 ];
+	const double y = p[ 1 ];
+	const double z = p[ 2 ];
+
+	const double error =	q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x +
+							q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y +
+							q.c2 * z * z + 2.0 * q.cd * z +
+							q.d2;
+
+	return ( error > 0.0 ) ? error : 0.0;
+}
+
+
+// Rejects collapses that would turn a remaining triangle around v0 over
+static bool CollapseKeepsOrientation( const vec3f* positions, const uint32_t* indices, const uint32_t* adjOffsets, const uint32_t* adjTris, const uint32_t v0, const uint32_t v1 )
+{
+	for ( uint32_t k = adjOffsets[ v0 ]; k < adjOffsets[ v0 + 1 ]; ++k )
+	{
+		const uint32_t* tri = &indices[ 3 * adjTris[ k ] ];
+		if ( ( tri[ 0 ] == v1 ) || ( tri[ 1 ] == v1 ) || ( tri[ 2 ] == v1 ) ) {
+			continue; // Degenerates and is removed
+		}
+
+		vec3f p[ 3 ] = { positions[ tri[ 0 ] ], positions[ tri[ 1 ] ], positions[ tri[ 2 ] ] };
+		const vec3f n0 = Cross( p[ 1 ] - p[ 0 ], p[ 2 ] - p[ 0 ] );
+
+		for ( uint32_t i = 0; i < 3; ++i ) {
+			p[ i ] = ( tri[ i ] == v0 ) ? positions[ v1 ] : p[ i ];
+		}
+		const vec3f n1 = Cross( p[ 1 ] - p[ 0 ], p[ 2 ] - p[ 0 ] );
+
+		if ( Dot( n0, n1 ) <= 0.0f ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+float SimplifyMesh( const vec3f* positions, const uint32_t vertexCount, const uint32_t* indices, const uint32_t indexCount, const uint32_t targetIndexCount, std::vector<uint32_t>& outIndices )
+{
+	outIndices.assign( indices, indices + indexCount );
+	if ( ( indexCount <= targetIndexCount ) || ( vertexCount == 0 ) ) {
+		return 0.0f;
+	}
+
+	std::vector<uint8_t> locked( vertexCount, 0 );
+
+	// Vertices split for attributes share a position, moving either side would tear the seam
+	{
+		std::vector<uint32_t> order( vertexCount );
+		std::iota( order.begin(), order.end(), 0 );
+
+		auto positionLess = [ positions ]( const uint32_t lhs, const uint32_t rhs ) {
+			const vec3f& a = positions[ lhs ];
+			const vec3f& b = positions[ rhs ];
+			if ( a[ 0 ] != b[ 0 ] ) {
+				return a[ 0 ] < b[ 0 ];
+			}
+			if ( a[ 1 ] != b[ 1 ] ) {
+				return a[ 1 ] < b[ 1 ];
+			}
+			return a[ 2 ] < b[ 2 ];
+		};
+		std::sort( order.begin(), order.end(), positionLess );
+
+		for ( uint32_t i = 1; i < vertexCount; ++i )
+		{
+			if ( ( positionLess( order[ i - 1 ], order[ i ] ) == false ) && ( positionLess( order[ i ], order[ i - 1 ] ) == false ) )
+			{
+				locked[ order[ i - 1 ] ] = 1;
+				locked[ order[ i ] ] = 1;
+			}
+		}
+	}
+
+	// Edges with only one triangle are open borders, nothing on the other side holds them in place
+	{
+		std::vector<uint64_t> edges;
+		edges.reserve( indexCount );
+		for ( uint32_t i = 0; i < indexCount; i += 3 )
+		{
+			for ( uint32_t e = 0; e < 3; ++e )
+			{
+				const uint64_t a = indices[ i + e ];
+				const uint64_t b = indices[ i + ( e + 1 ) % 3 ];
+				edges.push_back( ( a < b ) ? ( ( a << 32 ) | b ) : ( ( b << 32 ) | a ) );
+			}
+		}
+		std::sort( edges.begin(), edges.end() );
+
+		const uint32_t edgeCount = static_cast<uint32_t>( edges.size() );
+		for ( uint32_t i = 0; i < edgeCount; )
+		{
+			uint32_t runEnd = i + 1;
+			while ( ( runEnd < edgeCount ) && ( edges[ runEnd ] == edges[ i ] ) ) {
+				++runEnd;
+			}
+			if ( ( runEnd - i ) == 1 )
+			{
+				locked[ uint32_t( edges[ i ] >> 32 ) ] = 1;
+				locked[ uint32_t( edges[ i ] & 0xFFFFFFFF ) ] = 1;
+			}
+			i = runEnd;
+		}
+	}
+
+	std::vector<quadric_t> quadrics( vertexCount );
+	memset( quadrics.data(), 0, vertexCount * sizeof( quadric_t ) );
+
+	for ( uint32_t i = 0; i < indexCount; i += 3 )
+	{
+		const vec3f& p0 = positions[ indices[ i + 0 ] ];
+		const vec3f n = Cross( positions[ indices[ i + 1 ] ] - p0, positions[ indices[ i + 2 ] ] - p0 );
+		const double length = sqrt( double( Dot( n, n ) ) );
+		if ( length <= 0.0 ) {
+			continue;
+		}
+
+		const double a = n[ 0 ] / length;
+		const double b = n[ 1 ] / length;
+		const double c = n[ 2 ] / length;
+		const double d = -( a * p0[ 0 ] + b * p0[ 1 ] + c * p0[ 2 ] );
+
+		for ( uint32_t k = 0; k < 3; ++k ) {
+			QuadricAddPlane( quadrics[ indices[ i + k ] ], a, b, c, d );
+		}
+	}
+
+	std::vector<uint32_t> remap( vertexCount );
+	std::vector<uint8_t> touched( vertexCount );
+	std::vector<uint32_t> adjOffsets( vertexCount + 1 );
+	std::vector<uint32_t> adjFill( vertexCount );
+	std::vector<uint32_t> adjTris;
+	std::vector<collapse_t> collapses;
+
+	double maxError = 0.0;
+	uint32_t currentCount = indexCount;
+
+	// Each pass collapses the cheapest edges that don't share triangles, so every orientation check stays valid
+	while ( currentCount > targetIndexCount )
+	{
+		const uint32_t triCount = currentCount / 3;
+
+		std::fill( adjOffsets.begin(), adjOffsets.end(), 0 );
+		for ( uint32_t i = 0; i < currentCount; ++i ) {
+			++adjOffsets[ outIndices[ i ] + 1 ];
+		}
+		for ( uint32_t v = 0; v < vertexCount; ++v ) {
+			adjOffsets[ v + 1 ] += adjOffsets[ v ];
+		}
+
+		adjTris.resize( currentCount );
+		std::copy( adjOffsets.begin(), adjOffsets.begin() + vertexCount, adjFill.begin() );
+		for ( uint32_t i = 0; i < currentCount; ++i ) {
+			adjTris[ adjFill[ outIndices[ i ] ]++ ] = i / 3;
+		}
+
+		collapses.clear();
+		for ( uint32_t i = 0; i < currentCount; i += 3 )
+		{
+			for ( uint32_t e = 0; e < 3; ++e )
+			{
+				const uint32_t a = outIndices[ i + e ];
+				const uint32_t b = outIndices[ i + ( e + 1 ) % 3 ];
+
+				quadric_t q = quadrics[ a ];
+				QuadricAdd( q, quadrics[ b ] );
+
+				if ( locked[ a ] == 0 ) {
+					collapses.push_back( { QuadricError( q, positions[ b ] ), a, b } );
+				}
+				if ( locked[ b ] == 0 ) {
+					collapses.push_back( { QuadricError( q, positions[ a ] ), b, a } );
+				}
+			}
+		}
+		if ( collapses.empty() ) {
+			break;
+		}
+
+		std::sort( collapses.begin(), collapses.end(), []( const collapse_t& lhs, const collapse_t& rhs ) {
+			return lhs.cost < rhs.cost;
+		} );
+
+		// A collapse removes about two triangles, stop short of the target
+		const uint32_t targetTriCount = targetIndexCount / 3;
+		const uint32_t maxCollapses = ( triCount > ( targetTriCount + 2 ) ) ? ( ( triCount - targetTriCount ) / 2 ) : 1;
+
+		std::iota( remap.begin(), remap.end(), 0 );
+		std::fill( touched.begin(), touched.end(), 0 );
+
+		uint32_t collapseCount = 0;
+		for ( const collapse_t& collapse : collapses )
+		{
+			if ( collapseCount >= maxCollapses ) {
+				break;
+			}
+			if ( ( touched[ collapse.v0 ] != 0 ) || ( touched[ collapse.v1 ] != 0 ) ) {
+				continue;
+			}
+			if ( CollapseKeepsOrientation( positions, outIndices.data(), adjOffsets.data(), adjTris.data(), collapse.v0, collapse.v1 ) == false ) {
+				continue;
+			}
+
+			remap[ collapse.v0 ] = collapse.v1;
+			QuadricAdd( quadrics[ collapse.v1 ], quadrics[ collapse.v0 ] );
+			maxError = std::max( maxError, collapse.cost );
+
+			for ( uint32_t k = adjOffsets[ collapse.v0 ]; k < adjOffsets[ collapse.v0 + 1 ]; ++k )
+			{
+				const uint32_t triIx = adjTris[ k ];
+				touched[ outIndices[ 3 * triIx + 0 ] ] = 1;
+				touched[ outIndices[ 3 * triIx + 1 ] ] = 1;
+				touched[ outIndices[ 3 * triIx + 2 ] ] = 1;
+			}
+			++collapseCount;
+		}
+
+		if ( collapseCount == 0 ) {
+			break;
+		}
+
+		uint32_t writeIx = 0;
+		for ( uint32_t i = 0; i < currentCount; i += 3 )
+		{
+			const uint32_t a = remap[ outIndices[ i + 0 ] ];
+			const uint32_t b = remap[ outIndices[ i + 1 ] ];
+			const uint32_t c = remap[ outIndices[ i + 2 ] ];
+			if ( ( a == b ) || ( b == c ) || ( a == c ) ) {
+				continue;
+			}
+			outIndices[ writeIx + 0 ] = a;
+			outIndices[ writeIx + 1 ] = b;
+			outIndices[ writeIx + 2 ] = c;
+			writeIx += 3;
+		}
+		currentCount = writeIx;
+		outIndices.resize( currentCount );
+	}
+
+	return static_cast<float>( sqrt( maxError ) );
+}
+
+
+float MeshBoundingRadius( const vec3f* positions, const uint32_t vertexCount )
+{
+	if ( vertexCount == 0 ) {
+		return 0.0f;
+	}
+
+	vec3f boundsMin = positions[ 0 ];
+	vec3f boundsMax = positions[ 0 ];
+	for ( uint32_t v = 1; v < vertexCount; ++v )
+	{
+		for ( uint32_t i = 0; i < 3; ++i )
+		{
+			boundsMin[ i ] = std::min( boundsMin[ i ], positions[ v ][ i ] );
+			boundsMax[ i ] = std::max( boundsMax[ i ], positions[ v ][ i ] );
+		}
+	}
+
+	const vec3f center = vec3f( 0.5f * ( boundsMin[ 0 ] + boundsMax[ 0 ] ), 0.5f * ( boundsMin[ 1 ] + boundsMax[ 1 ] ), 0.5f * ( boundsMin[ 2 ] + boundsMax[ 2 ] ) );
+
+	float radiusSq = 0.0f;
+	for ( uint32_t v = 0; v < vertexCount; ++v )
+	{
+		const vec3f delta = positions[ v ] - center;
+		radiusSq = std::max( radiusSq, Dot( delta, delta ) );
+	}
+	return sqrtf( radiusSq );
+}
+
+
+struct lodFileHeader_t
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	surfCount;
+};
+
+struct lodFileSurface_t
+{
+	uint32_t	vertexCount;
+	uint32_t	indexCount;
+	uint32_t	sourceHash;		// Positions and indices the chain was built from
+	uint32_t	lodCount;
+};
+
+struct lodFileLevel_t
+{
+	float		error;
+	uint32_t	indexCount;
+};
+
+static const uint32_t LodFileMagic = 0x444F4C4D; // "MLOD"
+static const uint32_t LodFileVersion = 2;
+
+
+// Edits that keep the vertex and index counts still invalidate the bake
+static uint32_t SourceHash( const Surface& surf )
+{
+	const uint32_t vertexCount = static_cast<uint32_t>( surf.vertices.size() );
+	const uint32_t indexCount = static_cast<uint32_t>( surf.indices.size() );
+
+	std::vector<vec3f> positions( vertexCount );
+	for ( uint32_t vIx = 0; vIx < vertexCount; ++vIx ) {
+		positions[ vIx ] = Trunc<4,1>( surf.vertices[ vIx ].pos );
+	}
+
+	const uint32_t hashes[ 2 ] = {
+		Hash( reinterpret_cast<const uint8_t*>( positions.data() ), vertexCount * sizeof( vec3f ) ),
+		Hash( reinterpret_cast<const uint8_t*>( surf.indices.data() ), indexCount * sizeof( uint32_t ) ),
+	};
+	return Hash( reinterpret_cast<const uint8_t*>( hashes ), sizeof( hashes ) );
+}
+
+
+// Each level targets half the triangles of the previous one
+static void BuildLodChain( const Surface& surf, std::vector<meshLod_t>& lods )
+{
+	const uint32_t MinLodIndices = 3 * 64;
+
+	const uint32_t vertexCount = static_cast<uint32_t>( surf.vertices.size() );
+	const uint32_t indexCount = static_cast<uint32_t>( surf.indices.size() );
+
+	std::vector<vec3f> positions( vertexCount );
+	for ( uint32_t vIx = 0; vIx < vertexCount; ++vIx ) {
+		positions[ vIx ] = Trunc<4,1>( surf.vertices[ vIx ].pos );
+	}
+
+	const float radius = MeshBoundingRadius( positions.data(), vertexCount );
+
+	uint32_t prevIndexCount = indexCount;
+	for ( uint32_t lod = 1; ( lod < MaxMeshLods ) && ( radius > 0.0f ); ++lod )
+	{
+		const uint32_t targetIndexCount = ( ( indexCount >> lod ) / 3 ) * 3;
+		if ( targetIndexCount < MinLodIndices ) {
+			break;
+		}
+
+		meshLod_t level;
+		const float error = SimplifyMesh( positions.data(), vertexCount, surf.indices.data(), indexCount, targetIndexCount, level.indices );
+
+		// Locked borders and seams can stall the simplifier, a level that barely shrinks isn't worth drawing
+		const uint32_t lodIndexCount = static_cast<uint32_t>( level.indices.size() );
+		if ( ( lodIndexCount == 0 ) || ( lodIndexCount > ( prevIndexCount - prevIndexCount / 8 ) ) ) {
+			break;
+		}
+
+		level.error = error / radius;
+		lods.push_back( std::move( level ) );
+		prevIndexCount = lodIndexCount;
+	}
+}
+
+
+bool WriteModelLods( const std::string& path, const Model& model )
+{
+	std::ofstream file( path, std::ios::binary | std::ios::trunc );
+	if ( file.is_open() == false )
+	{
+		std::cout << "Couldn't write LOD chains \"" << path << "\"." << std::endl;
+		return false;
+	}
+
+	lodFileHeader_t header = {};
+	header.magic = LodFileMagic;
+	header.version = LodFileVersion;
+	header.surfCount = model.surfCount;
+	file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+
+	std::vector<meshLod_t> lods;
+	for ( uint32_t s = 0; s < model.surfCount; ++s )
+	{
+		const Surface& surf = model.surfs[ s ];
+
+		lods.clear();
+		BuildLodChain( surf, lods );
+
+		lodFileSurface_t surfHeader = {};
+		surfHeader.vertexCount = static_cast<uint32_t>( surf.vertices.size() );
+		surfHeader.indexCount = static_cast<uint32_t>( surf.indices.size() );
+		surfHeader.sourceHash = SourceHash( surf );
+		surfHeader.lodCount = static_cast<uint32_t>( lods.size() );
+		file.write( reinterpret_cast<const char*>( &surfHeader ), sizeof( surfHeader ) );
+
+		for ( auto it = lods.begin(); it != lods.end(); ++it )
+		{
+			const lodFileLevel_t level = { it->error, static_cast<uint32_t>( it->indices.size() ) };
+			file.write( reinterpret_cast<const char*>( &level ), sizeof( level ) );
+			file.write( reinterpret_cast<const char*>( it->indices.data() ), level.indexCount * sizeof( uint32_t ) );
+		}
+	}
+	return ( file.fail() == false );
+}
+
+
+bool ReadModelLods( const std::string& path, const Model& model, modelLods_t& lods )
+{
+	lods.clear();
+
+	std::ifstream file( path, std::ios::binary );
+	if ( file.is_open() == false ) {
+		return false;
+	}
+
+	lodFileHeader_t header = {};
+	file.read( reinterpret_cast<char*>( &header ), sizeof( header ) );
+	if ( file.fail() || ( header.magic != LodFileMagic ) || ( header.version != LodFileVersion ) || ( header.surfCount != model.surfCount ) )
+	{
+		std::cout << "LOD chains \"" << path << "\" are stale, rebake to draw them." << std::endl;
+		return false;
+	}
+
+	lods.resize( model.surfCount );
+	for ( uint32_t s = 0; s < model.surfCount; ++s )
+	{
+		const Surface& surf = model.surfs[ s ];
+
+		lodFileSurface_t surfHeader = {};
+		file.read( reinterpret_cast<char*>( &surfHeader ), sizeof( surfHeader ) );
+
+		const uint32_t vertexCount = static_cast<uint32_t>( surf.vertices.size() );
+		const uint32_t indexCount = static_cast<uint32_t>( surf.indices.size() );
+		if ( file.fail() || ( surfHeader.vertexCount != vertexCount ) || ( surfHeader.indexCount != indexCount ) ||
+			( surfHeader.sourceHash != SourceHash( surf ) ) || ( surfHeader.lodCount >= MaxMeshLods ) )
+		{
+			std::cout << "LOD chains \"" << path << "\" are stale, rebake to draw them." << std::endl;
+			lods.clear();
+			return false;
+		}
+
+		lods[ s ].resize( surfHeader.lodCount );
+		for ( uint32_t lod = 0; lod < surfHeader.lodCount; ++lod )
+		{
+			lodFileLevel_t level = {};
+			file.read( reinterpret_cast<char*>( &level ), sizeof( level ) );
+			if ( file.fail() || ( level.indexCount > indexCount ) )
+			{
+				lods.clear();
+				return false;
+			}
+
+			std::vector<uint32_t>& indices = lods[ s ][ lod ].indices;
+			lods[ s ][ lod ].error = level.error;
+			indices.resize( level.indexCount );
+			file.read( reinterpret_cast<char*>( indices.data() ), level.indexCount * sizeof( uint32_t ) );
+
+			if ( file.fail() )
+			{
+				lods.clear();
+				return false;
+			}
+
+			// Levels index the surface's own vertices, anything past them would read another surface
+			if ( std::all_of( indices.begin(), indices.end(), [ vertexCount ]( const uint32_t ix ) { return ix < vertexCount; } ) == false )
+			{
+				std::cout << "LOD chains \"" << path << "\" index past their vertices, rebake to draw them." << std::endl;
+				lods.clear();
+				return false;
+			}
+		}
+	}
+
+	if ( file.fail() )
+	{
+		lods.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,51 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+#include "common.h"
+#include <gfxcore/scene/scene.h>
+
+// Simplified level of a surface, indexes the vertices of the surface itself
+struct meshLod_t
+{
+	float					error;		// Relative to the surface bounding radius
+	std::vector<uint32_t>	indices;
+};
+
+// Levels after the surface itself, one list per surface of the model
+using modelLods_t = std::vector<std::vector<meshLod_t>>;
+
+// Quadric error simplification of an indexed triangle list. Edges collapse onto one of their endpoints,
+// so the result indexes the original vertices and every LOD can share one vertex range.
+// Vertices on open borders and attribute seams are never removed.
+// Returns the largest collapse error as a distance in position units.
+float	SimplifyMesh( const vec3f* positions, const uint32_t vertexCount, const uint32_t* indices, const uint32_t indexCount, const uint32_t targetIndexCount, std::vector<uint32_t>& outIndices );
+
+// Radius of the sphere around the center of the position bounds
+float	MeshBoundingRadius( const vec3f* positions, const uint32_t vertexCount );
+
+// Builds the chain of every surface and writes it next to the baked model. Run by c_bakeAssets.
+bool	WriteModelLods( const std::string& path, const Model& model );
+
+// Fails when the file is missing or was baked from different geometry
+bool	ReadModelLods( const std::string& path, const Model& model, modelLods_t& lods );
\ No newline at end of file
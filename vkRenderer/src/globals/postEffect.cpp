@@ -119,12 +119,18 @@ void ImageProcess::FrameEnd()
 }
 
 
+void ImageProcess::DeclareResources( RenderGraph& graph )
+{
+	// The stencil is only bound to fill its slot, no image process samples it
+	graph.ReadPass( m_pass );
+	graph.WriteFrameBuffer( m_pass->GetFrameBuffer() );
+}
+
+
 void ImageProcess::Execute( CommandContext& cmdContext )
 {
 	cmdContext.MarkerBeginRegion( m_dbgName.c_str(), ColorToVector( Color::White ) );
 
-	m_pass->InsertResourceBarriers( cmdContext );
-
 	hdl_t pipeLineHandle = CreateGraphicsPipeline( cmdContext.GetRenderContext(), m_pass, *m_progAsset );
 
 	vk_RenderImageShader( cmdContext, pipeLineHandle, m_pass, m_transitionState );
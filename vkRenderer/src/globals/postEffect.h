@@ -72,5 +72,11 @@ public:
 	void				SetSourceCubeImage( const uint32_t slot, Image* image );
 	void				SetConstants( const void* dataBlock, const uint32_t sizeInBytes );
 
+	void				DeclareResources( RenderGraph& graph );
 	void				Execute( CommandContext& cmdContext );
+
+	inline const DrawPass* GetPass() const
+	{
+		return m_pass;
+	}
 };
\ No newline at end of file
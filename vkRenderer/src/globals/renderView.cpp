@@ -46,7 +46,11 @@ void RenderView::Init( const renderViewCreateInfo_t& info )
 	m_resources = info.resources;
 	m_viewId = info.viewId;
 
+	lodBias = ( info.lodBias > 0.0f ) ? info.lodBias : 1.0f;
+
 	m_viewParms = info.context->RegisterBindParm( bindset_view );
+	m_cullParms = info.context->RegisterBindParm( bindset_cull );
+	m_lightCullParms = info.context->RegisterBindParm( bindset_lightCull );
 
 	for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx ) {
 		passes[ passIx ] = nullptr;
@@ -101,7 +105,8 @@ void RenderView::Init( const renderViewCreateInfo_t& info )
 
 	if( info.region == renderViewRegion_t::SHADOW )
 	{
-		m_transitionState.flags.clear = true;
+		// Shadow views share the atlas, each rendered tile is cleared on its own so cached tiles are kept
+		m_transitionState.flags.clear = false;
 		m_transitionState.flags.store = true;
 		m_transitionState.flags.readOnly = true;
 		m_transitionState.flags.readAfter = true;
@@ -146,6 +151,22 @@ void RenderView::Init( const renderViewCreateInfo_t& info )
 void RenderView::FrameBegin()
 {
 	m_viewParms->Bind( bind_modelBuffer, &m_resources->surfParmPartitions[ m_viewId ] );
+	m_viewParms->Bind( bind_drawRemapBuffer, &m_resources->drawRemapPartitions[ m_viewId ] );
+	m_viewParms->Bind( bind_hiZPyramidBuffer, &m_resources->hiZPyramid );
+	m_viewParms->Bind( bind_hiZParms, &m_resources->hiZParms );
+	m_viewParms->Bind( bind_clusterLightsBuffer, &m_resources->clusterLightPartitions[ m_viewId ] );
+
+	m_cullParms->Bind( bind_viewBuffer, &m_resources->viewParms );
+	m_cullParms->Bind( bind_modelBuffer, &m_resources->surfParmPartitions[ m_viewId ] );
+	m_cullParms->Bind( bind_drawRemapWrite, &m_resources->drawRemapPartitions[ m_viewId ] );
+	m_cullParms->Bind( bind_drawCommandWrite, &m_resources->drawCommandPartitions[ m_viewId ] );
+	m_cullParms->Bind( bind_hiZPyramidBuffer, &m_resources->hiZPyramid );
+	m_cullParms->Bind( bind_hiZParms, &m_resources->hiZParms );
+	m_cullParms->Bind( bind_cullStatsWrite, &m_resources->cullStats );
+
+	m_lightCullParms->Bind( bind_viewBuffer, &m_resources->viewParms );
+	m_lightCullParms->Bind( bind_lightBuffer, &m_resources->lightParms );
+	m_lightCullParms->Bind( bind_clusterLightsWrite, &m_resources->clusterLightPartitions[ m_viewId ] );
 
 	for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
 	{
@@ -249,6 +270,36 @@ const ShaderBindParms* RenderView::BindParms() const
 }
 
 
+const ShaderBindParms* RenderView::CullParms() const
+{
+	return m_cullParms;
+}
+
+
+const ShaderBindParms* RenderView::LightCullParms() const
+{
+	return m_lightCullParms;
+}
+
+
+const GpuBuffer& RenderView::DrawCommands() const
+{
+	return m_resources->drawCommandPartitions[ m_viewId ];
+}
+
+
+const GpuBuffer& RenderView::HiZPyramid() const
+{
+	return m_resources->hiZPyramid;
+}
+
+
+uint32_t RenderView::ObjectCount() const
+{
+	return ( drawGroupOffset[ DRAWPASS_COUNT - 1 ] + drawGroup[ DRAWPASS_COUNT - 1 ].InstanceCount() );
+}
+
+
 vec2i RenderView::GetFrameSize() const
 {
 	if( m_framebuffer == nullptr ) {
@@ -282,6 +333,12 @@ const mat4x4f& RenderView::GetViewprojMatrix() const
 }
 
 
+const frustum_t& RenderView::GetFrustum() const
+{
+	return m_frustum;
+}
+
+
 const int RenderView::GetViewId() const
 {
 	return m_viewId;
@@ -323,11 +380,24 @@ void RenderView::SetCamera( const Camera& camera, const bool reverseZ )
 	m_viewMatrix = camera.GetViewMatrix();
 	m_projMatrix = camera.GetPerspectiveMatrix( reverseZ );
 	m_viewprojMatrix = m_projMatrix * m_viewMatrix;
+	ExtractFrustumPlanes( m_viewprojMatrix, m_frustum );
 
 	m_viewport.near = camera.GetNearClip();
 	m_viewport.far = camera.GetFarClip();
 }
 
+
+void RenderView::SetViewProjection( const mat4x4f& viewMatrix, const mat4x4f& projMatrix, const float nearClip, const float farClip )
+{
+	m_viewMatrix = viewMatrix;
+	m_projMatrix = projMatrix;
+	m_viewprojMatrix = m_projMatrix * m_viewMatrix;
+	ExtractFrustumPlanes( m_viewprojMatrix, m_frustum );
+
+	m_viewport.near = nearClip;
+	m_viewport.far = farClip;
+}
+
 void RenderView::AttachDebugMenu( const debugMenuFuncPtr funcPtr )
 {
 	debugMenus.Append( funcPtr );
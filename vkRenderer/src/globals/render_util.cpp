@@ -52,6 +52,18 @@ mat4x4f MatrixFromVector( const vec3f& v )
 }
 
 
+// mat4x4f is indexed [ row ][ column ], filled row by row and multiplies column vectors
+mat4x4f MatrixFromColumns( const vec4f& c0, const vec4f& c1, const vec4f& c2, const vec4f& c3 )
+{
+	const float values[ 16 ] = {	c0[ 0 ], c1[ 0 ], c2[ 0 ], c3[ 0 ],
+									c0[ 1 ], c1[ 1 ], c2[ 1 ], c3[ 1 ],
+									c0[ 2 ], c1[ 2 ], c2[ 2 ], c3[ 2 ],
+									c0[ 3 ], c1[ 3 ], c2[ 3 ], c3[ 3 ] };
+
+	return mat4x4f( values );
+}
+
+
 void MatrixToEulerZYX( const mat4x4f& m, float& xDegrees, float& yDegrees, float& zDegrees )
 {
 	if( m[2][0] < 1.0f )
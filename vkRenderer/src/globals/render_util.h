@@ -69,5 +69,6 @@ public:
 };
 
 mat4x4f MatrixFromVector( const vec3f& v );
+mat4x4f MatrixFromColumns( const vec4f& c0, const vec4f& c1, const vec4f& c2, const vec4f& c3 );
 void MatrixToEulerZYX( const mat4x4f& m, float& a, float& b, float& c );
 void CreateQuadSurface2D( const std::string& materialName, Model& outModel, vec2f& origin, vec2f& size );
\ No newline at end of file
@@ -26,6 +26,7 @@
 #include <gfxcore/scene/scene.h>
 #include "common.h"
 #include "drawGroup.h"
+#include "cull.h"
 #include "../draw_passes/drawpass.h"
 
 class ResourceContext;
@@ -49,6 +50,7 @@ struct renderViewCreateInfo_t
 	const ResourceContext*	resources;
 	RenderContext*			context;
 	FrameBuffer*			fb;
+	float					lodBias;
 };
 
 
@@ -60,6 +62,8 @@ private:
 	const ResourceContext*	m_resources;
 	const FrameBuffer*		m_framebuffer;
 	ShaderBindParms*		m_viewParms;
+	ShaderBindParms*		m_cullParms;
+	ShaderBindParms*		m_lightCullParms;
 	vec4f					m_clearColor;
 	float					m_clearDepth;
 	uint32_t				m_clearStencil;
@@ -68,6 +72,7 @@ private:
 	mat4x4f					m_viewMatrix;
 	mat4x4f					m_projMatrix;
 	mat4x4f					m_viewprojMatrix;
+	frustum_t				m_frustum;
 	const char*				m_name;
 	renderViewRegion_t		m_region;
 	int						m_viewId;
@@ -86,12 +91,25 @@ public:
 		m_viewMatrix = mat4x4f( 1.0f );
 		m_projMatrix = mat4x4f( 1.0f );
 		m_viewprojMatrix = mat4x4f( 1.0f );
+		ExtractFrustumPlanes( m_viewprojMatrix, m_frustum );
 
 		m_viewId = -1;
 		m_committed = false;
 
+		sortViewMatrix = mat4x4f( 1.0f );
+		lodViewMatrix = mat4x4f( 1.0f );
+		lodScanFrame = 0;
+
 		numLights = 0;
+		numDirectionalLights = 0;
 		memset( drawGroupOffset, 0, sizeof( drawGroupOffset ) );
+		memset( drawCommandOffset, 0, sizeof( drawCommandOffset ) );
+		gpuCulling = false;
+		occlusionCulling = false;
+		lodBias = 1.0f;
+		culled = false;
+		drawsChanged = true;
+		reuseFrameBuffer = false;
 
 		m_framebuffer = nullptr;
 		m_region = renderViewRegion_t::UNKNOWN;
@@ -118,14 +136,21 @@ public:
 	float					ClearDepth() const;
 	uint32_t				ClearStencil() const;
 	const ShaderBindParms*	BindParms() const;
+	const ShaderBindParms*	CullParms() const;
+	const ShaderBindParms*	LightCullParms() const;
+	const GpuBuffer&		DrawCommands() const;
+	const GpuBuffer&		HiZPyramid() const;
+	uint32_t				ObjectCount() const;
 
 	void					SetCamera( const Camera& camera, const bool reverseZ = true );
+	void					SetViewProjection( const mat4x4f& viewMatrix, const mat4x4f& projMatrix, const float nearClip, const float farClip );
 	void					SetViewRect( const int32_t x, const int32_t y, const uint32_t width, const uint32_t height );
 	const viewport_t&		GetViewport() const;
 	vec2i					GetFrameSize() const;
 	const mat4x4f&			GetViewMatrix() const;
 	const mat4x4f&			GetProjMatrix() const;
 	const mat4x4f&			GetViewprojMatrix() const;
+	const frustum_t&		GetFrustum() const;
 	const int				GetViewId() const;
 	const void				SetViewId( const int id );
 
@@ -139,8 +164,23 @@ public:
 
 	uint32_t				lights[ MaxLights ];
 	uint32_t				numLights;
+	uint32_t				numDirectionalLights;	// Leading entries of the light list, shaded everywhere instead of through clusters
 	uint32_t				drawGroupOffset[ DRAWPASS_COUNT ];
+	uint32_t				drawCommandOffset[ DRAWPASS_COUNT ];
+	bool					gpuCulling;
+	bool					occlusionCulling;	// Tested against the Hi-Z pyramid of the previous frame
+	float					lodBias;			// Scales the screen error allowed when selecting mesh LODs
+	bool					culled;				// Nothing drawn by a committed view can see the result, commit and rendering are skipped
+	bool					drawsChanged;		// Draw groups were rebuilt or patched by the last commit
+	bool					reuseFrameBuffer;	// The framebuffer still holds a valid earlier result, rendering is skipped
 	DrawPass*				passes[ DRAWPASS_COUNT ];
 	DrawGroup				drawGroup[ DRAWPASS_COUNT ];
+	LinearAllocator			drawArena;
+	std::vector<uint8_t>	visibleEntities;
+	std::vector<uint8_t>	lastVisibleEntities;
+	mat4x4f					sortViewMatrix;
+	mat4x4f					lodViewMatrix;		// Eye of the last LOD rescan
+	uint32_t				lodScanFrame;
+	std::vector<float>		lodRadius;			// Projected radius each entity's LOD was selected for, see LodRadius()
 	debugMenuArray_t		debugMenus;
 };
\ No newline at end of file
@@ -0,0 +1,208 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "resolutionScale.h"
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+#include <iostream>
+
+
+void ResolutionScaleController::Init( const resolutionScaleInfo_t& info )
+{
+	assert( info.budgetMs > 0.0f );
+	assert( ( info.minScale > 0.0f ) && ( info.minScale <= info.maxScale ) );
+
+	m_info = info;
+	Reset();
+}
+
+
+void ResolutionScaleController::Reset()
+{
+	m_scale = m_info.maxScale;
+	m_averageMs = 0.0f;
+	m_headroomFrames = 0;
+	m_hasSample = false;
+}
+
+
+float ResolutionScaleController::Quantize( const float scale ) const
+{
+	// Rounded down, a small bias keeps values already on a step from falling to the one below
+	const float quantized = floorf( scale / ScaleStep + 1e-3f ) * ScaleStep;
+	return std::min( std::max( quantized, m_info.minScale ), m_info.maxScale );
+}
+
+
+float ResolutionScaleController::Update( const float gpuFrameMs )
+{
+	// No measurement this frame, e.g. timestamps aren't supported or not written yet
+	if ( gpuFrameMs <= 0.0f ) {
+		return m_scale;
+	}
+
+	if ( m_hasSample == false ) {
+		m_averageMs = gpuFrameMs;
+		m_hasSample = true;
+	} else if ( gpuFrameMs > m_averageMs ) {
+		m_averageMs = gpuFrameMs;
+	} else {
+		m_averageMs += AverageWeight * ( gpuFrameMs - m_averageMs );
+	}
+
+	const float prevScale = m_scale;
+
+	if ( m_averageMs > m_info.budgetMs )
+	{
+		m_scale = Quantize( m_scale * sqrtf( m_info.budgetMs / m_averageMs ) );
+		m_headroomFrames = 0;
+	}
+	else if ( m_averageMs < ( HeadroomRatio * m_info.budgetMs ) )
+	{
+		++m_headroomFrames;
+		if ( m_headroomFrames >= m_info.settleFrames )
+		{
+			// Grows to where the frame would land on the headroom line, so the next frames stay under budget
+			const float fitScale = m_scale * sqrtf( HeadroomRatio * m_info.budgetMs / m_averageMs );
+			m_scale = Quantize( std::max( m_scale + ScaleStep, fitScale ) );
+			m_headroomFrames = 0;
+		}
+	}
+	else
+	{
+		m_headroomFrames = 0;
+	}
+
+	// The average was measured at the old scale, predict it at the new one so a single
+	// spike doesn't keep lowering the scale while the average decays
+	if ( m_scale != prevScale ) {
+		const float ratio = m_scale / prevScale;
+		m_averageMs *= ratio * ratio;
+	}
+
+	return m_scale;
+}
+
+
+float ResolutionScaleController::Scale() const
+{
+	return m_scale;
+}
+
+
+float ResolutionScaleController::AverageMs() const
+{
+	return m_averageMs;
+}
+
+
+// Synthetic GPU cost of a frame, a fixed part plus a part that follows the pixel count
+static float SyntheticFrameMs( const float fullResMs, const float fixedMs, const float scale )
+{
+	return fixedMs + ( fullResMs - fixedMs ) * scale * scale;
+}
+
+
+static bool HarnessCheck( const bool passed, const char* name, const ResolutionScaleController& controller )
+{
+	std::cout << ( passed ? "PASS" : "FAIL" ) << ": " << name << ", scale " << controller.Scale() << ", average " << controller.AverageMs() << "ms" << std::endl;
+	return passed;
+}
+
+
+bool RunResolutionScaleHarness()
+{
+	resolutionScaleInfo_t info = {};
+	info.budgetMs = 16.67f;
+	info.minScale = 0.5f;
+	info.maxScale = 1.0f;
+	info.settleFrames = 30;
+
+	bool passed = true;
+
+	// A scene twice as expensive as the budget settles under it without hitting the floor
+	{
+		ResolutionScaleController controller;
+		controller.Init( info );
+		for ( uint32_t frame = 0; frame < 300; ++frame ) {
+			controller.Update( SyntheticFrameMs( 2.0f * info.budgetMs, 2.0f, controller.Scale() ) );
+		}
+		const float frameMs = SyntheticFrameMs( 2.0f * info.budgetMs, 2.0f, controller.Scale() );
+		passed &= HarnessCheck( ( frameMs <= info.budgetMs ) && ( controller.Scale() > info.minScale ), "heavy scene fits the budget", controller );
+	}
+
+	// Cost no lower scale can meet clamps to the floor
+	{
+		ResolutionScaleController controller;
+		controller.Init( info );
+		for ( uint32_t frame = 0; frame < 300; ++frame ) {
+			controller.Update( SyntheticFrameMs( 10.0f * info.budgetMs, 0.0f, controller.Scale() ) );
+		}
+		passed &= HarnessCheck( controller.Scale() == info.minScale, "overloaded scene clamps to the minimum", controller );
+	}
+
+	// A single spike lowers the scale once, then it recovers to full resolution
+	{
+		ResolutionScaleController controller;
+		controller.Init( info );
+		float lowestScale = info.maxScale;
+		uint32_t drops = 0;
+		for ( uint32_t frame = 0; frame < 600; ++frame )
+		{
+			const float prevScale = controller.Scale();
+			const float frameMs = ( frame == 10 ) ? 3.0f * info.budgetMs : SyntheticFrameMs( 0.5f * info.budgetMs, 1.0f, prevScale );
+			controller.Update( frameMs );
+			drops += ( controller.Scale() < prevScale ) ? 1 : 0;
+			lowestScale = std::min( lowestScale, controller.Scale() );
+		}
+		passed &= HarnessCheck( ( drops == 1 ) && ( lowestScale < info.maxScale ) && ( controller.Scale() == info.maxScale ), "spike recovers", controller );
+	}
+
+	// Frames just under budget but above the headroom line leave the scale alone
+	{
+		ResolutionScaleController controller;
+		controller.Init( info );
+		controller.Update( 2.0f * info.budgetMs );
+		const float settledScale = controller.Scale();
+		bool changed = false;
+		for ( uint32_t frame = 0; frame < 300; ++frame )
+		{
+			controller.Update( 0.5f * ( 1.0f + ResolutionScaleController::HeadroomRatio ) * info.budgetMs );
+			changed |= ( controller.Scale() != settledScale );
+		}
+		passed &= HarnessCheck( changed == false, "steady frames near the budget don't oscillate", controller );
+	}
+
+	// Missing timings change nothing
+	{
+		ResolutionScaleController controller;
+		controller.Init( info );
+		controller.Update( 2.0f * info.budgetMs );
+		const float scale = controller.Scale();
+		controller.Update( 0.0f );
+		passed &= HarnessCheck( controller.Scale() == scale, "missing timing is ignored", controller );
+	}
+
+	return passed;
+}
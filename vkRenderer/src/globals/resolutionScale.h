@@ -0,0 +1,75 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+struct resolutionScaleInfo_t
+{
+	float		budgetMs;		// GPU frame time the scale is steered towards
+	float		minScale;		// Per-axis limits of the scale
+	float		maxScale;
+	uint32_t	settleFrames;	// Frames with headroom before the scale may grow a step
+};
+
+// Picks the per-axis render scale of the main view from measured GPU frame times. Cost is assumed
+// to follow the pixel count, the square of the scale. Over budget the scale drops right away, with
+// headroom it only grows after a run of frames so it doesn't oscillate.
+// Nothing here touches the device, the timings can come from timestamp queries or be synthetic.
+class ResolutionScaleController
+{
+private:
+	resolutionScaleInfo_t	m_info;
+	float					m_scale;
+	float					m_averageMs;	// Follows spikes at once, decays slowly
+	uint32_t				m_headroomFrames;
+	bool					m_hasSample;
+
+	float					Quantize( const float scale ) const;
+
+public:
+	static constexpr float	ScaleStep = 1.0f / 32.0f;	// Scales snap to this so the viewport changes in whole steps
+	static constexpr float	AverageWeight = 0.1f;		// Weight of a new sample that is below the average
+	static constexpr float	HeadroomRatio = 0.85f;		// Fraction of the budget that counts as room to grow
+
+	ResolutionScaleController()
+	{
+		resolutionScaleInfo_t info = {};
+		info.budgetMs = 16.0f;
+		info.minScale = 0.5f;
+		info.maxScale = 1.0f;
+		info.settleFrames = 30;
+
+		Init( info );
+	}
+
+	void					Init( const resolutionScaleInfo_t& info );
+	void					Reset();
+	float					Update( const float gpuFrameMs );
+	float					Scale() const;
+	float					AverageMs() const;
+};
+
+// Drives a controller with synthetic GPU timings and checks how it settles. Needs no device or window.
+bool RunResolutionScaleHarness();
@@ -0,0 +1,759 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "sceneBvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+static const uint32_t	SahBinCount = 12;
+static const float		FatMargin = 0.1f;			// Fraction of the entity extent added around each leaf
+static const float		MinFatMargin = 0.01f;		// Floor of the margin, flat entities have no extent on one axis
+static const float		RebuildCostRatio = 1.5f;	// Rebuild when reinsertions raise the tree cost past this ratio
+static const uint32_t	AllPlanes = ( 1 << 6 ) - 1;
+static const uint32_t	CullStackSize = 64;
+
+
+static float SurfaceArea( const float* boundsMin, const float* boundsMax )
+{
+	const float dx = boundsMax[ 0 ] - boundsMin[ 0 ];
+	const float dy = boundsMax[ 1 ] - boundsMin[ 1 ];
+	const float dz = boundsMax[ 2 ] - boundsMin[ 2 ];
+	return 2.0f * ( dx * dy + dy * dz + dz * dx );
+}
+
+
+static float UnionArea( const float* aMin, const float* aMax, const float* bMin, const float* bMax )
+{
+	float boundsMin[ 3 ];
+	float boundsMax[ 3 ];
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		boundsMin[ i ] = std::min( aMin[ i ], bMin[ i ] );
+		boundsMax[ i ] = std::max( aMax[ i ], bMax[ i ] );
+	}
+	return SurfaceArea( boundsMin, boundsMax );
+}
+
+
+// Axis-parallel rays would divide by zero and turn a slab on the origin into 0 * inf = NaN.
+// A huge finite reciprocal keeps the slab test exact without special cases.
+static float SafeReciprocal( const float x )
+{
+	const float MinDenom = 1e-30f;
+	if ( fabsf( x ) < MinDenom ) {
+		return ( x < 0.0f ) ? -1.0f / MinDenom : 1.0f / MinDenom;
+	}
+	return 1.0f / x;
+}
+
+
+static bool RayIntersectsBox( const float* boundsMin, const float* boundsMax, const vec3f& origin, const vec3f& invDir, float& tEnter )
+{
+	float tMin = 0.0f;
+	float tMax = FLT_MAX;
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		const float t0 = ( boundsMin[ i ] - origin[ i ] ) * invDir[ i ];
+		const float t1 = ( boundsMax[ i ] - origin[ i ] ) * invDir[ i ];
+		tMin = std::max( tMin, std::min( t0, t1 ) );
+		tMax = std::min( tMax, std::max( t0, t1 ) );
+	}
+	tEnter = tMin;
+	return ( tMin <= tMax );
+}
+
+
+int32_t SceneBvh::AllocNode()
+{
+	int32_t nodeIx = m_freeList;
+	if ( nodeIx >= 0 ) {
+		m_freeList = m_nodes[ nodeIx ].child[ 0 ];
+	} else {
+		nodeIx = static_cast<int32_t>( m_nodes.size() );
+		m_nodes.push_back( node_t() );
+	}
+
+	node_t& node = m_nodes[ nodeIx ];
+	node.parent = -1;
+	node.child[ 0 ] = -1;
+	node.child[ 1 ] = -1;
+	node.entity = -1;
+	return nodeIx;
+}
+
+
+void SceneBvh::FreeNode( const int32_t nodeIx )
+{
+	m_nodes[ nodeIx ].child[ 0 ] = m_freeList;
+	m_nodes[ nodeIx ].entity = -1;
+	m_freeList = nodeIx;
+}
+
+
+void SceneBvh::SetLeafBounds( const int32_t leafIx, const uint32_t entity )
+{
+	node_t& leaf = m_nodes[ leafIx ];
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		const float boundsMin = m_tightMin[ 3 * entity + i ];
+		const float boundsMax = m_tightMax[ 3 * entity + i ];
+		const float margin = std::max( FatMargin * ( boundsMax - boundsMin ), MinFatMargin );
+		leaf.boundsMin[ i ] = boundsMin - margin;
+		leaf.boundsMax[ i ] = boundsMax + margin;
+	}
+}
+
+
+void SceneBvh::RefitAncestors( int32_t nodeIx )
+{
+	while ( nodeIx >= 0 )
+	{
+		node_t& node = m_nodes[ nodeIx ];
+		const node_t& child0 = m_nodes[ node.child[ 0 ] ];
+		const node_t& child1 = m_nodes[ node.child[ 1 ] ];
+		m_internalArea -= SurfaceArea( node.boundsMin, node.boundsMax );
+		for ( uint32_t i = 0; i < 3; ++i )
+		{
+			node.boundsMin[ i ] = std::min( child0.boundsMin[ i ], child1.boundsMin[ i ] );
+			node.boundsMax[ i ] = std::max( child0.boundsMax[ i ], child1.boundsMax[ i ] );
+		}
+		m_internalArea += SurfaceArea( node.boundsMin, node.boundsMax );
+		nodeIx = node.parent;
+	}
+}
+
+
+int32_t SceneBvh::BuildRange( uint32_t* entities, const uint32_t count, const int32_t parent )
+{
+	assert( count > 0 );
+
+	// Nodes may move as the pool grows, so they are only accessed by index across recursion
+	const int32_t nodeIx = AllocNode();
+	m_nodes[ nodeIx ].parent = parent;
+
+	if ( count == 1 )
+	{
+		m_nodes[ nodeIx ].entity = entities[ 0 ];
+		m_leaves[ entities[ 0 ] ] = nodeIx;
+		SetLeafBounds( nodeIx, entities[ 0 ] );
+		return nodeIx;
+	}
+
+	float centroidMin[ 3 ] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float centroidMax[ 3 ] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		const uint32_t e = entities[ i ];
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			const float c = 0.5f * ( m_tightMin[ 3 * e + k ] + m_tightMax[ 3 * e + k ] );
+			centroidMin[ k ] = std::min( centroidMin[ k ], c );
+			centroidMax[ k ] = std::max( centroidMax[ k ], c );
+		}
+	}
+
+	uint32_t axis = 0;
+	for ( uint32_t k = 1; k < 3; ++k ) {
+		axis = ( ( centroidMax[ k ] - centroidMin[ k ] ) > ( centroidMax[ axis ] - centroidMin[ axis ] ) ) ? k : axis;
+	}
+	const float axisMin = centroidMin[ axis ];
+	const float axisExtent = centroidMax[ axis ] - centroidMin[ axis ];
+
+	uint32_t splitCount = count / 2;
+	if ( axisExtent > 0.0f )
+	{
+		auto BinOf = [ & ]( const uint32_t e ) {
+			const float c = 0.5f * ( m_tightMin[ 3 * e + axis ] + m_tightMax[ 3 * e + axis ] );
+			const uint32_t bin = static_cast<uint32_t>( SahBinCount * ( c - axisMin ) / axisExtent );
+			return std::min( bin, SahBinCount - 1 );
+		};
+
+		uint32_t binCounts[ SahBinCount ] = {};
+		float binMin[ SahBinCount ][ 3 ];
+		float binMax[ SahBinCount ][ 3 ];
+		for ( uint32_t b = 0; b < SahBinCount; ++b )
+		{
+			for ( uint32_t k = 0; k < 3; ++k )
+			{
+				binMin[ b ][ k ] = FLT_MAX;
+				binMax[ b ][ k ] = -FLT_MAX;
+			}
+		}
+
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			const uint32_t e = entities[ i ];
+			const uint32_t b = BinOf( e );
+			++binCounts[ b ];
+			for ( uint32_t k = 0; k < 3; ++k )
+			{
+				binMin[ b ][ k ] = std::min( binMin[ b ][ k ], m_tightMin[ 3 * e + k ] );
+				binMax[ b ][ k ] = std::max( binMax[ b ][ k ], m_tightMax[ 3 * e + k ] );
+			}
+		}
+
+		// Sweep from the right to get the cost of every right-hand side, then from the left to choose the split
+		float rightCost[ SahBinCount ];
+		{
+			float accumMin[ 3 ] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float accumMax[ 3 ] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			uint32_t accumCount = 0;
+			for ( uint32_t b = SahBinCount - 1; b > 0; --b )
+			{
+				for ( uint32_t k = 0; k < 3; ++k )
+				{
+					accumMin[ k ] = std::min( accumMin[ k ], binMin[ b ][ k ] );
+					accumMax[ k ] = std::max( accumMax[ k ], binMax[ b ][ k ] );
+				}
+				accumCount += binCounts[ b ];
+				rightCost[ b ] = ( accumCount > 0 ) ? accumCount * SurfaceArea( accumMin, accumMax ) : 0.0f;
+			}
+		}
+
+		float bestCost = FLT_MAX;
+		uint32_t bestSplit = 0;
+		{
+			float accumMin[ 3 ] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float accumMax[ 3 ] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			uint32_t accumCount = 0;
+			for ( uint32_t b = 0; b < ( SahBinCount - 1 ); ++b )
+			{
+				for ( uint32_t k = 0; k < 3; ++k )
+				{
+					accumMin[ k ] = std::min( accumMin[ k ], binMin[ b ][ k ] );
+					accumMax[ k ] = std::max( accumMax[ k ], binMax[ b ][ k ] );
+				}
+				accumCount += binCounts[ b ];
+				if ( ( accumCount == 0 ) || ( accumCount == count ) ) {
+					continue;
+				}
+
+				const float cost = accumCount * SurfaceArea( accumMin, accumMax ) + rightCost[ b + 1 ];
+				if ( cost < bestCost )
+				{
+					bestCost = cost;
+					bestSplit = b + 1;
+				}
+			}
+		}
+
+		if ( bestSplit > 0 )
+		{
+			uint32_t* mid = std::partition( entities, entities + count, [ & ]( const uint32_t e ) { return BinOf( e ) < bestSplit; } );
+			splitCount = static_cast<uint32_t>( mid - entities );
+		}
+	}
+
+	// Coincident centroids can't be separated by binning, split the range in half
+	if ( ( splitCount == 0 ) || ( splitCount == count ) ) {
+		splitCount = count / 2;
+	}
+
+	const int32_t child0 = BuildRange( entities, splitCount, nodeIx );
+	const int32_t child1 = BuildRange( entities + splitCount, count - splitCount, nodeIx );
+
+	m_nodes[ nodeIx ].child[ 0 ] = child0;
+	m_nodes[ nodeIx ].child[ 1 ] = child1;
+
+	node_t& node = m_nodes[ nodeIx ];
+	for ( uint32_t k = 0; k < 3; ++k )
+	{
+		node.boundsMin[ k ] = std::min( m_nodes[ child0 ].boundsMin[ k ], m_nodes[ child1 ].boundsMin[ k ] );
+		node.boundsMax[ k ] = std::max( m_nodes[ child0 ].boundsMax[ k ], m_nodes[ child1 ].boundsMax[ k ] );
+	}
+	m_internalArea += SurfaceArea( node.boundsMin, node.boundsMax );
+	return nodeIx;
+}
+
+
+// Descends toward the sibling that adds the least area to the tree, as in Box2D's dynamic tree
+void SceneBvh::InsertLeaf( const int32_t leafIx )
+{
+	if ( m_root < 0 )
+	{
+		m_root = leafIx;
+		m_nodes[ leafIx ].parent = -1;
+		return;
+	}
+
+	const float* leafMin = m_nodes[ leafIx ].boundsMin;
+	const float* leafMax = m_nodes[ leafIx ].boundsMax;
+
+	int32_t siblingIx = m_root;
+	while ( m_nodes[ siblingIx ].child[ 0 ] >= 0 )
+	{
+		const node_t& node = m_nodes[ siblingIx ];
+		const float area = SurfaceArea( node.boundsMin, node.boundsMax );
+		const float combinedArea = UnionArea( node.boundsMin, node.boundsMax, leafMin, leafMax );
+
+		const float siblingCost = 2.0f * combinedArea;
+		const float inheritanceCost = 2.0f * ( combinedArea - area );
+
+		float childCost[ 2 ];
+		for ( uint32_t c = 0; c < 2; ++c )
+		{
+			const node_t& child = m_nodes[ node.child[ c ] ];
+			const float unionArea = UnionArea( child.boundsMin, child.boundsMax, leafMin, leafMax );
+			const bool isLeaf = ( child.child[ 0 ] < 0 );
+			childCost[ c ] = ( isLeaf ? unionArea : ( unionArea - SurfaceArea( child.boundsMin, child.boundsMax ) ) ) + inheritanceCost;
+		}
+
+		if ( ( siblingCost < childCost[ 0 ] ) && ( siblingCost < childCost[ 1 ] ) ) {
+			break;
+		}
+		siblingIx = ( childCost[ 0 ] < childCost[ 1 ] ) ? node.child[ 0 ] : node.child[ 1 ];
+	}
+
+	const int32_t oldParentIx = m_nodes[ siblingIx ].parent;
+	const int32_t newParentIx = AllocNode();
+
+	// Starts empty so the refit below only adds its area
+	node_t& newParent = m_nodes[ newParentIx ];
+	newParent.parent = oldParentIx;
+	newParent.child[ 0 ] = siblingIx;
+	newParent.child[ 1 ] = leafIx;
+	for ( uint32_t k = 0; k < 3; ++k )
+	{
+		newParent.boundsMin[ k ] = 0.0f;
+		newParent.boundsMax[ k ] = 0.0f;
+	}
+
+	if ( oldParentIx >= 0 )
+	{
+		node_t& oldParent = m_nodes[ oldParentIx ];
+		oldParent.child[ ( oldParent.child[ 0 ] == siblingIx ) ? 0 : 1 ] = newParentIx;
+	} else {
+		m_root = newParentIx;
+	}
+
+	m_nodes[ siblingIx ].parent = newParentIx;
+	m_nodes[ leafIx ].parent = newParentIx;
+
+	RefitAncestors( newParentIx );
+}
+
+
+void SceneBvh::RemoveLeaf( const int32_t leafIx )
+{
+	if ( leafIx == m_root )
+	{
+		m_root = -1;
+		return;
+	}
+
+	const int32_t parentIx = m_nodes[ leafIx ].parent;
+	const int32_t grandParentIx = m_nodes[ parentIx ].parent;
+	const int32_t siblingIx = ( m_nodes[ parentIx ].child[ 0 ] == leafIx ) ? m_nodes[ parentIx ].child[ 1 ] : m_nodes[ parentIx ].child[ 0 ];
+
+	m_nodes[ siblingIx ].parent = grandParentIx;
+	if ( grandParentIx >= 0 )
+	{
+		node_t& grandParent = m_nodes[ grandParentIx ];
+		grandParent.child[ ( grandParent.child[ 0 ] == parentIx ) ? 0 : 1 ] = siblingIx;
+		RefitAncestors( grandParentIx );
+	} else {
+		m_root = siblingIx;
+	}
+
+	m_internalArea -= SurfaceArea( m_nodes[ parentIx ].boundsMin, m_nodes[ parentIx ].boundsMax );
+	FreeNode( parentIx );
+	m_nodes[ leafIx ].parent = -1;
+}
+
+
+// Internal node area relative to the root, the expected number of nodes a random ray visits.
+// The area sum is kept up to date by builds, refits and removals, so this doesn't walk the tree.
+float SceneBvh::Cost() const
+{
+	if ( ( m_root < 0 ) || ( m_nodes[ m_root ].child[ 0 ] < 0 ) ) {
+		return 0.0f;
+	}
+
+	const float rootArea = SurfaceArea( m_nodes[ m_root ].boundsMin, m_nodes[ m_root ].boundsMax );
+	if ( rootArea <= 0.0f ) {
+		return 0.0f;
+	}
+	return static_cast<float>( m_internalArea / rootArea );
+}
+
+
+void SceneBvh::Build( const CullBounds& bounds )
+{
+	const uint32_t count = bounds.Count();
+
+	m_nodes.clear();
+	m_nodes.reserve( 2 * count );
+	m_root = -1;
+	m_freeList = -1;
+	m_internalArea = 0.0;
+
+	m_leaves.assign( count, -1 );
+	m_tightMin.resize( 3 * count );
+	m_tightMax.resize( 3 * count );
+	m_unbounded.clear();
+
+	std::vector<uint32_t> entities;
+	entities.reserve( count );
+	for ( uint32_t e = 0; e < count; ++e )
+	{
+		if ( bounds.IsUnbounded( e ) )
+		{
+			m_unbounded.push_back( e );
+			continue;
+		}
+
+		const vec3f center = bounds.Center( e );
+		const vec3f extent = bounds.Extent( e );
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			m_tightMin[ 3 * e + k ] = center[ k ] - extent[ k ];
+			m_tightMax[ 3 * e + k ] = center[ k ] + extent[ k ];
+		}
+		entities.push_back( e );
+	}
+
+	if ( entities.empty() == false ) {
+		m_root = BuildRange( entities.data(), static_cast<uint32_t>( entities.size() ), -1 );
+	}
+
+	m_builtCost = Cost();
+	m_rebuilt = true;
+}
+
+
+void SceneBvh::Update( const CullBounds& bounds )
+{
+	const uint32_t count = bounds.Count();
+
+	m_reinsertCount = 0;
+	m_rebuilt = false;
+
+	if ( count != m_leaves.size() )
+	{
+		Build( bounds );
+		return;
+	}
+
+	for ( uint32_t e = 0; e < count; ++e )
+	{
+		if ( bounds.IsUnbounded( e ) != ( m_leaves[ e ] < 0 ) )
+		{
+			Build( bounds );
+			return;
+		}
+	}
+
+	for ( uint32_t e = 0; e < count; ++e )
+	{
+		const int32_t leafIx = m_leaves[ e ];
+		if ( leafIx < 0 ) {
+			continue;
+		}
+
+		const vec3f center = bounds.Center( e );
+		const vec3f extent = bounds.Extent( e );
+
+		bool changed = false;
+		bool contained = true;
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			const float boundsMin = center[ k ] - extent[ k ];
+			const float boundsMax = center[ k ] + extent[ k ];
+			changed = changed || ( boundsMin != m_tightMin[ 3 * e + k ] ) || ( boundsMax != m_tightMax[ 3 * e + k ] );
+			contained = contained && ( boundsMin >= m_nodes[ leafIx ].boundsMin[ k ] ) && ( boundsMax <= m_nodes[ leafIx ].boundsMax[ k ] );
+
+			m_tightMin[ 3 * e + k ] = boundsMin;
+			m_tightMax[ 3 * e + k ] = boundsMax;
+		}
+
+		if ( ( changed == false ) || contained ) {
+			continue;
+		}
+
+		RemoveLeaf( leafIx );
+		SetLeafBounds( leafIx, e );
+		InsertLeaf( leafIx );
+		++m_reinsertCount;
+	}
+
+	if ( ( m_reinsertCount > 0 ) && ( Cost() > ( RebuildCostRatio * m_builtCost ) ) ) {
+		Build( bounds );
+	}
+}
+
+
+uint32_t SceneBvh::EntityCount() const
+{
+	return static_cast<uint32_t>( m_leaves.size() );
+}
+
+
+uint32_t SceneBvh::NodeCount() const
+{
+	return static_cast<uint32_t>( m_nodes.size() );
+}
+
+
+uint32_t SceneBvh::ReinsertCount() const
+{
+	return m_reinsertCount;
+}
+
+
+bool SceneBvh::Rebuilt() const
+{
+	return m_rebuilt;
+}
+
+
+// Planes a node is fully inside of are dropped for its subtree, so nodes inside the frustum are accepted without tests.
+// The walk descends into the first child and stacks the second, so the stack holds at most one entry per level.
+// Trees degraded deeper than the stack by reinsertion continue the overflowing subtree in a nested walk.
+uint32_t SceneBvh::CullSubtree( const int32_t rootIx, const uint32_t rootPlaneMask, const frustum_t& frustum, uint8_t* visible ) const
+{
+	struct entry_t
+	{
+		int32_t		nodeIx;
+		uint32_t	planeMask;
+	};
+
+	entry_t stack[ CullStackSize ];
+	uint32_t stackCount = 0;
+	stack[ stackCount++ ] = { rootIx, rootPlaneMask };
+
+	uint32_t visibleCount = 0;
+	while ( stackCount > 0 )
+	{
+		const entry_t entry = stack[ --stackCount ];
+
+		const node_t& node = m_nodes[ entry.nodeIx ];
+		const bool isLeaf = ( node.child[ 0 ] < 0 );
+
+		// Leaves are tested with the tight entity bounds to match per-entity culling exactly
+		const float* boundsMin = isLeaf ? &m_tightMin[ 3 * node.entity ] : node.boundsMin;
+		const float* boundsMax = isLeaf ? &m_tightMax[ 3 * node.entity ] : node.boundsMax;
+
+		uint32_t planeMask = entry.planeMask;
+		bool outside = false;
+		for ( uint32_t p = 0; ( p < 6 ) && ( outside == false ); ++p )
+		{
+			if ( ( planeMask & ( 1 << p ) ) == 0 ) {
+				continue;
+			}
+
+			const float cx = 0.5f * ( boundsMin[ 0 ] + boundsMax[ 0 ] );
+			const float cy = 0.5f * ( boundsMin[ 1 ] + boundsMax[ 1 ] );
+			const float cz = 0.5f * ( boundsMin[ 2 ] + boundsMax[ 2 ] );
+			const float ex = 0.5f * ( boundsMax[ 0 ] - boundsMin[ 0 ] );
+			const float ey = 0.5f * ( boundsMax[ 1 ] - boundsMin[ 1 ] );
+			const float ez = 0.5f * ( boundsMax[ 2 ] - boundsMin[ 2 ] );
+
+			const float dist = cx * frustum.nx[ p ] + cy * frustum.ny[ p ] + cz * frustum.nz[ p ] + frustum.d[ p ];
+			const float radius = ex * fabsf( frustum.nx[ p ] ) + ey * fabsf( frustum.ny[ p ] ) + ez * fabsf( frustum.nz[ p ] );
+
+			if ( ( dist + radius ) < 0.0f ) {
+				outside = true;
+			} else if ( ( dist - radius ) >= 0.0f ) {
+				planeMask &= ~( 1 << p );
+			}
+		}
+
+		if ( outside ) {
+			continue;
+		}
+
+		if ( isLeaf )
+		{
+			visible[ node.entity ] = 1;
+			++visibleCount;
+			continue;
+		}
+
+		if ( stackCount < ( CullStackSize - 1 ) ) {
+			stack[ stackCount++ ] = { node.child[ 1 ], planeMask };
+		} else {
+			visibleCount += CullSubtree( node.child[ 1 ], planeMask, frustum, visible );
+		}
+		stack[ stackCount++ ] = { node.child[ 0 ], planeMask };
+	}
+	return visibleCount;
+}
+
+
+uint32_t SceneBvh::CullFrustum( const frustum_t& frustum, uint8_t* visible ) const
+{
+	const uint32_t count = EntityCount();
+	if ( count > 0 ) {
+		memset( visible, 0, count );
+	}
+
+	uint32_t visibleCount = 0;
+	for ( const uint32_t e : m_unbounded )
+	{
+		visible[ e ] = 1;
+		++visibleCount;
+	}
+
+	if ( m_root >= 0 ) {
+		visibleCount += CullSubtree( m_root, AllPlanes, frustum, visible );
+	}
+	return visibleCount;
+}
+
+
+// Hits are sorted by entry distance so callers doing exact tests can stop at the first closer hit
+void SceneBvh::IntersectRay( const vec3f& origin, const vec3f& dir, std::vector<bvhRayHit_t>& hits ) const
+{
+	hits.clear();
+	if ( m_root < 0 ) {
+		return;
+	}
+
+	const vec3f invDir = vec3f( SafeReciprocal( dir[ 0 ] ), SafeReciprocal( dir[ 1 ] ), SafeReciprocal( dir[ 2 ] ) );
+
+	std::vector<int32_t> stack;
+	stack.reserve( 64 );
+	stack.push_back( m_root );
+
+	while ( stack.empty() == false )
+	{
+		const node_t& node = m_nodes[ stack.back() ];
+		stack.pop_back();
+
+		float t = 0.0f;
+		if ( RayIntersectsBox( node.boundsMin, node.boundsMax, origin, invDir, t ) == false ) {
+			continue;
+		}
+
+		if ( node.child[ 0 ] >= 0 )
+		{
+			stack.push_back( node.child[ 0 ] );
+			stack.push_back( node.child[ 1 ] );
+			continue;
+		}
+
+		if ( RayIntersectsBox( &m_tightMin[ 3 * node.entity ], &m_tightMax[ 3 * node.entity ], origin, invDir, t ) ) {
+			hits.push_back( { static_cast<uint32_t>( node.entity ), t } );
+		}
+	}
+
+	std::sort( hits.begin(), hits.end(), []( const bvhRayHit_t& lhs, const bvhRayHit_t& rhs ) {
+		return lhs.t < rhs.t;
+	} );
+}
+
+
+// Depth-first leaf order keeps spatial neighbours together, unbounded entities come last
+void SceneBvh::LeafOrder( std::vector<uint32_t>& entities ) const
+{
+	entities.clear();
+	entities.reserve( EntityCount() );
+
+	if ( m_root >= 0 )
+	{
+		std::vector<int32_t> stack;
+		stack.push_back( m_root );
+		while ( stack.empty() == false )
+		{
+			const node_t& node = m_nodes[ stack.back() ];
+			stack.pop_back();
+
+			if ( node.child[ 0 ] < 0 )
+			{
+				entities.push_back( node.entity );
+				continue;
+			}
+			stack.push_back( node.child[ 1 ] );
+			stack.push_back( node.child[ 0 ] );
+		}
+	}
+	entities.insert( entities.end(), m_unbounded.begin(), m_unbounded.end() );
+}
+
+
+bool RayIntersectsBounds( const AABB& localBounds, const mat4x4f& transform, const vec3f& origin, const vec3f& dir, float& t )
+{
+	const vec4f translation = transform * vec4f( 0.0f, 0.0f, 0.0f, 1.0f );
+	const vec3f offset = origin - Trunc<4,1>( translation );
+
+	// Without shear the axes are orthogonal, so projecting onto each scaled axis inverts the transform
+	float localMin[ 3 ];
+	float localMax[ 3 ];
+	vec3f localOrigin;
+	vec3f localInvDir;
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		vec4f basis = vec4f( 0.0f, 0.0f, 0.0f, 0.0f );
+		basis[ i ] = 1.0f;
+		const vec3f axis = Trunc<4,1>( transform * basis );
+		const float lengthSq = Dot( axis, axis );
+		if ( lengthSq <= 0.0f ) {
+			return false;
+		}
+
+		localOrigin[ i ] = Dot( offset, axis ) / lengthSq;
+		localInvDir[ i ] = lengthSq * SafeReciprocal( Dot( dir, axis ) );
+		localMin[ i ] = localBounds.GetMin()[ i ];
+		localMax[ i ] = localBounds.GetMax()[ i ];
+	}
+	return RayIntersectsBox( localMin, localMax, localOrigin, localInvDir, t );
+}
+
+
+Entity* TraceEntity( Scene* scene, const SceneBvh& bvh, const Ray& ray )
+{
+	const uint32_t entCount = static_cast<uint32_t>( scene->entities.size() );
+	if ( bvh.EntityCount() != entCount ) {
+		return scene->GetTracedEntity( ray );
+	}
+
+	const vec3f origin = vec3f( float( ray.o[ 0 ] ), float( ray.o[ 1 ] ), float( ray.o[ 2 ] ) );
+	const vec3f dir = vec3f( float( ray.d[ 0 ] ), float( ray.d[ 1 ] ), float( ray.d[ 2 ] ) );
+
+	std::vector<bvhRayHit_t> hits;
+	bvh.IntersectRay( origin, dir, hits );
+
+	Entity* closest = nullptr;
+	float closestT = FLT_MAX;
+	for ( const bvhRayHit_t& hit : hits )
+	{
+		// World bounds contain the oriented bounds, nothing further along can be closer
+		if ( hit.t >= closestT ) {
+			break;
+		}
+
+		Entity* ent = scene->entities[ hit.entity ];
+		if ( ent->HasFlag( ENT_FLAG_NO_DRAW ) ) {
+			continue;
+		}
+
+		float t = 0.0f;
+		if ( RayIntersectsBounds( ent->GetLocalBounds(), ent->GetMatrix(), origin, dir, t ) && ( t < closestT ) )
+		{
+			closestT = t;
+			closest = ent;
+		}
+	}
+	return closest;
+}
@@ -0,0 +1,105 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+#include <gfxcore/scene/scene.h>
+#include <gfxcore/primitives/geom.h>
+#include "common.h"
+#include "cull.h"
+
+struct bvhRayHit_t
+{
+	uint32_t	entity;
+	float		t;			// Entry distance into the entity bounds in units of the ray direction
+};
+
+
+// Dynamic bounding volume hierarchy over entity world bounds, one entity per leaf.
+// Built top-down with a binned SAH. Leaves hold fattened bounds so small moves only refit the tight box;
+// entities that leave their fattened bounds are removed and reinserted. The tree is rebuilt when
+// reinsertions have degraded its cost too far or the entity list changes.
+// Unbounded entities are kept out of the tree and always pass culling.
+class SceneBvh
+{
+private:
+	struct node_t
+	{
+		float		boundsMin[ 3 ];
+		float		boundsMax[ 3 ];
+		int32_t		parent;
+		int32_t		child[ 2 ];		// -1 for leaves, child[ 0 ] links free nodes
+		int32_t		entity;			// Leaves only
+	};
+
+	std::vector<node_t>		m_nodes;
+	std::vector<int32_t>	m_leaves;		// Leaf node of each entity, -1 if unbounded
+	std::vector<float>		m_tightMin;		// Exact entity bounds, 3 floats per entity
+	std::vector<float>		m_tightMax;
+	std::vector<uint32_t>	m_unbounded;
+	int32_t					m_root;
+	int32_t					m_freeList;
+	float					m_builtCost;
+	double					m_internalArea;		// Summed surface area of internal nodes, double so refits drift little before the next build
+	uint32_t				m_reinsertCount;
+	bool					m_rebuilt;
+
+	int32_t					AllocNode();
+	void					FreeNode( const int32_t nodeIx );
+	int32_t					BuildRange( uint32_t* entities, const uint32_t count, const int32_t parent );
+	void					InsertLeaf( const int32_t leafIx );
+	void					RemoveLeaf( const int32_t leafIx );
+	void					RefitAncestors( int32_t nodeIx );
+	void					SetLeafBounds( const int32_t leafIx, const uint32_t entity );
+	float					Cost() const;
+	uint32_t				CullSubtree( const int32_t rootIx, const uint32_t rootPlaneMask, const frustum_t& frustum, uint8_t* visible ) const;
+
+public:
+	SceneBvh()
+	{
+		m_root = -1;
+		m_freeList = -1;
+		m_builtCost = 0.0f;
+		m_internalArea = 0.0;
+		m_reinsertCount = 0;
+		m_rebuilt = false;
+	}
+
+	void					Build( const CullBounds& bounds );
+	void					Update( const CullBounds& bounds );
+
+	uint32_t				EntityCount() const;
+	uint32_t				NodeCount() const;
+	uint32_t				ReinsertCount() const;
+	bool					Rebuilt() const;
+
+	uint32_t				CullFrustum( const frustum_t& frustum, uint8_t* visible ) const;
+	void					IntersectRay( const vec3f& origin, const vec3f& dir, std::vector<bvhRayHit_t>& hits ) const;
+	void					LeafOrder( std::vector<uint32_t>& entities ) const;
+};
+
+// Exact test against bounds under a transform without shear. Returns the entry distance in units of dir.
+bool RayIntersectsBounds( const AABB& localBounds, const mat4x4f& transform, const vec3f& origin, const vec3f& dir, float& t );
+
+// Closest drawn entity whose oriented bounds the ray hits. Falls back to Scene::GetTracedEntity
+// while the hierarchy hasn't caught up with entities added since the last commit.
+Entity* TraceEntity( Scene* scene, const SceneBvh& bvh, const Ray& ray );
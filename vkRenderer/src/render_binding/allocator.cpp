@@ -67,7 +67,7 @@ void Allocation::Free()
 }
 
 
-void AllocatorMemory::Create( const uint32_t sizeBytes, const memoryRegion_t region, const resourceLifeTime_t lifetime )
+void AllocatorMemory::Create( const uint64_t sizeBytes, const memoryRegion_t region, const resourceLifeTime_t lifetime )
 {
 	// Resource Management
 	{
@@ -212,10 +212,51 @@ bool AllocatorMemory::Allocate( uint64_t alignment, uint64_t allocSize, Allocati
 
 	const uint64_t nextOffset = GetAlignedOffset( alignment );
 
+	AddRecord( nextOffset, allocSize, alignment, handle );
+
+	m_offset = nextOffset + allocSize;
+
+	return true;
+}
+
+
+bool AllocatorMemory::AllocateAliased( uint64_t alignment, uint64_t allocSize, allocAliasSlot_t& slot, Allocation& handle )
+{
+	if ( slot.isValid == false )
+	{
+		if ( !Allocate( alignment, allocSize, handle ) ) {
+			return false;
+		}
+
+		slot.offset = GetRecord( handle.handle )->offset;
+		slot.size = allocSize;
+		slot.aliasCount = 1;
+		slot.isValid = true;
+
+		return true;
+	}
+
+	const uint64_t boundary = ( slot.offset % alignment );
+	const uint64_t slotOffset = ( boundary == 0 ) ? slot.offset : ( slot.offset + alignment - boundary );
+
+	// Resources that outgrow the slot get their own range
+	if ( ( slotOffset + allocSize ) > ( slot.offset + slot.size ) ) {
+		return Allocate( alignment, allocSize, handle );
+	}
+
+	AddRecord( slotOffset, allocSize, alignment, handle );
+	++slot.aliasCount;
+
+	return true;
+}
+
+
+void AllocatorMemory::AddRecord( const uint64_t offset, const uint64_t allocSize, const uint64_t alignment, Allocation& handle )
+{
 	const int index = static_cast<int>( m_allocations.size() );
 
 	allocRecord_t alloc;
-	alloc.offset = nextOffset;
+	alloc.offset = offset;
 	alloc.size = allocSize;
 	alloc.alignment = alignment;
 	alloc.isValid = true;
@@ -224,10 +265,6 @@ bool AllocatorMemory::Allocate( uint64_t alignment, uint64_t allocSize, Allocati
 	handle.handle = hdl_t( index );
 	handle.allocator = this;
 	m_handles.push_back( index );
-
-	m_offset = nextOffset + allocSize;
-
-	return true;
 }
 
 
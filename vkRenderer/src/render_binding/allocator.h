@@ -44,6 +44,17 @@ struct allocRecord_t
 };
 
 
+// A range of an allocator shared by resources that are never in use at the same time.
+// The first resource placed in the slot reserves it, later ones are placed at its start when they fit.
+struct allocAliasSlot_t
+{
+	uint64_t	offset;
+	uint64_t	size;
+	uint32_t	aliasCount;
+	bool		isValid;
+};
+
+
 class Allocation
 {
 private:
@@ -91,6 +102,8 @@ private:
 
 	friend class Allocation;
 
+	void					AddRecord( const uint64_t offset, const uint64_t allocSize, const uint64_t alignment, Allocation& handle );
+
 public:
 	AllocatorMemory()
 	{
@@ -109,7 +122,7 @@ public:
 		m_memoryRegion = memoryRegion_t::UNKNOWN;
 	}
 
-	void					Create( const uint32_t sizeBytes, const memoryRegion_t region, const resourceLifeTime_t lifetime );
+	void					Create( const uint64_t sizeBytes, const memoryRegion_t region, const resourceLifeTime_t lifetime );
 	void					Destroy();
 
 	void					Bind( VkDeviceMemory& _memory, void* memMap, const uint64_t _size, const uint32_t _type );
@@ -121,6 +134,7 @@ public:
 	uint64_t				GetAlignedOffset( const uint64_t alignment ) const;
 	bool					CanAllocate( uint64_t alignment, uint64_t allocSize ) const;
 	bool					Allocate( uint64_t alignment, uint64_t allocSize, Allocation& handle );
+	bool					AllocateAliased( uint64_t alignment, uint64_t allocSize, allocAliasSlot_t& slot, Allocation& handle );
 	void					Reset();
 	void					Free( hdl_t& handle );
 	memoryRegion_t			GetMemoryRegion() const;
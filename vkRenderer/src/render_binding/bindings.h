@@ -11,6 +11,12 @@ BINDING( particleWriteBuffer,	WRITE_BUFFER,		1,						BIND_STATE_CS );
 BINDING( computeParms,			CONSTANT_BUFFER,	1,						BIND_STATE_CS );
 BINDING( computeWrite,			WRITE_BUFFER,		1,						BIND_STATE_CS );
 BINDING( computeImage,			IMAGE_2D_ARRAY,		MaxImageDescriptors,	BIND_STATE_CS );
+BINDING( drawRemapWrite,		WRITE_BUFFER,		1,						BIND_STATE_CS );
+BINDING( drawCommandWrite,		WRITE_BUFFER,		1,						BIND_STATE_CS );
+BINDING( cullStatsWrite,		WRITE_BUFFER,		1,						BIND_STATE_CS );
+BINDING( hiZSourceImage,		IMAGE_2D,			1,						BIND_STATE_CS );
+BINDING( hiZPyramidWrite,		WRITE_BUFFER,		1,						BIND_STATE_CS );
+BINDING( clusterLightsWrite,	WRITE_BUFFER,		1,						BIND_STATE_CS );
 
 // Post Effect Resources
 BINDING( imageProcess,			CONSTANT_BUFFER,	1,						BIND_STATE_PS );
@@ -20,8 +26,12 @@ BINDING( sourceCubeImages,		IMAGE_CUBE,	1,			BIND_STATE_PS );
 // Raster Resources
 BINDING( viewBuffer,			READ_BUFFER,		1,						BIND_STATE_ALL );
 BINDING( modelBuffer,			READ_BUFFER,		1,						BIND_STATE_ALL );
-BINDING( image2DArray,			IMAGE_2D_ARRAY,		MaxImageDescriptors,	BIND_STATE_ALL );
-BINDING( imageCubeArray,		IMAGE_CUBE_ARRAY,	MaxImageDescriptors,	BIND_STATE_ALL );
+BINDING( drawRemapBuffer,		READ_BUFFER,		1,						BIND_STATE_VS );
+BINDING( hiZPyramidBuffer,		READ_BUFFER,		1,						BIND_STATE_ALL );
+BINDING( hiZParms,				CONSTANT_BUFFER,	1,						BIND_STATE_ALL );
+BINDING( clusterLightsBuffer,	READ_BUFFER,		1,						BIND_STATE_PS );
+BINDING( image2DArray,			IMAGE_2D_TABLE,		MaxBindlessImages,		BIND_STATE_ALL );
+BINDING( imageCubeArray,		IMAGE_CUBE_TABLE,	MaxBindlessImages,		BIND_STATE_ALL );
 BINDING( materialBuffer,		READ_BUFFER,		1,						BIND_STATE_ALL );
 BINDING( lightBuffer,			READ_BUFFER,		1,						BIND_STATE_ALL );
 BINDING( imageCodeArray,		IMAGE_2D_ARRAY,		MaxCodeImages,			BIND_STATE_ALL );
@@ -42,6 +52,10 @@ const uint64_t bindset_global = Hash( "bindset_global" );
 static const ShaderBinding g_viewBindings[] =
 {
 	bind_modelBuffer,
+	bind_drawRemapBuffer,
+	bind_hiZPyramidBuffer,
+	bind_hiZParms,
+	bind_clusterLightsBuffer,
 };
 const uint64_t bindset_view = Hash( "bindset_view" );
 
@@ -73,6 +87,36 @@ static const ShaderBinding g_computeBindings[] =
 const uint64_t bindset_compute = Hash( "bindset_compute" );
 
 
+static const ShaderBinding g_cullBindings[] =
+{
+	bind_viewBuffer,
+	bind_modelBuffer,
+	bind_drawRemapWrite,
+	bind_drawCommandWrite,
+	bind_hiZPyramidBuffer,
+	bind_hiZParms,
+	bind_cullStatsWrite,
+};
+const uint64_t bindset_cull = Hash( "bindset_cull" );
+
+
+static const ShaderBinding g_hiZBindings[] =
+{
+	bind_hiZSourceImage,
+	bind_hiZPyramidWrite,
+};
+const uint64_t bindset_hiZ = Hash( "bindset_hiZ" );
+
+
+static const ShaderBinding g_lightCullBindings[] =
+{
+	bind_viewBuffer,
+	bind_lightBuffer,
+	bind_clusterLightsWrite,
+};
+const uint64_t bindset_lightCull = Hash( "bindset_lightCull" );
+
+
 static const ShaderBinding g_imageProcessBindings[] =
 {
 	bind_sourceImages,
@@ -39,9 +39,54 @@ struct vsInput_t
 struct surfaceBufferObject_t
 {
 	mat4x4f		model;
+	vec4f		boundsCenter;	// World-space AABB used by GPU culling
+	vec4f		boundsExtent;
 	uint32_t	diffuseIblCubeId;
 	uint32_t	envCubeId;
-	uint32_t	pad[ 14 ];
+	uint32_t	drawId;			// Indirect command that draws this object
+	uint32_t	cullFlags;		// SURF_CULL_* bits
+	uint32_t	pad[ 4 ];
+};
+
+
+enum surfaceCullFlags_t : uint32_t
+{
+	SURF_CULL_NONE			= 0,
+	SURF_CULL_NO_OCCLUSION	= ( 1 << 0 ),	// Moved since the Hi-Z pyramid was built, last frame's depth can't be trusted
+};
+
+
+// Matches VkDrawIndexedIndirectCommand
+struct drawCommandBufferObject_t
+{
+	uint32_t	indexCount;
+	uint32_t	instanceCount;
+	uint32_t	firstIndex;
+	int32_t		vertexOffset;
+	uint32_t	firstInstance;
+};
+
+
+// Describes the Hi-Z pyramid as it was built in the previous frame
+struct hiZBufferObject_t
+{
+	mat4x4f		viewMat;
+	mat4x4f		projMat;
+	vec4f		dimensions;		// Level 0 width, height, 1/width, 1/height
+	uint32_t	levelCount;
+	uint32_t	valid;			// Occlusion culling is skipped until a pyramid exists
+	int32_t		debugLevel;		// Level shown by the post process, negative is off
+	uint32_t	pad;
+	uint32_t	levelOffsets[ MaxHiZLevels ];
+};
+
+
+struct cullStatsBufferObject_t
+{
+	uint32_t	visible;
+	uint32_t	frustumCulled;
+	uint32_t	occlusionCulled;
+	uint32_t	pad;
 };
 
 
@@ -50,7 +95,11 @@ struct viewBufferObject_t
 	mat4x4f		view;
 	mat4x4f		proj;
 	vec4f		dimensions;
+	vec4f		viewportRect;	// Offset and scale of the viewport within the framebuffer, in UVs
 	uint32_t	numLights;
+	float		nearClip;		// Depth range split into light cluster slices
+	float		farClip;
+	uint32_t	numDirectionalLights;
 };
 
 
@@ -61,6 +110,7 @@ struct globalUboConstants_t
 	vec4f		shadowParms;
 	vec4f		tonemap;
 	vec4f		dof;
+	vec4f		resolutionScale;	// Main view viewport over its target size (xy) and the inverse (zw)
 	uint32_t	numSamples;
 	uint32_t	whiteId;
 	uint32_t	blackId;
@@ -97,8 +147,11 @@ struct lightBufferObject_t
 	vec4f		lightPos;
 	vec4f		intensity;
 	vec4f		lightDir;
-	uint32_t	shadowViewId;
-	uint32_t	pad[ 3 ];
+	vec4f		cascadeSplits;	// View depth where each cascade ends
+	uint32_t	shadowViewId;	// First cascade for directional lights, the others follow it
+	uint32_t	cascadeCount;
+	float		radius;			// Distance where the falloff reaches zero
+	uint32_t	pad;
 };
 
 
@@ -91,27 +91,128 @@ public:
 
 static DescriptorWritesBuilder writeBuilder;
 
-static void AppendDescriptorWrites( const ShaderBindParms& parms, const uint32_t currentBuffer, std::vector<VkWriteDescriptorSet>& descSetWrites )
+static inline bool SameBufferInfo( const VkDescriptorBufferInfo& lhs, const VkDescriptorBufferInfo& rhs )
+{
+	return ( lhs.buffer == rhs.buffer ) && ( lhs.offset == rhs.offset ) && ( lhs.range == rhs.range );
+}
+
+
+static inline bool SameImageInfo( const VkDescriptorImageInfo& lhs, const VkDescriptorImageInfo& rhs )
+{
+	return ( lhs.sampler == rhs.sampler ) && ( lhs.imageView == rhs.imageView ) && ( lhs.imageLayout == rhs.imageLayout );
+}
+
+
+static VkDescriptorImageInfo MakeImageInfo( const Image& image, const uint32_t currentBuffer, const VkSampler depthSampler )
+{
+	VkDescriptorImageInfo info = {};
+	info.imageView = image.gpuImage->GetVkImageView( currentBuffer );
+	assert( info.imageView != nullptr );
+
+	if ( ( image.info.aspect & ( IMAGE_ASPECT_DEPTH_FLAG | IMAGE_ASPECT_STENCIL_FLAG ) ) != 0 )
+	{
+		info.sampler = ( depthSampler != VK_NULL_HANDLE ) ? depthSampler : context.bilinearSampler[ image.sampler.addrMode ];
+		info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	}
+	else
+	{
+		info.sampler = context.bilinearSampler[ image.sampler.addrMode ];
+		info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+	return info;
+}
+
+
+// Texture tables only write slots that changed, one write per run of adjacent slots. Empty
+// slots stay unwritten when partially bound, otherwise they hold a default image.
+static void AppendTableWrites( const ImageTable& table, const ShaderBinding& binding, const uint32_t currentBuffer, const bool rebound,
+								descriptorCache_t& cache, const VkWriteDescriptorSet& writeTemplate, std::vector<VkWriteDescriptorSet>& descSetWrites, uint32_t& descriptorCount )
+{
+	const uint32_t descCount = binding.GetDescriptorCount();
+	const uint32_t slotCount = Min( table.Capacity(), descCount );
+
+	const Image* emptyImage = nullptr;
+	if ( context.bindlessPartiallyBound == false ) {
+		emptyImage = ( binding.GetType() == bindType_t::IMAGE_CUBE_TABLE ) ? rc.defaultImageCube : rc.whiteImage;
+	}
+
+	cache.imageInfos.resize( descCount );
+
+	uint32_t runStart = descCount;
+	for ( uint32_t slot = 0; slot <= descCount; ++slot )
+	{
+		bool changed = false;
+		if ( slot < descCount )
+		{
+			const Image* image = ( slot < slotCount ) ? table[ slot ] : nullptr;
+			image = ( image != nullptr ) ? image : emptyImage;
+
+			// Nothing to write for an empty slot, its stale descriptor is never read
+			VkDescriptorImageInfo newInfo = {};
+			uint32_t generation = 0;
+			if ( image != nullptr )
+			{
+				newInfo = MakeImageInfo( *image, currentBuffer, VK_NULL_HANDLE );
+				generation = image->gpuImage->GetGeneration();
+			}
+
+			changed = rebound || ( cache.generations[ slot ] != generation ) || ( SameImageInfo( cache.imageInfos[ slot ], newInfo ) == false );
+			cache.generations[ slot ] = generation;
+			cache.imageInfos[ slot ] = newInfo;
+
+			changed = changed && ( image != nullptr );
+		}
+
+		if ( changed && ( runStart == descCount ) ) {
+			runStart = slot;
+		}
+
+		if ( ( changed == false ) && ( runStart != descCount ) )
+		{
+			// Points into the cache, which isn't touched again before the writes are submitted
+			VkWriteDescriptorSet writeInfo = writeTemplate;
+			writeInfo.dstArrayElement = runStart;
+			writeInfo.descriptorCount = slot - runStart;
+			writeInfo.pImageInfo = &cache.imageInfos[ runStart ];
+
+			descriptorCount += writeInfo.descriptorCount;
+			descSetWrites.push_back( writeInfo );
+
+			runStart = descCount;
+		}
+	}
+}
+
+
+// Only writes what differs from the last write to this frame state's set. Resources are compared
+// by generation as well as handle since a recreated buffer or view can come back with the old handle.
+static void AppendDescriptorWrites( ShaderBindParms& parms, const uint32_t currentBuffer, std::vector<VkWriteDescriptorSet>& descSetWrites, uint32_t& descriptorCount )
 {
 	const ShaderBindSet* set = parms.GetSet();
 
 	const uint32_t count = set->Count();
-	descSetWrites.reserve( descSetWrites.size() + count );
-
 	for ( uint32_t i = 0; i < count; ++i )
 	{
 		const ShaderBinding* binding = set->GetBinding( i );
 
-		if( parms.AttachmentChanged( *binding ) == false ) {
-			continue;
-		}
-
 		const ShaderAttachment* attachment = parms.GetAttachment( *binding );
 		assert( attachment != nullptr );
 
+		// A rebind rewrites the whole binding
+		descriptorCache_t& cache = parms.GetWriteCache( *binding );
+		const uint32_t version = parms.GetVersion( *binding );
+		const bool rebound = ( cache.version != version ) || ( cache.generations.size() != binding->GetDescriptorCount() );
+		if ( rebound )
+		{
+			cache.version = version;
+			cache.generations.assign( binding->GetDescriptorCount(), 0 );
+			cache.bufferInfos.clear();
+			cache.imageInfos.clear();
+		}
+
 		VkWriteDescriptorSet writeInfo = {};
 		writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		writeInfo.descriptorCount = binding->GetMaxDescriptorCount();
+		writeInfo.descriptorCount = binding->GetDescriptorCount();
 		writeInfo.dstSet = parms.GetVkObject();
 		writeInfo.descriptorType = vk_GetDescriptorType( binding->GetType() );
 		writeInfo.dstArrayElement = 0;
@@ -120,14 +221,23 @@ static void AppendDescriptorWrites( const ShaderBindParms& parms, const uint32_t
 		if ( attachment->GetSemantic() == bindSemantic_t::BUFFER ) {
 			const GpuBuffer* buffer = attachment->GetBuffer();
 
-			VkDescriptorBufferInfo& info = writeBuilder.NextBufferInfo();
-			info.buffer = buffer->GetVkObject();
-			info.offset = buffer->GetBaseOffset();
-			info.range = buffer->GetSize();
+			VkDescriptorBufferInfo newInfo = {};
+			newInfo.buffer = buffer->GetVkObject();
+			newInfo.offset = buffer->GetBaseOffset();
+			newInfo.range = buffer->GetSize();
 
-			info.range = ( info.range == 0 ) ? VK_WHOLE_SIZE : info.range;
+			newInfo.range = ( newInfo.range == 0 ) ? VK_WHOLE_SIZE : newInfo.range;
 
-			assert( info.buffer != nullptr );
+			assert( newInfo.buffer != nullptr );
+
+			if ( ( rebound == false ) && ( cache.generations[ 0 ] == buffer->GetGeneration() ) && SameBufferInfo( cache.bufferInfos[ 0 ], newInfo ) ) {
+				continue;
+			}
+			cache.generations[ 0 ] = buffer->GetGeneration();
+			cache.bufferInfos.assign( 1, newInfo );
+
+			VkDescriptorBufferInfo& info = writeBuilder.NextBufferInfo();
+			info = newInfo;
 
 			writeInfo.pBufferInfo = &info;
 		}
@@ -137,32 +247,31 @@ static void AppendDescriptorWrites( const ShaderBindParms& parms, const uint32_t
 				image = rc.whiteImage;
 			}
 
-			VkDescriptorImageInfo& info = writeBuilder.NextImageInfo();
-			info.sampler = context.bilinearSampler[ image->sampler.addrMode ];
-			info.imageView = attachment->GetImage()->gpuImage->GetVkImageView( currentBuffer );
-			assert( info.imageView != nullptr );
+			const VkDescriptorImageInfo newInfo = MakeImageInfo( *image, currentBuffer, VK_NULL_HANDLE );
 
-			if ( ( image->info.aspect & ( IMAGE_ASPECT_DEPTH_FLAG | IMAGE_ASPECT_STENCIL_FLAG ) ) != 0 ) {
-				info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-			}
-			else {
-				info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			if ( ( rebound == false ) && ( cache.generations[ 0 ] == image->gpuImage->GetGeneration() ) && SameImageInfo( cache.imageInfos[ 0 ], newInfo ) ) {
+				continue;
 			}
+			cache.generations[ 0 ] = image->gpuImage->GetGeneration();
+			cache.imageInfos.assign( 1, newInfo );
+
+			VkDescriptorImageInfo& info = writeBuilder.NextImageInfo();
+			info = newInfo;
 
 			writeInfo.pImageInfo = &info;
 		}
 		else if ( attachment->GetSemantic() == bindSemantic_t::IMAGE_ARRAY ) {
-			std::vector<VkDescriptorImageInfo>& infos = writeBuilder.NextImageInfoArray();
-
 			const ImageArray& images = *attachment->GetImageArray();
 
-			const uint32_t descCount = binding->GetMaxDescriptorCount();
+			const uint32_t descCount = binding->GetDescriptorCount();
 			const uint32_t imageCount = images.Count();
 			assert( imageCount <= descCount );
 
-			infos.resize( descCount );
-			writeInfo.descriptorCount = descCount;
+			cache.imageInfos.resize( descCount );
 
+			// Entries are assigned straight into the array, so diff every element against the last write
+			uint32_t firstChanged = descCount;
+			uint32_t lastChanged = 0;
 			for ( uint32_t descIx = 0; descIx < descCount; ++descIx )
 			{
 				const Image* image = rc.whiteImage;
@@ -170,26 +279,37 @@ static void AppendDescriptorWrites( const ShaderBindParms& parms, const uint32_t
 					image = images[ descIx ];
 				}
 
-				VkDescriptorImageInfo& info = infos[ descIx ];
-
-				info = {};
-				info.imageView = image->gpuImage->GetVkImageView( currentBuffer );
-				assert( info.imageView != nullptr );
+				const VkDescriptorImageInfo newInfo = MakeImageInfo( *image, currentBuffer, context.depthShadowSampler );
+				const uint32_t generation = image->gpuImage->GetGeneration();
 
-				if ( ( image->info.aspect & ( IMAGE_ASPECT_DEPTH_FLAG | IMAGE_ASPECT_STENCIL_FLAG ) ) != 0 )
-				{
-					info.sampler = context.depthShadowSampler;
-					info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-				}
-				else
-				{
-					info.sampler = context.bilinearSampler[ image->sampler.addrMode ];
-					info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				if ( ( rebound == false ) && ( cache.generations[ descIx ] == generation ) && SameImageInfo( cache.imageInfos[ descIx ], newInfo ) ) {
+					continue;
 				}
+				cache.generations[ descIx ] = generation;
+				cache.imageInfos[ descIx ] = newInfo;
+
+				firstChanged = std::min( firstChanged, descIx );
+				lastChanged = descIx;
 			}
+
+			if ( firstChanged == descCount ) {
+				continue;
+			}
+
+			// One write spans all changed entries, the unchanged ones between are rewritten as-is
+			std::vector<VkDescriptorImageInfo>& infos = writeBuilder.NextImageInfoArray();
+			infos.assign( cache.imageInfos.begin() + firstChanged, cache.imageInfos.begin() + lastChanged + 1 );
+
+			writeInfo.dstArrayElement = firstChanged;
+			writeInfo.descriptorCount = static_cast<uint32_t>( infos.size() );
 			writeInfo.pImageInfo = infos.data();
 		}
+		else if ( attachment->GetSemantic() == bindSemantic_t::IMAGE_TABLE ) {
+			AppendTableWrites( *attachment->GetImageTable(), *binding, currentBuffer, rebound, cache, writeInfo, descSetWrites, descriptorCount );
+			continue;
+		}
 
+		descriptorCount += writeInfo.descriptorCount;
 		descSetWrites.push_back( writeInfo );
 	}
 }
@@ -201,6 +321,7 @@ void RenderContext::UpdateBindParms()
 
 	writeBuilder.Reset();
 	std::vector<VkWriteDescriptorSet> descriptorWrites;
+	uint32_t descriptorCount = 0;
 
 	const uint32_t bindParmCount = bindParmsList.Count();
 	for ( uint32_t i = 0; i < bindParmCount; ++i )
@@ -208,9 +329,13 @@ void RenderContext::UpdateBindParms()
 		if( bindParmsList[ i ].IsValid() == false ) {
 			continue;
 		}
-		AppendDescriptorWrites( bindParmsList[ i ], context.bufferId, descriptorWrites );
+		AppendDescriptorWrites( bindParmsList[ i ], context.bufferId, descriptorWrites, descriptorCount );
 	}
 
+	// Zero in steady state, anything else is a binding or resource that changed this frame
+	g_renderDebugData.descriptorWriteCount = static_cast<uint32_t>( descriptorWrites.size() );
+	g_renderDebugData.descriptorCount = descriptorCount;
+
 	if( descriptorWrites.size() > 0 ) {
 		vkUpdateDescriptorSets( context.device, static_cast<uint32_t>( descriptorWrites.size() ), descriptorWrites.data(), 0, nullptr );
 	}
@@ -139,6 +139,9 @@ void GpuBuffer::Create( const char* name, const swapBuffering_t swapBuffering, c
 			usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
 		} else if ( type == bufferType_t::STAGING ) {
 			usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		} else if ( type == bufferType_t::INDIRECT ) {
+			alignment = context.deviceProperties.limits.minStorageBufferOffsetAlignment;
+			usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 		} else {
 			assert(0);
 		}
@@ -282,6 +285,7 @@ GpuBufferView GpuBuffer::GetView( const uint64_t baseElementIx, const uint64_t e
 	view.m_bufferCount = m_bufferCount;
 	view.m_type = m_type;
 	view.m_swapBuffering = m_swapBuffering;
+	view.m_generation = m_generation;
 
 	return view;
 }
\ No newline at end of file
@@ -32,7 +32,8 @@ enum class bufferType_t
 	STORAGE,
 	VERTEX,
 	INDEX,
-	STAGING
+	STAGING,
+	INDIRECT,
 };
 
 
@@ -28,6 +28,7 @@
 #include "../render_state/rhi.h"
 #include "../render_state/cmdContext.h"
 #include "../render_binding/bufferObjects.h"
+#include "../globals/meshSimplify.h"
 #include <gfxcore/scene/assetManager.h>
 
 extern AssetManager g_assets;
@@ -43,6 +44,9 @@ void Renderer::UpdateTextureData()
 	{
 		Asset<Image>* imageAsset = g_assets.textureLib.Find( *it );
 		Image& image = imageAsset->Get();
+		if ( image.gpuImage == nullptr ) {
+			continue;
+		}
 
 		const uint64_t currentOffset = textureStagingBuffer.GetSize();
 		textureStagingBuffer.CopyData( image.cpuImage->Ptr(), image.cpuImage->GetByteCount() );
@@ -76,10 +80,22 @@ void Renderer::UploadTextures()
 		}
 		Image& texture = textureAsset->Get();
 
+		ClassifyAlphaMask( *it );
+
+		const int slot = AllocImageSlot();
+		if ( slot < 0 )
+		{
+			if ( unslottedTextures.insert( *it ).second ) {
+				std::cout << "Texture table full (" << resources.gpuImages2D.Capacity() << " slots), " << textureAsset->GetName() << " samples white" << std::endl;
+			}
+			continue;
+		}
+
 		gpuImageStateFlags_t flags = ( GPU_IMAGE_READ | GPU_IMAGE_TRANSFER_SRC | GPU_IMAGE_TRANSFER_DST );
 
+		// Unmanaged, ReleaseTexture() can delete it before shutdown
 		texture.gpuImage= 
-			new GpuImage( textureAsset->GetName().c_str(), texture.info, flags, renderContext.localMemory, resourceLifeTime_t::REBOOT );
+			new GpuImage( textureAsset->GetName().c_str(), texture.info, flags, renderContext.localMemory, resourceLifeTime_t::UNMANAGED );
 
 		Transition( &uploadContext, texture, GPU_IMAGE_NONE, GPU_IMAGE_TRANSFER_DST );
 
@@ -92,16 +108,14 @@ void Renderer::UploadTextures()
 
 		CopyBufferToImage( &uploadContext, texture, textureStagingBuffer, currentOffset );
 		
-		assert( imageFreeSlot < MaxImageDescriptors );
-		texture.gpuImage->SetId( imageFreeSlot );
-		++imageFreeSlot;
+		texture.gpuImage->SetId( slot );
 	}
 
 	// 2. Generate MIPS
 	for ( auto it = uploadTextures.begin(); it != uploadTextures.end(); ++it )
 	{
 		Asset<Image>* textureAsset = g_assets.textureLib.Find( *it );
-		if ( textureAsset->IsLoaded() == false ) {
+		if ( ( textureAsset->IsLoaded() == false ) || ( textureAsset->Get().gpuImage == nullptr ) ) {
 			continue;
 		}
 		Image& texture = textureAsset->Get();
@@ -113,56 +127,157 @@ void Renderer::UploadTextures()
 		GenerateMipmaps( &uploadContext, texture );
 	}
 
-	// 3. Add to resource type lists
+	// 3. Add to texture tables, the other table's slot stays empty
+	std::set<hdl_t> slottedTextures;
+	for ( auto it = uploadTextures.begin(); it != uploadTextures.end(); ++it )
 	{
-		// Find first cubemap. FIXME: Hacky, just done so there aren't nulls in the list
-		Image* firstCube = nullptr;
-		for ( auto it = uploadTextures.begin(); it != uploadTextures.end(); ++it )
+		Asset<Image>* textureAsset = g_assets.textureLib.Find( *it );
+		if ( ( textureAsset->IsLoaded() == false ) || ( textureAsset->Get().gpuImage == nullptr ) ) {
+			continue;
+		}
+		Image& texture = textureAsset->Get();
+		const int uploadId = texture.gpuImage->GetId();
+
+		switch ( texture.info.type )
 		{
-			Asset<Image>* textureAsset = g_assets.textureLib.Find( *it );
-			if ( textureAsset->IsLoaded() == false ) {
-				continue;
-			}
-			if ( textureAsset->Get().info.type == IMAGE_TYPE_CUBE )
-			{
-				firstCube = &textureAsset->Get();
+			case IMAGE_TYPE_2D:
+				resources.gpuImages2D.Set( uploadId, &texture );
+				resources.gpuImagesCube.Clear( uploadId );
+				break;
+			case IMAGE_TYPE_CUBE:
+				resources.gpuImages2D.Clear( uploadId );
+				resources.gpuImagesCube.Set( uploadId, &texture );
 				break;
-			}
 		}
-		assert( firstCube != nullptr );
 
-		// Fill assigned slots
-		for ( uint32_t i = 0; i < imageFreeSlot; ++i )
-		{
-			Asset<Image>* textureAsset = g_assets.textureLib.Find( i );
-			if ( textureAsset->IsLoaded() == false ) {
-				continue;
-			}
-			Image& texture = textureAsset->Get();
-			const int uploadId = texture.gpuImage->GetId();
+		unslottedTextures.erase( *it );
+		slottedTextures.insert( *it );
+	}
+
+	// Materials written before the texture had a slot point at white
+	RequeueMaterials( slottedTextures );
+
+	uploadTextures.clear();
+}
+
+// Scanned once per texture while its CPU copy is around. Materials only alpha test albedo textures
+// that have cutout texels, a plain RGBA texture with opaque alpha skips the discard.
+void Renderer::ClassifyAlphaMask( const hdl_t texHdl )
+{
+	if ( textureAlphaMasks.find( texHdl.Get() ) != textureAlphaMasks.end() ) {
+		return;
+	}
 
-			switch ( texture.info.type )
+	const Asset<Image>* textureAsset = g_assets.textureLib.Find( texHdl );
+	if ( ( textureAsset == nullptr ) || ( textureAsset->IsLoaded() == false ) ) {
+		return;
+	}
+
+	const Image& texture = textureAsset->Get();
+	const bool hasAlpha = ( texture.info.fmt == IMAGE_FMT_RGBA_8 ) || ( texture.info.fmt == IMAGE_FMT_RGBA_8_UNORM ) || ( texture.info.fmt == IMAGE_FMT_BGRA_8 );
+
+	bool masked = false;
+	if ( hasAlpha && ( texture.cpuImage != nullptr ) )
+	{
+		const uint8_t threshold = static_cast<uint8_t>( AlphaTestThreshold * 255.0f );
+		const uint8_t* texels = reinterpret_cast<const uint8_t*>( texture.cpuImage->Ptr() );
+		const uint32_t texelCount = texture.cpuImage->GetByteCount() / 4;
+		for ( uint32_t i = 0; ( i < texelCount ) && ( masked == false ); ++i ) {
+			masked = ( texels[ 4 * i + 3 ] < threshold );
+		}
+	}
+	textureAlphaMasks[ texHdl.Get() ] = masked;
+}
+
+int Renderer::AllocImageSlot()
+{
+	if ( releasedImageSlots.empty() == false )
+	{
+		const int slot = releasedImageSlots.back();
+		releasedImageSlots.pop_back();
+		return slot;
+	}
+
+	if ( imageFreeSlot < resources.gpuImages2D.Capacity() ) {
+		return static_cast<int>( imageFreeSlot++ );
+	}
+	return -1;
+}
+
+void Renderer::RequeueMaterials( const std::set<hdl_t>& textures )
+{
+	if ( textures.empty() ) {
+		return;
+	}
+
+	const uint32_t materialCount = g_assets.materialLib.Count();
+	for ( uint32_t i = 0; i < materialCount; ++i )
+	{
+		Asset<Material>* matAsset = g_assets.materialLib.Find( i );
+		if ( matAsset->IsLoaded() == false ) {
+			continue;
+		}
+
+		const Material& m = matAsset->Get();
+		for ( uint32_t t = 0; t < Material::MaxMaterialTextures; ++t )
+		{
+			if ( textures.find( m.GetTexture( t ) ) != textures.end() )
 			{
-				case IMAGE_TYPE_2D:
-					resources.gpuImages2D[ uploadId ] = &texture;
-					resources.gpuImagesCube[ uploadId ] = firstCube;
-					break;
-				case IMAGE_TYPE_CUBE:
-					resources.gpuImages2D[ uploadId ] = &g_assets.textureLib.GetDefault()->Get();
-					resources.gpuImagesCube[ uploadId ] = &texture;
-					break;
+				matAsset->QueueUpload();
+				uploadMaterials.insert( matAsset->Handle() );
+				break;
 			}
 		}
+	}
+}
 
-		// Fill defaults
-		for ( uint32_t i = imageFreeSlot; i < MaxImageDescriptors; ++i )
+// Frames in flight may still sample a released texture, its image and slot are held until they retire
+void Renderer::ReleaseTexture( const hdl_t texHdl )
+{
+	Asset<Image>* textureAsset = g_assets.textureLib.Find( texHdl );
+	if ( textureAsset == nullptr ) {
+		return;
+	}
+
+	Image& texture = textureAsset->Get();
+	if ( texture.gpuImage == nullptr ) {
+		return;
+	}
+
+	const int slot = texture.gpuImage->GetId();
+	if ( slot >= 0 )
+	{
+		resources.gpuImages2D.Clear( slot );
+		resources.gpuImagesCube.Clear( slot );
+	}
+
+	retiredImages.push_back( retiredImage_t{ texture.gpuImage, slot, m_frameNumber } );
+	texture.gpuImage = nullptr;
+
+	// The slot is reused once retired, materials must stop pointing at it
+	RequeueMaterials( { texHdl } );
+}
+
+void Renderer::DestroyRetiredImages( const bool flush )
+{
+	for ( auto it = retiredImages.begin(); it != retiredImages.end(); )
+	{
+		if ( ( flush == false ) && ( ( m_frameNumber - it->frameNumber ) < MaxFrameStates ) )
 		{
-			resources.gpuImages2D[ i ] = &g_assets.textureLib.GetDefault()->Get();
-			resources.gpuImagesCube[ i ] = firstCube;
+			++it;
+			continue;
 		}
-	}
 
-	uploadTextures.clear();
+		if ( it->slot >= 0 )
+		{
+			releasedImageSlots.push_back( it->slot );
+
+			// Textures that found the tables full can try again
+			uploadTextures.insert( unslottedTextures.begin(), unslottedTextures.end() );
+		}
+		delete it->gpuImage;
+		it = retiredImages.erase( it );
+	}
 }
 
 void Renderer::UpdateGpuMaterials()
@@ -196,11 +311,10 @@ void Renderer::UpdateGpuMaterials()
 					const hdl_t imageId = m.GetTexture( t );
 					const Asset<Image>* imageAsset = g_assets.textureLib.Find( imageId );
 					const Image& image = imageAsset->Get();
-					assert( image.gpuImage != nullptr );
 
-					const int uploadId = image.gpuImage->GetId();
-					assert( uploadId >= 0 );
-					materialObject.textures[ t ] = uploadId;
+					// Released or without a table slot, white until it is uploaded again
+					const bool hasSlot = ( image.gpuImage != nullptr ) && ( image.gpuImage->GetId() >= 0 );
+					materialObject.textures[ t ] = hasSlot ? image.gpuImage->GetId() : rc.whiteImage->gpuImage->GetId();
 				} else {
 					materialObject.textures[ t ] = -1;
 				}
@@ -243,6 +357,10 @@ void Renderer::UploadModelsToGPU()
 			continue;
 		}
 
+		// Simplification is baked offline with c_bakeAssets, models without current chains only draw level 0
+		modelLods_t lodChains;
+		ReadModelLods( BakePath + modelAsset->GetName() + BakedLodExtension, model, lodChains );
+
 		for ( uint32_t s = 0; s < model.surfCount; ++s )
 		{
 			Surface& surf = model.surfs[ s ];	
@@ -306,6 +424,42 @@ void Renderer::UploadModelsToGPU()
 				geometry.ibBufElements += indexCount;
 
 				assert( geometry.ibBufElements < MaxIndices );
+
+				upload.lodCount = 1;
+				upload.lods[ 0 ].firstIndex = upload.firstIndex;
+				upload.lods[ 0 ].indexCount = indexCount;
+				upload.lods[ 0 ].error = 0.0f;
+			}
+
+			// Upload the baked LOD chain
+			if ( s < lodChains.size() )
+			{
+				const std::vector<meshLod_t>& lods = lodChains[ s ];
+				for ( uint32_t lod = 1; lod <= lods.size(); ++lod )
+				{
+					const std::vector<uint32_t>& lodIndices = lods[ lod - 1 ].indices;
+					const uint32_t lodIndexCount = static_cast<uint32_t>( lodIndices.size() );
+					if ( ( geometry.ibBufElements + lodIndexCount ) >= MaxIndices ) {
+						break;
+					}
+
+					VkDeviceSize ibCopySize = sizeof( lodIndices[ 0 ] ) * lodIndexCount;
+
+					VkBufferCopy ibCopyRegion{ };
+					ibCopyRegion.size = ibCopySize;
+					ibCopyRegion.srcOffset = geometry.stagingBuffer.GetSize();
+					ibCopyRegion.dstOffset = geometry.ib.GetSize();
+					CopyGpuBuffer( geometry.stagingBuffer, geometry.ib, ibCopyRegion );
+
+					geometry.stagingBuffer.CopyData( lodIndices.data(), static_cast<size_t>( ibCopySize ) );
+
+					upload.lods[ lod ].firstIndex = geometry.ibBufElements;
+					upload.lods[ lod ].indexCount = lodIndexCount;
+					upload.lods[ lod ].error = lods[ lod - 1 ].error;
+					upload.lodCount = lod + 1;
+
+					geometry.ibBufElements += lodIndexCount;
+				}
 			}
 		}
 		modelAsset->CompleteUpload();
@@ -0,0 +1,74 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "../globals/common.h"
+
+// Bindless texture table. Slots are indexed directly by materials and shaders, empty
+// slots are left unwritten when the device supports partially bound descriptors.
+class ImageTable
+{
+private:
+	std::vector<const Image*>	m_images;
+
+public:
+	inline void Init( const uint32_t capacity )
+	{
+		m_images.assign( capacity, nullptr );
+	}
+
+
+	inline void Reset()
+	{
+		std::fill( m_images.begin(), m_images.end(), nullptr );
+	}
+
+
+	inline void Set( const uint32_t slot, const Image* image )
+	{
+		assert( slot < Capacity() );
+		m_images[ slot ] = image;
+	}
+
+
+	inline void Clear( const uint32_t slot )
+	{
+		assert( slot < Capacity() );
+		m_images[ slot ] = nullptr;
+	}
+
+
+	inline uint32_t Capacity() const
+	{
+		return static_cast<uint32_t>( m_images.size() );
+	}
+
+
+	inline const Image* operator[]( const uint32_t slot ) const
+	{
+		return m_images[ slot ];
+	}
+};
@@ -32,8 +32,81 @@
 #include <gfxcore/core/assetLib.h>
 #include <gfxcore/scene/scene.h>
 
+extern AssetManager g_assets;
+
 static std::unordered_map< uint64_t, pipelineObject_t > g_pipelineLib;
 
+// Everything a compile needs is captured on the main thread, workers never touch passes or assets
+struct pipelineCompileRequest_t
+{
+	hdl_t					hdl;
+	pipelineState_t			state;
+	bool					compute;
+	VkShaderModule			modules[ 2 ];
+	VkDescriptorSetLayout	layouts[ GpuProgram::MaxBindSets ];
+	uint32_t				layoutCount;
+	VkRenderPass			renderPass;
+	viewport_t				viewport;
+	uint32_t				colorAttachmentCount;
+	const char*				csName;
+	pipelineObject_t		result;
+};
+
+// Swapped out pipelines can still be referenced by frames in flight
+struct retiredPipeline_t
+{
+	VkPipeline			pipeline;
+	VkPipelineLayout	pipelineLayout;
+	uint32_t			frameNumber;
+};
+
+static std::vector<pipelineCompileRequest_t>	g_compileRequests;
+static std::set<uint64_t>						g_queuedPipelines;
+static std::vector<retiredPipeline_t>			g_retiredPipelines;
+
+// Variants missed at commit, added from the view jobs
+struct pipelineRequest_t
+{
+	const DrawPass*			pass;
+	hdl_t					progHdl;
+	materialFeatureBits_t	features;
+};
+
+static std::mutex								g_requestLock;
+static std::vector<pipelineRequest_t>			g_requestedPipelines;
+static std::set<uint64_t>						g_requestedHdls;
+
+// Every graphics pipeline state built this session, written out as the scene's prewarm manifest
+static std::unordered_map< uint64_t, pipelineState_t > g_pipelineManifest;
+
+static const uint32_t PipelineManifestMagic = 0x4D50564B; // "KVPM"
+static const uint32_t PipelineManifestVersion = 2;
+
+struct pipelineManifestHeader_t
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	stateSize;
+	uint32_t	count;
+};
+
+static const uint32_t PipelineCacheMagic = 0x4350564B; // "KVPC"
+static const uint32_t PipelineCacheVersion = 1;
+
+// Precedes the driver's cache data on disk. Drivers are meant to reject foreign data themselves,
+// but not all do, so a blob from another device or driver is never handed to them.
+struct pipelineCacheHeader_t
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	vendorId;
+	uint32_t	deviceId;
+	uint32_t	driverVersion;
+	uint8_t		uuid[ VK_UUID_SIZE ];
+	uint32_t	dataHash;
+	uint64_t	dataSize;
+};
+
 static const uint32_t MaxVertexAttribs = 6;
 static std::array<VkVertexInputAttributeDescription, MaxVertexAttribs> GetVertexAttributeDescriptions()
 {
@@ -100,7 +173,7 @@ void CreateBindingLayout( ShaderBindSet& bindSet, VkDescriptorSetLayout& layout
 		
 		layoutBindings[i] = {};
 		layoutBindings[i].binding = binding->GetSlot();
-		layoutBindings[i].descriptorCount = binding->GetMaxDescriptorCount();
+		layoutBindings[i].descriptorCount = binding->GetDescriptorCount();
 		layoutBindings[i].descriptorType = vk_GetDescriptorType( binding->GetType() );
 		layoutBindings[i].pImmutableSamplers = nullptr;
 		layoutBindings[i].stageFlags = vk_GetStageFlags( binding->GetBindFlags() );
@@ -129,66 +202,259 @@ void DestroyPipelineCache()
 		vkDestroyPipelineLayout( context.device, it->second.pipelineLayout, nullptr );
 	}
 	g_pipelineLib.clear();
+
+	// Compiles that finished but were never swapped in
+	for ( auto it = g_compileRequests.begin(); it != g_compileRequests.end(); ++it )
+	{
+		vkDestroyPipeline( context.device, it->result.pipeline, nullptr );
+		vkDestroyPipelineLayout( context.device, it->result.pipelineLayout, nullptr );
+	}
+	g_compileRequests.clear();
+	g_queuedPipelines.clear();
+
+	for ( auto it = g_retiredPipelines.begin(); it != g_retiredPipelines.end(); ++it )
+	{
+		vkDestroyPipeline( context.device, it->pipeline, nullptr );
+		vkDestroyPipelineLayout( context.device, it->pipelineLayout, nullptr );
+	}
+	g_retiredPipelines.clear();
 }
 
 
-bool GetPipelineObject( hdl_t hdl, pipelineObject_t** pipelineObject )
+static pipelineCacheHeader_t MakePipelineCacheHeader( const uint8_t* data, const size_t dataSize )
 {
-	auto it = g_pipelineLib.find( hdl.Get() );
-	if ( it != g_pipelineLib.end() ) {
-		*pipelineObject = &it->second;
-		return true;
+	const VkPhysicalDeviceProperties& props = context.deviceProperties;
+
+	pipelineCacheHeader_t header = {};
+	header.magic = PipelineCacheMagic;
+	header.version = PipelineCacheVersion;
+	header.vendorId = props.vendorID;
+	header.deviceId = props.deviceID;
+	header.driverVersion = props.driverVersion;
+	memcpy( header.uuid, props.pipelineCacheUUID, VK_UUID_SIZE );
+	header.dataSize = dataSize;
+	header.dataHash = ( dataSize > 0 ) ? Hash( data, static_cast<uint32_t>( dataSize ) ) : 0;
+	return header;
+}
+
+
+// Creates the device's pipeline cache, seeded from the file if it was saved by this device and driver.
+// Returns the number of bytes seeded, zero for a cold start.
+size_t LoadVkPipelineCacheBlob( const std::string& path )
+{
+	assert( context.pipelineCache == VK_NULL_HANDLE );
+
+	std::vector<uint8_t> blob;
+	{
+		std::ifstream file( path, std::ios::binary | std::ios::ate );
+		if ( file.is_open() )
+		{
+			blob.resize( static_cast<size_t>( file.tellg() ) );
+			file.seekg( 0 );
+			file.read( reinterpret_cast<char*>( blob.data() ), blob.size() );
+			if ( file.fail() ) {
+				blob.clear();
+			}
+		}
 	}
-	return false;
+
+	const uint8_t* data = nullptr;
+	size_t dataSize = 0;
+
+	if ( blob.size() > sizeof( pipelineCacheHeader_t ) )
+	{
+		pipelineCacheHeader_t fileHeader;
+		memcpy( &fileHeader, blob.data(), sizeof( fileHeader ) );
+
+		const uint8_t* fileData = blob.data() + sizeof( pipelineCacheHeader_t );
+		const size_t fileDataSize = blob.size() - sizeof( pipelineCacheHeader_t );
+
+		// Also rejects truncated or corrupted files
+		const pipelineCacheHeader_t expected = MakePipelineCacheHeader( fileData, fileDataSize );
+		if ( memcmp( &fileHeader, &expected, sizeof( pipelineCacheHeader_t ) ) == 0 )
+		{
+			data = fileData;
+			dataSize = fileDataSize;
+		}
+		else {
+			std::cout << "Pipeline cache \"" << path << "\" is stale or from another device, starting cold." << std::endl;
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo{ };
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = dataSize;
+	cacheInfo.pInitialData = data;
+
+	if ( vkCreatePipelineCache( context.device, &cacheInfo, nullptr, &context.pipelineCache ) != VK_SUCCESS )
+	{
+		// The driver may still refuse the data, an empty cache is always valid
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		dataSize = 0;
+		VK_CHECK_RESULT( vkCreatePipelineCache( context.device, &cacheInfo, nullptr, &context.pipelineCache ) );
+	}
+	return dataSize;
 }
 
 
-hdl_t FindPipelineObject( const DrawPass* pass, const Asset<GpuProgram>& progAsset )
+void SaveVkPipelineCacheBlob( const std::string& path )
 {
-	pipelineState_t state = {};
-	state.stateBits = pass->StateBits();
-	state.samplingRate = pass->SampleRate();
-	state.progHdl = progAsset.Handle();
-	state.passBits = pass->GetFrameBuffer()->GetAttachmentBits();
+	if ( context.pipelineCache == VK_NULL_HANDLE ) {
+		return;
+	}
 
-	const hdl_t pipelineHdl = Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
+	size_t dataSize = 0;
+	VK_CHECK_RESULT( vkGetPipelineCacheData( context.device, context.pipelineCache, &dataSize, nullptr ) );
+	if ( dataSize == 0 ) {
+		return;
+	}
 
-	auto it = g_pipelineLib.find( pipelineHdl.Get() );
-	if ( it != g_pipelineLib.end() ) {
-		return pipelineHdl;
+	std::vector<uint8_t> data( dataSize );
+	VK_CHECK_RESULT( vkGetPipelineCacheData( context.device, context.pipelineCache, &dataSize, data.data() ) );
+
+	const pipelineCacheHeader_t header = MakePipelineCacheHeader( data.data(), dataSize );
+
+	std::ofstream file( path, std::ios::binary | std::ios::trunc );
+	if ( file.is_open() == false )
+	{
+		std::cout << "Couldn't write pipeline cache \"" << path << "\"." << std::endl;
+		return;
 	}
-	return INVALID_HDL;
+	file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	file.write( reinterpret_cast<const char*>( data.data() ), dataSize );
 }
 
 
-void DestroyGraphicsPipeline( const DrawPass* pass, const Asset<GpuProgram>& progAsset )
+// Appends the pipeline states recorded by an earlier session, returns how many were read
+size_t LoadPipelineManifest( const std::string& path, std::vector<pipelineState_t>& states )
 {
-	pipelineState_t state = {};
-	state.stateBits = pass->StateBits();
-	state.samplingRate = pass->SampleRate();
-	state.progHdl = progAsset.Handle();
-	state.passBits = pass->GetFrameBuffer()->GetAttachmentBits();
+	std::ifstream file( path, std::ios::binary );
+	if ( file.is_open() == false ) {
+		return 0;
+	}
 
-	const hdl_t pipelineHdl = Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
+	pipelineManifestHeader_t header = {};
+	file.read( reinterpret_cast<char*>( &header ), sizeof( header ) );
 
-	auto it = g_pipelineLib.find( pipelineHdl.Get() );
-	if ( it == g_pipelineLib.end() ) {
+	// The state layout changes whenever pipelineState_t does, old manifests are dropped
+	if ( file.fail() || ( header.magic != PipelineManifestMagic ) || ( header.version != PipelineManifestVersion ) || ( header.stateSize != sizeof( pipelineState_t ) ) )
+	{
+		std::cout << "Pipeline manifest \"" << path << "\" is stale, skipping prewarm." << std::endl;
+		return 0;
+	}
+
+	const size_t firstState = states.size();
+	states.resize( firstState + header.count );
+
+	file.read( reinterpret_cast<char*>( states.data() + firstState ), header.count * sizeof( pipelineState_t ) );
+	if ( file.fail() )
+	{
+		states.resize( firstState );
+		return 0;
+	}
+	return header.count;
+}
+
+
+// Writes and resets the states recorded so the next scene starts its own manifest
+void SavePipelineManifest( const std::string& path )
+{
+	if ( path.empty() || g_pipelineManifest.empty() )
+	{
+		g_pipelineManifest.clear();
 		return;
 	}
-	vkDestroyPipeline( context.device, it->second.pipeline, nullptr );
-	vkDestroyPipelineLayout( context.device, it->second.pipelineLayout, nullptr );
 
-	g_pipelineLib.erase( it );
+	std::ofstream file( path, std::ios::binary | std::ios::trunc );
+	if ( file.is_open() == false )
+	{
+		std::cout << "Couldn't write pipeline manifest \"" << path << "\"." << std::endl;
+		return;
+	}
+
+	pipelineManifestHeader_t header = {};
+	header.magic = PipelineManifestMagic;
+	header.version = PipelineManifestVersion;
+	header.stateSize = sizeof( pipelineState_t );
+	header.count = static_cast<uint32_t>( g_pipelineManifest.size() );
+
+	file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	for ( auto it = g_pipelineManifest.begin(); it != g_pipelineManifest.end(); ++it ) {
+		file.write( reinterpret_cast<const char*>( &it->second ), sizeof( pipelineState_t ) );
+	}
+	g_pipelineManifest.clear();
 }
 
 
-hdl_t CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass* pass, const Asset<GpuProgram>& progAsset )
+static pipelineState_t MakeGraphicsPipelineState( const DrawPass* pass, const Asset<GpuProgram>& progAsset, const materialFeatureBits_t features = MATERIAL_FEATURE_ALL )
 {
 	pipelineState_t state = {};
 	state.stateBits = pass->StateBits();
 	state.samplingRate = pass->SampleRate();
 	state.progHdl = progAsset.Handle();
 	state.passBits = pass->GetFrameBuffer()->GetAttachmentBits();
+	state.materialFeatures = features;
+
+	return state;
+}
+
+
+static void InitGraphicsRequest( const DrawPass* pass, const Asset<GpuProgram>& progAsset, const materialFeatureBits_t features, pipelineCompileRequest_t& request )
+{
+	const GpuProgram& prog = progAsset.Get();
+
+	assert( prog.shaders[ 0 ].type == shaderType_t::VERTEX );
+	assert( prog.shaders[ 1 ].type == shaderType_t::PIXEL );
+
+	request = {};
+	request.state = MakeGraphicsPipelineState( pass, progAsset, features );
+	request.hdl = Hash( reinterpret_cast<const uint8_t*>( &request.state ), sizeof( request.state ) );
+	request.compute = false;
+	request.modules[ 0 ] = prog.vk_shaders[ 0 ];
+	request.modules[ 1 ] = prog.vk_shaders[ 1 ];
+	request.layoutCount = prog.bindsetCount;
+	for ( uint32_t i = 0; i < prog.bindsetCount; ++i ) {
+		request.layouts[ i ] = prog.bindsets[ i ]->GetVkObject();
+	}
+	request.renderPass = pass->GetFrameBuffer()->GetVkRenderPass();
+	request.viewport = pass->GetViewport();
+	request.colorAttachmentCount = pass->GetFrameBuffer()->ColorLayerCount();
+	assert( request.colorAttachmentCount <= 3 );
+}
+
+
+static void InitComputeRequest( const Asset<GpuProgram>& progAsset, pipelineCompileRequest_t& request )
+{
+	const GpuProgram& prog = progAsset.Get();
+
+	request = {};
+	request.state.progHdl = progAsset.Handle();
+	request.hdl = Hash( reinterpret_cast<const uint8_t*>( &request.state ), sizeof( request.state ) );
+	request.compute = true;
+	request.modules[ 0 ] = prog.vk_shaders[ 0 ];
+	request.layoutCount = prog.bindsetCount;
+	for ( uint32_t i = 0; i < prog.bindsetCount; ++i ) {
+		request.layouts[ i ] = prog.bindsets[ i ]->GetVkObject();
+	}
+	request.csName = prog.shaders->name.c_str();
+}
+
+
+bool GetPipelineObject( hdl_t hdl, pipelineObject_t** pipelineObject )
+{
+	auto it = g_pipelineLib.find( hdl.Get() );
+	if ( it != g_pipelineLib.end() ) {
+		*pipelineObject = &it->second;
+		return true;
+	}
+	return false;
+}
+
+
+hdl_t FindPipelineObject( const DrawPass* pass, const Asset<GpuProgram>& progAsset, const materialFeatureBits_t features )
+{
+	const pipelineState_t state = MakeGraphicsPipelineState( pass, progAsset, features );
 
 	const hdl_t pipelineHdl = Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
 
@@ -196,27 +462,41 @@ hdl_t CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass
 	if ( it != g_pipelineLib.end() ) {
 		return pipelineHdl;
 	}
+	return INVALID_HDL;
+}
 
-	const GpuProgram& prog = progAsset.Get();
 
-	pipelineObject_t pipelineObject;
+static void CompileGraphicsPipeline( pipelineCompileRequest_t& request )
+{
+	const pipelineState_t& state = request.state;
+
+	pipelineObject_t& pipelineObject = request.result;
+	pipelineObject = {};
 	pipelineObject.state = state;
 
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{ };
 	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertShaderStageInfo.module = prog.vk_shaders[ 0 ];
+	vertShaderStageInfo.module = request.modules[ 0 ];
 	vertShaderStageInfo.pName = "main";
 
-	assert( prog.shaders[ 0].type == shaderType_t::VERTEX );
-
 	VkPipelineShaderStageCreateInfo fragShaderStageInfo{ };
 	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragShaderStageInfo.module = prog.vk_shaders[ 1 ];
+	fragShaderStageInfo.module = request.modules[ 1 ];
 	fragShaderStageInfo.pName = "main";
 
-	assert( prog.shaders[ 1 ].type == shaderType_t::PIXEL );
+	// Programs without the constant ignore it, programs with it get exactly the requested features.
+	// Requests that don't specialize pass MATERIAL_FEATURE_ALL, the same as the shader default.
+	const VkSpecializationMapEntry specEntry = { MaterialFeaturesSpecId, 0, sizeof( uint32_t ) };
+
+	VkSpecializationInfo specInfo{ };
+	specInfo.mapEntryCount = 1;
+	specInfo.pMapEntries = &specEntry;
+	specInfo.dataSize = sizeof( uint32_t );
+	specInfo.pData = &state.materialFeatures;
+
+	fragShaderStageInfo.pSpecializationInfo = &specInfo;
 
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
@@ -244,16 +524,16 @@ hdl_t CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
 	VkViewport viewport{ };
-	viewport.x = static_cast<float>( pass->GetViewport().x );
-	viewport.y = static_cast<float>( pass->GetViewport().y );
-	viewport.width = static_cast<float>( pass->GetViewport().width );
-	viewport.height = static_cast<float>( pass->GetViewport().height );
+	viewport.x = static_cast<float>( request.viewport.x );
+	viewport.y = static_cast<float>( request.viewport.y );
+	viewport.width = static_cast<float>( request.viewport.width );
+	viewport.height = static_cast<float>( request.viewport.height );
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
 	VkRect2D scissor{ };
-	scissor.offset = { pass->GetViewport().x, pass->GetViewport().y };
-	scissor.extent = { pass->GetViewport().width, pass->GetViewport().height };
+	scissor.offset = { request.viewport.x, request.viewport.y };
+	scissor.extent = { request.viewport.width, request.viewport.height };
 
 	VkPipelineViewportStateCreateInfo viewportState{ };
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -304,8 +584,7 @@ hdl_t CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass
 
 	const bool blendEnable = ( ( state.stateBits & GFX_STATE_BLEND_ENABLE ) != 0 );
 
-	const uint32_t colorAttachmentCount = pass->GetFrameBuffer()->ColorLayerCount();
-	assert( colorAttachmentCount <= 3 );
+	const uint32_t colorAttachmentCount = request.colorAttachmentCount;
 
 	std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
 	colorBlendAttachments.resize( colorAttachmentCount );
@@ -357,15 +636,10 @@ hdl_t CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass
 	dynamicState.dynamicStateCount = dynamicStatesCount;
 	dynamicState.pDynamicStates = dynamicStates;
 	
-	VkDescriptorSetLayout layouts[GpuProgram::MaxBindSets];
-	for( uint32_t i = 0; i < prog.bindsetCount; ++i ) {
-		layouts[ i ] = prog.bindsets[ i ]->GetVkObject();
-	}
-
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{ };
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.pSetLayouts = layouts;
-	pipelineLayoutInfo.setLayoutCount = prog.bindsetCount;
+	pipelineLayoutInfo.pSetLayouts = request.layouts;
+	pipelineLayoutInfo.setLayoutCount = request.layoutCount;
 	
 	pipelineLayoutInfo.pushConstantRangeCount = 1;
 
@@ -432,39 +706,39 @@ hdl_t CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pDynamicState = &dynamicState;
 	pipelineInfo.layout = pipelineObject.pipelineLayout;
-	pipelineInfo.renderPass = pass->GetFrameBuffer()->GetVkRenderPass();
+	pipelineInfo.renderPass = request.renderPass;
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
 	pipelineInfo.pDepthStencilState = &depthStencil;
 
-	VK_CHECK_RESULT( vkCreateGraphicsPipelines( context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipelineObject.pipeline ) );
-
-	g_pipelineLib[ pipelineHdl.Get() ] = pipelineObject;
-
-	return pipelineHdl;
+	VK_CHECK_RESULT( vkCreateGraphicsPipelines( context.device, context.pipelineCache, 1, &pipelineInfo, nullptr, &pipelineObject.pipeline ) );
 }
 
 
-void DestroyComputePipeline( const Asset<GpuProgram>& progAsset )
+hdl_t CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass* pass, const Asset<GpuProgram>& progAsset )
 {
-	pipelineState_t state = {};
-	state.progHdl = progAsset.Handle();
+	const pipelineState_t state = MakeGraphicsPipelineState( pass, progAsset );
 
 	const hdl_t pipelineHdl = Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
 
 	auto it = g_pipelineLib.find( pipelineHdl.Get() );
-	if ( it == g_pipelineLib.end() ) {
-		return;
+	if ( it != g_pipelineLib.end() ) {
+		return pipelineHdl;
 	}
-	vkDestroyPipeline( context.device, it->second.pipeline, nullptr );
-	vkDestroyPipelineLayout( context.device, it->second.pipelineLayout, nullptr );
 
-	g_pipelineLib.erase( it );
+	pipelineCompileRequest_t request;
+	InitGraphicsRequest( pass, progAsset, MATERIAL_FEATURE_ALL, request );
+	CompileGraphicsPipeline( request );
+
+	g_pipelineLib[ pipelineHdl.Get() ] = request.result;
+	g_pipelineManifest[ pipelineHdl.Get() ] = state;
+
+	return pipelineHdl;
 }
 
 
-void CreateComputePipeline( const Asset<GpuProgram>& progAsset )
+void DestroyComputePipeline( const Asset<GpuProgram>& progAsset )
 {
 	pipelineState_t state = {};
 	state.progHdl = progAsset.Handle();
@@ -472,24 +746,26 @@ void CreateComputePipeline( const Asset<GpuProgram>& progAsset )
 	const hdl_t pipelineHdl = Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
 
 	auto it = g_pipelineLib.find( pipelineHdl.Get() );
-	if ( it != g_pipelineLib.end() ) {
+	if ( it == g_pipelineLib.end() ) {
 		return;
 	}
+	vkDestroyPipeline( context.device, it->second.pipeline, nullptr );
+	vkDestroyPipelineLayout( context.device, it->second.pipelineLayout, nullptr );
 
-	const GpuProgram& prog = progAsset.Get();
+	g_pipelineLib.erase( it );
+}
 
-	VkDescriptorSetLayout layouts[ GpuProgram::MaxBindSets ];
-	for ( uint32_t i = 0; i < prog.bindsetCount; ++i ) {
-		layouts[ i ] = prog.bindsets[ i ]->GetVkObject();
-	}
 
-	pipelineObject_t pipelineObject;
-	pipelineObject.state = state;
+static void CompileComputePipeline( pipelineCompileRequest_t& request )
+{
+	pipelineObject_t& pipelineObject = request.result;
+	pipelineObject = {};
+	pipelineObject.state = request.state;
 
 	VkPipelineShaderStageCreateInfo computeShaderStageInfo {};
 	computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-	computeShaderStageInfo.module = prog.vk_shaders[ 0 ];
+	computeShaderStageInfo.module = request.modules[ 0 ];
 	computeShaderStageInfo.pName = "main";
 	computeShaderStageInfo.pNext = nullptr;
 
@@ -500,8 +776,8 @@ void CreateComputePipeline( const Asset<GpuProgram>& progAsset )
 
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{ };
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.pSetLayouts = layouts;
-	pipelineLayoutInfo.setLayoutCount = prog.bindsetCount;
+	pipelineLayoutInfo.pSetLayouts = request.layouts;
+	pipelineLayoutInfo.setLayoutCount = request.layoutCount;
 	pipelineLayoutInfo.pushConstantRangeCount = 1;
 	pipelineLayoutInfo.pPushConstantRanges = &pushRanges;
 
@@ -514,9 +790,148 @@ void CreateComputePipeline( const Asset<GpuProgram>& progAsset )
 	pipelineInfo.stage = computeShaderStageInfo;
 	pipelineInfo.pNext = nullptr;
 
-	pipelineObject.csName = prog.shaders->name.c_str();
+	pipelineObject.csName = request.csName;
+
+	VK_CHECK_RESULT( vkCreateComputePipelines( context.device, context.pipelineCache, 1, &pipelineInfo, nullptr, &pipelineObject.pipeline ) );
+}
+
+void CreateComputePipeline( const Asset<GpuProgram>& progAsset )
+{
+	pipelineState_t state = {};
+	state.progHdl = progAsset.Handle();
+
+	const hdl_t pipelineHdl = Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
+
+	auto it = g_pipelineLib.find( pipelineHdl.Get() );
+	if ( it != g_pipelineLib.end() ) {
+		return;
+	}
 
-	VK_CHECK_RESULT( vkCreateComputePipelines( context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipelineObject.pipeline ) );
+	pipelineCompileRequest_t request;
+	InitComputeRequest( progAsset, request );
+	CompileComputePipeline( request );
 
-	g_pipelineLib[ pipelineHdl.Get() ] = pipelineObject;
-}
\ No newline at end of file
+	g_pipelineLib[ pipelineHdl.Get() ] = request.result;
+}
+
+
+void QueueGraphicsPipeline( const DrawPass* pass, const Asset<GpuProgram>& progAsset, const materialFeatureBits_t features )
+{
+	pipelineCompileRequest_t request;
+	InitGraphicsRequest( pass, progAsset, features, request );
+
+	// Views share pass configurations, compile each pipeline once
+	if ( g_queuedPipelines.insert( request.hdl.Get() ).second == false ) {
+		return;
+	}
+	g_compileRequests.push_back( request );
+}
+
+
+void QueueComputePipeline( const Asset<GpuProgram>& progAsset )
+{
+	pipelineCompileRequest_t request;
+	InitComputeRequest( progAsset, request );
+
+	if ( g_queuedPipelines.insert( request.hdl.Get() ).second == false ) {
+		return;
+	}
+	g_compileRequests.push_back( request );
+}
+
+
+uint32_t SubmitPipelineCompiles( JobSystem& jobs, JobCounter* counter )
+{
+	// Requests aren't touched again until SwapCompiledPipelines(), so jobs can point into the list
+	const uint32_t requestCount = static_cast<uint32_t>( g_compileRequests.size() );
+	for ( uint32_t i = 0; i < requestCount; ++i )
+	{
+		pipelineCompileRequest_t* request = &g_compileRequests[ i ];
+		if ( request->compute ) {
+			jobs.Submit( [ request ]() { CompileComputePipeline( *request ); }, counter );
+		} else {
+			jobs.Submit( [ request ]() { CompileGraphicsPipeline( *request ); }, counter );
+		}
+	}
+	return requestCount;
+}
+
+
+uint32_t SwapCompiledPipelines( const uint32_t frameNumber )
+{
+	const uint32_t requestCount = static_cast<uint32_t>( g_compileRequests.size() );
+	for ( uint32_t i = 0; i < requestCount; ++i )
+	{
+		const pipelineCompileRequest_t& request = g_compileRequests[ i ];
+
+		// The handle stays the same, draws pick up the new pipeline without recommitting
+		auto it = g_pipelineLib.find( request.hdl.Get() );
+		if ( it != g_pipelineLib.end() ) {
+			g_retiredPipelines.push_back( { it->second.pipeline, it->second.pipelineLayout, frameNumber } );
+		}
+		g_pipelineLib[ request.hdl.Get() ] = request.result;
+
+		if ( request.compute == false ) {
+			g_pipelineManifest[ request.hdl.Get() ] = request.state;
+		}
+	}
+	g_compileRequests.clear();
+	g_queuedPipelines.clear();
+
+	return requestCount;
+}
+
+
+void DestroyRetiredPipelines( const uint32_t frameNumber )
+{
+	// Only MaxFrameStates frames can be in flight, anything retired before that is idle
+	auto it = g_retiredPipelines.begin();
+	while ( it != g_retiredPipelines.end() )
+	{
+		if ( ( frameNumber - it->frameNumber ) < MaxFrameStates )
+		{
+			++it;
+			continue;
+		}
+		vkDestroyPipeline( context.device, it->pipeline, nullptr );
+		vkDestroyPipelineLayout( context.device, it->pipelineLayout, nullptr );
+
+		it = g_retiredPipelines.erase( it );
+	}
+}
+
+
+void RequestGraphicsPipeline( const DrawPass* pass, const Asset<GpuProgram>& progAsset, const materialFeatureBits_t features )
+{
+	const pipelineState_t state = MakeGraphicsPipelineState( pass, progAsset, features );
+	const hdl_t pipelineHdl = Hash( reinterpret_cast<const uint8_t*>( &state ), sizeof( state ) );
+
+	std::lock_guard<std::mutex> lock( g_requestLock );
+
+	// Every view misses the same variant until it's built
+	if ( g_requestedHdls.insert( pipelineHdl.Get() ).second == false ) {
+		return;
+	}
+	g_requestedPipelines.push_back( pipelineRequest_t{ pass, progAsset.Handle(), features } );
+}
+
+
+uint32_t QueueRequestedPipelines()
+{
+	std::lock_guard<std::mutex> lock( g_requestLock );
+
+	uint32_t queuedCount = 0;
+	for ( auto it = g_requestedPipelines.begin(); it != g_requestedPipelines.end(); ++it )
+	{
+		const Asset<GpuProgram>* progAsset = g_assets.gpuPrograms.Find( it->progHdl );
+		if ( ( progAsset == nullptr ) || ( progAsset->IsUploaded() == false ) ) {
+			continue;
+		}
+		QueueGraphicsPipeline( it->pass, *progAsset, it->features );
+		++queuedCount;
+	}
+	g_requestedPipelines.clear();
+	g_requestedHdls.clear();
+
+	return queuedCount;
+}
@@ -28,6 +28,8 @@
 #include "../render_state/rhi.h"
 
 class RenderContext;
+class JobSystem;
+class JobCounter;
 
 enum gfxStateBits_t : uint64_t
 {
@@ -54,12 +56,29 @@ enum gfxStateBits_t : uint64_t
 DEFINE_ENUM_OPERATORS( gfxStateBits_t, uint64_t )
 
 
+// Mirrors MATERIAL_FEATURE_* in shaders/globals.h, fed to specialization constant MaterialFeaturesSpecId
+enum materialFeatureBits_t : uint32_t
+{
+	MATERIAL_FEATURE_NONE			= 0,
+	MATERIAL_FEATURE_NORMAL_MAP		= ( 1 << 0 ),
+	MATERIAL_FEATURE_SPECULAR_MAPS	= ( 1 << 1 ),
+	MATERIAL_FEATURE_ALPHA_TEST		= ( 1 << 2 ),
+	MATERIAL_FEATURE_SHADOWED		= ( 1 << 3 ),
+	MATERIAL_FEATURE_IBL			= ( 1 << 4 ),
+	MATERIAL_FEATURE_ALL			= 0x1F,		// Same as the shader default, used by requests that don't specialize
+};
+DEFINE_ENUM_OPERATORS( materialFeatureBits_t, uint32_t )
+
+const uint32_t MaterialFeaturesSpecId = 0;
+
+
 struct pipelineState_t
 {
 	gfxStateBits_t				stateBits;
 	imageSamples_t				samplingRate;
 	hdl_t						progHdl;
 	renderAttachmentBits_t		passBits;
+	materialFeatureBits_t		materialFeatures;
 };
 
 class DrawPass;
@@ -88,10 +107,24 @@ class ShaderBindSet;
 
 void	ClearPipelineCache();
 void	DestroyPipelineCache();
+size_t	LoadVkPipelineCacheBlob( const std::string& path );	// The driver's VkPipelineCache, not the pipeline objects
+void	SaveVkPipelineCacheBlob( const std::string& path );
+size_t	LoadPipelineManifest( const std::string& path, std::vector<pipelineState_t>& states );
+void	SavePipelineManifest( const std::string& path );
 bool	GetPipelineObject( hdl_t hdl, pipelineObject_t** pipelineObject );
-hdl_t	FindPipelineObject( const DrawPass* pass, const Asset<GpuProgram>& progAsset );
+hdl_t	FindPipelineObject( const DrawPass* pass, const Asset<GpuProgram>& progAsset, const materialFeatureBits_t features = MATERIAL_FEATURE_ALL );
 void	CreateBindingLayout( ShaderBindSet& parms, VkDescriptorSetLayout& layout );
 hdl_t	CreateGraphicsPipeline( const RenderContext* renderContext, const DrawPass* pass, const Asset<GpuProgram>& prog );
-void	DestroyGraphicsPipeline( const DrawPass* pass, const Asset<GpuProgram>& prog );
 void	CreateComputePipeline( const Asset<GpuProgram>& prog );
-void	DestroyComputePipeline( const Asset<GpuProgram>& prog );
\ No newline at end of file
+void	DestroyComputePipeline( const Asset<GpuProgram>& prog );
+
+// Background compiles, the old pipeline stays in use until SwapCompiledPipelines()
+void		QueueGraphicsPipeline( const DrawPass* pass, const Asset<GpuProgram>& prog, const materialFeatureBits_t features = MATERIAL_FEATURE_ALL );
+void		QueueComputePipeline( const Asset<GpuProgram>& prog );
+uint32_t	SubmitPipelineCompiles( JobSystem& jobs, JobCounter* counter );
+uint32_t	SwapCompiledPipelines( const uint32_t frameNumber );
+void		DestroyRetiredPipelines( const uint32_t frameNumber );
+
+// Thread-safe, for variants first seen while committing. Queued with the next batch
+void		RequestGraphicsPipeline( const DrawPass* pass, const Asset<GpuProgram>& prog, const materialFeatureBits_t features );
+uint32_t	QueueRequestedPipelines();
\ No newline at end of file
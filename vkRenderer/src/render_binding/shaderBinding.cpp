@@ -65,12 +65,28 @@ bool ShaderBinding::IsArrayType() const
 }
 
 
+bool ShaderBinding::IsTableType() const
+{
+	return ( GetBindSemantic( m_state.type ) == bindSemantic_t::IMAGE_TABLE );
+}
+
+
 uint32_t ShaderBinding::GetMaxDescriptorCount() const
 {
 	return m_state.maxDescriptorCount;
 }
 
 
+// Texture tables are declared at MaxBindlessImages and sized to the device at init
+uint32_t ShaderBinding::GetDescriptorCount() const
+{
+	if ( IsTableType() ) {
+		return Min( m_state.maxDescriptorCount, context.bindlessImageCount );
+	}
+	return m_state.maxDescriptorCount;
+}
+
+
 bindStateFlag_t ShaderBinding::GetBindFlags() const
 {
 	return m_state.flags;
@@ -118,24 +134,43 @@ void ShaderBindSet::Create( const char* name, const ShaderBinding bindings[], co
 	// Create API object
 #ifdef USE_VULKAN
 	std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+	std::vector<VkDescriptorBindingFlags> bindingFlags;
 	layoutBindings.resize( bindCount );
+	bindingFlags.resize( bindCount );
 
+	bool updateAfterBind = false;
 	for ( uint32_t i = 0; i < bindCount; ++i )
 	{
 		const ShaderBinding* binding = GetBinding( i );
 
 		layoutBindings[ i ] = {};
 		layoutBindings[ i ].binding = binding->GetSlot();
-		layoutBindings[ i ].descriptorCount = binding->GetMaxDescriptorCount();
+		layoutBindings[ i ].descriptorCount = binding->GetDescriptorCount();
 		layoutBindings[ i ].descriptorType = vk_GetDescriptorType( binding->GetType() );
 		layoutBindings[ i ].pImmutableSamplers = nullptr;
 		layoutBindings[ i ].stageFlags = vk_GetStageFlags( binding->GetBindFlags() );
+
+		// Texture tables fill in as textures stream, so slots can be empty and written while bound
+		bindingFlags[ i ] = 0;
+		if ( binding->IsTableType() )
+		{
+			bindingFlags[ i ] |= context.bindlessPartiallyBound ? VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT : 0;
+			bindingFlags[ i ] |= context.bindlessUpdateAfterBind ? VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT : 0;
+			updateAfterBind = updateAfterBind || context.bindlessUpdateAfterBind;
+		}
 	}
 
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = static_cast<uint32_t>( bindingFlags.size() );
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
 	VkDescriptorSetLayoutCreateInfo layoutInfo{};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutInfo.bindingCount = static_cast<uint32_t>( layoutBindings.size() );
 	layoutInfo.pBindings = layoutBindings.data();
+	layoutInfo.flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0;
+	layoutInfo.pNext = &bindingFlagsInfo;
 
 	VK_CHECK_RESULT( vkCreateDescriptorSetLayout( context.device, &layoutInfo, nullptr, &vk_layout ) );
 
@@ -214,6 +249,7 @@ void ShaderBindParms::SetVkObject( const VkDescriptorSet descSet[ MaxFrameStates
 	{
 		assert( descSet[ frameIx ] != VK_NULL_HANDLE );
 		vk_descriptorSets[ frameIx ] = descSet[ frameIx ];
+		vk_writeCache[ frameIx ].clear();
 	}
 }
 
@@ -224,6 +260,12 @@ void ShaderBindParms::InitApiObjects()
 		vk_descriptorSets[ i ] = VK_NULL_HANDLE;
 	}
 }
+
+
+descriptorCache_t& ShaderBindParms::GetWriteCache( const ShaderBinding& binding )
+{
+	return vk_writeCache[ context.bufferId ][ binding.GetHash() ];
+}
 #endif
 
 
@@ -233,14 +275,14 @@ bool ShaderBindParms::IsValid() const
 }
 
 
-bool ShaderBindParms::AttachmentChanged( const ShaderBinding& binding ) const
+uint32_t ShaderBindParms::GetVersion( const ShaderBinding& binding ) const
 {
 	const uint32_t hash = binding.GetHash();
-	auto it = dirty[ context.bufferId ].find( hash );
-	if( it != dirty[ context.bufferId ].end() ) {
+	auto it = versions[ context.bufferId ].find( hash );
+	if( it != versions[ context.bufferId ].end() ) {
 		return it->second;
 	}
-	return false;
+	return 0;
 }
 
 
@@ -249,7 +291,10 @@ void ShaderBindParms::Clear()
 	for ( uint32_t frameIx = 0; frameIx < MaxFrameStates; ++frameIx )
 	{
 		attachments[ frameIx ].clear();
-		dirty[ frameIx ].clear();
+		versions[ frameIx ].clear();
+#ifdef USE_VULKAN
+		vk_writeCache[ frameIx ].clear();
+#endif
 	}
 }
 
@@ -261,10 +306,15 @@ void ShaderBindParms::Bind( const ShaderBinding& binding, const ShaderAttachment
 		if( binding.IsArrayType() ) {
 			assert( attachment.GetImageArray()->Count() <= binding.GetMaxDescriptorCount() );
 		}
+		if( binding.IsTableType() ) {
+			assert( attachment.GetImageTable()->Capacity() <= binding.GetDescriptorCount() );
+		}
 		assert( GetBindSemantic( binding.GetType() ) == attachment.GetSemantic() );
 
 		const uint32_t hash = binding.GetHash();
-		dirty[ context.bufferId ][ hash ] = ( attachments[ context.bufferId ][ hash ] != attachment );
+		if ( attachments[ context.bufferId ][ hash ] != attachment ) {
+			++versions[ context.bufferId ][ hash ];
+		}
 		attachments[ context.bufferId ][ hash ] = attachment;
 	} else {
 		assert( 0 );
@@ -277,7 +327,7 @@ void ShaderBindParms::Unbind( const ShaderBinding& binding )
 	if ( bindSet->HasBinding( binding ) )
 	{
 		const uint32_t hash = binding.GetHash();
-		dirty[ context.bufferId ][ hash ] = true;
+		++versions[ context.bufferId ][ hash ];
 		attachments[ context.bufferId ][ hash ] = ShaderAttachment();
 	} else {
 		assert( 0 );
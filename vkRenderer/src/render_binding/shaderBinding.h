@@ -27,6 +27,7 @@
 #include <unordered_map>
 #include "../globals/common.h"
 #include "../render_core/renderResource.h"
+#include "imageTable.h"
 
 class GpuBuffer;
 class GpuImage;
@@ -39,6 +40,8 @@ enum class bindType_t
 	IMAGE_3D,
 	IMAGE_CUBE,
 	IMAGE_CUBE_ARRAY,
+	IMAGE_2D_TABLE,
+	IMAGE_CUBE_TABLE,
 	READ_BUFFER,
 	WRITE_BUFFER,
 	READ_IMAGE_BUFFER,
@@ -52,6 +55,7 @@ enum class bindSemantic_t
 	BUFFER,
 	IMAGE,
 	IMAGE_ARRAY,
+	IMAGE_TABLE,
 };
 
 
@@ -84,6 +88,10 @@ static inline bindSemantic_t GetBindSemantic( const bindType_t bindType )
 		case bindType_t::IMAGE_2D_ARRAY:
 		case bindType_t::IMAGE_CUBE_ARRAY:
 			return bindSemantic_t::IMAGE_ARRAY;
+
+		case bindType_t::IMAGE_2D_TABLE:
+		case bindType_t::IMAGE_CUBE_TABLE:
+			return bindSemantic_t::IMAGE_TABLE;
 	}
 	return bindSemantic_t::UNKNOWN;
 }
@@ -121,7 +129,9 @@ public:
 	uint32_t		GetSlot() const;
 	bindType_t		GetType() const;
 	bool			IsArrayType() const;
+	bool			IsTableType() const;
 	uint32_t		GetMaxDescriptorCount() const;
+	uint32_t		GetDescriptorCount() const;
 	bindStateFlag_t	GetBindFlags() const;
 	uint32_t		GetHash() const;
 
@@ -137,6 +147,7 @@ private:
 		const GpuBuffer*	buffer;
 		const Image*		image;
 		const ImageArray*	imageArray;
+		const ImageTable*	imageTable;
 		const void*			ptr;
 	} u;
 	bindSemantic_t semantic;
@@ -167,6 +178,12 @@ public:
 		semantic = bindSemantic_t::IMAGE_ARRAY;
 	}
 
+	ShaderAttachment( const ImageTable* imageTable )
+	{
+		u.imageTable = imageTable;
+		semantic = bindSemantic_t::IMAGE_TABLE;
+	}
+
 	inline bool operator==( const ShaderAttachment& rhs ) const
 	{
 		return ( u.ptr == rhs.u.ptr );
@@ -196,6 +213,11 @@ public:
 	{
 		return ( semantic == bindSemantic_t::IMAGE_ARRAY ) ? u.imageArray : nullptr;
 	}
+
+	inline const ImageTable* GetImageTable() const
+	{
+		return ( semantic == bindSemantic_t::IMAGE_TABLE ) ? u.imageTable : nullptr;
+	}
 };
 
 
@@ -232,15 +254,28 @@ public:
 };
 
 
+#ifdef USE_VULKAN
+// What was last written to one binding of a descriptor set
+struct descriptorCache_t
+{
+	uint32_t							version;
+	std::vector<uint32_t>				generations;	// Per element, see RenderResource::GetGeneration()
+	std::vector<VkDescriptorBufferInfo>	bufferInfos;
+	std::vector<VkDescriptorImageInfo>	imageInfos;
+};
+#endif
+
+
 class ShaderBindParms
 {
 private:
 	const ShaderBindSet*							bindSet;
 	std::unordered_map<uint32_t, ShaderAttachment>	attachments[ MaxFrameStates ];
-	std::unordered_map<uint32_t, bool>				dirty[ MaxFrameStates ];
+	std::unordered_map<uint32_t, uint32_t>			versions[ MaxFrameStates ];		// Bumped when a binding's attachment changes
 
 #ifdef USE_VULKAN
 	VkDescriptorSet									vk_descriptorSets[ MaxFrameStates ];
+	std::unordered_map<uint32_t, descriptorCache_t>	vk_writeCache[ MaxFrameStates ];
 #endif
 
 public:
@@ -264,6 +299,7 @@ public:
 	VkDescriptorSet				GetVkObject() const;
 	void						SetVkObject( const VkDescriptorSet descSet[ MaxFrameStates ] );
 	void						InitApiObjects();
+	descriptorCache_t&			GetWriteCache( const ShaderBinding& binding );
 #endif
 
 	inline const ShaderBindSet*	GetSet() const
@@ -272,7 +308,7 @@ public:
 	}
 
 	bool						IsValid() const;
-	bool						AttachmentChanged( const ShaderBinding& binding ) const;
+	uint32_t					GetVersion( const ShaderBinding& binding ) const;
 	void						Clear();
 	void						Bind( const ShaderBinding& binding, const ShaderAttachment attachment );
 	void						Unbind( const ShaderBinding& binding );
@@ -27,6 +27,8 @@
 #include "../globals/renderview.h"
 #include "../render_binding/gpuResources.h"
 #include "../render_binding/bindings.h"
+#include "../app/jobSystem.h"
+#include "debugMenu.h"
 
 #if defined( USE_IMGUI )
 #include "../../external/imgui/imgui.h"
@@ -67,10 +69,12 @@ static inline bool SkipPass( const drawSurf_t& surf, const drawPass_t pass )
 }
 
 
+static void RenderViewPasses( CommandContext* cmdContext, RenderView* renderView, const viewport_t* tile );
+
+
 void RenderTask::RenderViewSurfaces( GfxContext* cmdContext )
 {
 	const drawPass_t passBegin = renderView->ViewRegionPassBegin();
-	const drawPass_t passEnd = renderView->ViewRegionPassEnd();
 
 	// For now the pass state is the same for the entire view region
 	const DrawPass* pass = renderView->passes[ passBegin ];
@@ -119,19 +123,29 @@ void RenderTask::RenderViewSurfaces( GfxContext* cmdContext )
 
 	VkCommandBuffer cmdBuffer = cmdContext->CommandBuffer();
 
-	for ( uint32_t passIx = passBegin; passIx <= passEnd; ++passIx )
+	if( parallel )
 	{
-		DrawPass* pass = renderView->passes[ passIx ];
-		if ( pass == nullptr ) {
-			continue;
-		}
-		// These barriers could be tighter by places them in between passes
-		pass->InsertResourceBarriers( *cmdContext );
+		// Pass contents were recorded by Record() into the task's secondary buffer
+		vkCmdBeginRenderPass( cmdBuffer, &passInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+		vkCmdExecuteCommands( cmdBuffer, 1, &secondaryContext.CommandBuffer() );
+	}
+	else
+	{
+		vkCmdBeginRenderPass( cmdBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE );
+		RenderViewPasses( cmdContext, renderView, nullptr );
 	}
 
-	vkCmdBeginRenderPass( cmdBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE );
+	vkCmdEndRenderPass( cmdBuffer );
+}
 
-	uint32_t modelOffset = 0;
+
+// Records the passes of a view. The viewport and scissor come from each pass unless a tile of the framebuffer is given.
+static void RenderViewPasses( CommandContext* cmdContext, RenderView* renderView, const viewport_t* tile )
+{
+	const drawPass_t passBegin = renderView->ViewRegionPassBegin();
+	const drawPass_t passEnd = renderView->ViewRegionPassEnd();
+
+	VkCommandBuffer cmdBuffer = cmdContext->CommandBuffer();
 
 	for ( uint32_t passIx = passBegin; passIx <= passEnd; ++passIx )
 	{
@@ -167,7 +181,7 @@ void RenderTask::RenderViewSurfaces( GfxContext* cmdContext )
 
 		cmdContext->MarkerBeginRegion( pass->Name(), ColorToVector( Color::White ) );
 
-		const viewport_t& viewport = pass->GetViewport();
+		const viewport_t& viewport = ( tile != nullptr ) ? *tile : pass->GetViewport();
 
 		VkViewport vk_viewport{ };
 		vk_viewport.x = static_cast<float>( viewport.x );
@@ -179,83 +193,222 @@ void RenderTask::RenderViewSurfaces( GfxContext* cmdContext )
 		vkCmdSetViewport( cmdBuffer, 0, 1, &vk_viewport );
 
 		VkRect2D rect{ };
+		rect.offset.x = viewport.x;
+		rect.offset.y = viewport.y;
 		rect.extent.width = viewport.width;
 		rect.extent.height = viewport.height;
 		vkCmdSetScissor( cmdBuffer, 0, 1, &rect );
 
-		sortKey_t lastKey = {};
-		lastKey.materialId = INVALID_HDL.Get();
-		lastKey.stencilBit = 0;
+		uint32_t lastMaterialId = ~0u;
+		uint32_t lastStencilBit = ~0u;
 
 		hdl_t pipelineHandle = INVALID_HDL;
 		pipelineObject_t* pipelineObject = nullptr;
 
-		for ( uint32_t surfIx = 0; surfIx < surfaceCount; ++surfIx )
+		// Commands for the pass are contiguous, instance counts were written by the cull dispatch
+		const GpuBuffer& drawCommands = renderView->DrawCommands();
+		const VkDeviceSize commandStride = sizeof( drawCommandBufferObject_t );
+		const VkDeviceSize commandBase = drawCommands.GetBaseOffset() + renderView->drawCommandOffset[ passIx ] * commandStride;
+
+		uint32_t surfIx = 0;
+		while ( surfIx < surfaceCount )
 		{
 			const drawSurf_t& surface = drawGroup->DrawSurf( surfIx );
-			const surfaceUpload_t& upload = drawGroup->SurfUpload( surfIx );
 
-			if ( SkipPass( surface, drawPass_t( passIx ) ) ) {
+			if ( SkipPass( surface, drawPass_t( passIx ) ) )
+			{
+				++surfIx;
 				continue;
 			}
 
-			if ( lastKey.key != surface.sortKey.key )
+			// A bucket is the draws with the same pipeline and material, Merge() made them contiguous.
+			// Each bucket is one indirect draw, the draws inside it only differ in geometry.
+			// Stencil reference is only dynamic state in the depth pass, so only it splits there.
+			const bool stencilState = ( passIx == DRAWPASS_DEPTH );
+			uint32_t bucketEnd = surfIx + 1;
+			while ( bucketEnd < surfaceCount )
 			{
-				cmdContext->MarkerInsert( surface.dbgName, ColorToVector( Color::LGrey ) );
+				const drawSurf_t& nextSurface = drawGroup->DrawSurf( bucketEnd );
+				if ( SkipPass( nextSurface, drawPass_t( passIx ) ) ||
+					( nextSurface.pipelineObject != surface.pipelineObject ) ||
+					( nextSurface.materialId != surface.materialId ) ||
+					( stencilState && ( nextSurface.stencilBit != surface.stencilBit ) ) ) {
+					break;
+				}
+				++bucketEnd;
+			}
+
+			const uint32_t bucketBegin = surfIx;
+			surfIx = bucketEnd;
 
-				if ( passIx == DRAWPASS_DEPTH ) {
-					vkCmdSetStencilReference( cmdBuffer, VK_STENCIL_FACE_FRONT_BIT, surface.stencilBit );
+			if( surface.pipelineObject != pipelineHandle )
+			{
+				GetPipelineObject( surface.pipelineObject, &pipelineObject );
+				if ( pipelineObject == nullptr ) {
+					continue;
 				}
 
-				if( surface.pipelineObject != pipelineHandle )
-				{
-					GetPipelineObject( surface.pipelineObject, &pipelineObject );
-					if ( pipelineObject == nullptr ) {
-						continue;
-					}
+				const RenderContext* renderContext = cmdContext->GetRenderContext();
 
-					const RenderContext* renderContext = cmdContext->GetRenderContext();
+				const uint32_t descSetCount = 3;
+				VkDescriptorSet descSetArray[ descSetCount ] = { renderContext->globalParms->GetVkObject(), renderView->BindParms()->GetVkObject(), pass->parms->GetVkObject() };
 
-					const uint32_t descSetCount = 3;
-					VkDescriptorSet descSetArray[ descSetCount ] = { renderContext->globalParms->GetVkObject(), renderView->BindParms()->GetVkObject(), pass->parms->GetVkObject() };
+				vkCmdBindPipeline( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineObject->pipeline );
+				vkCmdBindDescriptorSets( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineObject->pipelineLayout, 0, descSetCount, descSetArray, 0, nullptr );
+				pipelineHandle = surface.pipelineObject;
+			}
 
-					vkCmdBindPipeline( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineObject->pipeline );
-					vkCmdBindDescriptorSets( cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineObject->pipelineLayout, 0, descSetCount, descSetArray, 0, nullptr );
-					pipelineHandle = surface.pipelineObject;
-				}
-				lastKey = surface.sortKey;
+			if ( ( passIx == DRAWPASS_DEPTH ) && ( lastStencilBit != surface.stencilBit ) )
+			{
+				vkCmdSetStencilReference( cmdBuffer, VK_STENCIL_FACE_FRONT_BIT, surface.stencilBit );
+				lastStencilBit = surface.stencilBit;
 			}
 
-			assert( surface.sortKey.materialId < ( 1ull << KeyMaterialBits ) );
+			if ( lastMaterialId != surface.materialId )
+			{
+				cmdContext->MarkerInsert( drawGroup->DebugName( bucketBegin ), ColorToVector( Color::LGrey ) );
+				lastMaterialId = surface.materialId;
+			}
 
+			assert( surface.materialId < ( 1ull << KeyMaterialBits ) );
+
+			// Object ids come from the remap table through gl_InstanceIndex
 			pushConstants_t pushConstants = {};
 			pushConstants.viewId = uint32_t( renderView->GetViewId() );
-			pushConstants.objectId = surface.objectOffset + renderView->drawGroupOffset[ passIx ];
-			pushConstants.materialId = uint32_t( surface.sortKey.materialId );
+			pushConstants.materialId = surface.materialId;
 
 			vkCmdPushConstants( cmdBuffer, pipelineObject->pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof( pushConstants_t ), &pushConstants );
 
-			vkCmdDrawIndexed( cmdBuffer, upload.indexCount, drawGroup->InstanceCount( surfIx ), upload.firstIndex, upload.vertexOffset, 0 );
-		}	
+			const VkDeviceSize commandOffset = commandBase + bucketBegin * commandStride;
+			vkCmdDrawIndexedIndirect( cmdBuffer, drawCommands.GetVkObject(), commandOffset, bucketEnd - bucketBegin, static_cast<uint32_t>( commandStride ) );
+		}
 		cmdContext->MarkerEndRegion();
 	}
+}
 
-	vkCmdEndRenderPass( cmdBuffer );
+
+static void CullDraws( CommandContext* cmdContext, RenderView* renderView, const hdl_t cullProgHdl )
+{
+	const uint32_t objectCount = renderView->ObjectCount();
+	if ( ( objectCount == 0 ) || ( renderView->IsCommitted() == false ) ) {
+		return;
+	}
+
+	enum cullFlags_t : uint32_t
+	{
+		CULL_FRUSTUM	= ( 1 << 0 ),
+		CULL_OCCLUSION	= ( 1 << 1 ),
+	};
+
+	struct cullConstants_t
+	{
+		uint32_t	viewId;
+		uint32_t	objectCount;
+		uint32_t	cullFlags;
+	};
+
+	cullConstants_t constants = {};
+	constants.viewId = uint32_t( renderView->GetViewId() );
+	constants.objectCount = objectCount;
+	constants.cullFlags |= renderView->gpuCulling ? CULL_FRUSTUM : 0;
+	constants.cullFlags |= renderView->occlusionCulling ? CULL_OCCLUSION : 0;
+
+	const uint32_t groupSize = 64;
+	cmdContext->Dispatch( cullProgHdl, *renderView->CullParms(), &constants, sizeof( constants ), ( objectCount + groupSize - 1 ) / groupSize, 1, 1 );
+
+	// Draw commands and the remap table are consumed by the passes of this task
+	VkMemoryBarrier barrier{ };
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier( cmdContext->CommandBuffer(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
 }
 
 
-void RenderTask::Init( RenderView* view, drawPass_t begin, drawPass_t end )
+// Bins the committed lights into the view's clusters, which its lit passes read per fragment
+static void CullLights( CommandContext* cmdContext, RenderView* renderView, const hdl_t lightCullProgHdl )
+{
+	if ( ( renderView->GetRegion() != renderViewRegion_t::STANDARD_RASTER ) || ( renderView->IsCommitted() == false ) ) {
+		return;
+	}
+
+	const uint32_t viewId = uint32_t( renderView->GetViewId() );
+
+	const uint32_t groupSize = 64;
+	cmdContext->Dispatch( lightCullProgHdl, *renderView->LightCullParms(), &viewId, sizeof( viewId ), ( ClusterCount + groupSize - 1 ) / groupSize, 1, 1 );
+
+	VkMemoryBarrier barrier{ };
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier( cmdContext->CommandBuffer(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+}
+
+
+// Each job thread only writes its own slot. The worker count is bounded by the slots, see Renderer::Init()
+static void AddRecordTime( const Timer& recordTimer )
+{
+	const uint32_t threadIx = JobSystem::ThreadIndex();
+	if ( threadIx >= MaxRecordThreads ) {
+		throw std::runtime_error( "Record thread index exceeds the record timing slots" );
+	}
+
+	g_renderDebugData.recordThreadMs[ threadIx ] += static_cast<float>( recordTimer.GetElapsed() );
+	g_renderDebugData.recordThreadTasks[ threadIx ] += 1;
+}
+
+
+void RenderTask::Record()
+{
+	if ( renderView->reuseFrameBuffer ) {
+		return;
+	}
+
+	Timer recordTimer;
+	recordTimer.Start();
+
+	const drawPass_t passBegin = renderView->ViewRegionPassBegin();
+
+	const DrawPass* pass = renderView->passes[ passBegin ];
+	assert( pass != nullptr );
+
+	const renderPassTransition_t& transitionState = renderView->TransitionState();
+
+	secondaryContext.Begin( pass->GetFrameBuffer()->GetVkRenderPass( transitionState ), pass->GetFrameBuffer()->GetVkBuffer( transitionState, context.bufferId ) );
+	RenderViewPasses( &secondaryContext, renderView, nullptr );
+	secondaryContext.End();
+
+	recordTimer.Stop();
+	AddRecordTime( recordTimer );
+}
+
+
+void RenderTask::Init( RenderView* view, drawPass_t begin, drawPass_t end, RenderContext* renderContext )
 {
 	renderView = view;
 	beginPass = begin;
 	endPass= end;
 
+	cullProgHdl = g_assets.gpuPrograms.RetrieveHdl( "CullDraws" );
+	lightCullProgHdl = g_assets.gpuPrograms.RetrieveHdl( "LightCull" );
+
+	// ImGui draw data is recorded inline on the main thread
+	parallel = ( view != nullptr ) && ( view->GetRegion() != renderViewRegion_t::STANDARD_2D );
+	if( parallel ) {
+		secondaryContext.Create( view->GetName(), renderContext );
+	}
+
 	finishedSemaphore.Create( "Task Finished" );
 }
 
 
 void RenderTask::Shutdown()
 {
+	if( parallel ) {
+		secondaryContext.Destroy();
+	}
 	finishedSemaphore.Destroy();
 }
 
@@ -276,16 +429,219 @@ void RenderTask::FrameEnd()
 }
 
 
+void RenderTask::DeclareResources( RenderGraph& graph )
+{
+	if ( ( renderView == nullptr ) || renderView->reuseFrameBuffer ) {
+		return;
+	}
+
+	for ( uint32_t passIx = renderView->ViewRegionPassBegin(); passIx <= renderView->ViewRegionPassEnd(); ++passIx )
+	{
+		const DrawPass* pass = renderView->passes[ passIx ];
+		if ( pass != nullptr ) {
+			graph.ReadPass( pass );
+		}
+	}
+	graph.WriteFrameBuffer( renderView->passes[ renderView->ViewRegionPassBegin() ]->GetFrameBuffer() );
+
+	// Every view binds the pyramid, the culling dispatch tests against it
+	graph.ReadBuffer( &renderView->HiZPyramid(), GRAPH_ACCESS_COMPUTE );
+}
+
+
 void RenderTask::Execute( CommandContext& context )
 {
+	// The framebuffer is left in the state its last render pass ended in
+	if ( renderView->reuseFrameBuffer ) {
+		return;
+	}
+
 	context.MarkerBeginRegion( renderView->GetName(), ColorToVector( Color::White ) );
 
+	CullDraws( &context, renderView, cullProgHdl );
+	CullLights( &context, renderView, lightCullProgHdl );
 	RenderViewSurfaces( reinterpret_cast<GfxContext*>( &context ) );
 
 	context.MarkerEndRegion();
 }
 
 
+ShadowAtlasTask::ShadowAtlasTask( RenderView** views, const uint32_t viewCount, RenderContext* renderContext )
+{
+	assert( viewCount > 0 );
+	renderViews.assign( views, views + viewCount );
+
+	cullProgHdl = g_assets.gpuPrograms.RetrieveHdl( "CullDraws" );
+
+	secondaryContext.Create( "Shadow Atlas", renderContext );
+}
+
+
+bool ShadowAtlasTask::SkipView( const RenderView* view ) const
+{
+	// Culled views are flagged for reuse as well
+	return view->reuseFrameBuffer || ( view->IsCommitted() == false );
+}
+
+
+bool ShadowAtlasTask::HasPendingViews() const
+{
+	for ( const RenderView* view : renderViews )
+	{
+		if ( SkipView( view ) == false ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+const FrameBuffer* ShadowAtlasTask::AtlasFrameBuffer() const
+{
+	const RenderView* view = renderViews[ 0 ];
+	const DrawPass* pass = view->passes[ view->ViewRegionPassBegin() ];
+	assert( pass != nullptr );
+
+	return pass->GetFrameBuffer();
+}
+
+
+void ShadowAtlasTask::ClearTile( CommandContext* cmdContext, const RenderView* view )
+{
+	const viewport_t& tile = view->GetViewport();
+
+	VkClearAttachment attachment{ };
+	attachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	attachment.clearValue.depthStencil = { view->ClearDepth(), view->ClearStencil() };
+
+	VkClearRect rect{ };
+	rect.rect.offset = { tile.x, tile.y };
+	rect.rect.extent = { tile.width, tile.height };
+	rect.baseArrayLayer = 0;
+	rect.layerCount = 1;
+
+	vkCmdClearAttachments( cmdContext->CommandBuffer(), 1, &attachment, 1, &rect );
+}
+
+
+void ShadowAtlasTask::RenderAtlas( GfxContext* cmdContext )
+{
+	const FrameBuffer* atlas = AtlasFrameBuffer();
+	const renderPassTransition_t transitionState = renderViews[ 0 ]->TransitionState();
+	assert( transitionState.flags.clear == false );
+
+	VkRenderPassBeginInfo passInfo{ };
+	passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	passInfo.renderPass = atlas->GetVkRenderPass( transitionState );
+	passInfo.framebuffer = atlas->GetVkBuffer( transitionState, context.bufferId );
+	passInfo.renderArea.offset = { 0, 0 };
+	passInfo.renderArea.extent = { atlas->GetWidth(), atlas->GetHeight() };
+	passInfo.clearValueCount = 0;
+	passInfo.pClearValues = nullptr;
+
+	VkCommandBuffer cmdBuffer = cmdContext->CommandBuffer();
+
+	vkCmdBeginRenderPass( cmdBuffer, &passInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+	vkCmdExecuteCommands( cmdBuffer, 1, &secondaryContext.CommandBuffer() );
+	vkCmdEndRenderPass( cmdBuffer );
+}
+
+
+void ShadowAtlasTask::FrameBegin()
+{
+	for ( RenderView* view : renderViews ) {
+		view->FrameBegin();
+	}
+}
+
+
+void ShadowAtlasTask::FrameEnd()
+{
+	for ( RenderView* view : renderViews ) {
+		view->FrameEnd();
+	}
+}
+
+
+void ShadowAtlasTask::DeclareResources( RenderGraph& graph )
+{
+	if ( HasPendingViews() == false ) {
+		return;
+	}
+
+	for ( const RenderView* view : renderViews )
+	{
+		if ( SkipView( view ) ) {
+			continue;
+		}
+
+		for ( uint32_t passIx = view->ViewRegionPassBegin(); passIx <= view->ViewRegionPassEnd(); ++passIx )
+		{
+			const DrawPass* pass = view->passes[ passIx ];
+			if ( pass != nullptr ) {
+				graph.ReadPass( pass );
+			}
+		}
+	}
+	graph.WriteFrameBuffer( AtlasFrameBuffer() );
+}
+
+
+void ShadowAtlasTask::Record()
+{
+	if ( HasPendingViews() == false ) {
+		return;
+	}
+
+	Timer recordTimer;
+	recordTimer.Start();
+
+	const FrameBuffer* atlas = AtlasFrameBuffer();
+	const renderPassTransition_t transitionState = renderViews[ 0 ]->TransitionState();
+
+	secondaryContext.Begin( atlas->GetVkRenderPass( transitionState ), atlas->GetVkBuffer( transitionState, context.bufferId ) );
+	for ( RenderView* view : renderViews )
+	{
+		if ( SkipView( view ) ) {
+			continue;
+		}
+
+		secondaryContext.MarkerBeginRegion( view->GetName(), ColorToVector( Color::White ) );
+		ClearTile( &secondaryContext, view );
+		RenderViewPasses( &secondaryContext, view, &view->GetViewport() );
+		secondaryContext.MarkerEndRegion();
+	}
+	secondaryContext.End();
+
+	recordTimer.Stop();
+	AddRecordTime( recordTimer );
+}
+
+
+void ShadowAtlasTask::Execute( CommandContext& context )
+{
+	// Every tile is cached or culled, the atlas is left as it was
+	if ( HasPendingViews() == false ) {
+		return;
+	}
+
+	context.MarkerBeginRegion( "Shadow Atlas", ColorToVector( Color::White ) );
+
+	for ( RenderView* view : renderViews )
+	{
+		if ( SkipView( view ) ) {
+			continue;
+		}
+
+		CullDraws( &context, view, cullProgHdl );
+	}
+
+	RenderAtlas( reinterpret_cast<GfxContext*>( &context ) );
+
+	context.MarkerEndRegion();
+}
+
+
 ComputeTask::ComputeTask( const char* csName, ComputeState* state )
 {
 	m_state = state;
@@ -312,9 +668,10 @@ void ComputeTask::Execute( CommandContext& context )
 }
 
 
-void TransitionImageTask::Execute( CommandContext& context )
+void CopyImageTask::DeclareResources( RenderGraph& graph )
 {
-	Transition( &context, *m_img, m_srcState, m_dstState );
+	graph.ReadImage( m_src, GRAPH_ACCESS_TRANSFER );
+	graph.WriteImage( m_dst, GRAPH_ACCESS_TRANSFER );
 }
 
 
@@ -348,6 +705,23 @@ void RenderSchedule::Queue( GpuTask* task )
 }
 
 
+void RenderSchedule::Compile()
+{
+	graph.Compile( tasks );
+}
+
+
+void RenderSchedule::Resize()
+{
+	const uint32_t taskCount = static_cast<uint32_t>( tasks.size() );
+	for ( uint32_t i = 0; i < taskCount; ++i )
+	{
+		GpuTask* task = tasks[ i ];
+		task->Resize();
+	}
+}
+
+
 void RenderSchedule::FrameBegin()
 {
 	currentTask = 0;
@@ -363,6 +737,9 @@ void RenderSchedule::FrameBegin()
 	// Prepare dear imgui render data
 	ImGui::Render();
 #endif
+
+	// Declarations depend on what the tasks set up for this frame
+	graph.Build( tasks );
 }
 
 
@@ -377,10 +754,43 @@ void RenderSchedule::FrameEnd()
 }
 
 
+void RenderSchedule::Record( JobSystem& jobs )
+{
+	Timer recordTimer;
+	recordTimer.Start();
+
+	for ( uint32_t i = 0; i < MaxRecordThreads; ++i )
+	{
+		g_renderDebugData.recordThreadMs[ i ] = 0.0f;
+		g_renderDebugData.recordThreadTasks[ i ] = 0;
+	}
+
+	JobCounter recordJobs;
+
+	const uint32_t taskCount = static_cast<uint32_t>( tasks.size() );
+	for ( uint32_t i = 0; i < taskCount; ++i )
+	{
+		GpuTask* task = tasks[ i ];
+		if ( task->IsParallel() && ( graph.IsCulled( i ) == false ) ) {
+			jobs.Submit( [ task ]() { task->Record(); }, &recordJobs );
+		}
+	}
+	jobs.Wait( &recordJobs );
+
+	recordTimer.Stop();
+	g_renderDebugData.recordTimeMs = static_cast<float>( recordTimer.GetElapsed() );
+}
+
+
 void RenderSchedule::IssueNext( CommandContext& context )
 {
-	GpuTask* task = tasks[ currentTask ];
+	const uint32_t taskIx = currentTask;
 	++currentTask;
 
-	task->Execute( context );
+	if ( graph.IsCulled( taskIx ) ) {
+		return;
+	}
+
+	graph.IssueBarriers( taskIx, context );
+	tasks[ taskIx ]->Execute( context );
 }
\ No newline at end of file
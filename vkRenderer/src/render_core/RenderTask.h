@@ -5,7 +5,10 @@
 #include "../render_core/GpuSync.h"
 #include "../render_state/frameBuffer.h"
 #include "../render_binding/imageView.h"
+#include "../render_state/cmdContext.h"
+#include "renderGraph.h"
 
+class JobSystem;
 class CommandContext;
 class GfxContext;
 class RenderView;
@@ -38,8 +41,6 @@ union mipProcessParms_t
 	};
 };
 
-enum gpuImageStateFlags_t : uint8_t;
-
 class GpuTask
 {
 public:
@@ -48,6 +49,13 @@ public:
 	virtual void	Resize() = 0;
 	virtual void	Execute( CommandContext& context ) = 0;
 
+	// Images and buffers the task touches this frame. Tasks that declare nothing are never culled and get no barriers.
+	virtual void	DeclareResources( RenderGraph& graph ) {}
+
+	// Parallel tasks record their commands on a job thread before the schedule is issued
+	virtual bool	IsParallel() const { return false; }
+	virtual void	Record() {}
+
 	virtual ~GpuTask() {};
 };
 
@@ -55,24 +63,28 @@ public:
 class RenderTask : public GpuTask
 {
 private:
-	RenderView*		renderView;
-	drawPass_t		beginPass;
-	drawPass_t		endPass;
-	GpuSemaphore	finishedSemaphore;
-
-	void Init( RenderView* view, drawPass_t begin, drawPass_t end );
+	RenderView*			renderView;
+	drawPass_t			beginPass;
+	drawPass_t			endPass;
+	GpuSemaphore		finishedSemaphore;
+	SecondaryContext	secondaryContext;
+	hdl_t				cullProgHdl;
+	hdl_t				lightCullProgHdl;
+	bool				parallel;
+
+	void Init( RenderView* view, drawPass_t begin, drawPass_t end, RenderContext* renderContext );
 	void Shutdown();
 	void RenderViewSurfaces( GfxContext* context );
 
 public:
 	RenderTask()
 	{
-		Init( nullptr, DRAWPASS_COUNT, DRAWPASS_COUNT );
+		Init( nullptr, DRAWPASS_COUNT, DRAWPASS_COUNT, nullptr );
 	}
 
-	RenderTask( RenderView* view, drawPass_t begin, drawPass_t end )
+	RenderTask( RenderView* view, drawPass_t begin, drawPass_t end, RenderContext* renderContext )
 	{
-		Init( view, begin, end );
+		Init( view, begin, end, renderContext );
 	}
 
 	~RenderTask()
@@ -85,53 +97,64 @@ public:
 	void FrameBegin();
 	void FrameEnd();
 
+	void DeclareResources( RenderGraph& graph ) override;
+	bool IsParallel() const override { return parallel; }
+	void Record() override;
 	void Execute( CommandContext& context ) override;
 };
 
 
-class ComputeTask : public GpuTask
+// Renders every shadow view into its own tile of the shadow atlas within one render pass.
+// The atlas is loaded rather than cleared so tiles of cached views survive, rendered tiles are cleared individually.
+class ShadowAtlasTask : public GpuTask
 {
 private:
-	ComputeState*		m_state;
-	hdl_t				m_progHdl;
+	std::vector<RenderView*>	renderViews;
+	SecondaryContext			secondaryContext;
+	hdl_t						cullProgHdl;
+
+	bool SkipView( const RenderView* view ) const;
+	bool HasPendingViews() const;
+	const FrameBuffer* AtlasFrameBuffer() const;
+	void ClearTile( CommandContext* context, const RenderView* view );
+	void RenderAtlas( GfxContext* context );
 
 public:
-	ComputeTask( const char* csName, ComputeState* state );
+	ShadowAtlasTask( RenderView** views, const uint32_t viewCount, RenderContext* renderContext );
+
+	~ShadowAtlasTask()
+	{
+		secondaryContext.Destroy();
+	}
 
 	void Resize() {}
 
 	void FrameBegin();
 	void FrameEnd();
 
+	void DeclareResources( RenderGraph& graph ) override;
+	bool IsParallel() const override { return true; }
+	void Record() override;
 	void Execute( CommandContext& context ) override;
-	~ComputeTask()
-	{}
 };
 
 
-class TransitionImageTask : public GpuTask
+class ComputeTask : public GpuTask
 {
 private:
-	Image*					m_img;
-	gpuImageStateFlags_t	m_srcState;
-	gpuImageStateFlags_t	m_dstState;
+	ComputeState*		m_state;
+	hdl_t				m_progHdl;
 
 public:
-
-	TransitionImageTask( Image* img, const gpuImageStateFlags_t srcState, const gpuImageStateFlags_t dstState )
-	{
-		m_img = img;
-		m_srcState = srcState;
-		m_dstState = dstState;
-	}
+	ComputeTask( const char* csName, ComputeState* state );
 
 	void Resize() {}
 
-	void FrameBegin() {}
-	void FrameEnd() {}
+	void FrameBegin();
+	void FrameEnd();
 
 	void Execute( CommandContext& context ) override;
-	~TransitionImageTask()
+	~ComputeTask()
 	{}
 };
 
@@ -155,6 +178,7 @@ public:
 	void FrameBegin() {}
 	void FrameEnd() {}
 
+	void DeclareResources( RenderGraph& graph ) override;
 	void Execute( CommandContext& context ) override;
 	~CopyImageTask()
 	{}
@@ -165,6 +189,7 @@ class RenderSchedule
 {
 private:
 	std::vector< GpuTask* >	tasks;
+	RenderGraph				graph;
 	uint32_t				currentTask;
 	
 public:
@@ -172,10 +197,18 @@ public:
 	RenderSchedule() : currentTask( 0 )
 	{}
 
+	inline RenderGraph& Graph()
+	{
+		return graph;
+	}
+
 	uint32_t	PendingTasks() const;
 	void		Clear();
 	void		Queue( GpuTask* task );
+	void		Compile();
+	void		Resize();
 	void		FrameBegin();
 	void		FrameEnd();
+	void		Record( JobSystem& jobs );
 	void		IssueNext( CommandContext& context );
 };
\ No newline at end of file
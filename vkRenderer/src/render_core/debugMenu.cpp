@@ -417,7 +417,7 @@ void DebugMenuLightEdit( Scene* scene )
 			
 			EditRgb( rgb );
 
-			scene->lights[ i ].pos = origin;
+			scene->lights[ i ].pos = vec4f( origin[ 0 ], origin[ 1 ], origin[ 2 ], o[ 3 ] );
 			scene->lights[ i ].dir = dir;
 			scene->lights[ i ].color = rgb;
 
@@ -2,12 +2,58 @@
 
 class Scene;
 
+static const uint32_t MaxRecordThreads = 32;	// Bounds the render job system's workers, one slot each plus the caller
+
+enum viewRenderState_t : uint32_t
+{
+	VIEW_RENDERED,
+	VIEW_CACHED,
+	VIEW_CULLED,
+};
+
+struct viewDebugData_t
+{
+	const char*	name;
+	uint32_t	visibleCount;
+	uint32_t	culledCount;
+	uint32_t	gpuVisibleCount;	// Counted by the cull dispatch, lags the CPU by the frames in flight
+	uint32_t	gpuFrustumCulled;
+	uint32_t	gpuOcclusionCulled;
+	uint32_t	patchedCount;
+	uint32_t	rebuiltCount;
+	uint32_t	droppedCount;		// Surfaces past the largest partition the device can bind
+	uint32_t	arenaBytes;
+	viewRenderState_t	renderState;
+};
+
 struct renderDebugData_t
 {
 	uint32_t	frameNumber;
 	float		frameTimeMs;
+	float		gpuFrameTimeMs;			// Graphics queue time of the frame slot that just retired
+	float		resolutionScale;		// Per-axis scale of the main view
+	float		commitTimeMs;
+	uint32_t	bvhNodeCount;
+	uint32_t	bvhReinsertCount;
+	bool		bvhRebuilt;
+	float		shadowAtlasUsage;
+	float		pipelineBuildMs;		// Queue to swap-in time of the last pipeline batch
+	uint32_t	pipelineBuildCount;
+	uint32_t	pipelineCompilesPending;
+	uint32_t	pipelinePrewarmCount;	// Built from the scene manifest before the first frame
+	uint64_t	pipelineCacheBytes;		// Seeded from disk at startup, zero when cold
+	uint32_t	descriptorWriteCount;	// VkWriteDescriptorSets issued this frame
+	uint32_t	descriptorCount;		// Descriptors covered by those writes
+	uint32_t	graphBarrierCount;		// Barriers the render graph placed between tasks this frame
+	uint32_t	graphCulledTaskCount;	// Tasks skipped since nothing read their writes
+	float		recordTimeMs;
+	uint32_t	shaderReloadCount;		// Programs reloaded after their binaries changed on disk
+	char		lastShaderReload[ 64 ];	// Name of the most recently reloaded program
+	float		recordThreadMs[ MaxRecordThreads ];
+	uint32_t	recordThreadTasks[ MaxRecordThreads ];
 	float		mouseX;
 	float		mouseY;
+	viewDebugData_t	views[ MaxViews ];
 };
 
 extern renderDebugData_t g_renderDebugData;
@@ -21,4 +67,5 @@ void DebugMenuShaderTreeNode( Asset<GpuProgram>* shaderAsset );
 void DebugMenuLightEdit( Scene* scene );
 void DebugMenuDeviceProperties( VkPhysicalDeviceProperties deviceProperties, VkPhysicalDeviceFeatures deviceFeatures );
 void DeviceDebugMenu();
+void ViewDebugMenu();
 #endif
\ No newline at end of file
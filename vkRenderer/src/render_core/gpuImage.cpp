@@ -40,7 +40,7 @@ static VkImageCreateInfo vk_GetImageCreateInfo( const imageInfo_t& info, const g
 }
 #endif
 
-void GpuImage::Create( const char* name, const imageInfo_t& info, const gpuImageStateFlags_t flags, AllocatorMemory& memory, const resourceLifeTime_t lifetime )
+void GpuImage::Create( const char* name, const imageInfo_t& info, const gpuImageStateFlags_t flags, AllocatorMemory& memory, const resourceLifeTime_t lifetime, allocAliasSlot_t* aliasSlot )
 {
 	// Managed Resource
 	{
@@ -75,7 +75,15 @@ void GpuImage::Create( const char* name, const imageInfo_t& info, const gpuImage
 			allocInfo.allocationSize = memRequirements.size;
 			allocInfo.memoryTypeIndex = memory.GetVkMemoryType();
 
-			if ( memory.Allocate( memRequirements.alignment, memRequirements.size, m_allocation ) ) {
+			bool allocated = false;
+			if ( aliasSlot != nullptr ) {
+				assert( bufferCount == 1 );
+				allocated = memory.AllocateAliased( memRequirements.alignment, memRequirements.size, *aliasSlot, m_allocation );
+			} else {
+				allocated = memory.Allocate( memRequirements.alignment, memRequirements.size, m_allocation );
+			}
+
+			if ( allocated ) {
 				vkBindImageMemory( context.device, vk_image[ i ], memory.GetVkObject(), m_allocation.GetOffset() );
 			} else {
 				throw std::runtime_error( "Buffer could not be allocated!" );
@@ -40,9 +40,9 @@ protected:
 	}
 
 public:
-	GpuImage( const char* name, const imageInfo_t& info, const gpuImageStateFlags_t flags, AllocatorMemory& memory, const resourceLifeTime_t lifetime )
+	GpuImage( const char* name, const imageInfo_t& info, const gpuImageStateFlags_t flags, AllocatorMemory& memory, const resourceLifeTime_t lifetime, allocAliasSlot_t* aliasSlot = nullptr )
 	{
-		Create( name, info, flags, memory, lifetime );
+		Create( name, info, flags, memory, lifetime, aliasSlot );
 	}
 
 	virtual GpuImage::~GpuImage()
@@ -77,6 +77,7 @@ public:
 		vk_view[ 0 ] = view;
 		m_dbgName = name;
 		m_swapBuffering = swapBuffering_t::SINGLE_FRAME;
+		NewGeneration();
 	}
 
 	// TODO: take in swapchain
@@ -91,6 +92,7 @@ public:
 			vk_image[ i ] = image[ i ];
 			vk_view[ i ] = view[ i ];
 		}
+		NewGeneration();
 	}
 
 
@@ -130,6 +132,7 @@ public:
 		return m_dbgName;
 	}
 
-	void Create( const char* name, const imageInfo_t& info, const gpuImageStateFlags_t flags, AllocatorMemory& memory, const resourceLifeTime_t lifetime );
+	// Images given an alias slot share memory with the other images placed in it, see RenderGraph
+	void Create( const char* name, const imageInfo_t& info, const gpuImageStateFlags_t flags, AllocatorMemory& memory, const resourceLifeTime_t lifetime, allocAliasSlot_t* aliasSlot = nullptr );
 	virtual void Destroy();
 };
\ No newline at end of file
@@ -0,0 +1,541 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "renderGraph.h"
+#include "RenderTask.h"
+#include "debugMenu.h"
+#include "../render_state/cmdContext.h"
+#include "../render_state/deviceContext.h"
+#include "../render_state/frameBuffer.h"
+#include "../draw_passes/drawpass.h"
+
+static void GraphAccessMasks( const graphAccess_t access, const bool write, VkPipelineStageFlags& stages, VkAccessFlags& accessMask )
+{
+	switch ( access )
+	{
+		case GRAPH_ACCESS_SHADER:
+		{
+			stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			accessMask = write ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+		} break;
+
+		case GRAPH_ACCESS_COMPUTE:
+		{
+			stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			accessMask = write ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+		} break;
+
+		case GRAPH_ACCESS_ATTACHMENT:
+		{
+			// Loads read the attachment before it's written
+			stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			accessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			accessMask |= write ? ( VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT ) : 0;
+		} break;
+
+		case GRAPH_ACCESS_TRANSFER:
+		{
+			stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			accessMask = write ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_TRANSFER_READ_BIT;
+		} break;
+
+		case GRAPH_ACCESS_INDIRECT:
+		{
+			assert( write == false );
+			stages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+			accessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+		} break;
+	}
+}
+
+
+// Views wrap the VkImage of the image they were made from at buffer 0, so images are keyed by it too.
+// Transients are single buffered, so for them it is also the image every frame uses.
+static VkImage GraphImage( const Image* image )
+{
+	return image->gpuImage->GetVkImage( 0 );
+}
+
+
+uint32_t RenderGraph::FindResource( const uint64_t handle )
+{
+	auto it = m_resourceLookup.find( handle );
+	if ( it != m_resourceLookup.end() ) {
+		return it->second;
+	}
+
+	resource_t resource = {};
+	resource.handle = handle;
+	resource.transient = -1;
+
+	const uint32_t transientCount = static_cast<uint32_t>( m_transients.size() );
+	for ( uint32_t i = 0; i < transientCount; ++i )
+	{
+		if ( (uint64_t)GraphImage( m_transients[ i ].image ) == handle ) {
+			resource.transient = static_cast<int32_t>( i );
+		}
+	}
+
+	const uint32_t resourceIx = static_cast<uint32_t>( m_resources.size() );
+	m_resources.push_back( resource );
+	m_resourceLookup[ handle ] = resourceIx;
+
+	return resourceIx;
+}
+
+
+void RenderGraph::Declare( const uint64_t handle, const graphAccess_t access, const bool write )
+{
+	access_t declaration;
+	declaration.resource = FindResource( handle );
+	declaration.access = access;
+	declaration.write = write;
+
+	m_accesses.push_back( declaration );
+	++m_nodes[ m_declaringTask ].accessCount;
+}
+
+
+void RenderGraph::ReadImage( const Image* image, const graphAccess_t access )
+{
+	if ( ( image == nullptr ) || ( image->gpuImage == nullptr ) ) {
+		return;
+	}
+	// Views are tracked as the image they were made from
+	Declare( (uint64_t)GraphImage( image ), access, false );
+}
+
+
+void RenderGraph::WriteImage( const Image* image, const graphAccess_t access )
+{
+	if ( ( image == nullptr ) || ( image->gpuImage == nullptr ) ) {
+		return;
+	}
+	Declare( (uint64_t)GraphImage( image ), access, true );
+}
+
+
+void RenderGraph::ReadBuffer( const GpuBuffer* buffer, const graphAccess_t access )
+{
+	Declare( (uint64_t)buffer->GetVkObject(), access, false );
+}
+
+
+void RenderGraph::WriteBuffer( const GpuBuffer* buffer, const graphAccess_t access )
+{
+	Declare( (uint64_t)buffer->GetVkObject(), access, true );
+}
+
+
+void RenderGraph::ReadPass( const DrawPass* pass )
+{
+	ReadImage( pass->stencilImage );
+
+	const uint32_t codeImageCount = pass->codeImages.Count();
+	for ( uint32_t i = 0; i < codeImageCount; ++i ) {
+		ReadImage( pass->codeImages[ i ] );
+	}
+
+	const uint32_t codeCubeImageCount = pass->codeCubeImages.Count();
+	for ( uint32_t i = 0; i < codeCubeImageCount; ++i ) {
+		ReadImage( pass->codeCubeImages[ i ] );
+	}
+}
+
+
+void RenderGraph::WriteFrameBuffer( const FrameBuffer* fb )
+{
+	WriteImage( fb->GetColor() );
+	WriteImage( fb->GetColor1() );
+	WriteImage( fb->GetColor2() );
+	WriteImage( fb->GetDepth() );
+	WriteImage( fb->GetStencil() );
+	WriteImage( fb->GetResolve() );
+	WriteImage( fb->GetDepthResolve() );
+}
+
+
+void RenderGraph::DeclareTransient( const Image* image )
+{
+	// Only color images are discarded into their read layout
+	assert( ( image->info.aspect & IMAGE_ASPECT_COLOR_FLAG ) != 0 );
+	assert( m_compiled == false );
+
+	transientImage_t transient = {};
+	transient.image = image;
+	m_transients.push_back( transient );
+}
+
+
+void RenderGraph::DeclareTasks( const std::vector<GpuTask*>& tasks )
+{
+	const uint32_t taskCount = static_cast<uint32_t>( tasks.size() );
+
+	m_accesses.clear();
+	m_nodes.resize( taskCount );
+
+	for ( uint32_t i = 0; i < taskCount; ++i )
+	{
+		m_nodes[ i ] = {};
+		m_nodes[ i ].accessBegin = static_cast<uint32_t>( m_accesses.size() );
+
+		m_declaringTask = i;
+		tasks[ i ]->DeclareResources( *this );
+	}
+}
+
+
+void RenderGraph::Compile( const std::vector<GpuTask*>& tasks )
+{
+	DeclareTasks( tasks );
+
+	const uint32_t taskCount = static_cast<uint32_t>( m_nodes.size() );
+	for ( uint32_t taskIx = 0; taskIx < taskCount; ++taskIx )
+	{
+		const taskNode_t& node = m_nodes[ taskIx ];
+		for ( uint32_t i = 0; i < node.accessCount; ++i )
+		{
+			const resource_t& resource = m_resources[ m_accesses[ node.accessBegin + i ].resource ];
+			if ( resource.transient < 0 ) {
+				continue;
+			}
+
+			transientImage_t& transient = m_transients[ resource.transient ];
+			transient.firstTask = transient.used ? std::min( transient.firstTask, taskIx ) : taskIx;
+			transient.lastTask = transient.used ? std::max( transient.lastTask, taskIx ) : taskIx;
+			transient.used = true;
+		}
+	}
+
+	// Greedy interval coloring in order of first use, an image takes the first slot that's free by then
+	std::vector<uint32_t> order;
+	for ( uint32_t i = 0; i < static_cast<uint32_t>( m_transients.size() ); ++i )
+	{
+		if ( m_transients[ i ].used ) {
+			order.push_back( i );
+		}
+	}
+	std::sort( order.begin(), order.end(), [ this ]( const uint32_t a, const uint32_t b ) {
+		return m_transients[ a ].firstTask < m_transients[ b ].firstTask;
+	} );
+
+	std::vector<uint32_t> slotLastTask;
+	for ( const uint32_t transientIx : order )
+	{
+		transientImage_t& transient = m_transients[ transientIx ];
+
+		uint32_t slot = 0;
+		while ( ( slot < slotLastTask.size() ) && ( slotLastTask[ slot ] >= transient.firstTask ) ) {
+			++slot;
+		}
+
+		if ( slot == slotLastTask.size() ) {
+			slotLastTask.push_back( transient.lastTask );
+		} else {
+			slotLastTask[ slot ] = transient.lastTask;
+		}
+		transient.slot = slot;
+	}
+
+	// Nothing ever touches an unused transient, it can sit in any slot
+	for ( transientImage_t& transient : m_transients )
+	{
+		if ( transient.used == false )
+		{
+			if ( slotLastTask.empty() ) {
+				slotLastTask.push_back( 0 );
+			}
+			transient.slot = 0;
+		}
+	}
+
+	m_aliasSlots.resize( slotLastTask.size() );
+	m_slotImageCounts.resize( slotLastTask.size(), 0 );
+	for ( const transientImage_t& transient : m_transients ) {
+		++m_slotImageCounts[ transient.slot ];
+	}
+
+	ResetResources();
+	m_compiled = true;
+}
+
+
+bool RenderGraph::IsAliased( const transientImage_t& transient ) const
+{
+	return m_compiled && ( m_slotImageCounts[ transient.slot ] > 1 );
+}
+
+
+allocAliasSlot_t* RenderGraph::AliasSlot( const Image* image )
+{
+	for ( const transientImage_t& transient : m_transients )
+	{
+		if ( ( transient.image == image ) && IsAliased( transient ) ) {
+			return &m_aliasSlots[ transient.slot ];
+		}
+	}
+	return nullptr;
+}
+
+
+bool RenderGraph::HasAliasing() const
+{
+	for ( const transientImage_t& transient : m_transients )
+	{
+		if ( IsAliased( transient ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void RenderGraph::ResetResources()
+{
+	// Image handles change when frame buffers are recreated
+	m_resources.clear();
+	m_resourceLookup.clear();
+
+	for ( allocAliasSlot_t& slot : m_aliasSlots ) {
+		slot = {};
+	}
+}
+
+
+void RenderGraph::CullTasks()
+{
+	std::vector<bool> liveTransients( m_transients.size(), false );
+
+	uint32_t culledCount = 0;
+
+	// Walk back from the end of the frame, a transient is live while a kept task still reads it
+	for ( int32_t taskIx = static_cast<int32_t>( m_nodes.size() ) - 1; taskIx >= 0; --taskIx )
+	{
+		taskNode_t& node = m_nodes[ taskIx ];
+
+		bool hasWrites = false;
+		bool needed = false;
+		for ( uint32_t i = 0; i < node.accessCount; ++i )
+		{
+			const access_t& declaration = m_accesses[ node.accessBegin + i ];
+			if ( declaration.write == false ) {
+				continue;
+			}
+
+			const resource_t& resource = m_resources[ declaration.resource ];
+			hasWrites = true;
+			needed = needed || ( resource.transient < 0 ) || liveTransients[ resource.transient ];
+		}
+
+		// Tasks that write nothing the graph knows of have side effects of their own
+		node.culled = hasWrites && ( needed == false );
+		if ( node.culled )
+		{
+			++culledCount;
+			continue;
+		}
+
+		for ( uint32_t i = 0; i < node.accessCount; ++i )
+		{
+			const access_t& declaration = m_accesses[ node.accessBegin + i ];
+			const resource_t& resource = m_resources[ declaration.resource ];
+			if ( ( declaration.write == false ) && ( resource.transient >= 0 ) ) {
+				liveTransients[ resource.transient ] = true;
+			}
+		}
+	}
+
+	g_renderDebugData.graphCulledTaskCount = culledCount;
+}
+
+
+void RenderGraph::PlaceBarriers()
+{
+	m_imageBarriers.clear();
+
+	for ( transientImage_t& transient : m_transients ) {
+		transient.acquired = false;
+	}
+
+	uint32_t barrierCount = 0;
+
+	const uint32_t taskCount = static_cast<uint32_t>( m_nodes.size() );
+	for ( uint32_t taskIx = 0; taskIx < taskCount; ++taskIx )
+	{
+		taskNode_t& node = m_nodes[ taskIx ];
+		node.imageBarrierBegin = static_cast<uint32_t>( m_imageBarriers.size() );
+
+		if ( node.culled ) {
+			continue;
+		}
+
+		// Hazards against earlier tasks, all merged into one barrier
+		for ( uint32_t i = 0; i < node.accessCount; ++i )
+		{
+			const access_t& declaration = m_accesses[ node.accessBegin + i ];
+			resource_t& resource = m_resources[ declaration.resource ];
+			resourceState_t& state = resource.state;
+
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags accessMask = 0;
+			GraphAccessMasks( declaration.access, declaration.write, stages, accessMask );
+
+			if ( resource.transient >= 0 )
+			{
+				transientImage_t& transient = m_transients[ resource.transient ];
+				if ( IsAliased( transient ) && ( transient.acquired == false ) )
+				{
+					// Another image of the slot may have been using the memory up to here
+					assert( transient.image->gpuImage->GetBufferCount() == 1 );
+
+					VkImageMemoryBarrier barrier{ };
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.image = GraphImage( transient.image );
+					barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+					barrier.dstAccessMask = accessMask;
+					barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					barrier.subresourceRange.baseMipLevel = 0;
+					barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+					barrier.subresourceRange.baseArrayLayer = 0;
+					barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+					m_imageBarriers.push_back( barrier );
+
+					node.srcStages |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+					node.dstStages |= stages;
+
+					transient.acquired = true;
+					state = {};
+					continue;
+				}
+			}
+
+			if ( declaration.write )
+			{
+				// Write after read only has to wait for the reads to finish
+				if ( state.readStages != 0 )
+				{
+					node.srcStages |= state.readStages;
+					node.dstStages |= stages;
+				}
+				if ( state.writeStages != 0 )
+				{
+					node.srcStages |= state.writeStages;
+					node.srcAccess |= state.writeAccess;
+					node.dstStages |= stages;
+					node.dstAccess |= accessMask;
+				}
+			}
+			else if ( ( state.writeStages != 0 ) && ( ( state.readStages & stages ) != stages ) )
+			{
+				// Read after read never needs a barrier
+				node.srcStages |= state.writeStages;
+				node.srcAccess |= state.writeAccess;
+				node.dstStages |= stages;
+				node.dstAccess |= accessMask;
+			}
+		}
+
+		// The task's writes replace the tracked state, reads of what it writes happen within the task
+		++m_writeStamp;
+		for ( uint32_t i = 0; i < node.accessCount; ++i )
+		{
+			const access_t& declaration = m_accesses[ node.accessBegin + i ];
+			if ( declaration.write == false ) {
+				continue;
+			}
+
+			resourceState_t& state = m_resources[ declaration.resource ].state;
+			if ( state.writeStamp != m_writeStamp ) {
+				state = {};
+				state.writeStamp = m_writeStamp;
+			}
+
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags accessMask = 0;
+			GraphAccessMasks( declaration.access, true, stages, accessMask );
+
+			state.writeStages |= stages;
+			state.writeAccess |= accessMask;
+		}
+
+		for ( uint32_t i = 0; i < node.accessCount; ++i )
+		{
+			const access_t& declaration = m_accesses[ node.accessBegin + i ];
+			if ( declaration.write ) {
+				continue;
+			}
+
+			resourceState_t& state = m_resources[ declaration.resource ].state;
+			if ( state.writeStamp == m_writeStamp ) {
+				continue;
+			}
+
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags accessMask = 0;
+			GraphAccessMasks( declaration.access, false, stages, accessMask );
+
+			state.readStages |= stages;
+		}
+
+		node.imageBarrierCount = static_cast<uint32_t>( m_imageBarriers.size() ) - node.imageBarrierBegin;
+		barrierCount += ( node.srcStages != 0 ) ? 1 : 0;
+	}
+
+	g_renderDebugData.graphBarrierCount = barrierCount;
+}
+
+
+void RenderGraph::Build( const std::vector<GpuTask*>& tasks )
+{
+	DeclareTasks( tasks );
+	CullTasks();
+	PlaceBarriers();
+}
+
+
+bool RenderGraph::IsCulled( const uint32_t taskIx ) const
+{
+	return ( taskIx < m_nodes.size() ) && m_nodes[ taskIx ].culled;
+}
+
+
+void RenderGraph::IssueBarriers( const uint32_t taskIx, CommandContext& cmdContext ) const
+{
+	const taskNode_t& node = m_nodes[ taskIx ];
+	if ( node.srcStages == 0 ) {
+		return;
+	}
+
+	VkMemoryBarrier barrier{ };
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = node.srcAccess;
+	barrier.dstAccessMask = node.dstAccess;
+
+	const VkImageMemoryBarrier* imageBarriers = ( node.imageBarrierCount > 0 ) ? &m_imageBarriers[ node.imageBarrierBegin ] : nullptr;
+
+	vkCmdPipelineBarrier( cmdContext.CommandBuffer(), node.srcStages, node.dstStages, 0, 1, &barrier, 0, nullptr, node.imageBarrierCount, imageBarriers );
+}
@@ -0,0 +1,143 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "../globals/common.h"
+#include "../render_binding/allocator.h"
+
+class Image;
+class GpuBuffer;
+class GpuTask;
+class DrawPass;
+class FrameBuffer;
+class CommandContext;
+
+enum graphAccess_t : uint8_t
+{
+	GRAPH_ACCESS_SHADER,		// Sampled or storage access from the vertex and fragment stages of draws
+	GRAPH_ACCESS_COMPUTE,		// Sampled or storage access from dispatches
+	GRAPH_ACCESS_ATTACHMENT,	// Render pass attachment, the pass handles the layouts
+	GRAPH_ACCESS_TRANSFER,		// Copies and blits, the task transitions the image itself
+	GRAPH_ACCESS_INDIRECT,		// Draw arguments
+};
+
+
+// Tasks declare the images and buffers they read and write each frame. From that the graph
+// places at most one barrier before a task, culls tasks whose writes nothing reads, and lets
+// transient images that are never live at the same time share memory.
+//
+// Images rest in their read layout between tasks (see renderPassTransition_t::readAfter), so
+// hazards only need memory barriers. Transient images are discarded to undefined on first use.
+class RenderGraph
+{
+private:
+	struct resourceState_t
+	{
+		VkPipelineStageFlags	writeStages;	// Last write, persists across frames since they share the queue
+		VkAccessFlags			writeAccess;
+		VkPipelineStageFlags	readStages;		// Reads since the last write, already waited on it
+		uint32_t				writeStamp;
+	};
+
+	struct resource_t
+	{
+		uint64_t			handle;
+		int32_t				transient;		// -1 when the resource is read outside of the frame's tasks
+		resourceState_t		state;
+	};
+
+	struct access_t
+	{
+		uint32_t			resource;
+		graphAccess_t		access;
+		bool				write;
+	};
+
+	struct transientImage_t
+	{
+		const Image*		image;
+		uint32_t			firstTask;
+		uint32_t			lastTask;
+		uint32_t			slot;
+		bool				used;
+		bool				acquired;
+	};
+
+	struct taskNode_t
+	{
+		uint32_t				accessBegin;
+		uint32_t				accessCount;
+		uint32_t				imageBarrierBegin;
+		uint32_t				imageBarrierCount;
+		VkPipelineStageFlags	srcStages;
+		VkPipelineStageFlags	dstStages;
+		VkAccessFlags			srcAccess;
+		VkAccessFlags			dstAccess;
+		bool					culled;
+	};
+
+	std::vector<resource_t>					m_resources;
+	std::unordered_map<uint64_t, uint32_t>	m_resourceLookup;
+	std::vector<access_t>					m_accesses;
+	std::vector<taskNode_t>					m_nodes;
+	std::vector<VkImageMemoryBarrier>		m_imageBarriers;
+	std::vector<transientImage_t>			m_transients;
+	std::vector<allocAliasSlot_t>			m_aliasSlots;
+	std::vector<uint32_t>					m_slotImageCounts;
+	uint32_t								m_declaringTask;
+	uint32_t								m_writeStamp;
+	bool									m_compiled;
+
+	uint32_t	FindResource( const uint64_t handle );
+	void		Declare( const uint64_t handle, const graphAccess_t access, const bool write );
+	void		DeclareTasks( const std::vector<GpuTask*>& tasks );
+	void		CullTasks();
+	void		PlaceBarriers();
+	bool		IsAliased( const transientImage_t& transient ) const;
+
+public:
+	RenderGraph() : m_declaringTask( 0 ), m_writeStamp( 0 ), m_compiled( false )
+	{}
+
+	// Declarations, made from GpuTask::DeclareResources()
+	void				ReadImage( const Image* image, const graphAccess_t access = GRAPH_ACCESS_SHADER );
+	void				WriteImage( const Image* image, const graphAccess_t access = GRAPH_ACCESS_ATTACHMENT );
+	void				ReadBuffer( const GpuBuffer* buffer, const graphAccess_t access = GRAPH_ACCESS_SHADER );
+	void				WriteBuffer( const GpuBuffer* buffer, const graphAccess_t access = GRAPH_ACCESS_SHADER );
+	void				ReadPass( const DrawPass* pass );
+	void				WriteFrameBuffer( const FrameBuffer* fb );
+
+	// Transient images are only read by tasks of the frame they were written in
+	void				DeclareTransient( const Image* image );
+	void				Compile( const std::vector<GpuTask*>& tasks );
+	allocAliasSlot_t*	AliasSlot( const Image* image );
+	bool				HasAliasing() const;
+	void				ResetResources();
+
+	void				Build( const std::vector<GpuTask*>& tasks );
+	bool				IsCulled( const uint32_t taskIx ) const;
+	void				IssueBarriers( const uint32_t taskIx, CommandContext& context ) const;
+};
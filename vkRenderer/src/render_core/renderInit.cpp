@@ -32,6 +32,7 @@
 #include "../render_core/RenderTask.h"
 #include "../render_tasks/ImageWritebackTask.h"
 #include "../render_tasks/MipImageTask.h"
+#include "../render_tasks/HiZTask.h"
 
 #include "../draw_passes/drawpass.h"
 #include "swapChain.h"
@@ -47,8 +48,23 @@ void Renderer::Init( const renderConfig_t& cfg )
 {
 	InitApi( cfg );
 
-	resources.gpuImages2D.Resize( MaxImageDescriptors );
-	resources.gpuImagesCube.Resize( MaxImageDescriptors );
+	// Record timings get a slot per thread, the calling thread and every worker
+	jobs.Init( std::min( JobSystem::DefaultWorkerCount(), MaxRecordThreads - 1 ) );
+	pipelineJobs.Init( std::max( JobSystem::DefaultWorkerCount() / 2, 1u ) );
+
+	resources.gpuImages2D.Init( context.bindlessImageCount );
+	resources.gpuImagesCube.Init( context.bindlessImageCount );
+
+	// The main view only grows back toward full resolution after 30 frames with headroom
+	{
+		resolutionScaleInfo_t info = {};
+		info.budgetMs = config.gpuFrameBudgetMs;
+		info.minScale = MinResolutionScale;
+		info.maxScale = 1.0f;
+		info.settleFrames = 30;
+
+		resolutionScale.Init( info );
+	}
 
 	viewCount = 0;
 
@@ -61,7 +77,8 @@ void Renderer::Init( const renderConfig_t& cfg )
 		info.viewId = viewCount;
 		info.context = &renderContext;
 		info.resources = &resources;
-		info.fb = &shadowMap[ i ];
+		info.fb = &shadowAtlas;
+		info.lodBias = 4.0f;
 
 		shadowViews[ i ] = &views[ viewCount ];
 		shadowViews[ i ]->Init( info );
@@ -77,6 +94,7 @@ void Renderer::Init( const renderConfig_t& cfg )
 		info.context = &renderContext;
 		info.resources = &resources;
 		info.fb = &mainColor;
+		info.lodBias = 1.0f;
 
 		renderViews[ 0 ] = &views[ viewCount ];
 		renderViews[ 0 ]->Init( info );
@@ -91,6 +109,7 @@ void Renderer::Init( const renderConfig_t& cfg )
 			info.context = &renderContext;
 			info.resources = &resources;
 			info.fb = &cubeMapFrameBuffer[ i - 1 ];
+			info.lodBias = 4.0f;
 
 			renderViews[ i ] = &views[ viewCount ];
 			renderViews[ i ]->Init( info );
@@ -107,6 +126,7 @@ void Renderer::Init( const renderConfig_t& cfg )
 		info.context = &renderContext;
 		info.resources = &resources;
 		info.fb = g_swapChain.GetFrameBuffer();
+		info.lodBias = 1.0f;
 
 		view2Ds[ 0 ] = &views[ viewCount ];
 		view2Ds[ 0 ]->Init( info );
@@ -203,26 +223,17 @@ void Renderer::Init( const renderConfig_t& cfg )
 		}
 	}
 
+	// Always created, the view bindings reference its buffers even when occlusion culling is off
+	HiZTask* hiZTask = nullptr;
 	{
-		imageProcessCreateInfo_t info = {};
-		info.name = "ResolveMain";
-		info.clear = false;
-		info.resolve = true;
-		if ( ForceDisableMSAA ) {
-			info.progHdl = AssetLibGpuProgram::Handle( "Resolve" );
-		} else {
-			info.progHdl = AssetLibGpuProgram::Handle( "ResolveMSAA" );
-		}
-		info.fb = &mainColorResolved;
+		hiZCreateInfo_t info{};
+		info.name = "HiZBuild";
+		info.view = renderViews[ 0 ];
 		info.context = &renderContext;
 		info.resources = &resources;
-		info.inputImages = 3;
-
-		resolve = new ImageProcess( info );
+		info.enabled = config.occlusionCulling;
 
-		resolve->SetSourceImage( 0, &resources.mainColorImage );
-		resolve->SetSourceImage( 1, &resources.depthImageView );
-		resolve->SetSourceImage( 2, &resources.stencilImageView );
+		hiZTask = new HiZTask( info );
 	}
 
 	if ( config.gaussianBlur )
@@ -359,18 +370,12 @@ void Renderer::Init( const renderConfig_t& cfg )
 
 	InitShaderResources();
 
-	InitImGui( *view2Ds[ 0 ] );
-
-	UploadAssets();
-
-	for ( uint32_t i = 0; i < MaxShadowViews; ++i ) {
-		schedule.Queue( new RenderTask( shadowViews[ i ], DRAWPASS_SHADOW_BEGIN, DRAWPASS_SHADOW_END ) );
-	}
-	schedule.Queue( new RenderTask( renderViews[ 0 ], DRAWPASS_MAIN_BEGIN, DRAWPASS_MAIN_END ) );
+	schedule.Queue( new ShadowAtlasTask( shadowViews, MaxShadowViews, &renderContext ) );
+	schedule.Queue( new RenderTask( renderViews[ 0 ], DRAWPASS_MAIN_BEGIN, DRAWPASS_MAIN_END, &renderContext ) );
 	if ( config.useCubeViews )
 	{
 		for ( uint32_t i = 1; i < Max3DViews; ++i ) {
-			schedule.Queue( new RenderTask( renderViews[ i ], DRAWPASS_MAIN_BEGIN, DRAWPASS_MAIN_END ) );
+			schedule.Queue( new RenderTask( renderViews[ i ], DRAWPASS_MAIN_BEGIN, DRAWPASS_MAIN_END, &renderContext ) );
 		}
 		if ( config.computeDiffuseIbl )
 		{
@@ -387,7 +392,7 @@ void Renderer::Init( const renderConfig_t& cfg )
 		}
 	//	schedule.Queue( mipCubeTask );
 	}
-	schedule.Queue( resolve );
+	schedule.Queue( hiZTask );
 	if ( config.writeCubeViews ) {
 		schedule.Queue( imageCubemapWriteBackTask );
 	}
@@ -410,8 +415,29 @@ void Renderer::Init( const renderConfig_t& cfg )
 			schedule.Queue( pingPongQueue[i] );
 		}
 	}
-	schedule.Queue( new RenderTask( view2Ds[ 0 ], DRAWPASS_MAIN_BEGIN, DRAWPASS_MAIN_END ) );
+	schedule.Queue( new RenderTask( view2Ds[ 0 ], DRAWPASS_MAIN_BEGIN, DRAWPASS_MAIN_END, &renderContext ) );
 	schedule.Queue( new ComputeTask( "ClearParticles", &particleState ) );
+
+	// Images only used within the frame can share memory once their lifetimes are known
+	schedule.Graph().DeclareTransient( &resources.mainColorImage );
+	schedule.Graph().DeclareTransient( &resources.gBufferLayerImage );
+	if ( config.gaussianBlur )
+	{
+		schedule.Graph().DeclareTransient( &resources.tempColorImage );
+		schedule.Graph().DeclareTransient( &resources.blurredImage );
+	}
+	schedule.Compile();
+
+	// The graph tracks images by their Vulkan handle, so it can only be compiled once the frame buffers exist.
+	// Aliased images are placed by remaking the frame buffers before anything is uploaded or drawn with them,
+	// the swap chain is kept and UploadAssets() makes the initial layout transitions.
+	if ( schedule.Graph().HasAliasing() ) {
+		RecreateFramebuffers();
+	}
+
+	InitImGui( *view2Ds[ 0 ] );
+
+	UploadAssets();
 }
 
 
@@ -419,8 +445,11 @@ void Renderer::InitApi( const renderConfig_t& cfg )
 {
 	{
 		// Device Set-up
+		context.preferSoftwareDevice = cfg.softwareDevice;
 		context.Create( g_window );
 
+		g_renderDebugData.pipelineCacheBytes = LoadVkPipelineCacheBlob( PipelineCachePath );
+
 		InitConfig( cfg ); // Must be after device must be set-up, but before everything is initialized
 
 		int width, height;
@@ -465,6 +494,15 @@ void Renderer::InitApi( const renderConfig_t& cfg )
 		bindset = &renderContext.bindSets[ bindset_compute ];
 		bindset->Create( "ComputeBindings", g_computeBindings, COUNTARRAY( g_computeBindings ) );
 
+		bindset = &renderContext.bindSets[ bindset_cull ];
+		bindset->Create( "CullBindings", g_cullBindings, COUNTARRAY( g_cullBindings ) );
+
+		bindset = &renderContext.bindSets[ bindset_hiZ ];
+		bindset->Create( "HiZBindings", g_hiZBindings, COUNTARRAY( g_hiZBindings ) );
+
+		bindset = &renderContext.bindSets[ bindset_lightCull ];
+		bindset->Create( "LightCullBindings", g_lightCullBindings, COUNTARRAY( g_lightCullBindings ) );
+
 		bindset = &renderContext.bindSets[ bindset_imageProcess ];
 		bindset->Create( "ImageProcessBindings", g_imageProcessBindings, COUNTARRAY( g_imageProcessBindings ) );
 	}
@@ -576,12 +614,30 @@ void Renderer::InitShaderResources()
 			bufferType_t::STORAGE,
 			renderContext.sharedMemory
 		);
-		resources.surfParms.Create(
-			"Surf",
+		// Each partition is bound as one range, so the device's storage range caps a view's surfaces
+		{
+			const uint64_t maxRange = context.deviceProperties.limits.maxStorageBufferRange;
+			const uint64_t elementSize = std::max( sizeof( surfaceBufferObject_t ), sizeof( drawCommandBufferObject_t ) );
+			resources.maxSurfaceCapacity = static_cast<uint32_t>( maxRange / elementSize );
+		}
+		CreateSurfaceBuffers( std::min( MaxSurfaces, resources.maxSurfaceCapacity ) );
+
+		resources.cullStats.Create(
+			"Cull Stats",
 			swapBuffering_t::MULTI_FRAME,
 			resourceLifeTime_t::REBOOT,
-			MaxViews * MaxSurfaces,
-			sizeof( surfaceBufferObject_t ),
+			1,
+			MaxViews * sizeof( cullStatsBufferObject_t ),
+			bufferType_t::STORAGE,
+			renderContext.sharedMemory
+		);
+		// Written by the light cull of each view, a count followed by light ids per cluster
+		resources.clusterLights.Create(
+			"Cluster Lights",
+			swapBuffering_t::MULTI_FRAME,
+			resourceLifeTime_t::REBOOT,
+			MaxViews,
+			ClusterCount * ( MaxClusterLights + 1 ) * sizeof( uint32_t ),
 			bufferType_t::STORAGE,
 			renderContext.sharedMemory
 		);
@@ -622,8 +678,9 @@ void Renderer::InitShaderResources()
 			renderContext.sharedMemory
 		);
 
-		for ( size_t v = 0; v < MaxViews; ++v ) {
-			resources.surfParmPartitions[ v ] = resources.surfParms.GetView( v * MaxSurfaces, MaxSurfaces );
+		for ( size_t v = 0; v < MaxViews; ++v )
+		{
+			resources.clusterLightPartitions[ v ] = resources.clusterLights.GetView( v, 1 );
 		}
 
 		geometry.vb.Create(
@@ -681,7 +738,7 @@ void Renderer::InitImGui( RenderView& view )
 	vkInfo.Device = context.device;
 	vkInfo.QueueFamily = context.queueFamilyIndices[ QUEUE_GRAPHICS ];
 	vkInfo.Queue = context.gfxContext;
-	vkInfo.PipelineCache = nullptr;
+	vkInfo.PipelineCache = context.pipelineCache;
 	vkInfo.DescriptorPool = context.descriptorPool;
 	vkInfo.Allocator = nullptr;
 	vkInfo.MinImageCount = MaxFrameStates;
@@ -721,6 +778,7 @@ void Renderer::InitImGui( RenderView& view )
 	g_imguiControls.dofFocalDepth = 0.01f;
 	g_imguiControls.dofFocalRange = 0.25f;
 	g_imguiControls.dbgImageId = -1;
+	g_imguiControls.hiZDebugLevel = -1;
 	g_imguiControls.selectedEntityId = -1;
 	g_imguiControls.selectedModelOrigin = vec3f( 0.0f );
 
@@ -728,8 +786,24 @@ void Renderer::InitImGui( RenderView& view )
 }
 
 
-void Renderer::BuildPipelines()
+void Renderer::BuildPipelines( const bool waitForCompiles )
 {
+	if ( waitForCompiles ) {
+		pipelineJobs.Wait( &pipelineCompileJobs );
+	}
+
+	// Draws keep using the old pipelines until the whole batch has landed
+	if ( pipelineCompileJobs.IsDone() ) {
+		SwapBuiltPipelines();
+	}
+
+	DestroyRetiredPipelines( m_frameNumber );
+
+	// One batch in flight at a time, its jobs still read the current shader modules
+	if ( pipelineCompileJobs.IsDone() == false ) {
+		return;
+	}
+
 	const uint32_t programCount = g_assets.gpuPrograms.Count();
 
 	std::vector< Asset<GpuProgram>* > invalidAssets;
@@ -749,15 +823,38 @@ void Renderer::BuildPipelines()
 		invalidAssets.push_back( progAsset );
 	}
 
-	if( invalidAssets.size() == 0 ) {
+	if( invalidAssets.size() > 0 )
+	{
+		pipelineBuildTimer.Start();
+		QueueProgramPipelines( invalidAssets );
+	}
+
+	// Feature variants that missed at commit time ride along with the batch
+	const uint32_t requestedCount = QueueRequestedPipelines();
+	if ( ( invalidAssets.size() == 0 ) && ( requestedCount == 0 ) ) {
 		return;
 	}
 
-	AssignBindSetsToGpuProgs();
+	if ( invalidAssets.size() == 0 ) {
+		pipelineBuildTimer.Start();
+	}
 
-	FlushGPU();
+	// Compile on the pipeline workers
+	g_renderDebugData.pipelineCompilesPending = SubmitPipelineCompiles( pipelineJobs, &pipelineCompileJobs );
 
-	// 2. Destroy shaders
+	if ( waitForCompiles )
+	{
+		pipelineJobs.Wait( &pipelineCompileJobs );
+		SwapBuiltPipelines();
+	}
+}
+
+
+void Renderer::QueueProgramPipelines( const std::vector< Asset<GpuProgram>* >& invalidAssets )
+{
+	AssignBindSetsToGpuProgs();
+
+	// 2. Destroy shaders. Built pipelines don't reference their modules, so no flush is needed
 	for ( auto it = invalidAssets.begin(); it != invalidAssets.end(); ++it )
 	{
 		Asset<GpuProgram>* progAsset = *it;
@@ -769,7 +866,7 @@ void Renderer::BuildPipelines()
 		}
 	}
 
-	// 3. Create shaders
+	// 3. Create shaders, noting which programs were compiled with material feature branches
 	for ( auto it = invalidAssets.begin(); it != invalidAssets.end(); ++it )
 	{
 		Asset<GpuProgram>* progAsset = *it;
@@ -777,6 +874,14 @@ void Renderer::BuildPipelines()
 		for ( uint32_t shaderIx = 0; shaderIx < prog.shaderCount; ++shaderIx ) {
 			prog.vk_shaders[ shaderIx ] = vk_CreateShaderModule( prog.shaders[ shaderIx ].blob );
 		}
+
+		featurePrograms.erase( progAsset->Handle().Get() );
+		if ( ( prog.shaderCount > 1 ) && ( prog.shaders[ 1 ].type == shaderType_t::PIXEL ) )
+		{
+			if ( vk_HasSpecConstant( prog.shaders[ 1 ].blob, MaterialFeaturesSpecId ) ) {
+				featurePrograms.insert( progAsset->Handle().Get() );
+			}
+		}
 	}
 
 	// 4. Collect all passes in active views
@@ -798,7 +903,10 @@ void Renderer::BuildPipelines()
 		}
 	}
 
-	// 5. Destroy pipelines. Own pass so cache isn't destroyed per iteration
+	// 5. Queue pipelines, everything the workers need is captured from the passes here
+	const uint32_t materialCount = g_assets.materialLib.Count();
+	std::set<uint32_t> featureMasks;
+
 	for ( auto it = invalidAssets.begin(); it != invalidAssets.end(); ++it )
 	{
 		Asset<GpuProgram>* progAsset = *it;
@@ -808,50 +916,234 @@ void Renderer::BuildPipelines()
 		if ( prog.shaders[ 0 ].type == shaderType_t::COMPUTE )
 		{
 			assert( prog.shaderCount == 1 );
-			DestroyComputePipeline( *progAsset );
+			QueueComputePipeline( *progAsset );
 			continue;
 		}
 
+		// One variant per distinct feature set among the loaded materials that use this program
+		featureMasks.clear();
+		if ( featurePrograms.count( progAsset->Handle().Get() ) > 0 )
+		{
+			for ( uint32_t matIx = 0; matIx < materialCount; ++matIx )
+			{
+				const Asset<Material>* materialAsset = g_assets.materialLib.Find( matIx );
+				if ( materialAsset == nullptr ) {
+					continue;
+				}
+
+				const Material& material = materialAsset->Get();
+				for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
+				{
+					if ( material.GetShader( drawPass_t( passIx ) ) == progAsset->Handle() ) {
+						featureMasks.insert( MaterialFeatures( material ) );
+						break;
+					}
+				}
+			}
+		}
+
+		if ( featureMasks.empty() ) {
+			featureMasks.insert( MATERIAL_FEATURE_ALL );
+		}
+
 		const uint32_t passCount = static_cast<uint32_t>( passes.size() );
-		for ( uint32_t passIx = 0; passIx < passCount; ++passIx ) {
-			DestroyGraphicsPipeline( passes[ passIx ], *progAsset );
+		for ( uint32_t passIx = 0; passIx < passCount; ++passIx )
+		{
+			for ( auto maskIt = featureMasks.begin(); maskIt != featureMasks.end(); ++maskIt ) {
+				QueueGraphicsPipeline( passes[ passIx ], *progAsset, materialFeatureBits_t( *maskIt ) );
+			}
 		}
 	}
+}
 
-	// 6. Create pipelines
-	for ( auto it = invalidAssets.begin(); it != invalidAssets.end(); ++it )
+
+void Renderer::SwapBuiltPipelines()
+{
+	const uint32_t pipelineCount = SwapCompiledPipelines( m_frameNumber );
+	if ( pipelineCount == 0 ) {
+		return;
+	}
+
+	// Surfaces skipped while their pipeline was missing are picked up on the rebuild
+	forceDrawGroupRebuild = true;
+
+	pipelineBuildTimer.Stop();
+
+	// Compare against a run without the cache file to see the cold start cost
+	g_renderDebugData.pipelineBuildMs = static_cast<float>( pipelineBuildTimer.GetElapsed() );
+	g_renderDebugData.pipelineBuildCount = pipelineCount;
+	g_renderDebugData.pipelineCompilesPending = 0;
+
+	if ( config.logPipelineTimes == false ) {
+		return;
+	}
+	std::cout << "Built " << pipelineCount << " pipelines in " << g_renderDebugData.pipelineBuildMs << "ms, pipeline cache "
+		<< ( ( g_renderDebugData.pipelineCacheBytes > 0 ) ? "warm" : "cold" ) << " (" << g_renderDebugData.pipelineCacheBytes << " bytes loaded)" << std::endl;
+}
+
+
+void Renderer::PrewarmPipelines()
+{
+	std::vector<pipelineState_t> states;
+	if ( LoadPipelineManifest( config.pipelineManifest, states ) == 0 ) {
+		return;
+	}
+
+	// Image processes own passes outside the views
+	std::vector<const DrawPass*> passes;
+	passes.reserve( MaxViews * DRAWPASS_COUNT + pingPongQueue.size() + 1 );
+
+	for ( uint32_t viewIx = 0; viewIx < MaxViews; ++viewIx )
 	{
-		Asset<GpuProgram>* progAsset = *it;
-		progAsset->CompleteUpload();
+		for ( int passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
+		{
+			const DrawPass* pass = views[ viewIx ].passes[ passIx ];
+			if ( pass != nullptr ) {
+				passes.push_back( pass );
+			}
+		}
+	}
 
-		GpuProgram& prog = progAsset->Get();
-		if ( prog.shaders[ 0 ].type == shaderType_t::COMPUTE )
+	for ( size_t i = 0; i < pingPongQueue.size(); ++i ) {
+		passes.push_back( pingPongQueue[ i ]->GetPass() );
+	}
+
+	pipelineBuildTimer.Start();
+
+	uint32_t queuedCount = 0;
+	const uint32_t stateCount = static_cast<uint32_t>( states.size() );
+	for ( uint32_t stateIx = 0; stateIx < stateCount; ++stateIx )
+	{
+		const pipelineState_t& state = states[ stateIx ];
+
+		// Program handles are name hashes so they survive across runs, shaders removed since are dropped
+		Asset<GpuProgram>* progAsset = g_assets.gpuPrograms.Find( state.progHdl );
+		if ( ( progAsset == nullptr ) || ( progAsset->IsUploaded() == false ) ) {
+			continue;
+		}
+
+		// Any pass with the same state and attachments has a compatible render pass
+		const DrawPass* matchingPass = nullptr;
+		for ( auto it = passes.begin(); it != passes.end(); ++it )
 		{
-			assert( prog.shaderCount == 1 );
-			CreateComputePipeline( *progAsset );
+			const DrawPass* pass = *it;
+			const renderAttachmentBits_t passBits = pass->GetFrameBuffer()->GetAttachmentBits();
+			if ( ( pass->StateBits() == state.stateBits ) && ( pass->SampleRate() == state.samplingRate ) &&
+				( memcmp( &passBits, &state.passBits, sizeof( renderAttachmentBits_t ) ) == 0 ) )
+			{
+				matchingPass = pass;
+				break;
+			}
+		}
+
+		if ( ( matchingPass == nullptr ) || ( FindPipelineObject( matchingPass, *progAsset, state.materialFeatures ) != INVALID_HDL ) ) {
 			continue;
 		}
 
-		const uint32_t passCount = static_cast<uint32_t>( passes.size() );
-		for ( uint32_t passIx = 0; passIx < passCount; ++passIx ) {
-			CreateGraphicsPipeline( &renderContext, passes[ passIx ], *progAsset );
-		}	
+		QueueGraphicsPipeline( matchingPass, *progAsset, state.materialFeatures );
+		++queuedCount;
+	}
+
+	SubmitPipelineCompiles( pipelineJobs, &pipelineCompileJobs );
+	pipelineJobs.Wait( &pipelineCompileJobs );
+	SwapBuiltPipelines();
+
+	g_renderDebugData.pipelinePrewarmCount = queuedCount;
+	if ( config.logPipelineTimes ) {
+		std::cout << "Prewarmed " << queuedCount << " of " << stateCount << " pipelines from \"" << config.pipelineManifest << "\"" << std::endl;
 	}
 }
 
 
+// Every view gets a partition of the same capacity. Growing waits on the GPU since
+// in-flight frames still read the old buffers, so it only happens when a view outgrows them.
+void Renderer::CreateSurfaceBuffers( const uint32_t surfaceCapacity )
+{
+	assert( surfaceCapacity <= resources.maxSurfaceCapacity );
+
+	if ( resources.surfaceCapacity > 0 )
+	{
+		FlushGPU();
+
+		resources.surfParms.Destroy();
+		resources.drawRemap.Destroy();
+		resources.drawCommands.Destroy();
+		renderContext.surfaceMemory.Destroy();
+	}
+
+	{
+		const uint64_t alignment = context.deviceProperties.limits.minStorageBufferOffsetAlignment;
+		const uint64_t bufferSlack = 64 * 1024; // Covers the alignment each buffer asks of the allocator
+
+		uint64_t frameSize = 0;
+		frameSize += MaxViews * surfaceCapacity * GpuBuffer::GetAlignedSize( sizeof( surfaceBufferObject_t ), alignment );
+		frameSize += MaxViews * GpuBuffer::GetAlignedSize( surfaceCapacity * sizeof( uint32_t ), alignment );
+		frameSize += MaxViews * GpuBuffer::GetAlignedSize( surfaceCapacity * sizeof( drawCommandBufferObject_t ), alignment );
+		frameSize += 3 * bufferSlack;
+
+		renderContext.surfaceMemory.Create( MaxFrameStates * frameSize, memoryRegion_t::SHARED, resourceLifeTime_t::UNMANAGED );
+	}
+
+	resources.surfParms.Create(
+		"Surf",
+		swapBuffering_t::MULTI_FRAME,
+		resourceLifeTime_t::UNMANAGED,
+		MaxViews * surfaceCapacity,
+		sizeof( surfaceBufferObject_t ),
+		bufferType_t::STORAGE,
+		renderContext.surfaceMemory
+	);
+	// Each element is one view's partition, so the arrays inside are tightly packed
+	resources.drawRemap.Create(
+		"Draw Remap",
+		swapBuffering_t::MULTI_FRAME,
+		resourceLifeTime_t::UNMANAGED,
+		MaxViews,
+		surfaceCapacity * sizeof( uint32_t ),
+		bufferType_t::STORAGE,
+		renderContext.surfaceMemory
+	);
+	resources.drawCommands.Create(
+		"Draw Commands",
+		swapBuffering_t::MULTI_FRAME,
+		resourceLifeTime_t::UNMANAGED,
+		MaxViews,
+		surfaceCapacity * sizeof( drawCommandBufferObject_t ),
+		bufferType_t::INDIRECT,
+		renderContext.surfaceMemory
+	);
+
+	for ( size_t v = 0; v < MaxViews; ++v )
+	{
+		resources.surfParmPartitions[ v ] = resources.surfParms.GetView( v * surfaceCapacity, surfaceCapacity );
+		resources.drawRemapPartitions[ v ] = resources.drawRemap.GetView( v, 1 );
+		resources.drawCommandPartitions[ v ] = resources.drawCommands.GetView( v, 1 );
+	}
+
+	resources.surfaceCapacity = surfaceCapacity;
+}
+
+
+// Multisampled main views resolve color and depth-stencil as their render pass ends
+bool Renderer::MainPassResolves() const
+{
+	return ( config.mainColorSubSamples != IMAGE_SMP_1 );
+}
+
+
 void Renderer::CreateFramebuffers()
 {
 	int width = 0;
 	int height = 0;
 	g_window.GetWindowFrameBufferSize( width, height );
 
-	// Shadow images
-	for ( uint32_t shadowIx = 0; shadowIx < MaxShadowMaps; ++shadowIx )
+	schedule.Graph().ResetResources();
+
+	// Shadow atlas
 	{
 		imageInfo_t info{};
-		info.width = ShadowMapWidth;
-		info.height = ShadowMapHeight;
+		info.width = ShadowAtlasSize;
+		info.height = ShadowAtlasSize;
 		info.mipLevels = 1;
 		info.layers = 1;
 		info.subsamples = IMAGE_SMP_1;
@@ -860,10 +1152,10 @@ void Renderer::CreateFramebuffers()
 		info.aspect = IMAGE_ASPECT_DEPTH_FLAG;
 		info.tiling = IMAGE_TILING_MORTON;
 
-		resources.shadowMapImage[ shadowIx ].Create(
+		resources.shadowAtlasImage.Create(
 			info,
 			nullptr,
-			new GpuImage( "shadowMap", info, GPU_IMAGE_RW, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE )
+			new GpuImage( "shadowAtlas", info, GPU_IMAGE_RW, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE )
 		);
 	}
 
@@ -883,13 +1175,13 @@ void Renderer::CreateFramebuffers()
 		resources.mainColorImage.Create(
 			info,
 			nullptr,
-			new GpuImage( "mainColor", info, GPU_IMAGE_RW | GPU_IMAGE_TRANSFER_SRC, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE )
+			new GpuImage( "mainColor", info, GPU_IMAGE_RW | GPU_IMAGE_TRANSFER_SRC, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE, schedule.Graph().AliasSlot( &resources.mainColorImage ) )
 		);
 		
 		resources.gBufferLayerImage.Create(
 			info,
 			nullptr,
-			new GpuImage( "gBufferLayer", info, GPU_IMAGE_RW | GPU_IMAGE_TRANSFER_SRC, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE )
+			new GpuImage( "gBufferLayer", info, GPU_IMAGE_RW | GPU_IMAGE_TRANSFER_SRC, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE, schedule.Graph().AliasSlot( &resources.gBufferLayerImage ) )
 		);
 		
 		info.fmt = IMAGE_FMT_D_32_S8;
@@ -1050,7 +1342,7 @@ void Renderer::CreateFramebuffers()
 		resources.blurredImage.Create(
 			info,
 			nullptr,
-			new GpuImage( "blurredImage", info, GPU_IMAGE_RW | GPU_IMAGE_TRANSFER, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE )
+			new GpuImage( "blurredImage", info, GPU_IMAGE_RW | GPU_IMAGE_TRANSFER, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE, schedule.Graph().AliasSlot( &resources.blurredImage ) )
 		);
 		info.mipLevels = 1;
 
@@ -1098,9 +1390,9 @@ void Renderer::CreateFramebuffers()
 		info.mipLevels = 1;
 		info.layers = 1;
 		info.subsamples = IMAGE_SMP_1;
-		info.fmt = IMAGE_FMT_RG_32;
+		info.fmt = resources.depthStencilImage.info.fmt;
 		info.type = IMAGE_TYPE_2D;
-		info.aspect = IMAGE_ASPECT_COLOR_FLAG;
+		info.aspect = resources.depthStencilImage.info.aspect;
 		info.tiling = resources.depthStencilImage.info.tiling;
 
 		resources.depthStencilResolvedImage.Create(
@@ -1110,10 +1402,17 @@ void Renderer::CreateFramebuffers()
 		);
 	}
 
-	// Depth-stencil views
+	// Resolved depth-stencil views, without multisampling the main pass depth is read directly
 	{
-		resources.depthResolvedImageView.Init( resources.depthStencilResolvedImage, resources.depthStencilResolvedImage.info, resourceLifeTime_t::RESIZE );
-		resources.stencilResolvedImageView.Init( resources.depthStencilResolvedImage, resources.depthStencilResolvedImage.info, resourceLifeTime_t::RESIZE );
+		const Image& depthStencil = MainPassResolves() ? resources.depthStencilResolvedImage : resources.depthStencilImage;
+
+		imageInfo_t depthInfo = depthStencil.info;
+		depthInfo.aspect = IMAGE_ASPECT_DEPTH_FLAG;
+		resources.depthResolvedImageView.Init( depthStencil, depthInfo, resourceLifeTime_t::RESIZE );
+
+		imageInfo_t stencilInfo = depthStencil.info;
+		stencilInfo.aspect = IMAGE_ASPECT_STENCIL_FLAG;
+		resources.stencilResolvedImageView.Init( depthStencil, stencilInfo, resourceLifeTime_t::RESIZE );
 	}
 
 	// Temp image
@@ -1132,7 +1431,7 @@ void Renderer::CreateFramebuffers()
 		resources.tempColorImage.Create(
 			info,
 			nullptr,
-			new GpuImage( "tempColor", info, GPU_IMAGE_RW, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE )
+			new GpuImage( "tempColor", info, GPU_IMAGE_RW, renderContext.frameBufferMemory, resourceLifeTime_t::RESIZE, schedule.Graph().AliasSlot( &resources.tempColorImage ) )
 		);
 	}
 
@@ -1156,17 +1455,6 @@ void Renderer::CreateFramebuffers()
 		);
 	}
 
-	// Main Color Resolved Frame buffer
-	{
-		frameBufferCreateInfo_t fbInfo;
-		fbInfo.name = "MainColorResolveFB";
-		fbInfo.color0 = &resources.mainColorResolvedImageViews[0];
-		fbInfo.color1 = &resources.depthStencilResolvedImage;
-		fbInfo.swapBuffering = swapBuffering_t::SINGLE_FRAME;
-
-		mainColorResolved.Create( fbInfo );
-	}
-
 	// Blurred Image Frame buffer
 	blurredImageFrameBuffers.resize( resources.blurredImageViews.size() );
 	for ( uint32_t i = 0; i < blurredImageFrameBuffers.size(); ++i )
@@ -1189,15 +1477,14 @@ void Renderer::CreateFramebuffers()
 		tempColor.Create( fbInfo );
 	}
 
-	// Shadow map
-	for ( uint32_t shadowIx = 0; shadowIx < MaxShadowMaps; ++shadowIx )
-	{	
+	// Shadow atlas
+	{
 		frameBufferCreateInfo_t fbInfo;
-		fbInfo.name = "ShadowMapFB";
-		fbInfo.depth = &resources.shadowMapImage[ shadowIx ];
+		fbInfo.name = "ShadowAtlasFB";
+		fbInfo.depth = &resources.shadowAtlasImage;
 		fbInfo.swapBuffering = swapBuffering_t::SINGLE_FRAME;
 
-		shadowMap[ shadowIx ].Create( fbInfo );
+		shadowAtlas.Create( fbInfo );
 	}
 
 	// Main Scene 3D Render
@@ -1213,6 +1500,20 @@ void Renderer::CreateFramebuffers()
 		}
 		fbInfo.swapBuffering = swapBuffering_t::SINGLE_FRAME;
 
+		// The resolve happens as the main pass ends. Afterwards only the resolved images
+		// and the multisampled depth (read by the Hi-Z build) are used, the rest is dropped.
+		fbInfo.discardMask = RENDER_PASS_MASK_COLOR1;
+		if ( MainPassResolves() )
+		{
+			fbInfo.resolve0 = &resources.mainColorResolvedImageViews[ 0 ];
+			fbInfo.depthResolve = &resources.depthStencilResolvedImage;
+			fbInfo.discardMask |= RENDER_PASS_MASK_COLOR0 | RENDER_PASS_MASK_STENCIL;
+		}
+		else
+		{
+			fbInfo.color0 = &resources.mainColorResolvedImageViews[ 0 ];
+		}
+
 		mainColor.Create( fbInfo );
 	}
 
@@ -4,6 +4,7 @@ static std::vector<RenderResource*> m_taskDependentResources;
 static std::vector<RenderResource*> m_frameDependentResources;
 static std::vector<RenderResource*> m_viewDependentResources;
 static std::vector<RenderResource*> m_appDependentResources;
+static uint32_t m_lastGeneration = 0;
 
 std::vector<RenderResource*> RenderResource::GetResourceList( const resourceLifeTime_t lifetime )
 {
@@ -53,8 +54,15 @@ void RenderResource::Cleanup( const resourceLifeTime_t lifetime )
 	}
 }
 
+void RenderResource::NewGeneration()
+{
+	m_generation = ++m_lastGeneration;
+}
+
 void RenderResource::Create( const resourceLifeTime_t lifetime )
 {
+	NewGeneration();
+
 	m_lifetime = lifetime;
 	switch ( m_lifetime )
 	{
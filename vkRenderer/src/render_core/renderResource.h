@@ -17,11 +17,20 @@ class RenderResource
 {
 protected:
 	resourceLifeTime_t m_lifetime;
+	uint32_t m_generation = 0;
+
+	void NewGeneration();
 
 public:
 
 	void Create( const resourceLifeTime_t lifetime );
 
+	// Bumped whenever the API object is recreated, the driver can hand out the same handle again
+	inline uint32_t GetGeneration() const
+	{
+		return m_generation;
+	}
+
 	static std::vector<RenderResource*> GetResourceList( const resourceLifeTime_t lifetime );
 	static void Cleanup( const resourceLifeTime_t lifetime );
 
@@ -36,8 +36,13 @@
 
 void Renderer::Shutdown()
 {
+	// Finish in-flight compiles before their results are destroyed
+	pipelineJobs.Shutdown();
+
 	FlushGPU();
 	Destroy();
+
+	jobs.Shutdown();
 }
 
 
@@ -90,6 +95,12 @@ void Renderer::ShutdownShaderResources()
 	// Managed Cleanup
 	RenderResource::Cleanup( resourceLifeTime_t::REBOOT );
 
+	resources.surfParms.Destroy();
+	resources.drawRemap.Destroy();
+	resources.drawCommands.Destroy();
+	renderContext.surfaceMemory.Destroy();
+	resources.surfaceCapacity = 0;
+
 	// Images
 	const uint32_t textureCount = g_assets.textureLib.Count();
 	for ( uint32_t i = 0; i < textureCount; ++i )
@@ -98,14 +109,14 @@ void Renderer::ShutdownShaderResources()
 		delete texture.gpuImage;
 	}
 
-	for ( uint32_t i = 0; i < MaxImageDescriptors; ++i )
-	{
-		resources.gpuImages2D[ i ] = nullptr;
-		resources.gpuImagesCube[ i ] = nullptr;
-	}
+	DestroyRetiredImages( true );
+	resources.gpuImages2D.Reset();
+	resources.gpuImagesCube.Reset();
 
 	// PSO
+	SavePipelineManifest( config.pipelineManifest );
 	DestroyPipelineCache();
+	SaveVkPipelineCacheBlob( PipelineCachePath );
 
 	const uint32_t shaderCount = g_assets.gpuPrograms.Count();
 	for ( uint32_t i = 0; i < shaderCount; ++i )
@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <iterator>
 #include <numeric>
+#include <cfloat>
 #include <map>
 #include <sstream>
 
@@ -50,6 +51,7 @@
 #include "../render_binding/shaderBinding.h"
 #include "../render_binding/bufferObjects.h"
 #include "../globals/render_util.h"
+#include "../globals/sceneBvh.h"
 
 #include "../../GeoBuilder.h"
 #include "../../window.h"
@@ -63,6 +65,7 @@
 #endif
 
 extern Scene* g_scene;
+extern SceneBvh g_sceneBvh;
 
 SwapChain g_swapChain;
 renderConstants_t rc;
@@ -73,56 +76,371 @@ static ImGui_ImplVulkanH_Window imguiMainWindowData;
 
 void Renderer::Commit( const Scene* scene )
 {
+	commitTimer.Start();
+
 	const uint32_t entCount = static_cast<uint32_t>( scene->entities.size() );
+
+	// Cameras and light frustums must be current before the views cull against them
+	CommitViews( scene );
+
+	// Draw groups are retained across frames. They are rebuilt when the entity list changes,
+	// and for the frame pending model/material uploads are made plus the one after.
+	bool rebuild = forceDrawGroupRebuild || ( entityStates.size() != entCount );
+	bool pendingUploads = false;
+
+	entityStates.resize( entCount );
+	entityDirty.resize( entCount );
+	entityDirtyMask = ENT_DIRTY_NONE;
+
+	// Shared asset state is resolved once on this thread so the view jobs only read it
+	entityBounds.Reset();
+	for ( uint32_t entIx = 0; entIx < entCount; ++entIx )
+	{
+		const Entity& ent = *scene->entities[ entIx ];
+		pendingUploads = CommitModelResources( ent ) || pendingUploads;
+
+		entityDirty[ entIx ] = CommitEntityState( entIx, ent );
+		entityDirtyMask |= entityDirty[ entIx ];
+
+		if ( ent.HasFlag( ENT_FLAG_CAMERA_LOCKED ) ) {
+			entityBounds.AppendUnbounded();
+		} else {
+			entityBounds.Append( ent.GetLocalBounds(), ent.GetMatrix() );
+		}
+	}
+
+	// Views cull against the hierarchy concurrently, so it is brought up to date before they start
+	g_sceneBvh.Update( entityBounds );
+	g_renderDebugData.bvhNodeCount = g_sceneBvh.NodeCount();
+	g_renderDebugData.bvhReinsertCount = g_sceneBvh.ReinsertCount();
+	g_renderDebugData.bvhRebuilt = g_sceneBvh.Rebuilt();
+
+	rebuild = rebuild || pendingUploads;
+	forceDrawGroupRebuild = pendingUploads;
+
+	JobCounter commitJobs;
 	for ( uint32_t viewIx = 0; viewIx < MaxViews; ++viewIx )
 	{
-		RenderView& view = views[ viewIx ];
-		if( view.IsCommitted() == false ) {
+		RenderView* view = &views[ viewIx ];
+		if( view->IsCommitted() == false ) {
 			continue;
 		}
-		for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
+		if( view->culled ) {
+			continue;
+		}
+		jobs.Submit( [ this, view, scene, rebuild ]() { CommitDrawGroups( *view, scene, rebuild ); }, &commitJobs );
+	}
+	jobs.Wait( &commitJobs );
+
+	UpdateShadowCache();
+
+	commitTimer.Stop();
+	g_renderDebugData.commitTimeMs = static_cast<float>( commitTimer.GetElapsed() );
+}
+
+
+// Eye position of a rigid view matrix. Columns are taken through the matrix product so this holds regardless of storage order.
+static vec3f ViewOrigin( const mat4x4f& viewMatrix )
+{
+	const vec4f translation = viewMatrix * vec4f( 0.0f, 0.0f, 0.0f, 1.0f );
+	const vec4f axes[ 3 ] = { vec4f( 1.0f, 0.0f, 0.0f, 0.0f ), vec4f( 0.0f, 1.0f, 0.0f, 0.0f ), vec4f( 0.0f, 0.0f, 1.0f, 0.0f ) };
+
+	vec3f origin;
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		const vec4f column = viewMatrix * axes[ i ];
+		origin[ i ] = -( column[ 0 ] * translation[ 0 ] + column[ 1 ] * translation[ 1 ] + column[ 2 ] * translation[ 2 ] );
+	}
+	return origin;
+}
+
+
+void Renderer::CommitDrawGroups( RenderView& view, const Scene* scene, const bool rebuild )
+{
+	const uint32_t entCount = static_cast<uint32_t>( scene->entities.size() );
+	assert( entityBounds.Count() == entCount );
+
+	view.lastVisibleEntities.swap( view.visibleEntities );
+	view.visibleEntities.resize( entCount );
+	if ( view.lodRadius.size() != entCount ) {
+		view.lodRadius.assign( entCount, 0.0f );
+	}
+	view.drawsChanged = false;
+
+	// 2D views draw screen-space geometry only and are never culled.
+	// With GPU culling the draw groups hold every entity and visibility is resolved by the cull dispatch.
+	view.gpuCulling = config.gpuCulling && ( view.GetRegion() != renderViewRegion_t::STANDARD_2D );
+
+	// Only the main view has a depth pyramid to test against
+	view.occlusionCulling = config.occlusionCulling && ( &view == renderViews[ 0 ] );
+
+	uint32_t visibleCount = entCount;
+	if ( ( view.GetRegion() != renderViewRegion_t::STANDARD_2D ) && ( view.gpuCulling == false ) ) {
+		visibleCount = g_sceneBvh.CullFrustum( view.GetFrustum(), view.visibleEntities.data() );
+	} else if ( entCount > 0 ) {
+		memset( view.visibleEntities.data(), 1, entCount );
+	}
+
+	viewDebugData_t& viewDebug = g_renderDebugData.views[ view.GetViewId() ];
+	viewDebug.name = view.GetName();
+	viewDebug.visibleCount = visibleCount;
+	viewDebug.culledCount = entCount - visibleCount;
+	viewDebug.patchedCount = 0;
+	viewDebug.rebuiltCount = 0;
+
+	bool rebuildView = rebuild || ( view.lastVisibleEntities.size() != entCount );
+	if ( ( rebuildView == false ) && ( entCount > 0 ) ) {
+		rebuildView = ( memcmp( view.lastVisibleEntities.data(), view.visibleEntities.data(), entCount ) != 0 );
+	}
+
+	// Anything other than a transform change alters which surfaces are drawn or how they sort
+	const uint8_t structuralDirty = static_cast<uint8_t>( ~ENT_DIRTY_TRANSFORM );
+	if ( ( rebuildView == false ) && ( ( entityDirtyMask & structuralDirty ) != 0 ) )
+	{
+		for ( uint32_t entIx = 0; entIx < entCount; ++entIx )
+		{
+			if ( ( view.visibleEntities[ entIx ] != 0 ) && ( ( entityDirty[ entIx ] & structuralDirty ) != 0 ) )
+			{
+				rebuildView = true;
+				break;
+			}
+		}
+	}
+
+	// Blended passes depend on draw order, so they are re-sorted whenever the eye or a transform moves
+	const uint32_t blendedCount = view.drawGroup[ DRAWPASS_TRANS ].InstanceCount() + view.drawGroup[ DRAWPASS_EMISSIVE ].InstanceCount();
+	if ( ( rebuildView == false ) && ( blendedCount > 0 ) )
+	{
+		const bool eyeMoved = ( memcmp( &view.sortViewMatrix, &view.GetViewMatrix(), sizeof( mat4x4f ) ) != 0 );
+		rebuildView = eyeMoved || ( ( entityDirtyMask & ENT_DIRTY_TRANSFORM ) != 0 );
+	}
+
+	// Opaque keys hold the eye distance of the last rebuild and patching transforms keeps that order,
+	// so the groups are re-sorted once the eye has travelled far enough to reorder them
+	if ( rebuildView == false )
+	{
+		const viewport_t& viewport = view.GetViewport();
+		const float resortDistance = OpaqueResortDistance * ( viewport.far - viewport.near );
+		const vec3f eyeDelta = ViewOrigin( view.GetViewMatrix() ) - ViewOrigin( view.sortViewMatrix );
+		rebuildView = ( Dot( eyeDelta, eyeDelta ) > ( resortDistance * resortDistance ) );
+	}
+
+	// Moving an entity changes its projected size, only moved instances are checked for a LOD switch.
+	// Moving the eye changes every instance, that rescan runs at most every LodRescanFrames frames.
+	if ( rebuildView == false )
+	{
+		const bool eyeMoved = ( memcmp( &view.lodViewMatrix, &view.GetViewMatrix(), sizeof( mat4x4f ) ) != 0 );
+		const bool rescanAll = eyeMoved && ( ( m_frameNumber - view.lodScanFrame ) >= LodRescanFrames );
+		const bool rescanMoved = ( ( entityDirtyMask & ENT_DIRTY_TRANSFORM ) != 0 );
+		if ( rescanAll || rescanMoved )
 		{
-			view.drawGroup[ passIx ].Reset();
+			for ( uint32_t passIx = 0; ( passIx < DRAWPASS_COUNT ) && ( rebuildView == false ); ++passIx )
+			{
+				const DrawGroup& drawGroup = view.drawGroup[ passIx ];
+
+				const uint32_t instanceCount = drawGroup.InstanceCount();
+				for ( uint32_t instanceIx = 0; instanceIx < instanceCount; ++instanceIx )
+				{
+					const uint32_t entIx = drawGroup.EntityId( instanceIx );
+					if ( ( rescanAll == false ) && ( ( entityDirty[ entIx ] & ENT_DIRTY_TRANSFORM ) == 0 ) ) {
+						continue;
+					}
+
+					const drawSurf_t& surf = drawGroup.InstanceDrawSurf( instanceIx );
+					if ( SelectLod( view, LodRadius( view, entIx ), surf.uploadId ) != surf.lod )
+					{
+						rebuildView = true;
+						break;
+					}
+				}
+			}
 		}
 
-		for ( uint32_t entIx = 0; entIx < entCount; ++entIx ) {
-			CommitModel( view, *scene->entities[ entIx ] );
+		if ( rescanAll )
+		{
+			view.lodViewMatrix = view.GetViewMatrix();
+			view.lodScanFrame = m_frameNumber;
+		}
+	}
+
+	if ( rebuildView == false )
+	{
+		if ( ( entityDirtyMask & ENT_DIRTY_TRANSFORM ) == 0 ) {
+			return;
 		}
 
-		uint32_t drawGroupOffset = 0;
 		for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
 		{
-			view.drawGroup[ passIx ].Sort();
-			view.drawGroup[ passIx ].Merge();
-			view.drawGroup[ passIx ].AssignGeometryResources( &geometry );
+			DrawGroup& drawGroup = view.drawGroup[ passIx ];
+
+			const uint32_t instanceCount = drawGroup.InstanceCount();
+			for ( uint32_t instanceIx = 0; instanceIx < instanceCount; ++instanceIx )
+			{
+				const uint32_t entIx = drawGroup.EntityId( instanceIx );
+				if ( ( entityDirty[ entIx ] & ENT_DIRTY_TRANSFORM ) != 0 )
+				{
+					drawGroup.SetInstanceTransform( instanceIx, entityStates[ entIx ].matrix );
+					++viewDebug.patchedCount;
+				}
+			}
+		}
+		view.drawsChanged = ( viewDebug.patchedCount > 0 );
+		return;
+	}
+
+	view.drawsChanged = true;
+	viewDebug.droppedCount = 0;
 
-			view.drawGroupOffset[ passIx ] = drawGroupOffset;
-			drawGroupOffset += view.drawGroup[ passIx ].InstanceCount();
+	view.drawArena.Reset();
+	for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
+	{
+		view.drawGroup[ passIx ].Reset( &view.drawArena );
+	}
+	view.sortViewMatrix = view.GetViewMatrix();
+	view.lodViewMatrix = view.GetViewMatrix();
+	view.lodScanFrame = m_frameNumber;
+
+	for ( uint32_t entIx = 0; entIx < entCount; ++entIx )
+	{
+		if ( view.visibleEntities[ entIx ] == 0 ) {
+			continue;
 		}
+		CommitModel( view, *scene->entities[ entIx ], entIx );
 	}
-	CommitViews( scene );
+
+	uint32_t drawGroupOffset = 0;
+	uint32_t drawCommandOffset = 0;
+	for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
+	{
+		view.drawGroup[ passIx ].Sort();
+		const bool depthOrdered = ( passIx == DRAWPASS_TRANS ) || ( passIx == DRAWPASS_EMISSIVE );
+		view.drawGroup[ passIx ].Merge( depthOrdered );
+		view.drawGroup[ passIx ].AssignGeometryResources( &geometry );
+
+		view.drawGroupOffset[ passIx ] = drawGroupOffset;
+		drawGroupOffset += view.drawGroup[ passIx ].InstanceCount();
+
+		view.drawCommandOffset[ passIx ] = drawCommandOffset;
+		drawCommandOffset += view.drawGroup[ passIx ].Count();
+	}
+	viewDebug.rebuiltCount = drawGroupOffset;
+	viewDebug.arenaBytes = static_cast<uint32_t>( view.drawArena.Used() );
 }
 
 
-void Renderer::CommitModel( RenderView& view, const Entity& ent )
+uint8_t Renderer::CommitEntityState( const uint32_t entIx, const Entity& ent )
 {
-	if ( ent.HasFlag( ENT_FLAG_NO_DRAW ) ) {
-		return;
+	entityCommitState_t& state = entityStates[ entIx ];
+
+	uint32_t flags = 0;
+	flags |= ent.HasFlag( ENT_FLAG_NO_SHADOWS ) ? ( 1 << 0 ) : 0;
+	flags |= ent.HasFlag( ENT_FLAG_WIREFRAME ) ? ( 1 << 1 ) : 0;
+	flags |= ent.HasFlag( ENT_FLAG_DEBUG ) ? ( 1 << 2 ) : 0;
+	flags |= ent.HasFlag( ENT_FLAG_CAMERA_LOCKED ) ? ( 1 << 3 ) : 0;
+
+	const bool hidden = ent.HasFlag( ENT_FLAG_NO_DRAW );
+	const mat4x4f matrix = ent.GetMatrix();
+
+	uint8_t dirty = ENT_DIRTY_NONE;
+	if ( state.generation != entityGeneration ) {
+		dirty = ENT_DIRTY_ALL;
+	}
+	else
+	{
+		dirty |= ( memcmp( &state.matrix, &matrix, sizeof( mat4x4f ) ) != 0 ) ? ENT_DIRTY_TRANSFORM : 0;
+		dirty |= ( ( state.modelHdl != ent.modelHdl ) || ( state.materialHdl != ent.materialHdl ) ) ? ENT_DIRTY_MATERIAL : 0;
+		dirty |= ( ( state.flags != flags ) || ( state.outline != ent.outline ) ) ? ENT_DIRTY_FLAGS : 0;
+		dirty |= ( state.hidden != hidden ) ? ENT_DIRTY_VISIBILITY : 0;
 	}
 
-	assert( DRAWPASS_COUNT <= Material::MaxMaterialShaders );
+	state.generation = entityGeneration;
+	state.matrix = matrix;
+	state.modelHdl = ent.modelHdl;
+	state.materialHdl = ent.materialHdl;
+	state.flags = flags;
+	state.outline = ent.outline;
+	state.hidden = hidden;
+
+	return dirty;
+}
+
+
+// Returns true if the entity's model or materials are waiting on an upload
+bool Renderer::CommitModelResources( const Entity& ent )
+{
+	if ( ent.HasFlag( ENT_FLAG_NO_DRAW ) ) {
+		return false;
+	}
 
 	Asset<Model>* modelAsset = g_assets.modelLib.Find( ent.modelHdl );
 	Model& model = modelAsset->Get();
 
+	bool pendingUpload = ( modelAsset->IsUploaded() == false );
+
+	if( ( model.uploadId == -1 ) && ( model.surfCount > 0 ) )
+	{
+		model.uploadId = geometry.surfUploads.Count();
+		geometry.surfUploads.Grow( model.surfCount );
+	}
+
 	for ( uint32_t i = 0; i < model.surfCount; ++i )
 	{
-		if( model.uploadId == -1 )
-		{
-			model.uploadId = geometry.surfUploads.Count();
-			geometry.surfUploads.Grow( model.surfCount );
+		hdl_t materialHdl = ent.materialHdl.IsValid() ? ent.materialHdl : model.surfs[ i ].materialHdl;
+		const Asset<Material>* materialAsset = g_assets.materialLib.Find( materialHdl );
+		const Material& material = materialAsset->Get();
+
+		if( materialAsset->IsUploaded() == false ) {
+			uploadMaterials.insert( materialHdl );
+			pendingUpload = true;
+		}
+
+		for ( uint32_t t = 0; t < Material::MaxMaterialTextures; ++t ) {
+			const hdl_t texHandle = material.GetTexture( t );
+			if ( texHandle.IsValid() ) {
+				Asset<Image>* imageAsset = g_assets.textureLib.Find( texHandle );
+				Image& image = imageAsset->Get();
+				// Unslotted textures are retried when a slot is released, not every frame
+				const bool unslotted = ( unslottedTextures.find( texHandle ) != unslottedTextures.end() );
+				if( ( ( image.gpuImage == nullptr ) || ( image.gpuImage->GetId() < 0 ) ) && ( unslotted == false ) ) {
+					uploadTextures.insert( texHandle );
+				}
+				if ( ( imageAsset->IsUploaded() == false ) && ( unslotted == false ) ) {
+					updateTextures.insert( texHandle );
+				}
+			}
 		}
+	}
+	return pendingUpload;
+}
+
+
+// Runs on a job thread per view. Must not modify state shared between views.
+void Renderer::CommitModel( RenderView& view, const Entity& ent, const uint32_t entIx )
+{
+	if ( ent.HasFlag( ENT_FLAG_NO_DRAW ) ) {
+		return;
+	}
 
+	assert( DRAWPASS_COUNT <= Material::MaxMaterialShaders );
+
+	const Asset<Model>* modelAsset = g_assets.modelLib.Find( ent.modelHdl );
+	const Model& model = modelAsset->Get();
+
+	assert( ( model.uploadId != -1 ) || ( model.surfCount == 0 ) );
+
+	// Distance from the eye to the bounds center, normalized to the clip range
+	const viewport_t& viewport = view.GetViewport();
+	const vec4f viewCenter = view.GetViewMatrix() * vec4f( entityBounds.Center( entIx ), 1.0f );
+	const float eyeDistance = sqrtf( viewCenter[ 0 ] * viewCenter[ 0 ] + viewCenter[ 1 ] * viewCenter[ 1 ] + viewCenter[ 2 ] * viewCenter[ 2 ] );
+	const float depth = ( eyeDistance - viewport.near ) / std::max( viewport.far - viewport.near, 1e-6f );
+
+	uint32_t objectCount = 0;
+	for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx ) {
+		objectCount += view.drawGroup[ passIx ].InstanceCount();
+	}
+
+	for ( uint32_t i = 0; i < model.surfCount; ++i )
+	{
 		hdl_t materialHdl = ent.materialHdl.IsValid() ? ent.materialHdl : model.surfs[ i ].materialHdl;
 		const Asset<Material>* materialAsset = g_assets.materialLib.Find( materialHdl );
 		const Material& material = materialAsset->Get();
@@ -180,36 +498,16 @@ void Renderer::CommitModel( RenderView& view, const Entity& ent )
 		drawSurf_t surf = {};
 
 		instance.modelMatrix = ent.GetMatrix();
-		instance.surfId = 0;
-		instance.id = 0;
+		instance.entityId = entIx;
 		surf.uploadId = ( model.uploadId + i );
 		surf.stencilBit = ent.outline ? OutlineStencilBit : 0;
+		surf.lod = SelectLod( view, LodRadius( view, entIx ), surf.uploadId );
 		surf.objectOffset = 0;
 		surf.flags = renderFlags;	
 		
-		surf.sortKey = {};
-		surf.sortKey.materialId = material.uploadId;
-		surf.sortKey.stencilBit = surf.stencilBit;
-
-		surf.dbgName = materialAsset->GetName().c_str();
-
-		if( materialAsset->IsUploaded() == false ) {
-			uploadMaterials.insert( materialHdl );
-		}
+		surf.materialId = material.uploadId;
 
-		for ( uint32_t t = 0; t < Material::MaxMaterialTextures; ++t ) {
-			const hdl_t texHandle = material.GetTexture( t );
-			if ( texHandle.IsValid() ) {
-				Asset<Image>* imageAsset = g_assets.textureLib.Find( texHandle );
-				Image& image = imageAsset->Get();
-				if( image.gpuImage->GetId() < 0 ) {
-					uploadTextures.insert( texHandle );
-				}
-				if ( imageAsset->IsUploaded() == false ) {
-					updateTextures.insert( texHandle );
-				}
-			}
-		}
+		const char* dbgName = materialAsset->GetName().c_str();
 
 		for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
 		{
@@ -228,15 +526,114 @@ void Renderer::CommitModel( RenderView& view, const Entity& ent )
 				continue;
 			}
 
-			surf.pipelineObject = FindPipelineObject( pass, *prog );
-			assert( surf.pipelineObject != INVALID_HDL );
+			const bool usesFeatures = ( featurePrograms.count( prog->Handle().Get() ) > 0 );
+			const materialFeatureBits_t features = usesFeatures ? MaterialFeatures( material ) : MATERIAL_FEATURE_ALL;
 
-			view.drawGroup[ passIx ].Add( surf, instance );
+			// Not drawn until its pipeline finishes compiling
+			surf.pipelineObject = FindPipelineObject( pass, *prog, features );
+			if ( surf.pipelineObject == INVALID_HDL )
+			{
+				RequestGraphicsPipeline( pass, *prog, features );
+				continue;
+			}
+
+			const bool backToFront = ( passIx == DRAWPASS_TRANS ) || ( passIx == DRAWPASS_EMISSIVE );
+			surf.sortKey = MakeSortKey( surf.pipelineObject, surf.materialId, surf.stencilBit, depth, backToFront );
+
+			// The surface buffers stop growing at the device's storage buffer range
+			if ( objectCount >= resources.maxSurfaceCapacity )
+			{
+				++g_renderDebugData.views[ view.GetViewId() ].droppedCount;
+				continue;
+			}
+
+			view.drawGroup[ passIx ].Add( surf, instance, dbgName );
+			++objectCount;
 		}
 	}
 }
 
 
+// Shader features a material's surfaces use. Alpha test follows the albedo texture's cutout texels,
+// shadowing follows whether lit surfaces receive shadows at all.
+materialFeatureBits_t Renderer::MaterialFeatures( const Material& material ) const
+{
+	materialFeatureBits_t features = MATERIAL_FEATURE_NONE;
+
+	if ( material.IsTextured() )
+	{
+		// Texture slots follow lit.frag: albedo, normal, roughness, metal
+		features |= material.GetTexture( 1 ).IsValid() ? MATERIAL_FEATURE_NORMAL_MAP : MATERIAL_FEATURE_NONE;
+		features |= ( material.GetTexture( 2 ).IsValid() || material.GetTexture( 3 ).IsValid() ) ? MATERIAL_FEATURE_SPECULAR_MAPS : MATERIAL_FEATURE_NONE;
+
+		auto maskIt = textureAlphaMasks.find( material.GetTexture( 0 ).Get() );
+		const bool alphaMasked = ( maskIt != textureAlphaMasks.end() ) && maskIt->second;
+		features |= alphaMasked ? MATERIAL_FEATURE_ALPHA_TEST : MATERIAL_FEATURE_NONE;
+	}
+
+	// Shadow maps are only rendered with shadows enabled, otherwise nothing can be received
+	features |= config.shadows ? MATERIAL_FEATURE_SHADOWED : MATERIAL_FEATURE_NONE;
+
+	const bool hasAmbient = ( material.Ka().r > 0.0f ) || ( material.Ka().g > 0.0f ) || ( material.Ka().b > 0.0f );
+	features |= hasAmbient ? MATERIAL_FEATURE_IBL : MATERIAL_FEATURE_NONE;
+
+	return features;
+}
+
+
+// Projected bounding radius in pixels, infinite when the eye is inside the bounds.
+// The stored radius only follows once it is off by more than LodHysteresis, so an instance
+// near a level threshold doesn't switch back and forth.
+float Renderer::LodRadius( RenderView& view, const uint32_t entIx ) const
+{
+	const vec3f extent = entityBounds.Extent( entIx );
+	const float worldRadius = sqrtf( Dot( extent, extent ) );
+
+	const vec4f viewCenter = view.GetViewMatrix() * vec4f( entityBounds.Center( entIx ), 1.0f );
+	const float eyeDistance = sqrtf( viewCenter[ 0 ] * viewCenter[ 0 ] + viewCenter[ 1 ] * viewCenter[ 1 ] + viewCenter[ 2 ] * viewCenter[ 2 ] );
+
+	const mat4x4f& proj = view.GetProjMatrix();
+	const float yScale = ( proj * vec4f( 0.0f, 1.0f, 0.0f, 0.0f ) )[ 1 ];
+	const bool perspective = ( ( proj * vec4f( 0.0f, 0.0f, 1.0f, 0.0f ) )[ 3 ] != 0.0f );
+
+	float projectedRadius = worldRadius * fabsf( yScale ) * 0.5f * view.GetViewport().height;
+	if ( perspective ) {
+		projectedRadius = ( eyeDistance <= worldRadius ) ? FLT_MAX : ( projectedRadius / eyeDistance );
+	}
+
+	float& selectedRadius = view.lodRadius[ entIx ];
+	const bool grown = ( projectedRadius > selectedRadius * ( 1.0f + LodHysteresis ) );
+	const bool shrunk = ( projectedRadius < selectedRadius * ( 1.0f - LodHysteresis ) );
+	if ( ( selectedRadius <= 0.0f ) || grown || shrunk ) {
+		selectedRadius = projectedRadius;
+	}
+	return selectedRadius;
+}
+
+
+// Coarsest level whose simplification error projects to less than the allowed pixel error.
+// Views with a larger bias accept coarser geometry.
+uint8_t Renderer::SelectLod( const RenderView& view, const float projectedRadius, const uint32_t uploadId ) const
+{
+	const surfaceUpload_t& upload = geometry.surfUploads[ uploadId ];
+	if ( upload.lodCount <= 1 ) {
+		return 0;
+	}
+
+	const float maxPixelError = LodPixelError * view.lodBias;
+
+	uint8_t lod = 0;
+	for ( uint32_t i = 1; i < upload.lodCount; ++i )
+	{
+		if ( ( upload.lods[ i ].error * projectedRadius ) > maxPixelError ) {
+			break;
+		}
+		lod = static_cast<uint8_t>( i );
+	}
+	return lod;
+}
+
+
 void Renderer::InitGPU()
 {
 	{
@@ -248,15 +645,27 @@ void Renderer::InitGPU()
 	InitShaderResources();
 	RecreateSwapChain();
 	UploadAssets();
+
+	// A new scene's entities may reuse the addresses and indices of the old one's
+	++entityGeneration;
+	forceDrawGroupRebuild = true;
+}
+
+
+void Renderer::SetPipelineManifest( const std::string& path )
+{
+	config.pipelineManifest = path;
 }
 
 
 void Renderer::ShutdownGPU()
 {
+	pipelineJobs.Wait( &pipelineCompileJobs );
 	FlushGPU();
 	ShutdownShaderResources();
 
 	imageFreeSlot = 0;
+	releasedImageSlots.clear();
 	geometry.vbBufElements = 0;
 	geometry.ibBufElements = 0;
 }
@@ -271,10 +680,28 @@ void Renderer::RecreateSwapChain()
 
 	RenderResource::Cleanup( resourceLifeTime_t::RESIZE );
 	g_swapChain.Destroy();
+	g_swapChain.Create( &g_window, width, height );
 
-	renderContext.frameBufferMemory.Create( MaxFrameBufferMemory, memoryRegion_t::LOCAL, resourceLifeTime_t::RESIZE );
+	CreateFrameResources( width, height );
+}
 
-	g_swapChain.Create( &g_window, width, height );
+
+// Remakes the frame buffers at the current size and keeps the swap chain
+void Renderer::RecreateFramebuffers()
+{
+	FlushGPU();
+
+	RenderResource::Cleanup( resourceLifeTime_t::RESIZE );
+	g_swapChain.CreateFrameBuffer();
+
+	CreateFrameResources( g_swapChain.GetWidth(), g_swapChain.GetHeight() );
+	renderContext.RefreshRegisteredBindParms();
+}
+
+
+void Renderer::CreateFrameResources( const int width, const int height )
+{
+	renderContext.frameBufferMemory.Create( MaxFrameBufferMemory, memoryRegion_t::LOCAL, resourceLifeTime_t::RESIZE );
 	CreateFramebuffers();
 
 	for ( uint32_t viewIx = 0; viewIx < viewCount; ++viewIx )
@@ -283,15 +710,7 @@ void Renderer::RecreateSwapChain()
 		views[ viewIx ].SetViewRect( 0, 0, width, height );
 	}
 
-	if( resolve != nullptr ) {
-		resolve->Resize();
-	}
-
-	for ( uint32_t i = 0; i < pingPongQueue.size(); ++i ) {
-		if ( pingPongQueue[ i ] != nullptr ) {
-			pingPongQueue[ i ]->Resize();
-		}
-	}
+	schedule.Resize();
 }
 
 
@@ -301,9 +720,7 @@ void Renderer::Resize()
 	renderContext.RefreshRegisteredBindParms();
 
 	uploadContext.Begin();
-	for ( uint32_t shadowIx = 0; shadowIx < MaxShadowMaps; ++shadowIx ) {
-		Transition( &uploadContext, resources.shadowMapImage[ shadowIx ], GPU_IMAGE_NONE, GPU_IMAGE_READ );
-	}
+	Transition( &uploadContext, resources.shadowAtlasImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
 	Transition( &uploadContext, resources.mainColorImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
 	Transition( &uploadContext, resources.gBufferLayerImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
 	Transition( &uploadContext, resources.mainColorResolvedImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
@@ -323,6 +740,11 @@ void Renderer::Resize()
 	uploadContext.Submit();
 
 	FlushGPU();
+
+	// The atlas was recreated with undefined contents
+	for ( uint32_t shadowIx = 0; shadowIx < MaxShadowViews; ++shadowIx ) {
+		shadowCache[ shadowIx ].valid = false;
+	}
 }
 
 
@@ -354,8 +776,14 @@ void Renderer::UploadAssets()
 		uploadTextures.insert( textureAsset->Handle() );
 	}
 
+	// Alpha test variants depend on the texture contents
+	for ( auto it = uploadTextures.begin(); it != uploadTextures.end(); ++it ) {
+		ClassifyAlphaMask( *it );
+	}
+
 	ClearPipelineCache();
-	BuildPipelines();
+	BuildPipelines( true );
+	PrewarmPipelines();
 
 	geometry.stagingBuffer.SetPos( 0 );
 	textureStagingBuffer.SetPos( 0 );
@@ -365,9 +793,7 @@ void Renderer::UploadAssets()
 
 	UploadTextures();
 
-	for ( uint32_t shadowIx = 0; shadowIx < MaxShadowMaps; ++shadowIx ) {
-		Transition( &uploadContext, resources.shadowMapImage[ shadowIx ], GPU_IMAGE_NONE, GPU_IMAGE_READ );
-	}	
+	Transition( &uploadContext, resources.shadowAtlasImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
 	Transition( &uploadContext, resources.mainColorImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
 	Transition( &uploadContext, resources.gBufferLayerImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
 	Transition( &uploadContext, resources.mainColorResolvedImage, GPU_IMAGE_NONE, GPU_IMAGE_READ );
@@ -399,6 +825,7 @@ void Renderer::Render()
 	frameTimer.Start();
 
 	BuildPipelines();
+	DestroyRetiredImages( false );
 
 	geometry.stagingBuffer.SetPos( 0 );
 	textureStagingBuffer.SetPos( 0 );
@@ -435,6 +862,16 @@ void Renderer::WaitForEndFrame()
 		gfxContext.frameFence[ context.bufferId ].Wait();
 	}
 
+	// Timings of this frame slot are complete now that its fence was waited on
+	const float gpuFrameMs = ReadGpuFrameTime();
+	if ( config.dynamicResolution ) {
+		resolutionScale.Update( gpuFrameMs );
+	}
+	g_renderDebugData.gpuFrameTimeMs = gpuFrameMs;
+	g_renderDebugData.resolutionScale = resolutionScale.Scale();
+
+	ApplyResolutionScale();
+
 	g_swapChain.WaitOnFlip( gfxContext.presentSemaphore );
 
 #ifdef USE_IMGUI
@@ -453,12 +890,29 @@ void Renderer::SubmitFrame()
 		computeContext.Begin();
 		gfxContext.Begin();
 
+		// Two timestamps per frame slot bracket the graphics work
+		const uint32_t timestampQuery = 2 * context.bufferId;
+		if ( context.timestampQueryPool != VK_NULL_HANDLE )
+		{
+			vkCmdResetQueryPool( gfxContext.CommandBuffer(), context.timestampQueryPool, timestampQuery, 2 );
+			vkCmdWriteTimestamp( gfxContext.CommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, context.timestampQueryPool, timestampQuery );
+		}
+
 		renderContext.UpdateBindParms();
 
+		// Secondary buffers are recorded on the job threads, then executed in schedule order
+		schedule.Record( jobs );
+
 		while( schedule.PendingTasks() > 0 ) {
 			schedule.IssueNext( gfxContext );
 		}
 
+		if ( context.timestampQueryPool != VK_NULL_HANDLE )
+		{
+			vkCmdWriteTimestamp( gfxContext.CommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, context.timestampQueryPool, timestampQuery + 1 );
+			gpuTimestampsWritten[ context.bufferId ] = true;
+		}
+
 		gfxContext.End();
 		computeContext.End();
 	}
@@ -482,6 +936,46 @@ void Renderer::SubmitFrame()
 }
 
 
+float Renderer::ReadGpuFrameTime() const
+{
+	static_assert( ( 2 * MaxFrameStates ) <= MaxTimeStampQueries, "Not enough timestamp queries for every frame state" );
+
+	if ( ( context.timestampQueryPool == VK_NULL_HANDLE ) || ( gpuTimestampsWritten[ context.bufferId ] == false ) ) {
+		return 0.0f;
+	}
+
+	uint64_t timestamps[ 2 ] = {};
+	const VkResult result = vkGetQueryPoolResults( context.device, context.timestampQueryPool, 2 * context.bufferId, 2, sizeof( timestamps ), timestamps, sizeof( uint64_t ), VK_QUERY_RESULT_64_BIT );
+	if ( ( result != VK_SUCCESS ) || ( timestamps[ 1 ] < timestamps[ 0 ] ) ) {
+		return 0.0f;
+	}
+
+	const double elapsedNs = static_cast<double>( timestamps[ 1 ] - timestamps[ 0 ] ) * context.deviceProperties.limits.timestampPeriod;
+	return static_cast<float>( elapsedNs / 1000000.0 );
+}
+
+
+// The main view keeps its full-size targets and only renders into a scaled viewport of them.
+// The post pass upscales that region to the display.
+void Renderer::ApplyResolutionScale()
+{
+	RenderView& view = *renderViews[ 0 ];
+
+	const float scale = config.dynamicResolution ? resolutionScale.Scale() : 1.0f;
+	const uint32_t width = std::max( 1u, static_cast<uint32_t>( mainColor.GetWidth() * scale ) );
+	const uint32_t height = std::max( 1u, static_cast<uint32_t>( mainColor.GetHeight() * scale ) );
+
+	view.SetViewRect( 0, 0, width, height );
+	for ( uint32_t passIx = view.ViewRegionPassBegin(); passIx <= view.ViewRegionPassEnd(); ++passIx )
+	{
+		DrawPass* pass = view.passes[ passIx ];
+		if ( pass != nullptr ) {
+			pass->SetViewport( 0, 0, width, height );
+		}
+	}
+}
+
+
 void Renderer::CommitLight( const light_t& light )
 {
 	if ( ( light.flags & LIGHT_FLAGS_HIDDEN ) != 0 ) {
@@ -493,26 +987,139 @@ void Renderer::CommitLight( const light_t& light )
 	lightObject.lightDir = light.dir;
 	lightObject.lightPos = light.pos;
 
-	if ( ( light.flags & LIGHT_FLAGS_SHADOW ) == 0 ) {
+	// Inverse square falloff drops to the cutoff here, the shaders window it to zero
+	const vec4f& intensity = lightObject.intensity;
+	const float peakIntensity = std::max( intensity[ 0 ], std::max( intensity[ 1 ], intensity[ 2 ] ) );
+	lightObject.radius = LightUnitDistance * sqrtf( std::max( peakIntensity, 0.0f ) / LightFalloffCutoff );
+
+	// Lights past the shadow view budget are committed unshadowed
+	if ( ( ( light.flags & LIGHT_FLAGS_SHADOW ) == 0 ) || ( shadowCount >= MaxShadowViews ) ) {
 		lightObject.shadowViewId = 0xFF;
 	}
+	else if ( light.pos[ 3 ] == 0.0f )
+	{
+		// Like a homogeneous point at infinity, a zero w marks a directional light
+		CommitShadowCascades( light, lightObject );
+	}
 	else
 	{
-		lightObject.shadowViewId = shadowCount;
+		lightObject.shadowViewId = shadowViews[ shadowCount ]->GetViewId();
+		shadowViews[ shadowCount ]->culled = false;
 
+		// Tiles are square, their placement in the atlas is assigned once all lights are known.
+		// Nothing past the light's radius is lit, so the far plane stops there and culling sees the light's reach.
 		Camera shadowCam;
 		shadowCam = Camera( light.pos, MatrixFromVector( light.dir.Reverse() ) );
-		shadowCam.SetClip( 0.1f, 1000.0f );
+		shadowCam.SetClip( 0.1f, std::max( lightObject.radius, 0.2f ) );
 		shadowCam.SetFov( Radians( 90.0f ) );
-		shadowCam.SetAspectRatio( ( ShadowMapWidth / (float)ShadowMapHeight ) );
+		shadowCam.SetAspectRatio( 1.0f );
 
-		shadowViews[ shadowCount ]->SetViewRect( 0, 0, ShadowMapWidth, ShadowMapHeight );
 		shadowViews[ shadowCount ]->SetCamera( shadowCam, false );
+
+		shadowLightIx[ shadowCount ] = committedLights.Count();
+		++shadowCount;
 	}
 	committedLights.Append( lightObject );
+}
 
-	++shadowCount;
-	assert( shadowCount < MaxShadowMaps );
+
+// Cascade splits blend a logarithmic and a uniform distribution over the shadowed depth of the main view.
+// Each cascade bounds its slice with a sphere, so its size doesn't change as the camera turns.
+void Renderer::CommitShadowCascades( const light_t& light, lightBufferObject_t& lightObject )
+{
+	const RenderView& mainView = *renderViews[ 0 ];
+	const mat4x4f& viewMatrix = mainView.GetViewMatrix();
+	const mat4x4f& projMatrix = mainView.GetProjMatrix();
+
+	// Rows of the view rotation are the camera axes, see MatrixFromColumns()
+	const vec3f viewX = vec3f( viewMatrix[ 0 ][ 0 ], viewMatrix[ 0 ][ 1 ], viewMatrix[ 0 ][ 2 ] );
+	const vec3f viewY = vec3f( viewMatrix[ 1 ][ 0 ], viewMatrix[ 1 ][ 1 ], viewMatrix[ 1 ][ 2 ] );
+	const vec3f viewZ = vec3f( viewMatrix[ 2 ][ 0 ], viewMatrix[ 2 ][ 1 ], viewMatrix[ 2 ][ 2 ] );
+	const vec3f eye = vec3f( 0.0f, 0.0f, 0.0f ) - ( viewMatrix[ 0 ][ 3 ] * viewX + viewMatrix[ 1 ][ 3 ] * viewY + viewMatrix[ 2 ][ 3 ] * viewZ );
+
+	// Clip w is the view depth up to sign, which tells the direction the camera looks in
+	const vec4f pz = projMatrix * vec4f( 0.0f, 0.0f, 1.0f, 0.0f );
+	const vec3f forward = ( ( pz[ 3 ] < 0.0f ) ? -1.0f : 1.0f ) * viewZ;
+	const float tanX = 1.0f / fabsf( ( projMatrix * vec4f( 1.0f, 0.0f, 0.0f, 0.0f ) )[ 0 ] );
+	const float tanY = 1.0f / fabsf( ( projMatrix * vec4f( 0.0f, 1.0f, 0.0f, 0.0f ) )[ 1 ] );
+	const float tanSqr = tanX * tanX + tanY * tanY;
+
+	const float nearClip = std::max( mainView.GetViewport().near, 0.01f );
+	const float farClip = std::max( std::min( mainView.GetViewport().far, ShadowCascadeDistance ), nearClip );
+	const uint32_t cascadeCount = std::min( config.shadowCascades, MaxShadowViews - shadowCount );
+	assert( cascadeCount <= MaxShadowCascades );
+
+	lightObject.shadowViewId = shadowViews[ shadowCount ]->GetViewId();
+	lightObject.cascadeCount = cascadeCount;
+	lightObject.cascadeSplits = vec4f( farClip, farClip, farClip, farClip );
+
+	const vec3f lightDir = Trunc<4,1>( light.dir ).Normalize();
+
+	float splitNear = nearClip;
+	for ( uint32_t cascadeIx = 0; cascadeIx < cascadeCount; ++cascadeIx )
+	{
+		const float t = ( cascadeIx + 1 ) / float( cascadeCount );
+		const float logSplit = nearClip * powf( farClip / nearClip, t );
+		const float uniformSplit = nearClip + ( farClip - nearClip ) * t;
+		const float splitFar = ShadowCascadeSplitBlend * logSplit + ( 1.0f - ShadowCascadeSplitBlend ) * uniformSplit;
+
+		// Smallest sphere centered on the view axis that holds the corners of the slice
+		const float centerDepth = std::min( splitFar, 0.5f * ( splitNear + splitFar ) * ( 1.0f + tanSqr ) );
+		const float farOffset = splitFar - centerDepth;
+		const float radius = sqrtf( farOffset * farOffset + splitFar * splitFar * tanSqr );
+
+		const uint32_t shadowIx = shadowCount;
+		shadowCascade_t& cascade = shadowCascades[ shadowIx ];
+		cascade.lightDir = lightDir;
+		cascade.center = eye + centerDepth * forward;
+		cascade.radius = ceilf( radius * 16.0f ) / 16.0f; // Small changes of the clip planes keep the same size
+		cascade.active = true;
+
+		lightObject.cascadeSplits[ cascadeIx ] = splitFar;
+
+		shadowViews[ shadowIx ]->culled = false;
+		shadowLightIx[ shadowIx ] = committedLights.Count();
+		SetCascadeView( shadowIx );
+
+		++shadowCount;
+		splitNear = splitFar;
+	}
+}
+
+
+// Orthographic view around a cascade's sphere. The center is snapped to whole texels of the view's tile
+// in light space, so a moving camera shifts the cascade in texel steps and shadow edges don't shimmer.
+void Renderer::SetCascadeView( const uint32_t shadowIx )
+{
+	const shadowCascade_t& cascade = shadowCascades[ shadowIx ];
+	RenderView& shadowView = *shadowViews[ shadowIx ];
+
+	const vec3f& forward = cascade.lightDir;
+	const vec3f helper = ( fabsf( forward[ 2 ] ) < 0.99f ) ? vec3f( 0.0f, 0.0f, 1.0f ) : vec3f( 0.0f, 1.0f, 0.0f );
+	const vec3f right = Cross( forward, helper ).Normalize();
+	const vec3f up = Cross( right, forward );
+
+	const float diameter = 2.0f * cascade.radius;
+	const float texelSize = diameter / std::max( static_cast<float>( shadowView.GetViewport().width ), 1.0f );
+
+	vec3f center = vec3f( Dot( right, cascade.center ), Dot( up, cascade.center ), Dot( forward, cascade.center ) );
+	for ( uint32_t i = 0; i < 3; ++i ) {
+		center[ i ] = floorf( center[ i ] / texelSize ) * texelSize;
+	}
+
+	const mat4x4f viewMatrix = MatrixFromColumns(	vec4f( right[ 0 ], up[ 0 ], forward[ 0 ], 0.0f ),
+													vec4f( right[ 1 ], up[ 1 ], forward[ 1 ], 0.0f ),
+													vec4f( right[ 2 ], up[ 2 ], forward[ 2 ], 0.0f ),
+													vec4f( -center[ 0 ], -center[ 1 ], -center[ 2 ], 1.0f ) );
+
+	// Depth runs from the caster reach toward the light to the far side of the sphere
+	const float depthRange = diameter + ShadowCasterReach;
+	const mat4x4f projMatrix = MatrixFromColumns(	vec4f( 1.0f / cascade.radius, 0.0f, 0.0f, 0.0f ),
+													vec4f( 0.0f, 1.0f / cascade.radius, 0.0f, 0.0f ),
+													vec4f( 0.0f, 0.0f, 1.0f / depthRange, 0.0f ),
+													vec4f( 0.0f, 0.0f, ( cascade.radius + ShadowCasterReach ) / depthRange, 1.0f ) );
+
+	shadowView.SetViewProjection( viewMatrix, projMatrix, 0.0f, depthRange );
 }
 
 
@@ -528,30 +1135,22 @@ void Renderer::CommitViews( const Scene* scene )
 	shadowCount = 0;
 	committedLights.Reset();
 
-	for( uint32_t i = 0; i < lightCount; ++i ) {
-		CommitLight( scene->lights[ i ] );
+	// Shadow views without a light stay culled
+	for ( uint32_t i = 0; i < MaxShadowViews; ++i )
+	{
+		shadowViews[ i ]->culled = true;
+		shadowCascades[ i ].active = false;
 	}
 
-	// Main view
+	// Main view, its rect follows the resolution scale (ApplyResolutionScale)
 	{
-		renderViews[ 0 ]->SetViewRect( 0, 0, width, height );
 		renderViews[ 0 ]->SetCamera( *scene->mainCamera );
 
-		renderViews[ 0 ]->numLights = lightCount;
-		for ( uint32_t lightIx = 0; lightIx < lightCount; ++lightIx ) {
-			renderViews[ 0 ]->lights[ lightIx ] = lightIx;
-		}
-
 		assert( Max3DViews >= 7 );
 		for ( uint32_t cubeViewIx = 1; cubeViewIx < 7; ++cubeViewIx )
 		{
 			renderViews[ cubeViewIx ]->SetViewRect( 0, 0, 256, 256 );
 			renderViews[ cubeViewIx ]->SetCamera( scene->cameras[ cubeViewIx ] );
-
-			renderViews[ cubeViewIx ]->numLights = lightCount;
-			for ( uint32_t lightIx = 0; lightIx < lightCount; ++lightIx ) {
-				renderViews[ cubeViewIx ]->lights[ lightIx ] = lightIx;
-			}
 		}
 	}
 
@@ -560,6 +1159,37 @@ void Renderer::CommitViews( const Scene* scene )
 		view2Ds[ 0 ]->SetViewRect( 0, 0, width, height );
 	}
 
+	// Cascades are fit to the main view, so lights are committed after it.
+	// Directional lights are committed first, they reach every cluster so they're kept out of the cluster lists.
+	for( uint32_t i = 0; i < lightCount; ++i )
+	{
+		if ( scene->lights[ i ].pos[ 3 ] == 0.0f ) {
+			CommitLight( scene->lights[ i ] );
+		}
+	}
+	const uint32_t directionalCount = committedLights.Count();
+
+	for( uint32_t i = 0; i < lightCount; ++i )
+	{
+		if ( scene->lights[ i ].pos[ 3 ] != 0.0f ) {
+			CommitLight( scene->lights[ i ] );
+		}
+	}
+
+	// Hidden lights aren't committed, so views index the committed list. Each view's light cull narrows it per cluster.
+	const uint32_t committedCount = committedLights.Count();
+	for ( uint32_t viewIx = 0; viewIx < Max3DViews; ++viewIx )
+	{
+		renderViews[ viewIx ]->numLights = committedCount;
+		renderViews[ viewIx ]->numDirectionalLights = directionalCount;
+		for ( uint32_t lightIx = 0; lightIx < committedCount; ++lightIx ) {
+			renderViews[ viewIx ]->lights[ lightIx ] = lightIx;
+		}
+	}
+
+	CullShadowViews();
+	AllocateShadowTiles();
+
 	activeViewCount = 0;
 	for( uint32_t i = 0; i < viewCount; ++i )
 	{
@@ -572,6 +1202,183 @@ void Renderer::CommitViews( const Scene* scene )
 }
 
 
+// Shadow maps are only sampled by surfaces drawn in raster views. A light whose shadow frustum
+// misses every raster view can't shade anything visible, so its shadow view is skipped. Spot shadow
+// frustums end at the light's radius, so lights that can't reach a view are culled too.
+void Renderer::CullShadowViews()
+{
+	for ( uint32_t shadowIx = 0; shadowIx < MaxShadowViews; ++shadowIx )
+	{
+		RenderView& shadowView = *shadowViews[ shadowIx ];
+		// Cascades are fit to the main view and always overlap it
+		if ( shadowView.culled || shadowCascades[ shadowIx ].active ) {
+			continue;
+		}
+
+		bool overlaps = false;
+		for ( uint32_t viewIx = 0; ( viewIx < Max3DViews ) && ( overlaps == false ); ++viewIx )
+		{
+			if ( renderViews[ viewIx ]->IsCommitted() ) {
+				overlaps = FrustumOverlaps( shadowView.GetFrustum(), renderViews[ viewIx ]->GetFrustum() );
+			}
+		}
+		shadowView.culled = ( overlaps == false );
+	}
+}
+
+
+// Morton order to grid coordinate, keeps the even bits of the code
+static uint32_t CompactBits( uint32_t v )
+{
+	v &= 0x55555555;
+	v = ( v | ( v >> 1 ) ) & 0x33333333;
+	v = ( v | ( v >> 2 ) ) & 0x0F0F0F0F;
+	v = ( v | ( v >> 4 ) ) & 0x00FF00FF;
+	v = ( v | ( v >> 8 ) ) & 0x0000FFFF;
+	return v;
+}
+
+
+// Every shadow view gets a square tile of the shadow atlas. Importance is the light's luminance over the
+// squared distance from the main view to the light or cascade, a stand-in for how much of the screen its shadows cover.
+// Each quartering of importance relative to the most important light halves the tile size. Tiles that
+// don't fit are shrunk starting with the least important of the largest. Packing the tiles largest first
+// along a Morton curve keeps every power of two tile aligned, so no free list is needed.
+void Renderer::AllocateShadowTiles()
+{
+	const uint32_t levelCount = 1 + static_cast<uint32_t>( log2f( float( ShadowTileMaxSize / ShadowTileMinSize ) ) );
+	const uint32_t cellsPerRow = ShadowAtlasSize / ShadowTileMinSize;
+	const uint32_t atlasCells = cellsPerRow * cellsPerRow;
+
+	uint32_t order[ MaxShadowViews ];
+	uint32_t level[ MaxShadowViews ];
+	float importance[ MaxShadowViews ];
+	uint32_t tileCount = 0;
+	float maxImportance = 0.0f;
+
+	const mat4x4f& mainViewMatrix = renderViews[ 0 ]->GetViewMatrix();
+
+	for ( uint32_t shadowIx = 0; shadowIx < shadowCount; ++shadowIx )
+	{
+		lightBufferObject_t& lightObject = committedLights[ shadowLightIx[ shadowIx ] ];
+
+		const shadowCascade_t& cascade = shadowCascades[ shadowIx ];
+
+		// Culled views aren't rendered and can't shade anything visible
+		if ( shadowViews[ shadowIx ]->culled )
+		{
+			lightObject.shadowViewId = 0xFF;
+			continue;
+		}
+
+		const vec4f& pos = lightObject.lightPos;
+		const vec4f& intensity = lightObject.intensity;
+		const vec4f focus = cascade.active ? vec4f( cascade.center[ 0 ], cascade.center[ 1 ], cascade.center[ 2 ], 1.0f ) : vec4f( pos[ 0 ], pos[ 1 ], pos[ 2 ], 1.0f );
+		const vec4f eyePos = mainViewMatrix * focus;
+		const float distanceSqr = eyePos[ 0 ] * eyePos[ 0 ] + eyePos[ 1 ] * eyePos[ 1 ] + eyePos[ 2 ] * eyePos[ 2 ];
+		const float luminance = 0.2126f * intensity[ 0 ] + 0.7152f * intensity[ 1 ] + 0.0722f * intensity[ 2 ];
+
+		importance[ shadowIx ] = std::max( luminance, 1e-6f ) / std::max( distanceSqr, 1.0f );
+		maxImportance = std::max( maxImportance, importance[ shadowIx ] );
+
+		order[ tileCount ] = shadowIx;
+		++tileCount;
+	}
+
+	std::sort( order, order + tileCount, [ &importance ]( const uint32_t a, const uint32_t b ) {
+		return importance[ a ] > importance[ b ];
+	} );
+
+	uint32_t usedCells = 0;
+	for ( uint32_t i = 0; i < tileCount; ++i )
+	{
+		const uint32_t shadowIx = order[ i ];
+		const float quarterings = 0.5f * log2f( maxImportance / importance[ shadowIx ] );
+		level[ shadowIx ] = std::min( levelCount - 1, static_cast<uint32_t>( quarterings ) );
+		usedCells += 1u << ( 2 * ( levelCount - 1 - level[ shadowIx ] ) );
+	}
+
+	while ( usedCells > atlasCells )
+	{
+		uint32_t shrinkIx = ~0u;
+		for ( uint32_t i = 0; i < tileCount; ++i )
+		{
+			const uint32_t shadowIx = order[ i ];
+			if ( level[ shadowIx ] >= ( levelCount - 1 ) ) {
+				continue;
+			}
+			if ( ( shrinkIx == ~0u ) || ( level[ shadowIx ] <= level[ shrinkIx ] ) ) {
+				shrinkIx = shadowIx;
+			}
+		}
+		assert( shrinkIx != ~0u ); // Even the smallest tiles don't fit
+		if ( shrinkIx == ~0u ) {
+			break;
+		}
+		usedCells -= 3u << ( 2 * ( levelCount - 2 - level[ shrinkIx ] ) );
+		++level[ shrinkIx ];
+	}
+
+	std::stable_sort( order, order + tileCount, [ &level ]( const uint32_t a, const uint32_t b ) {
+		return level[ a ] < level[ b ];
+	} );
+
+	uint32_t cellOffset = 0;
+	for ( uint32_t i = 0; i < tileCount; ++i )
+	{
+		const uint32_t shadowIx = order[ i ];
+		const uint32_t tileSize = ShadowTileMaxSize >> level[ shadowIx ];
+		const uint32_t x = CompactBits( cellOffset ) * ShadowTileMinSize;
+		const uint32_t y = CompactBits( cellOffset >> 1 ) * ShadowTileMinSize;
+
+		shadowViews[ shadowIx ]->SetViewRect( x, y, tileSize, tileSize );
+
+		// Texel snapping depends on the tile size
+		if ( shadowCascades[ shadowIx ].active ) {
+			SetCascadeView( shadowIx );
+		}
+
+		cellOffset += 1u << ( 2 * ( levelCount - 1 - level[ shadowIx ] ) );
+	}
+
+	g_renderDebugData.shadowAtlasUsage = cellOffset / float( atlasCells );
+}
+
+
+// A shadow map only changes when its light moves, its atlas tile moves or the casters in its frustum change.
+// Otherwise the tile from the last render is kept and the view isn't recorded.
+void Renderer::UpdateShadowCache()
+{
+	for ( uint32_t shadowIx = 0; shadowIx < MaxShadowViews; ++shadowIx )
+	{
+		RenderView& shadowView = *shadowViews[ shadowIx ];
+		shadowCacheState_t& cache = shadowCache[ shadowIx ];
+		viewDebugData_t& viewDebug = g_renderDebugData.views[ shadowView.GetViewId() ];
+
+		if ( shadowView.culled )
+		{
+			// Entities may change while the view isn't committed, force a rebuild when it returns
+			shadowView.visibleEntities.clear();
+			shadowView.reuseFrameBuffer = true;
+			cache.valid = false;
+			viewDebug.renderState = VIEW_CULLED;
+			continue;
+		}
+
+		const viewport_t& tile = shadowView.GetViewport();
+		const bool lightMoved = ( memcmp( &cache.viewprojMatrix, &shadowView.GetViewprojMatrix(), sizeof( mat4x4f ) ) != 0 );
+		const bool tileMoved = ( cache.tile.x != tile.x ) || ( cache.tile.y != tile.y ) || ( cache.tile.width != tile.width ) || ( cache.tile.height != tile.height );
+
+		shadowView.reuseFrameBuffer = cache.valid && ( lightMoved == false ) && ( tileMoved == false ) && ( shadowView.drawsChanged == false );
+		viewDebug.renderState = shadowView.reuseFrameBuffer ? VIEW_CACHED : VIEW_RENDERED;
+
+		cache.viewprojMatrix = shadowView.GetViewprojMatrix();
+		cache.tile = tile;
+		cache.valid = true;
+	}
+}
+
+
 void Renderer::UpdateBindSets()
 {
 	ShaderBindParms* globalParms = renderContext.globalParms;
@@ -605,14 +1412,20 @@ void Renderer::UpdateBuffers()
 #if defined( USE_IMGUI )
 		globals.generic = vec4f( g_imguiControls.heightMapHeight, g_imguiControls.roughness, 0.0f, 0.0f );
 		globals.tonemap = vec4f( g_imguiControls.toneMapColor[ 0 ], g_imguiControls.toneMapColor[ 1 ], g_imguiControls.toneMapColor[ 2 ], g_imguiControls.toneMapColor[ 3 ] );
-		globals.shadowParms = vec4f( 0, ShadowMapWidth, ShadowMapHeight, g_imguiControls.shadowStrength );
+		globals.shadowParms = vec4f( 0, ShadowAtlasSize, ShadowAtlasSize, g_imguiControls.shadowStrength );
 		globals.dof = vec4f( g_imguiControls.dofEnable ? 1.0f : 0.0f, g_imguiControls.dofFocalDepth, g_imguiControls.dofFocalRange, 0.0f );
 #else
 		globals.generic = vec4f( 0.0f, 0.0f, 0.0f, 0.0f );
 		globals.tonemap = vec4f( 1.0f, 1.0f, 1.0f, 1.0f );
-		globals.shadowParms = vec4f( 0, ShadowMapWidth, ShadowMapHeight, 0.5f );
+		globals.shadowParms = vec4f( 0, ShadowAtlasSize, ShadowAtlasSize, 0.5f );
 		globals.dof = vec4f( 0.0f, 0.0f, 0.0f, 0.0f );
 #endif
+		{
+			const viewport_t& viewport = renderViews[ 0 ]->GetViewport();
+			const float scaleX = viewport.width / static_cast<float>( mainColor.GetWidth() );
+			const float scaleY = viewport.height / static_cast<float>( mainColor.GetHeight() );
+			globals.resolutionScale = vec4f( scaleX, scaleY, 1.0f / scaleX, 1.0f / scaleY );
+		}
 		globals.numSamples = vk_GetSampleCount( config.mainColorSubSamples );
 		globals.whiteId = rc.whiteImage->gpuImage->GetId();
 		globals.blackId = rc.blackImage->gpuImage->GetId();
@@ -640,25 +1453,80 @@ void Renderer::UpdateBuffers()
 			viewBuffer.view = view.GetViewMatrix();
 			viewBuffer.proj = view.GetProjMatrix();
 			viewBuffer.dimensions = vec4f( (float)frameSize[ 0 ], (float)frameSize[ 1 ], 1.0f / frameSize[ 0 ], 1.0f / frameSize[ 1 ] );
+
+			const viewport_t& viewport = view.GetViewport();
+			viewBuffer.viewportRect = vec4f( viewport.x / (float)frameSize[ 0 ], viewport.y / (float)frameSize[ 1 ], viewport.width / (float)frameSize[ 0 ], viewport.height / (float)frameSize[ 1 ] );
 			viewBuffer.numLights = view.numLights;
+			viewBuffer.numDirectionalLights = view.numDirectionalLights;
+			viewBuffer.nearClip = std::max( viewport.near, 0.01f );
+			viewBuffer.farClip = std::max( viewport.far, viewBuffer.nearClip * 2.0f );
 		}
 		resources.viewParms.CopyData( &viewBuffer, sizeof( viewBuffer ) );
 	}
 
+	// The fence of this frame slot was waited on, so the counts are complete. Reset them for the next cull.
+	{
+		cullStatsBufferObject_t cullStats[ MaxViews ];
+
+		resources.cullStats.SetPos( 0 );
+		resources.cullStats.CopyFrom( cullStats, sizeof( cullStats ) );
+
+		for ( uint32_t viewIx = 0; viewIx < MaxViews; ++viewIx )
+		{
+			viewDebugData_t& viewDebug = g_renderDebugData.views[ viewIx ];
+			viewDebug.gpuVisibleCount = cullStats[ viewIx ].visible;
+			viewDebug.gpuFrustumCulled = cullStats[ viewIx ].frustumCulled;
+			viewDebug.gpuOcclusionCulled = cullStats[ viewIx ].occlusionCulled;
+		}
+
+		memset( cullStats, 0, sizeof( cullStats ) );
+		resources.cullStats.CopyData( cullStats, sizeof( cullStats ) );
+	}
+
+	// Partitions are sized for the largest view, merged draws never outnumber their objects
+	{
+		uint32_t objectCount = 0;
+		for ( uint32_t viewIx = 0; viewIx < MaxViews; ++viewIx )
+		{
+			const RenderView& view = views[ viewIx ];
+			if ( view.IsCommitted() && ( view.reuseFrameBuffer == false ) ) {
+				objectCount = std::max( objectCount, view.ObjectCount() );
+			}
+		}
+
+		if ( objectCount > resources.surfaceCapacity )
+		{
+			uint32_t surfaceCapacity = resources.surfaceCapacity;
+			while ( surfaceCapacity < objectCount ) {
+				surfaceCapacity *= 2;
+			}
+			CreateSurfaceBuffers( std::min( surfaceCapacity, resources.maxSurfaceCapacity ) );
+		}
+	}
+
 	for ( uint32_t viewIx = 0; viewIx < MaxViews; ++viewIx )
 	{
 		const RenderView& view = views[ viewIx ];
-		if ( view.IsCommitted() == false ) {
+		if ( ( view.IsCommitted() == false ) || view.reuseFrameBuffer ) {
 			continue;
 		}
 		const uint32_t viewId = view.GetViewId();
 
-		static surfaceBufferObject_t surfBuffer[ MaxSurfaces ];
+		// CommitModel() stops adding surfaces at maxSurfaceCapacity, so the view always fits
+		const uint32_t objectCount = view.ObjectCount();
+		const uint32_t drawCount = view.drawCommandOffset[ DRAWPASS_COUNT - 1 ] + view.drawGroup[ DRAWPASS_COUNT - 1 ].Count();
+
+		if ( surfaceStaging.size() < objectCount ) {
+			surfaceStaging.resize( objectCount );
+		}
+		if ( drawCommandStaging.size() < drawCount ) {
+			drawCommandStaging.resize( drawCount );
+		}
+		surfaceBufferObject_t* surfBuffer = surfaceStaging.data();
+		drawCommandBufferObject_t* drawCommands = drawCommandStaging.data();
 
 		for ( uint32_t passIx = 0; passIx < DRAWPASS_COUNT; ++passIx )
 		{
-			assert( view.drawGroup[ passIx ].InstanceCount() < MaxSurfaces );
-
 			if( view.drawGroup[ passIx ].InstanceCount() == 0 ) {
 				continue;
 			}
@@ -669,11 +1537,20 @@ void Renderer::UpdateBuffers()
 			Asset<Image>* envCubeAsset = g_assets.textureLib.Find( "code_assets/hdrEnvmap.img" );
 			const uint32_t envCubeId = envCubeAsset->Get().gpuImage->GetId();
 
-			const drawSurfInstance_t* instances = view.drawGroup[ passIx ].Instances();
 			for ( uint32_t surfIx = 0; surfIx < view.drawGroup[ passIx ].InstanceCount(); ++surfIx )
 			{
 				const uint32_t instanceId = view.drawGroupOffset[ passIx ] + view.drawGroup[ passIx ].InstanceId( surfIx );
-				surfBuffer[ instanceId ].model = instances[ surfIx ].modelMatrix.Transpose();
+				surfBuffer[ instanceId ].model = view.drawGroup[ passIx ].InstanceTransform( surfIx ).Transpose();
+
+				const uint32_t entIx = view.drawGroup[ passIx ].EntityId( surfIx );
+				const vec3f center = entityBounds.Center( entIx );
+				const vec3f extent = entityBounds.Extent( entIx );
+				surfBuffer[ instanceId ].boundsCenter = vec4f( center[ 0 ], center[ 1 ], center[ 2 ], 1.0f );
+				surfBuffer[ instanceId ].boundsExtent = vec4f( extent[ 0 ], extent[ 1 ], extent[ 2 ], 0.0f );
+
+				// Last frame's depth doesn't know where this entity is now
+				const bool moved = ( entityDirty[ entIx ] & ENT_DIRTY_TRANSFORM ) != 0;
+				surfBuffer[ instanceId ].cullFlags = moved ? SURF_CULL_NO_OCCLUSION : SURF_CULL_NONE;
 				
 				if( diffuseIblAsset->IsDefault() == false ) {
 					surfBuffer[ instanceId ].diffuseIblCubeId = diffuseIblCubeId;
@@ -682,17 +1559,42 @@ void Renderer::UpdateBuffers()
 					surfBuffer[ instanceId ].envCubeId = envCubeId;
 				}
 			}
+
+			// Instance counts are filled in by the cull dispatch. The instance range of a command
+			// is its object range, the remap table packs the surviving objects into it.
+			for ( uint32_t surfIx = 0; surfIx < view.drawGroup[ passIx ].Count(); ++surfIx )
+			{
+				const drawSurf_t& surf = view.drawGroup[ passIx ].DrawSurf( surfIx );
+				const surfaceUpload_t& upload = view.drawGroup[ passIx ].SurfUpload( surfIx );
+				const uint32_t drawId = view.drawCommandOffset[ passIx ] + surfIx;
+				const uint32_t objectOffset = view.drawGroupOffset[ passIx ] + surf.objectOffset;
+
+				drawCommandBufferObject_t& cmd = drawCommands[ drawId ];
+				cmd.indexCount = upload.indexCount;
+				cmd.instanceCount = 0;
+				cmd.firstIndex = upload.firstIndex;
+				cmd.vertexOffset = static_cast<int32_t>( upload.vertexOffset );
+				cmd.firstInstance = objectOffset;
+
+				const uint32_t instanceCount = view.drawGroup[ passIx ].InstanceCount( surfIx );
+				for ( uint32_t instanceIx = 0; instanceIx < instanceCount; ++instanceIx ) {
+					surfBuffer[ objectOffset + instanceIx ].drawId = drawId;
+				}
+			}
 		}
 
 		resources.surfParmPartitions[ viewId ].SetPos( 0 );
-		resources.surfParmPartitions[ viewId ].CopyData( surfBuffer, sizeof( surfaceBufferObject_t ) * MaxSurfaces );
+		resources.surfParmPartitions[ viewId ].CopyData( surfBuffer, sizeof( surfaceBufferObject_t ) * objectCount );
+
+		resources.drawCommandPartitions[ viewId ].SetPos( 0 );
+		resources.drawCommandPartitions[ viewId ].CopyData( drawCommands, sizeof( drawCommandBufferObject_t ) * drawCount );
 	}
 
 	resources.materialBuffers.SetPos( 0 );
 	resources.materialBuffers.CopyData( materialBuffer.Ptr(), sizeof( materialBufferObject_t ) * materialBuffer.Count() );
 
 	resources.lightParms.SetPos( 0 );
-	resources.lightParms.CopyData( committedLights.Ptr(), sizeof( lightBufferObject_t ) * MaxLights );
+	resources.lightParms.CopyData( committedLights.Ptr(), sizeof( lightBufferObject_t ) * committedLights.Count() );
 
 	resources.particleBuffer.SetPos( resources.particleBuffer.GetMaxSize() );
 	//state.particleBuffer.CopyData();
@@ -709,6 +1611,10 @@ void Renderer::InitConfig( const renderConfig_t& cfg )
 
 	config = cfg;
 
+	// Zero picks the default count
+	config.shadowCascades = ( cfg.shadowCascades == 0 ) ? DefaultShadowCascades : std::min( std::max( cfg.shadowCascades, 2u ), MaxShadowCascades );
+	config.gpuFrameBudgetMs = ( cfg.gpuFrameBudgetMs > 0.0f ) ? cfg.gpuFrameBudgetMs : DefaultGpuFrameBudgetMs;
+
 	config.mainColorSubSamples = maxSamples;
 }
 
@@ -722,4 +1628,87 @@ void DeviceDebugMenu()
 		ImGui::EndTabItem();
 	}
 #endif
-}
\ No newline at end of file
+}
+
+
+void ViewDebugMenu()
+{
+#if defined( USE_IMGUI )
+	if ( ImGui::BeginTabItem( "Views" ) )
+	{
+		uint32_t patchedCount = 0;
+		uint32_t rebuiltCount = 0;
+		uint32_t occlusionCulledCount = 0;
+		uint32_t renderedShadowCount = 0;
+
+		const char* renderStateNames[] = { "Drawn", "Cached", "Culled" };
+
+		const ImGuiTableFlags tableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+		if ( ImGui::BeginTable( "Views", 12, tableFlags ) )
+		{
+			ImGui::TableSetupColumn( "Id" );
+			ImGui::TableSetupColumn( "Name" );
+			ImGui::TableSetupColumn( "Visible" );
+			ImGui::TableSetupColumn( "Culled" );
+			ImGui::TableSetupColumn( "GPU Visible" );
+			ImGui::TableSetupColumn( "GPU Frustum" );
+			ImGui::TableSetupColumn( "GPU Occluded" );
+			ImGui::TableSetupColumn( "Patched" );
+			ImGui::TableSetupColumn( "Rebuilt" );
+			ImGui::TableSetupColumn( "Dropped" );
+			ImGui::TableSetupColumn( "Arena KB" );
+			ImGui::TableSetupColumn( "Render" );
+			ImGui::TableHeadersRow();
+
+			for ( uint32_t viewIx = 0; viewIx < MaxViews; ++viewIx )
+			{
+				const viewDebugData_t& viewDebug = g_renderDebugData.views[ viewIx ];
+				if ( viewDebug.name == nullptr ) {
+					continue;
+				}
+
+				ImGui::TableNextRow();
+				ImGui::TableSetColumnIndex( 0 );
+				ImGui::Text( "%u", viewIx );
+				ImGui::TableSetColumnIndex( 1 );
+				ImGui::Text( "%s", viewDebug.name );
+				ImGui::TableSetColumnIndex( 2 );
+				ImGui::Text( "%u", viewDebug.visibleCount );
+				ImGui::TableSetColumnIndex( 3 );
+				ImGui::Text( "%u", viewDebug.culledCount );
+				ImGui::TableSetColumnIndex( 4 );
+				ImGui::Text( "%u", viewDebug.gpuVisibleCount );
+				ImGui::TableSetColumnIndex( 5 );
+				ImGui::Text( "%u", viewDebug.gpuFrustumCulled );
+				ImGui::TableSetColumnIndex( 6 );
+				ImGui::Text( "%u", viewDebug.gpuOcclusionCulled );
+				ImGui::TableSetColumnIndex( 7 );
+				ImGui::Text( "%u", viewDebug.patchedCount );
+				ImGui::TableSetColumnIndex( 8 );
+				ImGui::Text( "%u", viewDebug.rebuiltCount );
+				ImGui::TableSetColumnIndex( 9 );
+				ImGui::Text( "%u", viewDebug.droppedCount );
+				ImGui::TableSetColumnIndex( 10 );
+				ImGui::Text( "%4.1f", viewDebug.arenaBytes / 1024.0f );
+				ImGui::TableSetColumnIndex( 11 );
+				ImGui::Text( "%s", renderStateNames[ viewDebug.renderState ] );
+
+				if ( ( viewIx < MaxShadowViews ) && ( viewDebug.renderState == VIEW_RENDERED ) ) {
+					++renderedShadowCount;
+				}
+
+				patchedCount += viewDebug.patchedCount;
+				rebuiltCount += viewDebug.rebuiltCount;
+				occlusionCulledCount += viewDebug.gpuOcclusionCulled;
+			}
+			ImGui::EndTable();
+		}
+		ImGui::Text( "Draw entries patched: %u, rebuilt: %u", patchedCount, rebuiltCount );
+		ImGui::Text( "Occlusion culled: %u", occlusionCulledCount );
+		ImGui::Text( "Shadow views rendered: %u/%u", renderedShadowCount, MaxShadowViews );
+		ImGui::Text( "Shadow atlas used: %3.0f%%", 100.0f * g_renderDebugData.shadowAtlasUsage );
+		ImGui::SliderInt( "Hi-Z Debug Level", &g_imguiControls.hiZDebugLevel, -1, MaxHiZLevels - 1 );
+		ImGui::EndTabItem();
+	}
+#endif
+}
@@ -29,11 +29,13 @@
 #include "../globals/renderConstants.h"
 #include "../globals/renderview.h"
 #include "../globals/postEffect.h"
+#include "../globals/resolutionScale.h"
 
 #include "../render_state/cmdContext.h"
 #include "../render_binding/bufferObjects.h"
 #include "../render_core/RenderTask.h"
 #include "../render_core/renderResource.h"
+#include "../app/jobSystem.h"
 
 class Window;
 class SwapChain;
@@ -65,6 +67,38 @@ struct renderConfig_t
 	bool			screenshot;
 	bool			gaussianBlur;
 	bool			shadows;
+	bool			gpuCulling;
+	bool			occlusionCulling;
+	uint32_t		shadowCascades;
+	bool			dynamicResolution;
+	bool			softwareDevice;			// Run on a CPU Vulkan device, e.g. lavapipe
+	bool			logPipelineTimes;		// Print pipeline build and prewarm results to the console
+	float			gpuFrameBudgetMs;		// Dynamic resolution target, zero picks the default
+	std::string		pipelineManifest;		// Prewarmed on load and rewritten on shutdown, empty to disable
+};
+
+
+enum entityDirtyFlags_t : uint8_t
+{
+	ENT_DIRTY_NONE			= 0,
+	ENT_DIRTY_TRANSFORM		= ( 1 << 0 ),
+	ENT_DIRTY_MATERIAL		= ( 1 << 1 ),	// Material or model handle changed
+	ENT_DIRTY_FLAGS			= ( 1 << 2 ),	// Render flags or outline changed
+	ENT_DIRTY_VISIBILITY	= ( 1 << 3 ),	// Hidden state changed
+	ENT_DIRTY_ALL			= 0xFF,
+};
+
+
+// Last committed state of an entity, used to find what changed since the previous frame
+struct entityCommitState_t
+{
+	uint32_t		generation;		// Entity generation the state was committed in, zero before the first commit
+	mat4x4f			matrix;
+	hdl_t			modelHdl;
+	hdl_t			materialHdl;
+	uint32_t		flags;
+	bool			outline;
+	bool			hidden;
 };
 
 
@@ -96,6 +130,7 @@ public:
 	AllocatorMemory			localMemory;
 	AllocatorMemory			frameBufferMemory;
 	AllocatorMemory			sharedMemory;
+	AllocatorMemory			surfaceMemory;	// Backs the per view surface and draw buffers, recreated when they grow
 
 	ShaderBindParms*		RegisterBindParm( const ShaderBindSet* set );
 	ShaderBindParms*		RegisterBindParm( const uint64_t setId );
@@ -133,6 +168,12 @@ class ResourceContext
 public:
 	GpuBuffer				globalConstants;
 	GpuBuffer				surfParms;
+	GpuBuffer				drawRemap;
+	GpuBuffer				drawCommands;
+	GpuBuffer				cullStats;
+	GpuBuffer				clusterLights;
+	GpuBuffer				hiZPyramid;	// Written by HiZTask
+	GpuBuffer				hiZParms;
 	GpuBuffer				materialBuffers;
 	GpuBuffer				lightParms;
 	GpuBuffer				particleBuffer;
@@ -155,13 +196,18 @@ public:
 	ImageView				depthImageView;
 	ImageView				stencilImageView;
 	GpuBufferView			surfParmPartitions[ MaxViews ]; // "View" is used in two ways here: view of data, and view of scene
+	GpuBufferView			drawRemapPartitions[ MaxViews ];
+	GpuBufferView			drawCommandPartitions[ MaxViews ];
+	GpuBufferView			clusterLightPartitions[ MaxViews ];
+	uint32_t				surfaceCapacity = 0;	// Objects per view partition of the surface and draw buffers
+	uint32_t				maxSurfaceCapacity = 0;	// Largest partition the device can bind as one storage buffer range
 
 	// Code images
 	std::vector<ImageView>	mainColorResolvedImageViews;
 	std::vector<ImageView>	blurredImageViews;
 	ImageView				depthResolvedImageView;
 	ImageView				stencilResolvedImageView;
-	Image					shadowMapImage[ MaxShadowViews ];
+	Image					shadowAtlasImage;
 	Image					mainColorResolvedImage;
 	Image					blurredImage;
 	Image					tempColorImage;
@@ -169,8 +215,8 @@ public:
 	Image					depthStencilResolvedImage;
 
 	// Data images
-	ImageArray				gpuImages2D;
-	ImageArray				gpuImagesCube;
+	ImageTable				gpuImages2D;
+	ImageTable				gpuImagesCube;
 };
 
 
@@ -186,14 +232,19 @@ public:
 
 	void								InitGPU();
 	void								ShutdownGPU();
+	void								SetPipelineManifest( const std::string& path );
 	void								Resize();
+	void								ReleaseTexture( const hdl_t texHdl );
 
 private:
 	using committedLightsArray_t	= Array<lightBufferObject_t, MaxLights>;
 	using materialBufferArray_t		= Array<materialBufferObject_t, MaxMaterials>;
 
-	static const uint32_t				ShadowMapWidth = 1024;
-	static const uint32_t				ShadowMapHeight = 1024;
+	static const uint32_t				ShadowAtlasSize = 2048;
+	static const uint32_t				ShadowTileMaxSize = 1024;
+	static const uint32_t				ShadowTileMinSize = 128;
+	static const uint32_t				DefaultShadowCascades = 3;
+	static constexpr float				DefaultGpuFrameBudgetMs = 16.0f;
 	static const uint32_t				OutlineStencilBit = 0x01;
 
 	renderConfig_t						config;
@@ -202,15 +253,28 @@ private:
 	RenderView*							renderViews[ Max3DViews ];
 	RenderView*							shadowViews[ MaxShadowViews ];
 	RenderView*							view2Ds[ Max2DViews ];
-	ImageProcess*						resolve = nullptr;
 	std::vector<ImageProcess*>			pingPongQueue;
 	uint32_t							viewCount;
 	uint32_t							activeViewCount;
 
 	RenderSchedule						schedule;
+	JobSystem							jobs;
+	JobSystem							pipelineJobs;			// Separate pool so waiting on frame jobs never runs a compile
+	JobCounter							pipelineCompileJobs;
+	std::set<uint64_t>					featurePrograms;		// Programs whose pixel shader reads MaterialFeaturesSpecId
+	CullBounds							entityBounds;
+	std::vector<entityCommitState_t>	entityStates;
+	uint32_t							entityGeneration = 1;	// Bumped when the scene's entities are replaced, retires every commit state
+	std::vector<uint8_t>				entityDirty;
+	uint8_t								entityDirtyMask = ENT_DIRTY_NONE;
+	bool								forceDrawGroupRebuild = true;
+	ResolutionScaleController			resolutionScale;
+	bool								gpuTimestampsWritten[ MaxFrameStates ] = {};
 
 	// Timers
 	Timer								frameTimer;
+	Timer								commitTimer;
+	Timer								pipelineBuildTimer;
 	uint32_t							m_frameNumber = 0;
 
 	// Upload management
@@ -218,7 +282,18 @@ private:
 	std::set<hdl_t>						updateTextures;
 	std::set<hdl_t>						uploadMaterials;
 
+	// Texture table slots, shared by the 2D and cube tables
+	struct retiredImage_t
+	{
+		GpuImage*	gpuImage;
+		int			slot;
+		uint32_t	frameNumber;
+	};
 	uint32_t							imageFreeSlot = 0;
+	std::vector<int>					releasedImageSlots;
+	std::set<hdl_t>						unslottedTextures;	// Found the tables full, sampled as white until a slot is released
+	std::unordered_map<uint64_t, bool>	textureAlphaMasks;	// Has texels the alpha test discards, see ClassifyAlphaMask()
+	std::vector<retiredImage_t>			retiredImages;
 	
 	// Render context
 	RenderContext						renderContext;
@@ -234,17 +309,38 @@ private:
 	GpuBuffer							textureStagingBuffer;
 	materialBufferArray_t				materialBuffer;
 	committedLightsArray_t				committedLights;
+	std::vector<surfaceBufferObject_t>	surfaceStaging;
+	std::vector<drawCommandBufferObject_t>	drawCommandStaging;
 
-	FrameBuffer							shadowMap[ MaxShadowMaps ];
+	FrameBuffer							shadowAtlas;
 	FrameBuffer							mainColor;
 	FrameBuffer							cubeMapFrameBuffer[ 6 ];
 	FrameBuffer							diffuseIblFrameBuffer[ 6 ];
 	FrameBuffer							specularIblFrameBuffer[ 6 ];
-	FrameBuffer							mainColorResolved;
 	std::vector<FrameBuffer>			blurredImageFrameBuffers;
 	FrameBuffer							tempColor;
 
 	uint32_t							shadowCount = 0;
+	uint32_t							shadowLightIx[ MaxShadowViews ] = {};
+
+	// Directional lights split the main view into cascades, each drawn by an orthographic shadow view
+	struct shadowCascade_t
+	{
+		vec3f							lightDir;
+		vec3f							center;
+		float							radius;
+		bool							active;
+	};
+	shadowCascade_t						shadowCascades[ MaxShadowViews ] = {};
+
+	// Last rendered state of each shadow map, so unchanged shadow views can be skipped
+	struct shadowCacheState_t
+	{
+		mat4x4f							viewprojMatrix;
+		viewport_t						tile;
+		bool							valid;
+	};
+	shadowCacheState_t					shadowCache[ MaxShadowViews ] = {};
 
 	// Init/Shutdown
 	void								InitApi( const renderConfig_t& cfg );
@@ -256,18 +352,34 @@ private:
 	void								ShutdownShaderResources();
 	void								Destroy();
 	void								RecreateSwapChain();
+	void								RecreateFramebuffers();
+	void								CreateFrameResources( const int width, const int height );
 
 	// API Resource Functions
 	void								CreateSyncObjects();
 	void								CreateFramebuffers();
+	void								CreateSurfaceBuffers( const uint32_t surfaceCapacity );
+	bool								MainPassResolves() const;
 
 	// Draw Frame
-	void								CommitModel( RenderView& view, const Entity& ent );
+	bool								CommitModelResources( const Entity& ent );
+	uint8_t								CommitEntityState( const uint32_t entIx, const Entity& ent );
+	void								CommitModel( RenderView& view, const Entity& ent, const uint32_t entIx );
+	float								LodRadius( RenderView& view, const uint32_t entIx ) const;
+	uint8_t								SelectLod( const RenderView& view, const float projectedRadius, const uint32_t uploadId ) const;
+	void								CommitDrawGroups( RenderView& view, const Scene* scene, const bool rebuild );
 	void								WaitForEndFrame();
 	void								SubmitFrame();
+	float								ReadGpuFrameTime() const;
+	void								ApplyResolutionScale();
 
 	void								CommitViews( const Scene* scene );
 	void								CommitLight( const light_t& light );
+	void								CommitShadowCascades( const light_t& light, lightBufferObject_t& lightObject );
+	void								SetCascadeView( const uint32_t shadowIx );
+	void								CullShadowViews();
+	void								AllocateShadowTiles();
+	void								UpdateShadowCache();
 
 	// Update/Upload
 	void								BeginUploadCommands( UploadContext& uploadContext );
@@ -277,10 +389,18 @@ private:
 	void								UploadAssets();
 	void								UpdateTextureData();
 	void								UploadTextures();
+	int									AllocImageSlot();
+	void								ClassifyAlphaMask( const hdl_t texHdl );
+	void								RequeueMaterials( const std::set<hdl_t>& textures );
+	void								DestroyRetiredImages( const bool flush );
 	void								UpdateGpuMaterials();
 	void								UploadModelsToGPU();
 	void								UpdateBindSets();
 	void								UpdateBuffers();
 	void								UpdateFrameDescSet();
-	void								BuildPipelines();
+	void								BuildPipelines( const bool waitForCompiles = false );
+	void								QueueProgramPipelines( const std::vector< Asset<GpuProgram>* >& invalidAssets );
+	materialFeatureBits_t				MaterialFeatures( const Material& material ) const;
+	void								SwapBuiltPipelines();
+	void								PrewarmPipelines();
 };
\ No newline at end of file
@@ -105,6 +105,9 @@ public:
 		return m_swapChainImage.info.height;
 	}
 
+	// The frame buffer is a resize resource, it is remade when the others are without a new swap chain
+	void CreateFrameBuffer();
+
 	void WaitOnFlip( GpuSemaphore& signalSemaphore );
 
 	bool Present( GfxContext& context );
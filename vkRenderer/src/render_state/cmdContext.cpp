@@ -69,6 +69,27 @@ void CommandContext::End()
 }
 
 
+void SecondaryContext::Begin( VkRenderPass renderPass, VkFramebuffer framebuffer )
+{
+	vkResetCommandBuffer( CommandBuffer(), 0 );
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{ };
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = framebuffer;
+
+	VkCommandBufferBeginInfo beginInfo{ };
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	VK_CHECK_RESULT( vkBeginCommandBuffer( CommandBuffer(), &beginInfo ) );
+
+	isOpen = true;
+}
+
+
 void CommandContext::Create( const char* name, RenderContext* renderContext )
 {
 	m_renderContext = renderContext;
@@ -88,7 +109,7 @@ void CommandContext::Create( const char* name, RenderContext* renderContext )
 		VkCommandBufferAllocateInfo allocInfo{ };
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.commandPool = commandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.level = level;
 		allocInfo.commandBufferCount = static_cast<uint32_t>( MaxFrameStates );
 
 		VK_CHECK_RESULT( vkAllocateCommandBuffers( context.device, &allocInfo, commandBuffers ) );
@@ -95,6 +95,9 @@ class CommandContext
 protected:
 	pipelineQueue_t				queueType;
 	bool						isOpen;
+#ifdef USE_VULKAN
+	VkCommandBufferLevel		level;
+#endif
 
 private:
 	std::vector<GpuSemaphore*>	waitSemaphores;
@@ -116,6 +119,7 @@ public:
 
 		queueType = QUEUE_UNKNOWN;
 		isOpen = false;
+		level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 #endif
 	}
 #ifdef USE_VULKAN
@@ -160,6 +164,30 @@ public:
 };
 
 
+// Records draws inside a render pass begun by a primary context. Each recording thread
+// must use its own context, the command pool is not shared.
+class SecondaryContext : public CommandContext
+{
+private:
+	using CommandContext::Begin;
+	using CommandContext::Submit;
+	using CommandContext::Dispatch;
+
+public:
+	SecondaryContext()
+	{
+		queueType = QUEUE_GRAPHICS;
+#ifdef USE_VULKAN
+		level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+#endif
+	}
+
+#ifdef USE_VULKAN
+	void						Begin( VkRenderPass renderPass, VkFramebuffer framebuffer );
+#endif
+};
+
+
 class ComputeContext : public CommandContext
 {
 public:
@@ -68,7 +68,10 @@ bool vk_IsDeviceSuitable( VkPhysicalDevice device, VkSurfaceKHR surface,  const
 	VkPhysicalDeviceFeatures supportedFeatures;
 	vkGetPhysicalDeviceFeatures( device, &supportedFeatures );
 
-	return indices.IsComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+	// Indirect draws are issued per state bucket, each command points at its own instance range
+	const bool indirectSupported = supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance;
+
+	return indices.IsComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy && indirectSupported;
 }
 
 
@@ -830,6 +833,37 @@ VkShaderModule vk_CreateShaderModule( const std::vector<char>& code )
 }
 
 
+// Scans the module's decorations for "OpDecorate %x SpecId specId"
+bool vk_HasSpecConstant( const std::vector<char>& code, const uint32_t specId )
+{
+	const uint32_t OpDecorate = 71;
+	const uint32_t DecorationSpecId = 1;
+	const uint32_t HeaderWordCount = 5;
+
+	const uint32_t* words = reinterpret_cast<const uint32_t*>( code.data() );
+	const uint32_t wordCount = static_cast<uint32_t>( code.size() / sizeof( uint32_t ) );
+
+	uint32_t wordIx = HeaderWordCount;
+	while ( wordIx < wordCount )
+	{
+		const uint32_t opCode = words[ wordIx ] & 0xFFFF;
+		const uint32_t opWordCount = words[ wordIx ] >> 16;
+		if ( opWordCount == 0 ) {
+			break;
+		}
+
+		if ( ( opCode == OpDecorate ) && ( opWordCount >= 4 ) && ( wordIx + 3 < wordCount ) )
+		{
+			if ( ( words[ wordIx + 2 ] == DecorationSpecId ) && ( words[ wordIx + 3 ] == specId ) ) {
+				return true;
+			}
+		}
+		wordIx += opWordCount;
+	}
+	return false;
+}
+
+
 VkResult vk_CreateDebugUtilsMessengerEXT( VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger )
 {
 	auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr( instance, "vkCreateDebugUtilsMessengerEXT" );
@@ -1047,6 +1081,15 @@ void DeviceContext::Create( Window& window )
 
 		for ( const auto& device : devices )
 		{
+			if ( preferSoftwareDevice )
+			{
+				VkPhysicalDeviceProperties properties;
+				vkGetPhysicalDeviceProperties( device, &properties );
+				if ( properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU ) {
+					continue;
+				}
+			}
+
 			if ( vk_IsDeviceSuitable( device, window.vk_surface, deviceExtensions ) )
 			{
 				vkGetPhysicalDeviceProperties( device, &deviceProperties );
@@ -1056,6 +1099,10 @@ void DeviceContext::Create( Window& window )
 			}
 		}
 
+		if ( ( physicalDevice == VK_NULL_HANDLE ) && preferSoftwareDevice ) {
+			throw std::runtime_error( "Failed to find a suitable software device!" );
+		}
+
 		if ( physicalDevice == VK_NULL_HANDLE ) {
 			throw std::runtime_error( "Failed to find a suitable GPU!" );
 		}
@@ -1092,6 +1139,8 @@ void DeviceContext::Create( Window& window )
 		deviceFeatures.fillModeNonSolid = VK_TRUE;
 		deviceFeatures.sampleRateShading = VK_TRUE;
 		deviceFeatures.pipelineStatisticsQuery = VK_TRUE;
+		deviceFeatures.multiDrawIndirect = VK_TRUE;
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
 		createInfo.pEnabledFeatures = &deviceFeatures;
 
 		std::vector<const char*> enabledExtensions;
@@ -1118,9 +1167,42 @@ void DeviceContext::Create( Window& window )
 			createInfo.enabledLayerCount = 0;
 		}
 
+		// Texture tables leave unused slots unwritten and take new textures while sets are bound
+		VkPhysicalDeviceDescriptorIndexingFeatures supportedIndexing{ };
+		supportedIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures{ };
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &supportedIndexing;
+		vkGetPhysicalDeviceFeatures2( physicalDevice, &supportedFeatures );
+
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{ };
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties{ };
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexingProperties;
+		vkGetPhysicalDeviceProperties2( physicalDevice, &properties );
+
+		bindlessPartiallyBound = ( supportedIndexing.descriptorBindingPartiallyBound == VK_TRUE );
+		bindlessUpdateAfterBind = ( supportedIndexing.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE );
+
+		uint32_t stageImageLimit = deviceProperties.limits.maxPerStageDescriptorSampledImages;
+		uint32_t setImageLimit = deviceProperties.limits.maxDescriptorSetSampledImages;
+		if ( bindlessUpdateAfterBind )
+		{
+			stageImageLimit = indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages;
+			setImageLimit = indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages;
+		}
+		const uint32_t imageLimit = Min( stageImageLimit, setImageLimit );
+		const uint32_t tableLimit = ( imageLimit > BindlessReservedImages ) ? ( imageLimit - BindlessReservedImages ) / BindlessTableCount : 1;
+		bindlessImageCount = Min( MaxBindlessImages, tableLimit );
+
 		VkPhysicalDeviceDescriptorIndexingFeatures descIndexing;
 		memset( &descIndexing, 0, sizeof( VkPhysicalDeviceDescriptorIndexingFeatures ) );
 		descIndexing.runtimeDescriptorArray = true;
+		descIndexing.descriptorBindingPartiallyBound = bindlessPartiallyBound;
+		descIndexing.descriptorBindingSampledImageUpdateAfterBind = bindlessUpdateAfterBind;
 		descIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
 		descIndexing.pNext = NULL;
 		createInfo.pNext = &descIndexing;
@@ -1230,7 +1312,7 @@ void DeviceContext::Create( Window& window )
 		poolSizes[ 1 ].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 		poolSizes[ 1 ].descriptorCount = DescriptorPoolMaxStorageBuffers;
 		poolSizes[ 2 ].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[ 2 ].descriptorCount = DescriptorPoolMaxComboImages;
+		poolSizes[ 2 ].descriptorCount = DescriptorPoolMaxComboImages + ( BindlessTableCount * MaxFrameStates * bindlessImageCount );
 		poolSizes[ 3 ].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
 		poolSizes[ 3 ].descriptorCount = DescriptorPoolMaxImages;
 
@@ -1240,6 +1322,7 @@ void DeviceContext::Create( Window& window )
 		poolInfo.pPoolSizes = poolSizes;
 		poolInfo.maxSets = DescriptorPoolMaxSets;
 		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		poolInfo.flags |= bindlessUpdateAfterBind ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0;
 
 		VK_CHECK_RESULT( vkCreateDescriptorPool( device, &poolInfo, nullptr, &descriptorPool ) );
 	}
@@ -1301,6 +1384,12 @@ void DeviceContext::Destroy( Window& window )
 
 	vkDestroyDescriptorPool( device, descriptorPool, nullptr );
 
+	if ( pipelineCache != VK_NULL_HANDLE )
+	{
+		vkDestroyPipelineCache( device, pipelineCache, nullptr );
+		pipelineCache = VK_NULL_HANDLE;
+	}
+
 	vkDestroyDevice( device, nullptr );
 
 	if ( EnableValidationLayers )
@@ -82,6 +82,7 @@ public:
 	VkPhysicalDeviceFeatures			deviceFeatures;
 	VkDebugUtilsMessengerEXT			debugMessenger;
 	VkDescriptorPool					descriptorPool;
+	VkPipelineCache						pipelineCache = VK_NULL_HANDLE;	// Seeded from and saved to disk, see LoadVkPipelineCacheBlob()
 	VkQueryPool							statQueryPool;
 	VkQueryPool							timestampQueryPool;
 	VkQueryPool							occlusionQueryPool;
@@ -91,6 +92,10 @@ public:
 	VkSampler							bilinearSampler[ 3 ];
 	VkSampler							depthShadowSampler;
 	uint32_t							queueFamilyIndices[ QUEUE_COUNT ];
+	uint32_t							bindlessImageCount = MaxImageDescriptors;	// Slots per texture table, see ImageTable
+	bool								bindlessPartiallyBound = false;
+	bool								bindlessUpdateAfterBind = false;
+	bool								preferSoftwareDevice = false;	// Pick a CPU device such as lavapipe, to check indirect draws without a GPU
 
 	bool								debugMarkersEnabled = false;
 	PFN_vkDebugMarkerSetObjectTagEXT	fnDebugMarkerSetObjectTag = VK_NULL_HANDLE;
@@ -144,6 +149,7 @@ void				vk_CopyImage( VkCommandBuffer cmdBuffer, const ImageView& src, ImageView
 void				vk_CopyBufferToImage( VkCommandBuffer cmdBuffer, Image* texture, const copyImageParms_t& copyParms, GpuBuffer& buffer, const uint64_t bufferOffset );
 imageSamples_t		vk_MaxImageSamples();
 VkShaderModule		vk_CreateShaderModule( const std::vector<char>& code );
+bool				vk_HasSpecConstant( const std::vector<char>& code, const uint32_t specId );
 VkResult			vk_CreateDebugUtilsMessengerEXT( VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger );
 void				vk_MarkerSetObjectTag( uint64_t object, VkDebugReportObjectTypeEXT objectType, uint64_t name, size_t tagSize, const void* tag );
 void				vk_MarkerSetObjectName( uint64_t object, VkDebugReportObjectTypeEXT objectType, const char* name );
\ No newline at end of file
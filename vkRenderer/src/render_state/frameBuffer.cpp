@@ -25,6 +25,9 @@ struct vk_RenderPassBits_t
 			renderAttachmentBits_t		attachmentBits;
 			renderTransitionBits_t		transitionBits;
 			renderPassAttachmentMask_t	attachmentMask; // Mask for which attachments are used
+			renderPassAttachmentBits_t	resolveBits;
+			renderPassAttachmentBits_t	depthResolveBits;
+			renderPassAttachmentMask_t	discardMask; // Mask for attachments that aren't stored
 		} semantic;
 		uint8_t bytes[ VkPassBitsSize ];
 	};
@@ -46,6 +49,14 @@ struct renderPassTuple_t
 
 static std::unordered_map<uint64_t, renderPassTuple_t> renderPassCache;
 
+
+static inline VkAttachmentStoreOp vk_GetStoreOp( const vk_RenderPassBits_t& passState, const renderPassTransition_t& transition, const renderPassAttachmentMask_t attachment )
+{
+	const bool discard = ( passState.semantic.discardMask & attachment ) != 0;
+	return ( transition.flags.store && !discard ) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+}
+
+
 VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 {
 	const uint64_t passHash = Hash( passState.bytes, VkPassBitsSize );
@@ -58,18 +69,30 @@ VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 
 	VkRenderPass pass = VK_NULL_HANDLE;
 
-	VkAttachmentReference colorAttachmentRef[ 3 ] = { };
-	VkAttachmentReference dsAttachmentRef{ };
+	VkAttachmentReference2 colorAttachmentRef[ 3 ] = { };
+	VkAttachmentReference2 resolveAttachmentRef[ 3 ] = { };
+	VkAttachmentReference2 dsAttachmentRef{ };
+	VkAttachmentReference2 dsResolveAttachmentRef{ };
 
 	uint32_t count = 0;
 	uint32_t colorCount = 0;
 
-	colorAttachmentRef[ 0 ].attachment = VK_ATTACHMENT_UNUSED;
-	colorAttachmentRef[ 1 ].attachment = VK_ATTACHMENT_UNUSED;
-	colorAttachmentRef[ 2 ].attachment = VK_ATTACHMENT_UNUSED;
+	for ( uint32_t i = 0; i < 3; ++i )
+	{
+		colorAttachmentRef[ i ].sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+		colorAttachmentRef[ i ].attachment = VK_ATTACHMENT_UNUSED;
+		resolveAttachmentRef[ i ].sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+		resolveAttachmentRef[ i ].attachment = VK_ATTACHMENT_UNUSED;
+	}
+	dsAttachmentRef.sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
 	dsAttachmentRef.attachment = VK_ATTACHMENT_UNUSED;
+	dsResolveAttachmentRef.sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+	dsResolveAttachmentRef.attachment = VK_ATTACHMENT_UNUSED;
 
-	VkAttachmentDescription attachments[ 5 ] = {};
+	VkAttachmentDescription2 attachments[ 7 ] = {};
+	for ( uint32_t i = 0; i < 7; ++i ) {
+		attachments[ i ].sType = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2;
+	}
 
 	if ( ( passState.semantic.attachmentMask & RENDER_PASS_MASK_COLOR0 ) != 0 )
 	{
@@ -81,7 +104,7 @@ VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 		}
 		attachments[ count ].samples = vk_GetSampleCount( passState.semantic.attachmentBits.color0.samples );
 		attachments[ count ].loadOp = passState.semantic.transitionBits.colorTrans0.flags.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
-		attachments[ count ].storeOp = passState.semantic.transitionBits.colorTrans0.flags.store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[ count ].storeOp = vk_GetStoreOp( passState, passState.semantic.transitionBits.colorTrans0, RENDER_PASS_MASK_COLOR0 );
 		attachments[ count ].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachments[ count ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
@@ -112,7 +135,7 @@ VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 		attachments[ count ].format = vk_GetTextureFormat( passState.semantic.attachmentBits.color1.fmt );
 		attachments[ count ].samples = vk_GetSampleCount( passState.semantic.attachmentBits.color1.samples );
 		attachments[ count ].loadOp = passState.semantic.transitionBits.colorTrans1.flags.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
-		attachments[ count ].storeOp = passState.semantic.transitionBits.colorTrans1.flags.store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[ count ].storeOp = vk_GetStoreOp( passState, passState.semantic.transitionBits.colorTrans1, RENDER_PASS_MASK_COLOR1 );
 		attachments[ count ].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachments[ count ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
@@ -139,7 +162,7 @@ VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 		attachments[ count ].format = vk_GetTextureFormat( passState.semantic.attachmentBits.color2.fmt );
 		attachments[ count ].samples = vk_GetSampleCount( passState.semantic.attachmentBits.color2.samples );
 		attachments[ count ].loadOp = passState.semantic.transitionBits.colorTrans2.flags.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
-		attachments[ count ].storeOp = passState.semantic.transitionBits.colorTrans2.flags.store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[ count ].storeOp = vk_GetStoreOp( passState, passState.semantic.transitionBits.colorTrans2, RENDER_PASS_MASK_COLOR2 );
 		attachments[ count ].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachments[ count ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
@@ -168,9 +191,9 @@ VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 		attachments[ count ].format = vk_GetTextureFormat( passState.semantic.attachmentBits.depth.fmt );
 		attachments[ count ].samples = vk_GetSampleCount( passState.semantic.attachmentBits.depth.samples );
 		attachments[ count ].loadOp = passState.semantic.transitionBits.depthTrans.flags.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
-		attachments[ count ].storeOp = passState.semantic.transitionBits.depthTrans.flags.store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[ count ].storeOp = vk_GetStoreOp( passState, passState.semantic.transitionBits.depthTrans, RENDER_PASS_MASK_DEPTH );
 		attachments[ count ].stencilLoadOp = passState.semantic.transitionBits.depthTrans.flags.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
-		attachments[ count ].stencilStoreOp = passState.semantic.transitionBits.depthTrans.flags.store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[ count ].stencilStoreOp = vk_GetStoreOp( passState, passState.semantic.transitionBits.depthTrans, RENDER_PASS_MASK_STENCIL );
 		
 		if ( passState.semantic.transitionBits.depthTrans.flags.readOnly ) {
 			attachments[ count ].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
@@ -200,7 +223,7 @@ VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 		attachments[ count ].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachments[ count ].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		attachments[ count ].stencilLoadOp = passState.semantic.transitionBits.stencilTrans.flags.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
-		attachments[ count ].stencilStoreOp = passState.semantic.transitionBits.stencilTrans.flags.store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[ count ].stencilStoreOp = vk_GetStoreOp( passState, passState.semantic.transitionBits.stencilTrans, RENDER_PASS_MASK_STENCIL );
 		
 		if ( passState.semantic.transitionBits.stencilTrans.flags.readOnly ) {
 			attachments[ count ].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
@@ -218,20 +241,96 @@ VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState )
 		++count;
 	}
 
-	VkSubpassDescription subpass{ };
+	// Resolve targets come last so clear values still line up with the attachments above.
+	// Their previous contents are never loaded, the resolve overwrites the whole render area.
+	if ( ( passState.semantic.attachmentMask & RENDER_PASS_MASK_RESOLVE0 ) != 0 )
+	{
+		assert( ( passState.semantic.attachmentMask & RENDER_PASS_MASK_COLOR0 ) != 0 );
+
+		attachments[ count ].format = vk_GetTextureFormat( passState.semantic.resolveBits.fmt );
+		attachments[ count ].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[ count ].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[ count ].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[ count ].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[ count ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		if ( passState.semantic.transitionBits.colorTrans0.flags.readOnly ) {
+			attachments[ count ].initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		} else {
+			attachments[ count ].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		}
+
+		if ( passState.semantic.transitionBits.colorTrans0.flags.readAfter ) {
+			attachments[ count ].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		} else {
+			attachments[ count ].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		}
+
+		resolveAttachmentRef[ 0 ].attachment = count;
+		resolveAttachmentRef[ 0 ].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		++count;
+	}
+
+	VkSubpassDescriptionDepthStencilResolve dsResolve{ };
+	dsResolve.sType = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_DEPTH_STENCIL_RESOLVE;
+
+	if ( ( passState.semantic.attachmentMask & RENDER_PASS_MASK_DEPTH_RESOLVE ) != 0 )
+	{
+		assert( ( passState.semantic.attachmentMask & RENDER_PASS_MASK_DEPTH ) != 0 );
+
+		attachments[ count ].format = vk_GetTextureFormat( passState.semantic.depthResolveBits.fmt );
+		attachments[ count ].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[ count ].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[ count ].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[ count ].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[ count ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+		if ( passState.semantic.transitionBits.depthTrans.flags.readOnly ) {
+			attachments[ count ].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		} else {
+			attachments[ count ].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		}
+
+		if ( passState.semantic.transitionBits.depthTrans.flags.readAfter ) {
+			attachments[ count ].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		} else {
+			attachments[ count ].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		}
+
+		dsResolveAttachmentRef.attachment = count;
+		dsResolveAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		// Sample zero is the only mode every device has to support for both aspects
+		dsResolve.depthResolveMode = VK_RESOLVE_MODE_SAMPLE_ZERO_BIT;
+		dsResolve.stencilResolveMode = VK_RESOLVE_MODE_SAMPLE_ZERO_BIT;
+		dsResolve.pDepthStencilResolveAttachment = &dsResolveAttachmentRef;
+
+		++count;
+	}
+
+	VkSubpassDescription2 subpass{ };
+	subpass.sType = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2;
 	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 	subpass.colorAttachmentCount = colorCount;
 	subpass.pColorAttachments = colorAttachmentRef;
 	subpass.pDepthStencilAttachment = &dsAttachmentRef;
 
-	VkRenderPassCreateInfo renderPassInfo{ };
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	if ( ( passState.semantic.attachmentMask & RENDER_PASS_MASK_RESOLVE0 ) != 0 ) {
+		subpass.pResolveAttachments = resolveAttachmentRef;
+	}
+	if ( ( passState.semantic.attachmentMask & RENDER_PASS_MASK_DEPTH_RESOLVE ) != 0 ) {
+		subpass.pNext = &dsResolve;
+	}
+
+	VkRenderPassCreateInfo2 renderPassInfo{ };
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO_2;
 	renderPassInfo.attachmentCount = count;
 	renderPassInfo.pAttachments = attachments;
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
 
-	VK_CHECK_RESULT( vkCreateRenderPass( context.device, &renderPassInfo, nullptr, &pass ) );
+	VK_CHECK_RESULT( vkCreateRenderPass2( context.device, &renderPassInfo, nullptr, &pass ) );
 
 	renderPassCache[ passHash ] = renderPassTuple_t{ pass, passState };
 
@@ -273,6 +372,8 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 	m_colorCount += ( createInfo.color2 != nullptr ) ? 1 : 0;
 	m_dsCount += ( createInfo.depth != nullptr ) ? 1 : 0;
 	m_dsCount += ( createInfo.stencil != nullptr ) ? 1 : 0;
+	m_resolveCount += ( createInfo.resolve0 != nullptr ) ? 1 : 0;
+	m_resolveCount += ( createInfo.depthResolve != nullptr ) ? 1 : 0;
 
 	m_attachmentCount = m_colorCount + m_dsCount;
 
@@ -282,6 +383,8 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 	images[ 2 ] = createInfo.color2;
 	images[ 3 ] = createInfo.depth;
 	images[ 4 ] = createInfo.stencil;
+	images[ 5 ] = createInfo.resolve0;
+	images[ 6 ] = createInfo.depthResolve;
 
 	uint32_t firstValidIx = MaxAttachmentCount;
 	for ( uint32_t imageIx = 0; imageIx < MaxAttachmentCount; ++imageIx ) {
@@ -306,6 +409,16 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 			throw std::runtime_error( "Color attachment 1 has to be used if 2 is." );
 		}
 
+		if ( ( createInfo.resolve0 != nullptr ) && ( ( createInfo.color0 == nullptr ) ||
+			( createInfo.color0->info.subsamples == IMAGE_SMP_1 ) || ( createInfo.resolve0->info.subsamples != IMAGE_SMP_1 ) ) ) {
+			throw std::runtime_error( "Color resolve needs a multisampled color attachment 0 and a single-sampled target." );
+		}
+
+		if ( ( createInfo.depthResolve != nullptr ) && ( ( createInfo.depth == nullptr ) ||
+			( createInfo.depth->info.subsamples == IMAGE_SMP_1 ) || ( createInfo.depthResolve->info.subsamples != IMAGE_SMP_1 ) ) ) {
+			throw std::runtime_error( "Depth resolve needs a multisampled depth attachment and a single-sampled target." );
+		}
+
 		for ( uint32_t imageIx = firstValidIx + 1; imageIx < MaxAttachmentCount; ++imageIx )
 		{
 			if( images[ imageIx ] == nullptr ) {
@@ -332,6 +445,8 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 
 	// Attachment bits
 	m_attachmentBits = {};
+	renderPassAttachmentBits_t resolveBits = {};
+	renderPassAttachmentBits_t depthResolveBits = {};
 	renderPassAttachmentMask_t mask = RENDER_PASS_MASK_NONE;
 	{
 		if ( createInfo.color0 != nullptr )
@@ -366,6 +481,20 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 			m_attachmentBits.stencil.fmt = createInfo.stencil->info.fmt;
 			mask |= RENDER_PASS_MASK_STENCIL;
 		}
+
+		if ( createInfo.resolve0 != nullptr )
+		{
+			resolveBits.samples = createInfo.resolve0->info.subsamples;
+			resolveBits.fmt = createInfo.resolve0->info.fmt;
+			mask |= RENDER_PASS_MASK_RESOLVE0;
+		}
+
+		if ( createInfo.depthResolve != nullptr )
+		{
+			depthResolveBits.samples = createInfo.depthResolve->info.subsamples;
+			depthResolveBits.fmt = createInfo.depthResolve->info.fmt;
+			mask |= RENDER_PASS_MASK_DEPTH_RESOLVE;
+		}
 	}
 
 	// Initialization
@@ -387,6 +516,9 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 		passBits.semantic.transitionBits.depthTrans = state;
 		passBits.semantic.transitionBits.stencilTrans = state;
 		passBits.semantic.attachmentMask = mask;
+		passBits.semantic.resolveBits = resolveBits;
+		passBits.semantic.depthResolveBits = depthResolveBits;
+		passBits.semantic.discardMask = createInfo.discardMask;
 
 		vk_renderPasses[ permIx ] = vk_CreateRenderPass( passBits );
 		if ( vk_renderPasses[ permIx ] == VK_NULL_HANDLE ) {
@@ -413,12 +545,18 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 			if ( createInfo.stencil != nullptr ) {
 				attachments[ currentAttachment++ ] = createInfo.stencil->gpuImage->GetVkImageView( frameIx );
 			}
-			assert( currentAttachment == m_attachmentCount );
+			if ( createInfo.resolve0 != nullptr ) {
+				attachments[ currentAttachment++ ] = createInfo.resolve0->gpuImage->GetVkImageView( frameIx );
+			}
+			if ( createInfo.depthResolve != nullptr ) {
+				attachments[ currentAttachment++ ] = createInfo.depthResolve->gpuImage->GetVkImageView( frameIx );
+			}
+			assert( currentAttachment == ( m_attachmentCount + m_resolveCount ) );
 
 			VkFramebufferCreateInfo framebufferInfo{ };
 			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 			framebufferInfo.renderPass = vk_renderPasses[ permIx ];
-			framebufferInfo.attachmentCount = m_attachmentCount;
+			framebufferInfo.attachmentCount = m_attachmentCount + m_resolveCount;
 			framebufferInfo.pAttachments = attachments;
 			framebufferInfo.width = images[ firstValidIx ]->info.width;
 			framebufferInfo.height = images[ firstValidIx ]->info.height;
@@ -433,6 +571,8 @@ void FrameBuffer::Create( const frameBufferCreateInfo_t& createInfo )
 		m_color2 = createInfo.color2;
 		m_depth = createInfo.depth;
 		m_stencil = createInfo.stencil;
+		m_resolve0 = createInfo.resolve0;
+		m_depthResolve = createInfo.depthResolve;
 	}
 	m_width = images[ firstValidIx ]->info.width;
 	m_height = images[ firstValidIx ]->info.height;
@@ -467,6 +607,7 @@ void FrameBuffer::Destroy()
 	}
 	m_colorCount = 0;
 	m_dsCount = 0;
+	m_resolveCount = 0;
 	m_attachmentCount = 0;
 	m_bufferCount = 0;
 }
\ No newline at end of file
@@ -42,6 +42,11 @@ struct frameBufferCreateInfo_t
 	Image*				color2;
 	Image*				depth;
 	Image*				stencil;
+	Image*				resolve0;		// Single-sampled target color0 is resolved into when the pass ends
+	Image*				depthResolve;	// Single-sampled target depth-stencil is resolved into (sample zero)
+
+	// Attachments nothing reads after the pass, their contents are dropped instead of stored
+	renderPassAttachmentMask_t	discardMask;
 
 	frameBufferCreateInfo_t() :
 		swapBuffering( swapBuffering_t::SINGLE_FRAME ),
@@ -54,6 +59,10 @@ struct frameBufferCreateInfo_t
 		color2 = nullptr;
 		depth = nullptr;
 		stencil = nullptr;
+		resolve0 = nullptr;
+		depthResolve = nullptr;
+
+		discardMask = RENDER_PASS_MASK_NONE;
 	}
 };
 
@@ -61,18 +70,21 @@ struct frameBufferCreateInfo_t
 class FrameBuffer : public RenderResource
 {
 private:
-	static const uint32_t MaxAttachmentCount = 5;
+	static const uint32_t MaxAttachmentCount = 7;
 
 	Image*						m_color0;
 	Image*						m_color1;
 	Image*						m_color2;
 	Image*						m_depth;
 	Image*						m_stencil;
+	Image*						m_resolve0;
+	Image*						m_depthResolve;
 
 	uint32_t					m_width;
 	uint32_t					m_height;
 	uint32_t					m_colorCount;
 	uint32_t					m_dsCount;
+	uint32_t					m_resolveCount;
 	uint32_t					m_attachmentCount;
 	uint32_t					m_bufferCount;
 
@@ -98,6 +110,7 @@ public:
 		m_bufferCount( 0 ),
 		m_colorCount( 0 ),
 		m_dsCount( 0 ),
+		m_resolveCount( 0 ),
 		m_width( 0 ),
 		m_height( 0 )
 	{
@@ -106,6 +119,8 @@ public:
 		m_color2 = nullptr;
 		m_depth = nullptr;
 		m_stencil = nullptr;
+		m_resolve0 = nullptr;
+		m_depthResolve = nullptr;
 	}
 
 	inline bool IsValid() const
@@ -168,6 +183,16 @@ public:
 		return ( m_dsCount >= 1 ) ? m_stencil : nullptr;
 	}
 
+	inline const Image* GetResolve() const
+	{
+		return m_resolve0;
+	}
+
+	inline const Image* GetDepthResolve() const
+	{
+		return m_depthResolve;
+	}
+
 	inline renderAttachmentBits_t GetAttachmentBits() const
 	{
 		return m_attachmentBits;
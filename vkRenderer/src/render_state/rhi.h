@@ -12,6 +12,8 @@ enum renderPassAttachmentMask_t : uint8_t
 	RENDER_PASS_MASK_COLOR2 = ( 1 << 2 ),
 	RENDER_PASS_MASK_DEPTH = ( 1 << 3 ),
 	RENDER_PASS_MASK_STENCIL = ( 1 << 4 ),
+	RENDER_PASS_MASK_RESOLVE0 = ( 1 << 5 ),
+	RENDER_PASS_MASK_DEPTH_RESOLVE = ( 1 << 6 ),
 };
 DEFINE_ENUM_OPERATORS( renderPassAttachmentMask_t, uint8_t )
 
@@ -56,7 +58,7 @@ static_assert( sizeof( renderPassTransition_t ) == 1, "Bits overflowed" );
 static const uint32_t PassPermBits = 6;
 static const uint32_t PassPermCount = ( 1 << PassPermBits );
 
-static const uint32_t VkPassBitsSize = 16;
+static const uint32_t VkPassBitsSize = 24;
 
 struct vk_RenderPassBits_t;
 VkRenderPass vk_CreateRenderPass( const vk_RenderPassBits_t& passState );
@@ -212,6 +214,8 @@ static VkDescriptorType vk_GetDescriptorType( const bindType_t type )
 		case bindType_t::IMAGE_3D:				return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		case bindType_t::IMAGE_CUBE:			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		case bindType_t::IMAGE_CUBE_ARRAY:		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case bindType_t::IMAGE_2D_TABLE:		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case bindType_t::IMAGE_CUBE_TABLE:		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		case bindType_t::READ_BUFFER:			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 		case bindType_t::WRITE_BUFFER:			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 		case bindType_t::READ_IMAGE_BUFFER:		return VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
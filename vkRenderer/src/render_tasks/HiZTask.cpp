@@ -0,0 +1,182 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "HiZTask.h"
+
+#include <SysCore/systemUtils.h>
+
+#include "../render_binding/gpuResources.h"
+#include "../render_binding/bindings.h"
+
+void HiZTask::Init( const hiZCreateInfo_t& info )
+{
+	m_dbgName = info.name;
+	m_view = info.view;
+	m_context = info.context;
+	m_resources = info.resources;
+	m_enabled = info.enabled;
+	m_valid = false;
+	m_viewMat = mat4x4f( 1.0f );
+	m_projMat = mat4x4f( 1.0f );
+
+	// Fixed size so the pyramid doesn't follow the swap chain, level 0 footprints scale with the depth buffer instead
+	m_levelCount = Min( MipCount( HiZWidth, HiZHeight ), MaxHiZLevels );
+
+	uint32_t texelCount = 0;
+	for ( uint32_t i = 0; i < m_levelCount; ++i )
+	{
+		MipDimensions( i, HiZWidth, HiZHeight, &m_levels[ i ].width, &m_levels[ i ].height );
+		m_levels[ i ].offset = texelCount;
+		texelCount += m_levels[ i ].width * m_levels[ i ].height;
+	}
+
+	m_resources->hiZPyramid.Create( "HiZ Pyramid", swapBuffering_t::SINGLE_FRAME, resourceLifeTime_t::REBOOT, 1, texelCount * sizeof( float ), bufferType_t::STORAGE, m_context->localMemory );
+	m_resources->hiZParms.Create( "HiZ Parms", swapBuffering_t::MULTI_FRAME, resourceLifeTime_t::REBOOT, 1, sizeof( hiZBufferObject_t ), bufferType_t::UNIFORM, m_context->sharedMemory );
+
+	m_parms = m_context->RegisterBindParm( bindset_hiZ );
+
+	// The depth image doesn't exist yet, the variant is picked from its sample count each frame
+	m_singleSampleProgHdl = AssetLibGpuProgram::Handle( "HiZBuild" );
+	m_multiSampleProgHdl = AssetLibGpuProgram::Handle( "HiZBuildMSAA" );
+	m_progHdl = m_singleSampleProgHdl;
+}
+
+
+void HiZTask::FrameBegin()
+{
+	m_progHdl = ( m_resources->depthImageView.info.subsamples == IMAGE_SMP_1 ) ? m_singleSampleProgHdl : m_multiSampleProgHdl;
+
+	m_parms->Bind( bind_hiZSourceImage, &m_resources->depthImageView );
+	m_parms->Bind( bind_hiZPyramidWrite, &m_resources->hiZPyramid );
+
+	// Culling this frame reads the pyramid from the previous one, so it's described with that frame's view
+	hiZBufferObject_t hiZ = {};
+	hiZ.viewMat = m_viewMat;
+	hiZ.projMat = m_projMat;
+	hiZ.dimensions = vec4f( float( HiZWidth ), float( HiZHeight ), 1.0f / HiZWidth, 1.0f / HiZHeight );
+	hiZ.levelCount = m_levelCount;
+	hiZ.valid = ( m_enabled && m_valid ) ? 1 : 0;
+#if defined( USE_IMGUI )
+	hiZ.debugLevel = m_enabled ? g_imguiControls.hiZDebugLevel : -1;
+#else
+	hiZ.debugLevel = -1;
+#endif
+	for ( uint32_t i = 0; i < m_levelCount; ++i ) {
+		hiZ.levelOffsets[ i ] = m_levels[ i ].offset;
+	}
+
+	m_resources->hiZParms.SetPos( 0 );
+	m_resources->hiZParms.CopyData( &hiZ, sizeof( hiZ ) );
+}
+
+
+void HiZTask::FrameEnd()
+{
+
+}
+
+
+uint32_t HiZTask::GetLevelCount() const
+{
+	return m_levelCount;
+}
+
+
+void HiZTask::DeclareResources( RenderGraph& graph )
+{
+	if ( ( m_enabled == false ) || ( m_view->IsCommitted() == false ) ) {
+		return;
+	}
+
+	graph.ReadImage( &m_resources->depthImageView, GRAPH_ACCESS_COMPUTE );
+	graph.WriteBuffer( &m_resources->hiZPyramid, GRAPH_ACCESS_COMPUTE );
+}
+
+
+void HiZTask::Execute( CommandContext& context )
+{
+	if ( ( m_enabled == false ) || ( m_view->IsCommitted() == false ) )
+	{
+		m_valid = false;
+		return;
+	}
+
+	context.MarkerBeginRegion( m_dbgName.c_str(), ColorToVector( ColorWhite ) );
+
+	const VkCommandBuffer cmdBuffer = context.CommandBuffer();
+
+	struct hiZConstants_t
+	{
+		uint32_t	srcOffset;
+		uint32_t	dstOffset;
+		uint32_t	srcWidth;
+		uint32_t	srcHeight;
+		uint32_t	dstWidth;
+		uint32_t	dstHeight;
+		uint32_t	level;
+		uint32_t	numSamples;
+	};
+
+	const uint32_t groupSize = 8;
+	for ( uint32_t i = 0; i < m_levelCount; ++i )
+	{
+		hiZConstants_t constants = {};
+		if ( i == 0 )
+		{
+			// Only the viewport of the main view holds this frame's depth when its resolution is scaled
+			const viewport_t& viewport = m_view->GetViewport();
+			constants.srcWidth = std::min<uint32_t>( viewport.width, m_resources->depthImageView.info.width );
+			constants.srcHeight = std::min<uint32_t>( viewport.height, m_resources->depthImageView.info.height );
+		}
+		else
+		{
+			constants.srcOffset = m_levels[ i - 1 ].offset;
+			constants.srcWidth = m_levels[ i - 1 ].width;
+			constants.srcHeight = m_levels[ i - 1 ].height;
+		}
+		constants.dstOffset = m_levels[ i ].offset;
+		constants.dstWidth = m_levels[ i ].width;
+		constants.dstHeight = m_levels[ i ].height;
+		constants.level = i;
+		constants.numSamples = vk_GetSampleCount( m_resources->depthImageView.info.subsamples );
+
+		context.Dispatch( m_progHdl, *m_parms, &constants, sizeof( constants ), ( constants.dstWidth + groupSize - 1 ) / groupSize, ( constants.dstHeight + groupSize - 1 ) / groupSize, 1 );
+
+		// Each level reads the one before it, readers of the last are ordered by the render graph
+		if ( ( i + 1 ) < m_levelCount )
+		{
+			VkMemoryBarrier barrier{ };
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier( cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+		}
+	}
+
+	m_viewMat = m_view->GetViewMatrix();
+	m_projMat = m_view->GetProjMatrix();
+	m_valid = true;
+
+	context.MarkerEndRegion();
+}
@@ -0,0 +1,83 @@
+/*
+* MIT License
+*
+* Copyright( c ) 2023 Thomas Griebel
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this softwareand associated documentation files( the "Software" ), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions :
+*
+* The above copyright noticeand this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include "../render_core/renderer.h"
+
+struct hiZCreateInfo_t
+{
+	const char*			name;
+	RenderView*			view;
+	RenderContext*		context;
+	ResourceContext*	resources;
+	bool				enabled;
+};
+
+
+// Builds a farthest-depth pyramid from the main view's depth buffer.
+// The next frame's cull dispatch reprojects entity bounds onto it to find occluded draws.
+class HiZTask : public GpuTask
+{
+private:
+	struct hiZLevel_t
+	{
+		uint32_t	width;
+		uint32_t	height;
+		uint32_t	offset;
+	};
+
+	std::string				m_dbgName;
+	RenderView*				m_view;
+	RenderContext*			m_context;
+	ResourceContext*		m_resources;
+	ShaderBindParms*		m_parms;
+	hdl_t					m_progHdl;
+	hdl_t					m_singleSampleProgHdl;
+	hdl_t					m_multiSampleProgHdl;
+	hiZLevel_t				m_levels[ MaxHiZLevels ];
+	uint32_t				m_levelCount;
+	mat4x4f					m_viewMat;	// Main view of the frame the pyramid was last built in
+	mat4x4f					m_projMat;
+	bool					m_enabled;
+	bool					m_valid;
+
+	void Init( const hiZCreateInfo_t& info );
+
+public:
+
+	HiZTask( const hiZCreateInfo_t& info )
+	{
+		Init( info );
+	}
+
+	void		Resize() {}
+
+	void		FrameBegin();
+	void		FrameEnd();
+
+	uint32_t	GetLevelCount() const;
+
+	void		DeclareResources( RenderGraph& graph ) override;
+	void		Execute( CommandContext& context ) override;
+};
@@ -153,6 +153,19 @@ void ImageWritebackTask::FrameEnd()
 
 
 
+void ImageWritebackTask::DeclareResources( RenderGraph& graph )
+{
+	// Declared even when no capture is pending since the request can arrive after the graph is built
+	const graphAccess_t access = HasFlags( m_flags, TRY_USE_API_COMMAND ) ? GRAPH_ACCESS_TRANSFER : GRAPH_ACCESS_COMPUTE;
+
+	const uint32_t imageCount = m_imageArray.Count();
+	for ( uint32_t i = 0; i < imageCount; ++i ) {
+		graph.ReadImage( m_imageArray[ i ], access );
+	}
+	graph.WriteBuffer( &m_writebackBuffer, access );
+}
+
+
 void ImageWritebackTask::Execute( CommandContext& cmdContext )
 {
 	if ( HasFlags( m_flags, SCREENSHOT ) && g_imguiControls.captureScreenshot == false ) {
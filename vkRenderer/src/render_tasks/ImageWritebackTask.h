@@ -58,5 +58,6 @@ public:
 	void FrameBegin();
 	void FrameEnd();
 
+	void DeclareResources( RenderGraph& graph ) override;
 	void Execute( CommandContext& context ) override;
 };
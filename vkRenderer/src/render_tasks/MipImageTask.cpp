@@ -20,11 +20,13 @@ void MipImageTask::Init( const mipProcessCreateInfo_t& info )
 	m_context->scratchMemory.AdjustOffset( 0, 0 );
 
 	m_mipLevels = m_image->info.mipLevels;
+	assert( m_mipLevels <= MaxMipLevels );
 
-	m_passes.resize( m_mipLevels );
-	m_imgViews.resize( m_mipLevels );
-	m_frameBuffers.resize( m_mipLevels );
-	m_bufferViews.resize( m_mipLevels );
+	// Passes point into these, the capacity keeps them in place when a resize changes the mip count
+	m_passes.reserve( MaxMipLevels );
+	m_imgViews.reserve( MaxMipLevels );
+	m_frameBuffers.reserve( MaxMipLevels );
+	m_bufferViews.reserve( MaxMipLevels );
 
 	{
 		m_tempImage.info = m_image->info;
@@ -38,16 +40,58 @@ void MipImageTask::Init( const mipProcessCreateInfo_t& info )
 		);
 	}
 
-	// Create buffer
-	m_buffer.Create( "Resource buffer", swapBuffering_t::SINGLE_FRAME, resourceLifeTime_t::TASK, m_mipLevels, MaxBufferSizeInBytes, bufferType_t::UNIFORM, m_context->sharedMemory );
+	// Create buffer, sized for any mip count so a resize can reuse it
+	m_buffer.Create( "Resource buffer", swapBuffering_t::SINGLE_FRAME, resourceLifeTime_t::TASK, MaxMipLevels, MaxBufferSizeInBytes, bufferType_t::UNIFORM, m_context->sharedMemory );
+
+	m_layer = info.layer;
+	CreatePasses();
+	CreateViews();
+	UpdateLevels();
+
+	m_firstFrame = true;
+}
+
+
+void MipImageTask::CreatePasses()
+{
+	// Levels past the mip count are released, new levels get a pass. Passes of kept levels are reused.
+	for ( uint32_t i = m_mipLevels; i < m_passes.size(); ++i )
+	{
+		if ( m_passes[ i ] != nullptr ) {
+			delete m_passes[ i ];
+		}
+	}
+
+	const uint32_t prevLevels = static_cast<uint32_t>( m_passes.size() );
+
+	m_passes.resize( m_mipLevels, nullptr );
+	m_imgViews.resize( m_mipLevels );
+	m_frameBuffers.resize( m_mipLevels );
+	m_bufferViews.resize( m_mipLevels );
+
+	for ( uint32_t i = std::max( prevLevels, 1u ); i < m_mipLevels; ++i )
+	{
+		m_bufferViews[ i ] = m_buffer.GetView( i, 1 );
+
+		m_passes[ i ] = new PostPass( &m_frameBuffers[ i ] );
+
+		m_passes[ i ]->codeImages.Resize( 1 );
+		m_passes[ i ]->codeImages[ 0 ] = &m_imgViews[ i - 1 ];
+
+		m_passes[ i ]->parms = m_context->RegisterBindParm( bindset_imageProcess );
+	}
+}
+
 
+void MipImageTask::CreateViews()
+{
 	// The last view is only needed to create a frame buffer 
 	for ( uint32_t i = 0; i < m_mipLevels; ++i )
 	{
 		imageSubResourceView_t subView = {};
 		subView.baseMip = i;
 		subView.mipLevels = 1;
-		subView.baseArray = info.layer;
+		subView.baseArray = m_layer;
 		subView.arrayCount = 1;
 
 		imageInfo_t viewInfo = m_image->info;
@@ -65,7 +109,14 @@ void MipImageTask::Init( const mipProcessCreateInfo_t& info )
 		info.swapBuffering = swapBuffering_t::SINGLE_FRAME;
 
 		m_frameBuffers[ i ].Create( info );
+	}
+}
 
+
+void MipImageTask::UpdateLevels()
+{
+	for ( uint32_t i = 1; i < m_mipLevels; ++i )
+	{
 		imageProcessObject_t imageProcessParms{};
 
 		const float w = float( m_imgViews[ i - 1 ].info.width );
@@ -73,20 +124,33 @@ void MipImageTask::Init( const mipProcessCreateInfo_t& info )
 		imageProcessParms.dimensions = vec4f( w, h, 1.0f / w, 1.0f / h );
 		assert( sizeof( imageProcessParms.dimensions ) <= ReservedConstantSizeInBytes );
 
-		m_bufferViews[ i ] = m_buffer.GetView( i, 1 );
-
 		m_bufferViews[ i ].SetPos( 0 );
 		m_bufferViews[ i ].CopyData( &imageProcessParms, ReservedConstantSizeInBytes );
 
-		m_passes[ i ] = new PostPass( &m_frameBuffers[ i ] );
 		m_passes[ i ]->SetViewport( 0, 0, m_imgViews[ i ].info.width, m_imgViews[ i ].info.height );
+	}
+}
 
-		m_passes[ i ]->codeImages.Resize( 1 );
-		m_passes[ i ]->codeImages[ 0 ] = &m_imgViews[ i - 1 ];
 
-		m_passes[ i ]->parms = m_context->RegisterBindParm( bindset_imageProcess );
-	}
+void MipImageTask::Resize()
+{
+	// Views and frame buffers of the old image were released with the rest of the frame buffer memory.
+	// The temp image holds the first downsampled level, so it's rebuilt at the new size in place.
+	m_mipLevels = m_image->info.mipLevels;
+	assert( m_mipLevels <= MaxMipLevels );
+
+	m_context->scratchMemory.AdjustOffset( 0, 0 );
+
+	m_tempImage.gpuImage->Destroy();
+	m_tempImage.info = m_image->info;
+	m_tempImage.info.mipLevels = 1;
+	MipDimensions( 1, m_image->info.width, m_image->info.height, &m_tempImage.info.width, &m_tempImage.info.height );
+	m_tempImage.gpuImage->Create( "tempMipImage", m_tempImage.info, GPU_IMAGE_RW | GPU_IMAGE_TRANSFER_SRC | GPU_IMAGE_TRANSFER_DST, m_context->scratchMemory, resourceLifeTime_t::TASK );
 	m_firstFrame = true;
+
+	CreatePasses();
+	CreateViews();
+	UpdateLevels();
 }
 
 
@@ -172,6 +236,23 @@ bool MipImageTask::SetConstantsForLevel( const uint32_t mipLevel, const void* da
 }
 
 
+void MipImageTask::DeclareResources( RenderGraph& graph )
+{
+	// Blits and copies move the image in and out of its read layout within the task
+	if ( m_mode == DOWNSAMPLE_LINEAR )
+	{
+		graph.ReadImage( m_image, GRAPH_ACCESS_TRANSFER );
+	}
+	else
+	{
+		for ( uint32_t i = 1; i < m_mipLevels; ++i ) {
+			graph.ReadPass( m_passes[ i ] );
+		}
+	}
+	graph.WriteImage( m_image, GRAPH_ACCESS_TRANSFER );
+}
+
+
 void MipImageTask::Execute( CommandContext& context )
 {
 	context.MarkerBeginRegion( m_dbgName.c_str(), ColorToVector( ColorWhite ) );
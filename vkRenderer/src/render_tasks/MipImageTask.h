@@ -10,6 +10,7 @@ private:
 	static const uint32_t	MaxBufferSizeInBytes		= 256;
 	static const uint32_t	ReservedConstantSizeInBytes	= 16;
 	static const uint32_t	MaxConstantBlockSizeInBytes	= 240;
+	static const uint32_t	MaxMipLevels				= 16;	// Enough for a 32k image
 
 	Image* m_image;
 	downSampleMode_t			m_mode;
@@ -23,10 +24,14 @@ private:
 	std::vector<FrameBuffer>	m_frameBuffers;
 	std::vector<GpuBufferView>	m_bufferViews;
 	uint32_t					m_mipLevels;
+	uint32_t					m_layer;
 	bool						m_firstFrame;
 
 	void Init( const mipProcessCreateInfo_t& info );
 	void Shutdown();
+	void CreatePasses();
+	void CreateViews();
+	void UpdateLevels();
 
 public:
 
@@ -35,7 +40,7 @@ public:
 		Init( info );
 	}
 
-	void		Resize() { assert( 0 ); } // support
+	void		Resize();
 
 	void		FrameBegin();
 	void		FrameEnd();
@@ -44,6 +49,7 @@ public:
 	bool		SetSourceImageForLevel( const uint32_t mipLevel, Image* img );
 	bool		SetConstantsForLevel( const uint32_t mipLevel, const void* dataBlock, const uint32_t sizeInBytes );
 
+	void		DeclareResources( RenderGraph& graph ) override;
 	void		Execute( CommandContext& context ) override;
 
 	~MipImageTask() {
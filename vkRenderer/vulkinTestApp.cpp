@@ -34,16 +34,22 @@
 #include "window.h"
 #include "src/globals/renderConstants.h"
 #include "src/render_core/renderer.h"
+#include "src/render_core/debugMenu.h"
+#include "src/globals/sceneBvh.h"
+#include "src/globals/meshSimplify.h"
 #include "scenes/sceneParser.h"
 #include <SysCore/systemUtils.h>
 #include <gfxcore/scene/assetBaker.h>
 #include "raytracerInterface.h"
 #include "src/app/cvar.h"
+#include "src/app/fileWatcher.h"
 
 AssetManager						g_assets;
 Scene*								g_scene;
+SceneBvh							g_sceneBvh;
 Renderer							g_renderer;
 Window								g_window;
+FileWatcher							g_shaderWatcher;
 
 static std::string sceneFile = "chess.json";
 
@@ -60,8 +66,72 @@ void RenderThread()
 {
 }
 
+static std::string FileStem( const std::string& path )
+{
+	const size_t dirPos = path.find_last_of( "/\\" );
+	const size_t start = ( dirPos == std::string::npos ) ? 0 : ( dirPos + 1 );
+	const size_t extPos = path.find( '.', start );
+	return path.substr( start, ( extPos == std::string::npos ) ? std::string::npos : ( extPos - start ) );
+}
+
+// Shader names are either the binary or the source it was built from.
+// Binaries are named <source><stage><perm>.spv, e.g. litPS_msaa.spv
+static bool ShaderUsesBinary( const std::string& shaderName, const std::string& binaryStem )
+{
+	const std::string stem = FileStem( shaderName );
+	if ( stem == binaryStem ) {
+		return true;
+	}
+
+	if ( ( binaryStem.size() < stem.size() + 2 ) || ( binaryStem.compare( 0, stem.size(), stem ) != 0 ) ) {
+		return false;
+	}
+
+	const std::string stage = binaryStem.substr( stem.size(), 2 );
+	return ( stage == "VS" ) || ( stage == "PS" ) || ( stage == "CS" );
+}
+
+// Only programs built from a rewritten binary are reloaded, the renderer recompiles their
+// pipelines in the background and retires the old ones once no frame uses them
+static void ReloadChangedShaders()
+{
+	std::vector<std::string> changedFiles;
+	g_shaderWatcher.Poll( changedFiles );
+
+	for ( auto fileIt = changedFiles.begin(); fileIt != changedFiles.end(); ++fileIt )
+	{
+		const std::string binaryStem = FileStem( *fileIt );
+
+		const uint32_t programCount = g_assets.gpuPrograms.Count();
+		for ( uint32_t progIx = 0; progIx < programCount; ++progIx )
+		{
+			Asset<GpuProgram>* progAsset = g_assets.gpuPrograms.Find( progIx );
+			if ( ( progAsset == nullptr ) || ( progAsset->IsLoaded() == false ) ) {
+				continue;
+			}
+
+			const GpuProgram& prog = progAsset->Get();
+			for ( uint32_t shaderIx = 0; shaderIx < prog.shaderCount; ++shaderIx )
+			{
+				if ( ShaderUsesBinary( prog.shaders[ shaderIx ].name, binaryStem ) )
+				{
+					// Shown in the debug menu rather than printed every time a file is saved
+					const std::string progName = progAsset->GetName();
+					snprintf( g_renderDebugData.lastShaderReload, sizeof( g_renderDebugData.lastShaderReload ), "%s", progName.c_str() );
+					++g_renderDebugData.shaderReloadCount;
+
+					progAsset->Reload( true );
+					break;
+				}
+			}
+		}
+	}
+}
+
 void CheckReloadAssets()
 {
+	ReloadChangedShaders();
+
 #if defined( USE_IMGUI )
 	if ( g_imguiControls.rebuildShaders )
 	{
@@ -80,6 +150,13 @@ void CheckReloadAssets()
 #endif
 }
 
+// Pipelines seen while running a scene are recorded next to its json
+static std::string PipelineManifestFile( const std::string& sceneFileName )
+{
+	const size_t extPos = sceneFileName.rfind( ".json" );
+	return sceneFileName.substr( 0, extPos ) + ".pipelines";
+}
+
 void BakeAssets()
 {	
 	AssetBaker baker;
@@ -89,6 +166,17 @@ void BakeAssets()
 	baker.AddAssetLib( &g_assets.textureLib, TexturePath, BakedTextureExtension );
 
 	baker.Bake();
+
+	// LOD chains aren't part of the model format, they are baked beside it
+	const uint32_t modelCount = g_assets.modelLib.Count();
+	for ( uint32_t m = 0; m < modelCount; ++m )
+	{
+		Asset<Model>* modelAsset = g_assets.modelLib.Find( m );
+		if ( modelAsset->IsLoaded() == false ) {
+			continue;
+		}
+		WriteModelLods( BakePath + modelAsset->GetName() + BakedLodExtension, modelAsset->Get() );
+	}
 }
 
 MakeCVar( bool,		r_cubeCapture );
@@ -96,9 +184,17 @@ MakeCVar( bool,		r_computeDiffuseIbl );
 MakeCVar( bool,		r_computeSpecularIbl );
 MakeCVar( char*,	c_scene );
 MakeCVar( bool,		c_bakeAssets );
+MakeCVar( bool,		c_resolutionScaleHarness );
 MakeCVar( bool,		r_shadows );
+MakeCVar( bool,		r_gpuCulling );
+MakeCVar( bool,		r_occlusionCulling );
 MakeCVar( bool,		r_downsampleScene );
 MakeCVar( bool,		r_screenshot );
+MakeCVar( int,		r_shadowCascades );
+MakeCVar( bool,		r_dynamicResolution );
+MakeCVar( int,		r_gpuFrameBudgetUs );
+MakeCVar( bool,		r_softwareDevice );
+MakeCVar( bool,		r_logPipelineTimes );
  
 void ParseCmdArgs( const int argc, char* argv[] )
 {
@@ -113,6 +209,11 @@ int main( int argc, char* argv[] )
 
 	ParseCmdArgs( argc, argv );
 
+	// Headless, runs before any scene or device work
+	if ( c_resolutionScaleHarness.GetBool() ) {
+		exit( RunResolutionScaleHarness() ? 0 : 1 );
+	}
+
 	if( c_scene.IsValid() ) {
 		LoadScene( c_scene.GetString(), &g_scene, &g_assets );
 	} else {
@@ -124,8 +225,16 @@ int main( int argc, char* argv[] )
 	config.computeDiffuseIbl = r_computeDiffuseIbl.GetBool();
 	config.computeSpecularIBL = r_computeSpecularIbl.GetBool();
 	config.shadows = r_shadows.GetBool();
+	config.gpuCulling = r_gpuCulling.GetBool();
+	config.occlusionCulling = r_occlusionCulling.GetBool();
 	config.downsampleScene = r_downsampleScene.GetBool();
 	config.screenshot = r_screenshot.GetBool();
+	config.shadowCascades = r_shadowCascades.GetInt();
+	config.dynamicResolution = r_dynamicResolution.GetBool();
+	config.softwareDevice = r_softwareDevice.GetBool();
+	config.logPipelineTimes = r_logPipelineTimes.GetBool();
+	config.gpuFrameBudgetMs = 0.001f * static_cast<float>( r_gpuFrameBudgetUs.GetInt() );	// Microseconds so budgets like 16667 can be set
+	config.pipelineManifest = PipelineManifestFile( c_scene.IsValid() ? c_scene.GetString() : sceneFile );
 
 	std::thread renderThread( RenderThread );
 
@@ -142,6 +251,8 @@ int main( int argc, char* argv[] )
 	{
 		g_renderer.Init( config );
 
+		g_shaderWatcher.Init( ShaderBinPath );
+
 		while ( g_window.IsOpen() )
 		{
 			CheckReloadAssets();
@@ -204,6 +315,7 @@ int main( int argc, char* argv[] )
 				LoadScene( file, &g_scene, &g_assets );
 				InitScene( g_scene );
 		
+				g_renderer.SetPipelineManifest( PipelineManifestFile( file ) );
 				g_renderer.InitGPU();
 
 				g_imguiControls.openSceneFileDialog = false;